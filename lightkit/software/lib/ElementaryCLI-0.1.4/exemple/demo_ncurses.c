@@ -7,6 +7,9 @@
 // Tell if main loop should keep running
 static volatile int keepRunning = 1;
 
+// The only user session of this demo
+static cli_session session;
+
 /**
  * @brief Handler to stop app on ctrl-c
  *
@@ -15,7 +18,7 @@ static volatile int keepRunning = 1;
 void sigint_handler(int dummy)
 {
 	keepRunning = 0;
-	cli_exit();
+	cli_exit(&session);
 	printf("\n\r- Quitting...\n\r");
 }
 
@@ -130,13 +133,14 @@ int main(void)
 
 	cli_init();
 	create_cli_commands();
+	cli_session_init(&session);
 
 	while (keepRunning) {
 		byte = getch();
 		if (byte == 0xFF) {
 			continue;
 		}
-		cli_rx(byte);
+		cli_rx(&session, byte);
 	}
 
 	endwin(); // Restore terminal to previous state
@@ -6,6 +6,7 @@
 // Global variables
 const char cliVersionName[] = CLI_NAME " - v" CLI_VERSION;
 cli_token  tokenList[CLI_MAX_TOKEN_COUNT];
+uint8_t    tokenCount;
 
 // ===================
 //      TOOLS
@@ -50,11 +51,8 @@ static void cli_print_token_tree(cli_token * curTok)
 	CLI_PRINTF("%s\n\r", curTok->desc);
 
 	// Recursive call for all childs
-	for (i = 0; i < CLI_MAX_CHILDS; ++i) {
-		if (curTok->childs[i] == NULL) {
-			continue;
-		}
-		cli_print_token_tree(curTok->childs[i]);
+	for (cli_token * child = curTok->firstChild; child != NULL; child = child->nextSibling) {
+		cli_print_token_tree(child);
 	}
 
 	--indent;
@@ -106,11 +104,8 @@ static void cli_usage(cli_token * curTok)
 		cli_print_token(curTok);
 	} else {
 		// Print all child descriptions
-		for (uint8_t i = 0; i < CLI_MAX_CHILDS; ++i) {
-			if (curTok->childs[i] == NULL) {
-				continue;
-			}
-			cli_print_token(curTok->childs[i]);
+		for (cli_token * child = curTok->firstChild; child != NULL; child = child->nextSibling) {
+			cli_print_token(child);
 		}
 	}
 }
@@ -134,27 +129,24 @@ static int cli_find_last_valid_token(char * cmdText[], uint8_t cmdTextCount, cli
 	(*curTok) = cli_get_root_token();
 
 	for (uint8_t i = 0; i < cmdTextCount; ++i) {
-		uint8_t childIndex;
+		uint32_t    hash = cli_hash(cmdText[i]);
+		cli_token * child;
 
-		// Search text into tokens
-		for (childIndex = 0; childIndex < CLI_MAX_CHILDS; ++childIndex) {
-			// Filter out empty childs
-			if ((*curTok)->childs[childIndex] == NULL) {
-				continue;
-			}
-			DPRINTF(FINDER, "Looking child: %s\n\r", (*curTok)->childs[childIndex]->text);
+		// Search text into tokens, only compare strings when hashes match
+		for (child = (*curTok)->firstChild; child != NULL; child = child->nextSibling) {
+			DPRINTF(FINDER, "Looking child: %s\n\r", child->text);
 
-			if (strncmp((*curTok)->childs[childIndex]->text, cmdText[i], CLI_MAX_TEXT_LEN) == 0) {
+			if ((child->hash == hash) && (strcmp(child->text, cmdText[i]) == 0)) {
 				// Found it !
-				(*curTok) = (*curTok)->childs[childIndex];
+				(*curTok) = child;
 				++depth;
-				DPRINTF(FINDER, "Identified child %s (%u)\n\r", (*curTok)->text, childIndex);
+				DPRINTF(FINDER, "Identified child %s\n\r", (*curTok)->text);
 				break;
 			}
 		}
 
 		// Check not found
-		if (childIndex >= CLI_MAX_CHILDS) {
+		if (child == NULL) {
 			DPRINTF(FINDER, "- failed\n\r");
 			return -depth; // Negative depth: depth first tokens are valid but not (depth+1)
 		}
@@ -175,71 +167,72 @@ static int cli_find_last_valid_token(char * cmdText[], uint8_t cmdTextCount, cli
  * @brief Get the children count of a token
  *
  * @param parent Pointer
- * @return Number of children [0; CLI_MAX_CHILDS]
+ * @return Number of children
  */
 static uint8_t cli_get_children_count(cli_token * parent)
 {
 	uint8_t count = 0;
 
-	for (int i = 0; i < CLI_MAX_CHILDS; ++i) {
-		if (parent->childs[i] != NULL) {
-			++count;
-		}
+	for (cli_token * child = parent->firstChild; child != NULL; child = child->nextSibling) {
+		++count;
 	}
 	return count;
 }
 
 /**
  * @brief Split a string by spaces into a list of strings
+ * @details A cmdText starting with a double quote ends at the next double quote,
+ * it can contain spaces and be empty: "my ssid" or ""
  *
  * @param cmdEdit Editable buffer "word1 word2 word3"
  * @param cmdText Array of char pointer : [0] -> "word1\0", [1] -> "word2\0",
  * etc.
  *
- * @return Number of cmdText found (Ex: 3)
+ * @return Number of cmdText found (Ex: 3), -1: Too many cmdText
  */
-static uint8_t cli_parse_cmd_text(char * cmdEdit, char * cmdText[])
+static int cli_parse_cmd_text(char * cmdEdit, char * cmdText[])
 {
 	uint8_t cmdTextCount = 0;
-	char *  pCmd         = cmdEdit;
+	char *  pRead        = cmdEdit;
+	char *  pWrite;
+	char    separator;
 
 	DPRINTF(PARSER, "- Entering\n\r");
 
-	// Check empty strings
-	if ((*pCmd) == '\0') {
-		DPRINTF(PARSER, "- Nothing to parse\n\r");
-		return 0; // Empty string
-	}
-
-	cmdText[0] = pCmd;
-
 	while (1) {
-		if ((*pCmd) == '\0') {
-			// To get count instead of index
-			++cmdTextCount;
+		// Allow user to put multiple spaces between cmdText and extra spaces
+		// at the end of the line
+		while ((*pRead) == ' ') {
+			++pRead;
+		}
+		if ((*pRead) == '\0') {
 			break;
-		} else if ((*pCmd) == ' ') {
-			// All spaces must be replaced by ending string
-			*pCmd = '\0';
-			++pCmd;
-
-			// A new cmdText begins only if next character is not a space
-			// and to an ending line
-			// This allow user to put multiple spaces between cmdText and extra space
-			// at the end of the line
-			if (((*pCmd) != ' ') && (*pCmd) != '\0') {
-				++cmdTextCount;
-				cmdText[cmdTextCount] = pCmd;
-
-				// Check maximum
-				if (cmdTextCount >= CLI_CMD_MAX_TOKEN) {
-					CLI_PRINTF("Limit is reached (CLI_CMD_MAX_TOKEN = %d)\n\r", CLI_CMD_MAX_TOKEN);
-					return -1;
-				}
+		}
+
+		// Check maximum
+		if (cmdTextCount >= CLI_CMD_MAX_TOKEN) {
+			CLI_PRINTF("Limit is reached (CLI_CMD_MAX_TOKEN = %d)\n\r", CLI_CMD_MAX_TOKEN);
+			return -1;
+		}
+
+		// Quotes are removed from the cmdText
+		separator = ' ';
+		if ((*pRead) == '"') {
+			separator = '"';
+			++pRead;
+		}
+
+		// Copy until separator, quotes make pWrite lag behind pRead
+		cmdText[cmdTextCount++] = pRead;
+		pWrite                  = pRead;
+		while ((*pRead) != '\0') {
+			if ((*pRead) == separator) {
+				++pRead;
+				break;
 			}
-		} else {
-			++pCmd;
+			*pWrite++ = *pRead++;
 		}
+		*pWrite = '\0';
 	}
 
 	DEBUG_BLOC(PARSER)
@@ -366,17 +359,14 @@ static char * cli_autocomplete(char * cmdText[], uint8_t cmdTextCount)
 	// 2. Print them if more than 1
 	for (int state = 0; state < 2; ++state) {
 		// For all childs of the last valid token found...
-		for (int i = 0; i < CLI_MAX_CHILDS; ++i) {
-			if (curTok->childs[i] == NULL) {
-				continue;
-			}
+		for (cli_token * child = curTok->firstChild; child != NULL; child = child->nextSibling) {
 			// Does the last text match this child ?
-			if (strncmp(lastCmdText, curTok->childs[i]->text, lastCmdTextLen) == 0) {
+			if (strncmp(lastCmdText, child->text, lastCmdTextLen) == 0) {
 				if (state == 0) {
 					++alternatives;
-					lastAlternativeTok = curTok->childs[i];
+					lastAlternativeTok = child;
 				} else if (state == 1) {
-					cli_print_token(curTok->childs[i]);
+					cli_print_token(child);
 				}
 			}
 		}
@@ -388,7 +378,7 @@ static char * cli_autocomplete(char * cmdText[], uint8_t cmdTextCount)
 				break; // Nothing to do, don't bother with state 1
 			} else if (alternatives == 1) {
 				// Return the pointer of the portion to write
-				return lastAlternativeTok->text + lastCmdTextLen;
+				return (char *) lastAlternativeTok->text + lastCmdTextLen;
 			} else {
 				CLI_PRINTF("\n\r"); // Go to next line before printing alternatives
 				continue;
@@ -416,14 +406,26 @@ int cli_init(void)
 
 	// Empty token list
 	memset(tokenList, 0, sizeof(tokenList));
+	tokenCount = 0;
 
 	// Add root children
 	cli_add_token(CLI_ROOT_TOKEN_NAME, "");
+	return 0;
+}
 
-	// Init LineBuffer
-	lb_init();
-	lb_set_valid_line_callback(&cli_execute_lb);
-	lb_set_autocomplete_callback(&cli_autocomplete_lb);
+/**
+ * @brief Init a user session
+ * @details A session holds its own line buffer and history,
+ * the token tree is shared by all sessions
+ *
+ * @param pSession The session to initialize
+ * @return 0
+ */
+int cli_session_init(cli_session * pSession)
+{
+	lb_init(pSession);
+	lb_set_valid_line_callback(pSession, &cli_execute_lb);
+	lb_set_autocomplete_callback(pSession, &cli_autocomplete_lb);
 	return 0;
 }
 
@@ -451,8 +453,27 @@ const char * cli_get_version(void)
 	return cliVersionName;
 }
 
+/**
+ * @brief Hash a token text (32 bits FNV-1a)
+ * @details Used to discard most of the tokens without comparing strings
+ *
+ * @param str The text to hash
+ * @return The hash
+ */
+uint32_t cli_hash(const char * str)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*str != '\0') {
+		hash ^= (uint8_t) *str++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 /**
  * @brief Add a token to the list of known tokens
+ * @warning text and desc are not copied, use string literals
  *
  * @param text The text of the token
  * @param desc The description of the token
@@ -460,26 +481,20 @@ const char * cli_get_version(void)
  */
 cli_token * cli_add_token(const char * text, const char * desc)
 {
-	cli_token * curTok = NULL;
-
-	// Find a not used token (Considered not used if text is not set)
-	for (int i = 0; i < CLI_MAX_TOKEN_COUNT; ++i) {
-		if (tokenList[i].text[0] == '\0') {
-			curTok = &tokenList[i];
-			break;
-		}
-	}
+	cli_token * curTok;
 
 	// Check overflow
-	if (curTok == NULL) {
-		DPRINTF(ERROR, "Unable to add token \"%s\", maximum reach: %u\n\r", curTok->text, CLI_MAX_TOKEN_COUNT);
+	if (tokenCount >= CLI_MAX_TOKEN_COUNT) {
+		DPRINTF(ERROR, "Unable to add token \"%s\", maximum reach: %u\n\r", text, CLI_MAX_TOKEN_COUNT);
 		return NULL;
 	}
 
 	// Clear and fill the structure
+	curTok = &tokenList[tokenCount++];
 	memset(curTok, 0, sizeof(*curTok));
-	cli_strcpy_safe(curTok->text, text, CLI_MAX_TEXT_LEN);
-	cli_strcpy_safe(curTok->desc, desc, CLI_MAX_DESC_LEN);
+	curTok->text   = text;
+	curTok->desc   = desc;
+	curTok->hash   = cli_hash(text);
 	curTok->isLeaf = true;
 
 	return curTok;
@@ -491,28 +506,35 @@ cli_token * cli_add_token(const char * text, const char * desc)
  * @param parent Pointer
  * @param children Pointer
  *
- * @return 0: ok, -1: Can't take more children
+ * @return 0: ok, -1: Can't take children
  */
 int cli_add_children(cli_token * parent, cli_token * children)
 {
-	uint8_t argc = parent->mandatoryArgc + parent->optionalArgc;
+	cli_token ** ppLast;
+	uint8_t      argc;
+
+	if ((parent == NULL) || (children == NULL)) {
+		DPRINTF(ERROR, "Unable to add children, token pool is exhausted\n\r");
+		return -1;
+	}
+
+	argc = parent->mandatoryArgc + parent->optionalArgc;
 	if (argc > 0) {
 		DPRINTF(ERROR, "Unable to add children for token \"%s\", parent has %u arguments\n\r", parent->text, argc);
 		return -1;
 	}
 
-	for (uint8_t i = 0; i < CLI_MAX_CHILDS; ++i) {
-		if (parent->childs[i] == NULL) {
-			parent->childs[i] = children;
-
-			// Token with children are no longer a leaf
-			parent->isLeaf = false;
-			return 0;
-		}
+	// Append at the end to keep the declaration order in usage
+	ppLast = &parent->firstChild;
+	while (*ppLast != NULL) {
+		ppLast = &(*ppLast)->nextSibling;
 	}
+	*ppLast               = children;
+	children->nextSibling = NULL;
 
-	DPRINTF(ERROR, "Unable to add children for token \"%s\", parent has no empty child (CLI_MAX_CHILDS = %d)\n\r", parent->text, CLI_MAX_CHILDS);
-	return -1;
+	// Token with children are no longer a leaf
+	parent->isLeaf = false;
+	return 0;
 }
 
 /**
@@ -521,10 +543,14 @@ int cli_add_children(cli_token * parent, cli_token * children)
  *
  * @param curTok Pointer
  * @param callback Pointer to function
- * @return 0
+ * @return 0: ok, -1: Error
  */
 int cli_set_callback(cli_token * curTok, cli_callback_t callback)
 {
+	if (curTok == NULL) {
+		DPRINTF(ERROR, "Unable to set callback, token pool is exhausted\n\r");
+		return -1;
+	}
 	if (!cli_is_token_a_leaf(curTok)) {
 		DPRINTF(ERROR, "Unable to set callback for token \"%s\", token is not a leaf\n\r", curTok->text);
 		return -1;
@@ -544,6 +570,10 @@ int cli_set_callback(cli_token * curTok, cli_callback_t callback)
  */
 int cli_set_argc(cli_token * curTok, uint8_t mandatoryArgc, uint8_t optionalArgc)
 {
+	if (curTok == NULL) {
+		DPRINTF(ERROR, "Unable to set argument count, token pool is exhausted\n\r");
+		return -1;
+	}
 	if (!cli_is_token_a_leaf(curTok)) {
 		DPRINTF(ERROR, "Can't set argument count for token \"%s\": token is not a leaf\n\r", curTok->text);
 		return -1;
@@ -580,7 +610,7 @@ uint8_t cli_autocomplete_lb(const char * str, uint16_t len, char * outBuffer, ui
 {
 	char    cmdEdit[CLI_CMD_MAX_LEN]; // Editable copy of str
 	char *  cmdText[CLI_CMD_MAX_TOKEN];
-	uint8_t cmdTextCount;
+	int     cmdTextCount;
 	uint8_t countToAdd, countAlreadyWrote;
 
 	// Copy incomming buffer
@@ -588,6 +618,9 @@ uint8_t cli_autocomplete_lb(const char * str, uint16_t len, char * outBuffer, ui
 
 	// PARSER (Note: cmdTextCount can be 0)
 	cmdTextCount = cli_parse_cmd_text(cmdEdit, cmdText);
+	if (cmdTextCount < 0) {
+		return 0;
+	}
 
 	// Search for alternatives
 	char * pText = cli_autocomplete(cmdText, cmdTextCount);
@@ -636,7 +669,7 @@ int cli_execute_lb(const char * str, uint16_t len)
 {
 	char    cmdEdit[CLI_CMD_MAX_LEN]; // Editable copy of str
 	char *  cmdText[CLI_CMD_MAX_TOKEN];
-	uint8_t cmdTextCount;
+	int     cmdTextCount;
 
 	// Copy incomming buffer
 	cli_strcpy_safe(cmdEdit, str, CLI_CMD_MAX_LEN);
@@ -644,7 +677,7 @@ int cli_execute_lb(const char * str, uint16_t len)
 	// PARSER
 	cmdTextCount = cli_parse_cmd_text(cmdEdit, cmdText);
 	if (cmdTextCount <= 0) {
-		return 0;
+		return cmdTextCount;
 	}
 
 	return cli_execute(cmdText, cmdTextCount);
@@ -653,19 +686,20 @@ int cli_execute_lb(const char * str, uint16_t len)
 /**
  * @brief Input of caracter to manage by cli
  *
+ * @param pSession The session receiving the caracter
  * @param byte The value of the caracter
  */
-void cli_rx(uint8_t byte)
+void cli_rx(cli_session * pSession, uint8_t byte)
 {
-	lb_rx(byte);
+	lb_rx(pSession, byte);
 }
 
 /**
- * @brief Exit CLI
+ * @brief Exit CLI session
  *
- * @param byte The value of the caracter
+ * @param pSession The session to exit
  */
-void cli_exit(void)
+void cli_exit(cli_session * pSession)
 {
-	lb_exit();
+	lb_exit(pSession);
 }
\ No newline at end of file
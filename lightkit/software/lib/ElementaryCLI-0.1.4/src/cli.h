@@ -27,17 +27,21 @@
 // Typedefs and structs
 // ======================
 
+typedef lb_handle_t cli_session; /**< A user session: line buffer and history */
+
 typedef int (*cli_callback_t)(uint8_t argc, char * argv[]); /**< Prototype of the function callable by cli commands */
 
 typedef struct cli_token_t cli_token; /**< Needed because we have self pointer into this structure */
 struct cli_token_t {
-	char           text[CLI_MAX_TEXT_LEN]; /**< Name of the token */
-	char           desc[CLI_MAX_DESC_LEN]; /**< Description of the token */
-	cli_token *    childs[CLI_MAX_CHILDS]; /**< Pointer to all token child (None if leaf) */
-	uint8_t        mandatoryArgc;          /**< Number of mandatory argument of the leaf */
-	uint8_t        optionalArgc;           /**< Number of optional argument of the leaf */
-	cli_callback_t callback;               /**< Function to call when user type the command */
-	uint8_t        isLeaf : 1;             /**< Tell if token is a leaf */
+	const char *   text;          /**< Name of the token (Not copied, must stay valid) */
+	const char *   desc;          /**< Description of the token (Not copied, must stay valid) */
+	uint32_t       hash;          /**< Hash of text, compared before text */
+	cli_token *    firstChild;    /**< First child of the token (NULL if leaf) */
+	cli_token *    nextSibling;   /**< Next child of the parent (NULL if last) */
+	uint8_t        mandatoryArgc; /**< Number of mandatory argument of the leaf */
+	uint8_t        optionalArgc;  /**< Number of optional argument of the leaf */
+	cli_callback_t callback;      /**< Function to call when user type the command */
+	uint8_t        isLeaf : 1;    /**< Tell if token is a leaf */
 };
 
 // ======================
@@ -45,6 +49,7 @@ struct cli_token_t {
 // ======================
 
 int          cli_init(void);
+int          cli_session_init(cli_session * pSession);
 void         cli_strcpy_safe(char * dest, const char * src, uint16_t maxLen);
 const char * cli_get_version(void);
 cli_token *  cli_add_token(const char * text, const char * desc);
@@ -52,9 +57,10 @@ int          cli_add_children(cli_token * parent, cli_token * children);
 int          cli_set_callback(cli_token * curTok, cli_callback_t callback);
 int          cli_set_argc(cli_token * curTok, uint8_t mandatoryArgc, uint8_t optionalArgc);
 cli_token *  cli_get_root_token(void);
+uint32_t     cli_hash(const char * str);
 uint8_t      cli_autocomplete_lb(const char * str, uint16_t len, char * outBuffer, uint16_t outBufferMaxLen);
 int          cli_execute_lb(const char * str, uint16_t len);
-void         cli_rx(uint8_t byte);
-void         cli_exit(void);
+void         cli_rx(cli_session * pSession, uint8_t byte);
+void         cli_exit(cli_session * pSession);
 
 #endif /* CLI_H */
\ No newline at end of file
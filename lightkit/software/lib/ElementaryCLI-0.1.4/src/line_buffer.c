@@ -3,24 +3,6 @@
 #define LINE_BUFFER_C
 #include "cli_debug.h"
 
-// Global variables
-typedef struct {
-	char lineBufferTable[LB_HISTORY_COUNT][LB_LINE_BUFFER_LENGTH]; /**< Buffer to store the state of the line */
-
-	uint8_t historyIndex;   /**< The current lineBuffer index under edition, history will be saved here after processing */
-	uint8_t explorerIndex;  /**< Index controlled by user when explorating history */
-	char *  curLineBuffer;  /**< The line currently under edition by user */
-	uint8_t lineSize;       /**< Size of the line (without ending '\0') */
-	char *  pCurPos;        /**< Current position of the cursor */
-	uint8_t escPos : 2;     /**< Current position in the ainsi escaped sequence [0;2] */
-	uint8_t isEscaping : 1; /**< Tell if next bytes will be managed as escaped command */
-	uint8_t isExiting : 1;  /**< Tell if module is in exiting mode */
-
-	lb_line_callback_t         lineCallback;     /**< Function called when user valid a line */
-	lb_autocomplete_callback_t autoCompCallback; /**< Function called when user request an autocompletion */
-} lb_handle_t;
-lb_handle_t lbHandle;
-
 // ===================
 //      TOOLS
 // ===================
@@ -36,13 +18,14 @@ lb_handle_t lbHandle;
  */
 static uint8_t lb_loop_index_operation(uint8_t index, int8_t add, int maxRange)
 {
-	index += add;
-	if (index < 0) {
-		return index + maxRange;
-	} else if (index >= maxRange) {
-		return index - maxRange;
+	int result = index + add; // Signed, 0 - 1 must not wrap to 255
+
+	if (result < 0) {
+		return result + maxRange;
+	} else if (result >= maxRange) {
+		return result - maxRange;
 	} else {
-		return index;
+		return result;
 	}
 }
 
@@ -55,14 +38,14 @@ static uint8_t lb_loop_index_operation(uint8_t index, int8_t add, int maxRange)
  * @note Do nothing if overflow is detected
  * @param toInsert Character to insert
  */
-static void lb_insert_at_cursor(char toInsert)
+static void lb_insert_at_cursor(lb_handle_t * pHandle, char toInsert)
 {
-	char * pBuffer = lbHandle.pCurPos;
+	char * pBuffer = pHandle->pCurPos;
 	char * pEnd;
 	char   backup;
 
 	// Check size before inserting
-	if ((lbHandle.lineSize + 1) >= LB_LINE_BUFFER_LENGTH) {
+	if ((pHandle->lineSize + 1) >= LB_LINE_BUFFER_LENGTH) {
 		DEBUG_BLOC(ERROR)
 		{
 			CLI_PRINTF("\n\r");
@@ -72,8 +55,8 @@ static void lb_insert_at_cursor(char toInsert)
 	}
 
 	// Define the new ending line
-	++lbHandle.lineSize;
-	pEnd = &lbHandle.curLineBuffer[lbHandle.lineSize];
+	++pHandle->lineSize;
+	pEnd = &pHandle->curLineBuffer[pHandle->lineSize];
 
 	// Slide characters
 	while (pBuffer <= pEnd) {
@@ -84,32 +67,32 @@ static void lb_insert_at_cursor(char toInsert)
 	}
 
 	// Slide cursor position
-	++lbHandle.pCurPos;
+	++pHandle->pCurPos;
 }
 
 /**
  * @brief Remove the character at .pCurPos
  * @note Do nothing if line is empty
  */
-static void lb_remove_at_cursor(void)
+static void lb_remove_at_cursor(lb_handle_t * pHandle)
 {
 	char * pBuffer;
 	char * pEnd;
 
 	// Check size before removing
-	if (((int) lbHandle.lineSize - 1) < 0) {
+	if (((int) pHandle->lineSize - 1) < 0) {
 		return;
 	}
 
 	// Can't remove char if positionned at first char
-	if (lbHandle.pCurPos <= lbHandle.curLineBuffer) {
+	if (pHandle->pCurPos <= pHandle->curLineBuffer) {
 		return;
 	}
 
-	--lbHandle.pCurPos;
-	pBuffer = lbHandle.pCurPos;
-	pEnd    = lbHandle.curLineBuffer + lbHandle.lineSize;
-	--lbHandle.lineSize;
+	--pHandle->pCurPos;
+	pBuffer = pHandle->pCurPos;
+	pEnd    = pHandle->curLineBuffer + pHandle->lineSize;
+	--pHandle->lineSize;
 
 	// Slide characters
 	while (pBuffer <= pEnd) {
@@ -124,11 +107,11 @@ static void lb_remove_at_cursor(void)
  * @param index Index of the history line buffer to copy
  * @return 0: ok, -1: Nothing on history
  */
-static int lb_use_history(void)
+static int lb_use_history(lb_handle_t * pHandle)
 {
 	// Shortcuts
-	uint8_t index       = lbHandle.explorerIndex;
-	char *  historyLine = lbHandle.lineBufferTable[index];
+	uint8_t index       = pHandle->explorerIndex;
+	char *  historyLine = pHandle->lineBufferTable[index];
 
 	// Is the pointed history line empty ?
 	if (historyLine[0] == '\0') {
@@ -136,17 +119,17 @@ static int lb_use_history(void)
 	}
 
 	// Copy content
-	if (lbHandle.curLineBuffer == historyLine) {
+	if (pHandle->curLineBuffer == historyLine) {
 		// We came back to curLine, empty the line buffer
-		lbHandle.curLineBuffer[0] = '\0';
+		pHandle->curLineBuffer[0] = '\0';
 	} else {
 		// Copy history to curLine
-		strncpy(lbHandle.curLineBuffer, historyLine, LB_LINE_BUFFER_LENGTH);
+		strncpy(pHandle->curLineBuffer, historyLine, LB_LINE_BUFFER_LENGTH);
 	}
 
 	// Update positions
-	lbHandle.lineSize = strlen(lbHandle.curLineBuffer);
-	lbHandle.pCurPos  = lbHandle.curLineBuffer + lbHandle.lineSize;
+	pHandle->lineSize = strlen(pHandle->curLineBuffer);
+	pHandle->pCurPos  = pHandle->curLineBuffer + pHandle->lineSize;
 	return 0;
 }
 
@@ -156,7 +139,7 @@ static int lb_use_history(void)
  * @param byte The escaped code
  * @return 0: OK, -1: unsupported code
  */
-static int lb_exec_escaped_code(uint8_t byte)
+static int lb_exec_escaped_code(lb_handle_t * pHandle, uint8_t byte)
 {
 	int tmp;
 
@@ -165,23 +148,23 @@ static int lb_exec_escaped_code(uint8_t byte)
 	case LB_CODE_ARROW_DOWN:
 		// Decide if we go up (-1) or down (+1) in history
 		tmp                    = (byte == LB_CODE_ARROW_UP) ? -1 : +1;
-		lbHandle.explorerIndex = lb_loop_index_operation(lbHandle.explorerIndex, tmp, LB_HISTORY_COUNT);
-		if (lb_use_history() == -1) {
+		pHandle->explorerIndex = lb_loop_index_operation(pHandle->explorerIndex, tmp, LB_HISTORY_COUNT);
+		if (lb_use_history(pHandle) == -1) {
 			// If nothing to see there (empty strings), come back to previous value as if nothing happened
-			lbHandle.explorerIndex = lb_loop_index_operation(lbHandle.explorerIndex, -tmp, LB_HISTORY_COUNT);
+			pHandle->explorerIndex = lb_loop_index_operation(pHandle->explorerIndex, -tmp, LB_HISTORY_COUNT);
 		}
 		break;
 	case LB_CODE_ARROW_RIGHT:
 		// Increment cursor
-		tmp = lbHandle.pCurPos - lbHandle.curLineBuffer;
-		if (tmp <= (lbHandle.lineSize - 1)) {
-			++lbHandle.pCurPos;
+		tmp = pHandle->pCurPos - pHandle->curLineBuffer;
+		if (tmp <= (pHandle->lineSize - 1)) {
+			++pHandle->pCurPos;
 		}
 		break;
 	case LB_CODE_ARROW_LEFT:
 		// Decrement cursor
-		if (lbHandle.pCurPos > lbHandle.curLineBuffer) {
-			--lbHandle.pCurPos;
+		if (pHandle->pCurPos > pHandle->curLineBuffer) {
+			--pHandle->pCurPos;
 		}
 		break;
 	default:
@@ -197,39 +180,39 @@ static int lb_exec_escaped_code(uint8_t byte)
  * @param byte The incomming new character
  * @return [description]
  */
-static void lb_handle_escaped(uint8_t byte)
+static void lb_handle_escaped(lb_handle_t * pHandle, uint8_t byte)
 {
-	++lbHandle.escPos;
+	++pHandle->escPos;
 
 	// Check '['
-	if (lbHandle.escPos == 1) {
+	if (pHandle->escPos == 1) {
 		// If 2nd character is ok, wait for the next one
 		if (byte == LB_KEY_OPEN_BRACKET) {
 			return;
 		}
-	} else if (lbHandle.escPos == 2) {
-		lb_exec_escaped_code(byte);
+	} else if (pHandle->escPos == 2) {
+		lb_exec_escaped_code(pHandle, byte);
 	}
 
 	// Reset escape handler
-	lbHandle.isEscaping = false;
-	lbHandle.escPos     = 0;
+	pHandle->isEscaping = false;
+	pHandle->escPos     = 0;
 }
 
 /**
  * @brief Compare the current line buffer with the previous in the history
  * @return 0: previous and current are identical
  */
-static int lb_cmp_curline_prevline()
+static int lb_cmp_curline_prevline(lb_handle_t * pHandle)
 {
 	char *  prevLine;
 	char *  curLine;
 	uint8_t index;
 
-	index = lb_loop_index_operation(lbHandle.historyIndex, -1, LB_HISTORY_COUNT);
+	index = lb_loop_index_operation(pHandle->historyIndex, -1, LB_HISTORY_COUNT);
 
-	prevLine = lbHandle.lineBufferTable[index];
-	curLine  = lbHandle.curLineBuffer;
+	prevLine = pHandle->lineBufferTable[index];
+	curLine  = pHandle->curLineBuffer;
 
 	return strncmp(prevLine, curLine, LB_LINE_BUFFER_LENGTH);
 }
@@ -238,20 +221,20 @@ static int lb_cmp_curline_prevline()
  * @brief Save current line and go to the next one (the older)
  * @return 0
  */
-static int lb_save_to_history(void)
+static int lb_save_to_history(lb_handle_t * pHandle)
 {
 	// Do not save empty lines and duplicates
-	if ((lbHandle.lineSize > 0) && (lb_cmp_curline_prevline() != 0)) {
+	if ((pHandle->lineSize > 0) && (lb_cmp_curline_prevline(pHandle) != 0)) {
 		// Go to next lineBuffer
-		lbHandle.historyIndex  = lb_loop_index_operation(lbHandle.historyIndex, +1, LB_HISTORY_COUNT);
-		lbHandle.curLineBuffer = lbHandle.lineBufferTable[lbHandle.historyIndex];
+		pHandle->historyIndex  = lb_loop_index_operation(pHandle->historyIndex, +1, LB_HISTORY_COUNT);
+		pHandle->curLineBuffer = pHandle->lineBufferTable[pHandle->historyIndex];
 	}
 
 	// Reset positions
-	lbHandle.pCurPos = lbHandle.curLineBuffer;
-	memset(lbHandle.curLineBuffer, 0, LB_LINE_BUFFER_LENGTH);
-	lbHandle.explorerIndex = lbHandle.historyIndex;
-	lbHandle.lineSize      = 0;
+	pHandle->pCurPos = pHandle->curLineBuffer;
+	memset(pHandle->curLineBuffer, 0, LB_LINE_BUFFER_LENGTH);
+	pHandle->explorerIndex = pHandle->historyIndex;
+	pHandle->lineSize      = 0;
 	return 0;
 }
 
@@ -259,9 +242,9 @@ static int lb_save_to_history(void)
  * @brief Get the current cursor position
  * @return position
  */
-static int lb_get_cursor_pos(void)
+static int lb_get_cursor_pos(lb_handle_t * pHandle)
 {
-	int curPos = lbHandle.pCurPos - lbHandle.curLineBuffer;
+	int curPos = pHandle->pCurPos - pHandle->curLineBuffer;
 	return (int) curPos;
 }
 
@@ -269,61 +252,61 @@ static int lb_get_cursor_pos(void)
  * @brief Look for an auto completion by calling the
  * specified callback
  */
-static void lb_auto_complete(void)
+static void lb_auto_complete(lb_handle_t * pHandle)
 {
 	uint16_t remainLen;
 	uint8_t  count;
 	char *   appendBuffer;
 
-	if (lbHandle.autoCompCallback == NULL) {
+	if (pHandle->autoCompCallback == NULL) {
 		return;
 	}
 
 	// Prevent autocompletion if cursor is not at the end of the line
-	if (lb_get_cursor_pos() != lbHandle.lineSize) {
+	if (lb_get_cursor_pos(pHandle) != pHandle->lineSize) {
 		return;
 	}
 
 	// Do autocompletion
-	appendBuffer = lbHandle.pCurPos;
-	remainLen    = LB_LINE_BUFFER_LENGTH - lbHandle.lineSize;
-	count        = lbHandle.autoCompCallback(lbHandle.curLineBuffer, lbHandle.lineSize, appendBuffer, remainLen);
+	appendBuffer = pHandle->pCurPos;
+	remainLen    = LB_LINE_BUFFER_LENGTH - pHandle->lineSize;
+	count        = pHandle->autoCompCallback(pHandle->curLineBuffer, pHandle->lineSize, appendBuffer, remainLen);
 
 	// Update position and counters if valid
 	if ((count > 0) && (count <= remainLen)) {
-		lbHandle.lineSize += count;
-		lbHandle.pCurPos += count;
+		pHandle->lineSize += count;
+		pHandle->pCurPos += count;
 
 		// End the line to be sure
-		(*lbHandle.pCurPos) = '\0';
+		(*pHandle->pCurPos) = '\0';
 	}
 }
 
 /**
  * @brief Process the lineBuffer once validated by user
  */
-static void lb_process_line(void)
+static void lb_process_line(lb_handle_t * pHandle)
 {
 	// Keep the actual display on line n
 	// and move to n+1 to display command's results
 	CLI_PRINTF("\n\r");
 
 	// Execute the command
-	if (lbHandle.lineCallback != NULL) {
-		lbHandle.lineCallback(lbHandle.curLineBuffer, lbHandle.lineSize);
+	if (pHandle->lineCallback != NULL) {
+		pHandle->lineCallback(pHandle->curLineBuffer, pHandle->lineSize);
 	}
 
 	// Save the command into history
-	lb_save_to_history();
+	lb_save_to_history(pHandle);
 }
 
 /**
  * @brief Refresh the line displayed on the terminal
  */
-static void lb_term_update(void)
+static void lb_term_update(lb_handle_t * pHandle)
 {
 	// Do not display prompt on exit
-	if (lbHandle.isExiting) {
+	if (pHandle->isExiting) {
 		return;
 	}
 
@@ -333,7 +316,7 @@ static void lb_term_update(void)
 			   "> %s"       // Print prompt and line
 			   "\x1B[1000D" // Set cursor to begin line
 			   "\x1B[%dC",  // Set cursor to actual position
-			   lbHandle.curLineBuffer, 2 + lb_get_cursor_pos());
+			   pHandle->curLineBuffer, 2 + lb_get_cursor_pos(pHandle));
 }
 
 // ===================
@@ -341,76 +324,82 @@ static void lb_term_update(void)
 // ===================
 
 /**
- * @brief Initialize the module
+ * @brief Initialize a line buffer handle
+ *
+ * @param pHandle The handle to initialize
  */
-void lb_init(void)
+void lb_init(lb_handle_t * pHandle)
 {
 	//DEBUG_ENABLE(ERROR);
 	//DEBUG_ENABLE(INFO);
 
 	// Init handle
-	memset(&lbHandle, 0, sizeof(lbHandle));
-	lbHandle.curLineBuffer = lbHandle.lineBufferTable[0];
-	lbHandle.pCurPos       = lbHandle.curLineBuffer;
+	memset(pHandle, 0, sizeof(*pHandle));
+	pHandle->curLineBuffer = pHandle->lineBufferTable[0];
+	pHandle->pCurPos       = pHandle->curLineBuffer;
 
 	// Display prompt on init
-	lb_term_update();
+	lb_term_update(pHandle);
 }
 
 /**
  * @brief Define the function callback to call when user hit enter
  *
+ * @param pHandle The line buffer handle
  * @param callback Pointer on function, can be NULL to remove callback
  */
-void lb_set_valid_line_callback(lb_line_callback_t callback)
+void lb_set_valid_line_callback(lb_handle_t * pHandle, lb_line_callback_t callback)
 {
-	lbHandle.lineCallback = callback;
+	pHandle->lineCallback = callback;
 }
 
 /**
  * @brief Define the function callback to call when user hit tab
  *
+ * @param pHandle The line buffer handle
  * @param callback Pointer on function, can be NULL to remove callback
  */
-void lb_set_autocomplete_callback(lb_autocomplete_callback_t callback)
+void lb_set_autocomplete_callback(lb_handle_t * pHandle, lb_autocomplete_callback_t callback)
 {
-	lbHandle.autoCompCallback = callback;
+	pHandle->autoCompCallback = callback;
 }
 
 /**
  * @brief Receive incomming byte from user
  *
+ * @param pHandle The line buffer handle
  * @param byte Incomming byte
  */
-void lb_rx(uint8_t byte)
+void lb_rx(lb_handle_t * pHandle, uint8_t byte)
 {
 	//DPRINTF(INFO, "rx: %c (0x%02X)\n\r", byte, byte);
-	if (lbHandle.isExiting) {
+	if (pHandle->isExiting) {
 		return;
-	} else if (lbHandle.isEscaping) {
-		lb_handle_escaped(byte);
+	} else if (pHandle->isEscaping) {
+		lb_handle_escaped(pHandle, byte);
 	} else if (byte == LB_KEY_ESC) {
-		lbHandle.isEscaping = true;
+		pHandle->isEscaping = true;
 	} else if (byte == LB_KEY_TAB) {
-		lb_auto_complete();
+		lb_auto_complete(pHandle);
 	} else if (byte == LB_KEY_ENTER_WIN) {
 		// Ignore this
 	} else if (byte == LB_KEY_ENTER_UNIX) {
-		lb_process_line();
+		lb_process_line(pHandle);
 	} else if ((byte == LB_KEY_BACKSPACE_1) || (byte == LB_KEY_BACKSPACE_2)) {
-		lb_remove_at_cursor();
+		lb_remove_at_cursor(pHandle);
 	} else {
-		lb_insert_at_cursor((char) byte);
+		lb_insert_at_cursor(pHandle, (char) byte);
 	}
-	lb_term_update();
+	lb_term_update(pHandle);
 }
 
 /**
  * @brief Put LineBuffer in exit mode
  * @details No more character will be accepted and
  * the prompt is not displayed anymore
+ * @param pHandle The line buffer handle
  */
-void lb_exit(void)
+void lb_exit(lb_handle_t * pHandle)
 {
-	lbHandle.isExiting = true;
+	pHandle->isExiting = true;
 }
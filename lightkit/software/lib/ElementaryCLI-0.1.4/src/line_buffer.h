@@ -35,14 +35,31 @@
 typedef int (*lb_line_callback_t)(const char * str, uint16_t len);
 typedef uint8_t (*lb_autocomplete_callback_t)(const char * str, uint16_t len, char * outBuffer, uint16_t outBufferMaxLen);
 
+// One handle per terminal: each one keep its own line and history
+typedef struct {
+	char lineBufferTable[LB_HISTORY_COUNT][LB_LINE_BUFFER_LENGTH]; /**< Buffer to store the state of the line */
+
+	uint8_t historyIndex;   /**< The current lineBuffer index under edition, history will be saved here after processing */
+	uint8_t explorerIndex;  /**< Index controlled by user when explorating history */
+	char *  curLineBuffer;  /**< The line currently under edition by user */
+	uint8_t lineSize;       /**< Size of the line (without ending '\0') */
+	char *  pCurPos;        /**< Current position of the cursor */
+	uint8_t escPos : 2;     /**< Current position in the ainsi escaped sequence [0;2] */
+	uint8_t isEscaping : 1; /**< Tell if next bytes will be managed as escaped command */
+	uint8_t isExiting : 1;  /**< Tell if module is in exiting mode */
+
+	lb_line_callback_t         lineCallback;     /**< Function called when user valid a line */
+	lb_autocomplete_callback_t autoCompCallback; /**< Function called when user request an autocompletion */
+} lb_handle_t;
+
 // ======================
 // Protoypes
 // ======================
 
-void lb_init(void);
-void lb_set_valid_line_callback(lb_line_callback_t callback);
-void lb_set_autocomplete_callback(lb_autocomplete_callback_t callback);
-void lb_rx(uint8_t byte);
-void lb_exit(void);
+void lb_init(lb_handle_t * pHandle);
+void lb_set_valid_line_callback(lb_handle_t * pHandle, lb_line_callback_t callback);
+void lb_set_autocomplete_callback(lb_handle_t * pHandle, lb_autocomplete_callback_t callback);
+void lb_rx(lb_handle_t * pHandle, uint8_t byte);
+void lb_exit(lb_handle_t * pHandle);
 
 #endif /* LINE_BUFFER_H */
\ No newline at end of file
@@ -1,53 +1,151 @@
 #include "buzzer.hpp"
+#include "file_sys/file_sys.hpp"
 #include "io/outputs.hpp"
 
 #ifdef MODULE_BUZZER
 
 struct buzzer_t {
-	uint32_t   output;
-	uint8_t    noteIndex;
-	uint32_t   timeout;
-	uint32_t * pMelody;
-	uint32_t   melodyLength;
-	uint8_t    repeat : 1;
-	uint8_t    enabled : 1;
+	uint32_t                     output;
+	uint32_t                     pin; /**< Native pin, PWM buzzers only */
+	uint8_t                      type;
+	const struct buzzer_note_t * pMelody;
+	uint16_t                     melodyLength;
+	uint16_t                     noteIndex;
+	uint32_t                     noteEndTick;
+	uint8_t                      repeat : 1;
+	uint8_t                      enabled : 1;
+	struct buzzer_note_t         fileMelody[BUZZER_FILE_MELODY_MAX_NOTES];
 };
 
 // MACROS
-#define STATE_MASK           0x80000000
-#define STATE_ON             0x80000000
-#define STATE_OF             0x00000000
-#define NOTE(state, delayMs) (state | delayMs)
-#define NOTE(state, delayMs) (state | delayMs)
+#define NOTE_ON(delayMs)  { BUZZER_ON_OFF_FREQ_HZ, delayMs }
+#define NOTE_OFF(delayMs) { 0, delayMs }
 
 // VARIABLES
 extern uint32_t        tick;
-static struct buzzer_t buzzerData[BUZZERS_COUNT] = { 0 };
+static struct buzzer_t buzzerData[BUZZERS_COUNT];
 
-// MELODY - binary
-static uint32_t melody1[] = {
-	NOTE(STATE_ON, 500),
-	NOTE(STATE_OF, 500),
+// MELODY - built-in
+static const struct buzzer_note_t melody1[] = {
+	NOTE_ON(500),
+	NOTE_OFF(500),
 };
-static uint32_t melody2[] = {
-	NOTE(STATE_ON, 500),
-	NOTE(STATE_OF, 1000),
+static const struct buzzer_note_t melody2[] = {
+	NOTE_ON(500),
+	NOTE_OFF(1000),
 };
-static uint32_t melody3[] = {
-	NOTE(STATE_ON, 50),
-	NOTE(STATE_OF, 50),
-	NOTE(STATE_ON, 50),
-	NOTE(STATE_OF, 50),
-	NOTE(STATE_ON, 50),
-	NOTE(STATE_OF, 50),
+static const struct buzzer_note_t melody3[] = {
+	NOTE_ON(50),
+	NOTE_OFF(50),
+	NOTE_ON(50),
+	NOTE_OFF(50),
+	NOTE_ON(50),
+	NOTE_OFF(50),
 };
 
+/**
+ * @brief Make a buzzer sound
+ *
+ * @param i Buzzer index
+ * @param freqHz Frequency of the note, 0 to stop
+ */
+static void buzzer_output(uint8_t i, uint16_t freqHz)
+{
+	if (buzzerData[i].type == BUZZER_TYPE_ON_OFF) {
+		output_set(buzzerData[i].output, freqHz != 0);
+		return;
+	}
+
+#ifdef ESP32
+	ledcWriteTone(BUZZER_LEDC_FIRST_CHANNEL + i, freqHz);
+#else
+	if (freqHz != 0) {
+		tone(buzzerData[i].pin, freqHz);
+	} else {
+		noTone(buzzerData[i].pin);
+	}
+#endif
+}
+
+/**
+ * @brief Load a melody from the filesystem
+ *
+ * @param i Buzzer index
+ * @param melodyId ID of the melody, see BUZZER_FILE_MELODY_PATH
+ * @return 0: OK, -1: No file or no valid note
+ */
+static int buzzer_load_melody(uint8_t i, uint8_t melodyId)
+{
+	char     pathBuffer[sizeof(BUZZER_FILE_MELODY_PATH) + 3];
+	String   path;
+	File     file;
+	uint16_t length = 0;
+
+	snprintf(pathBuffer, sizeof(pathBuffer), BUZZER_FILE_MELODY_PATH, melodyId);
+	path = pathBuffer;
+
+	if (!file_sys_exist(path)) {
+		return -1;
+	}
+
+	file = file_sys_open(path, "r");
+	while (file.available() && (length < BUZZER_FILE_MELODY_MAX_NOTES)) {
+		String   line = file.readStringUntil('\n');
+		unsigned freqHz, durationMs;
+
+		if (line.startsWith("#") || (sscanf(line.c_str(), "%u %u", &freqHz, &durationMs) != 2)) {
+			continue;
+		}
+
+		// A note without duration would never end
+		if ((durationMs == 0) || (durationMs > UINT16_MAX) || (freqHz > UINT16_MAX)) {
+			log_warn("Melody %d: ignored note \"%s\"", melodyId, line.c_str());
+			continue;
+		}
+
+		buzzerData[i].fileMelody[length].freqHz     = freqHz;
+		buzzerData[i].fileMelody[length].durationMs = durationMs;
+		length++;
+	}
+	file.close();
+
+	if (length == 0) {
+		log_error("Melody %d: no valid note in %s", melodyId, pathBuffer);
+		return -1;
+	}
+
+	buzzerData[i].pMelody      = buzzerData[i].fileMelody;
+	buzzerData[i].melodyLength = length;
+	return 0;
+}
+
 int buzzer_init(void)
 {
 	const uint32_t buzzerOutputs[BUZZERS_COUNT] = BUZZERS_OUTPUTS;
+#ifdef BUZZERS_TYPES
+	const uint8_t buzzerTypes[BUZZERS_COUNT] = BUZZERS_TYPES;
+#endif
 
 	for (int i = 0; i < BUZZERS_COUNT; ++i) {
 		buzzerData[i].output = buzzerOutputs[i];
+		buzzerData[i].pin    = output_get_pin(buzzerOutputs[i]);
+		buzzerData[i].type   = BUZZER_TYPE_ON_OFF;
+
+#ifdef BUZZERS_TYPES
+		buzzerData[i].type = buzzerTypes[i];
+		if ((buzzerData[i].type == BUZZER_TYPE_PWM) && !is_io_special_none(buzzerData[i].pin)) {
+			log_warn("Buzzer %d is not on a native pin, PWM disabled", i);
+			buzzerData[i].type = BUZZER_TYPE_ON_OFF;
+		}
+#endif
+
+#ifdef ESP32
+		if (buzzerData[i].type == BUZZER_TYPE_PWM) {
+			ledcSetup(BUZZER_LEDC_FIRST_CHANNEL + i, BUZZER_ON_OFF_FREQ_HZ, 8);
+			ledcAttachPin(buzzerData[i].pin, BUZZER_LEDC_FIRST_CHANNEL + i);
+		}
+#endif
+
 		buzzer_set_melody(i, 0, false);
 	}
 
@@ -59,34 +157,46 @@ void buzzer_stop(uint8_t buzzerId)
 	buzzer_set_melody(buzzerId, 0, false);
 }
 
+/**
+ * @brief Play a melody
+ * @details A melody file on the filesystem takes precedence
+ * over the built-in melody with the same ID
+ *
+ * @param i Buzzer index
+ * @param melodyId 0 to stop, 1-3 built-in, any other from the filesystem
+ * @param isRepeatEnabled Play it again and again
+ * @return 0: OK, -1: Unknown buzzer or melody
+ */
 int buzzer_set_melody(uint8_t i, uint8_t melodyId, bool isRepeatEnabled)
 {
-	if (i > BUZZERS_COUNT) {
+	if (i >= BUZZERS_COUNT) {
 		return -1;
 	}
 	// 0 means stop
 	if (melodyId == 0) {
 		buzzerData[i].enabled = false;
-		output_set(buzzerData[i].output, false);
+		buzzer_output(i, 0);
 		return 0;
 	}
 
 	// Check melody id
-	switch (melodyId) {
-	case 1:
-		buzzerData[i].pMelody      = melody1;
-		buzzerData[i].melodyLength = sizeof(melody1) / sizeof(uint32_t);
-		break;
-	case 2:
-		buzzerData[i].pMelody      = melody2;
-		buzzerData[i].melodyLength = sizeof(melody2) / sizeof(uint32_t);
-		break;
-	case 3:
-		buzzerData[i].pMelody      = melody3;
-		buzzerData[i].melodyLength = sizeof(melody3) / sizeof(uint32_t);
-		break;
-	default:
-		return -1;
+	if (buzzer_load_melody(i, melodyId) != 0) {
+		switch (melodyId) {
+		case 1:
+			buzzerData[i].pMelody      = melody1;
+			buzzerData[i].melodyLength = sizeof(melody1) / sizeof(struct buzzer_note_t);
+			break;
+		case 2:
+			buzzerData[i].pMelody      = melody2;
+			buzzerData[i].melodyLength = sizeof(melody2) / sizeof(struct buzzer_note_t);
+			break;
+		case 3:
+			buzzerData[i].pMelody      = melody3;
+			buzzerData[i].melodyLength = sizeof(melody3) / sizeof(struct buzzer_note_t);
+			break;
+		default:
+			return -1;
+		}
 	}
 
 	// Start at begin
@@ -95,44 +205,56 @@ int buzzer_set_melody(uint8_t i, uint8_t melodyId, bool isRepeatEnabled)
 	buzzerData[i].enabled   = true;
 
 	// Start now
-	buzzerData[i].timeout = 0;
+	buzzerData[i].noteEndTick = tick;
 
 	return 0;
 }
 
+/**
+ * @brief Play the next notes
+ * @details The end of a note is computed from the end of the previous one,
+ * not from the time it was processed, so loop latency does not add up
+ * over the melody. The tone itself is generated by the hardware.
+ */
 void buzzer_main(void)
 {
-	uint32_t note;
+	const struct buzzer_note_t * pNote;
 
 	for (int i = 0; i < BUZZERS_COUNT; ++i) {
 		if (!buzzerData[i].enabled) {
 			continue;
 		}
 
-		if (tick >= buzzerData[i].timeout) {
-			// Check if this was the last
-			if (buzzerData[i].noteIndex >= buzzerData[i].melodyLength) {
-				// Detect end of melody
-				if (buzzerData[i].repeat == false) {
-					buzzer_stop(i);
-					continue;
-				}
-
-				// Restart to begin
-				buzzerData[i].noteIndex = 0;
+		if ((int32_t) (tick - buzzerData[i].noteEndTick) < 0) {
+			continue;
+		}
+
+		// Check if this was the last
+		if (buzzerData[i].noteIndex >= buzzerData[i].melodyLength) {
+			// Detect end of melody
+			if (buzzerData[i].repeat == false) {
+				buzzer_stop(i);
+				continue;
 			}
 
-			// Read note from melody
-			note = buzzerData[i].pMelody[buzzerData[i].noteIndex];
-			++buzzerData[i].noteIndex;
+			// Restart to begin
+			buzzerData[i].noteIndex = 0;
+		}
 
-			// Program note duration
-			buzzerData[i].timeout = tick + (note & ~STATE_MASK);
+		// Read note from melody
+		pNote = &buzzerData[i].pMelody[buzzerData[i].noteIndex];
+		++buzzerData[i].noteIndex;
 
-			// Set state
-			output_set(buzzerData[i].output, (note & STATE_ON) != 0);
+		// Program note end
+		buzzerData[i].noteEndTick += pNote->durationMs;
+
+		// Too late (loop was blocked), start timing again from now
+		if ((int32_t) (tick - buzzerData[i].noteEndTick) >= 0) {
+			buzzerData[i].noteEndTick = tick + pNote->durationMs;
 		}
+
+		buzzer_output(i, pNote->freqHz);
 	}
 }
 
-#endif /* MODULE_BUZZER */
\ No newline at end of file
+#endif /* MODULE_BUZZER */
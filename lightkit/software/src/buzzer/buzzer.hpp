@@ -5,10 +5,25 @@
 
 #ifdef MODULE_BUZZER
 
+/* Buzzer types, see BUZZERS_TYPES */
+#define BUZZER_TYPE_ON_OFF 0 /**< Active buzzer, the output is only switched on and off */
+#define BUZZER_TYPE_PWM    1 /**< Passive buzzer on a native pin, driven at the note frequency */
+
+#define BUZZER_LEDC_FIRST_CHANNEL    8                  /**< ESP32: LEDC channel of the first buzzer */
+#define BUZZER_ON_OFF_FREQ_HZ        2000               /**< Frequency of built-in melodies on PWM buzzers */
+#define BUZZER_FILE_MELODY_MAX_NOTES 64                 /**< Notes of a melody loaded from the filesystem */
+#define BUZZER_FILE_MELODY_PATH      "/melodies/%u.txt" /**< One "<freqHz> <durationMs>" note per line */
+
+/** A note of a melody, freqHz = 0 is a silence */
+struct buzzer_note_t {
+	uint16_t freqHz;
+	uint16_t durationMs;
+};
+
 int  buzzer_init(void);
 void buzzer_stop(uint8_t buzzerId);
 int  buzzer_set_melody(uint8_t buzzerId, uint8_t melodyId, bool isRepeatEnabled);
 void buzzer_main(void);
 
 #endif /* MODULE_BUZZER */
-#endif /* BUZZER_HPP */
\ No newline at end of file
+#endif /* BUZZER_HPP */
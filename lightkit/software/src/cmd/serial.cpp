@@ -11,13 +11,84 @@
 
 #ifdef MODULE_SERIAL
 
-void serial_write(uint8_t * data, uint8_t len)
+// Internal variables
+static uint8_t       serialTxBuffer[SERIAL_TX_BUFFER_SIZE];
+static ring_buffer_t serialTx;
+static bool          isBuffered = false; /**< Set by the first serial_main(), boot logs are written right away */
+
+// ==================
+//  STATIC FUNCTIONS
+// ==================
+
+/**
+ * @brief Give pending bytes to the UART
+ *
+ * @param isBlocking true: wait for all bytes to be taken,
+ * false: only give what the UART FIFO can take right now
+ */
+static void serial_flush_tx(bool isBlocking)
+{
+	uint8_t  chunk[SERIAL_TX_CHUNK_SIZE];
+	uint16_t len;
+	int      room;
+
+	while (!rb_is_empty(&serialTx)) {
+		room = isBlocking ? SERIAL_TX_CHUNK_SIZE : Serial.availableForWrite();
+		if (room <= 0) {
+			break;
+		} else if (room > SERIAL_TX_CHUNK_SIZE) {
+			room = SERIAL_TX_CHUNK_SIZE;
+		}
+
+		len = rb_peek(&serialTx, chunk, room);
+		rb_consume(&serialTx, Serial.write(chunk, len));
+	}
+}
+
+// ==================
+//  FUNCTIONS
+// ==================
+
+/**
+ * @brief Queue data to send on serial, sent by serial_main()
+ * @details Until loop() calls serial_main(), data is written to the UART
+ * right away, so the logs of a failed or crashed setup() are not lost
+ * @note With RB_BLOCK policy, wait for the UART when the queue is full
+ *
+ * @param data Data to send
+ * @param len Length of data
+ */
+void serial_write(uint8_t * data, uint16_t len)
 {
-	Serial.write(data, len);
+	uint16_t written;
+
+	if (!isBuffered) {
+		Serial.write(data, len);
+		return;
+	}
+
+	while (len > 0) {
+		written = rb_write(&serialTx, data, len);
+		data += written;
+		len -= written;
+
+		// Only reached with RB_BLOCK policy
+		if (len > 0) {
+			serial_flush_tx(true);
+		}
+	}
+}
+
+void serial_print_stats(void)
+{
+	log_raw("Serial TX: %u bytes, %u dropped, %u pending\n\r",
+			serialTx.bytesOut, serialTx.bytesDropped, rb_count(&serialTx));
 }
 
 int serial_init(void)
 {
+	rb_init(&serialTx, serialTxBuffer, sizeof(serialTxBuffer), SERIAL_TX_POLICY);
+
 	Serial.begin(115200);
 	Serial.print("\n\r\n\r"); // Jump some lines after internal firmware stuff
 	return 0;
@@ -25,10 +96,14 @@ int serial_init(void)
 
 void serial_main(void)
 {
+	isBuffered = true;
+
 	// Send all we received to the terminal
 	while (Serial.available() > 0) {
-		term_rx(Serial.read());
+		term_rx(TERM_SESSION_SERIAL, Serial.read());
 	}
+
+	serial_flush_tx(false);
 }
 
 #endif /* MODULE_SERIAL */
@@ -10,7 +10,14 @@
 
 #include <Arduino.h>
 
-void serial_write(uint8_t * data, uint8_t len);
+#include "tools/ring_buffer.hpp"
+
+#define SERIAL_TX_BUFFER_SIZE 1024     /**< Bytes waiting to be sent on serial */
+#define SERIAL_TX_CHUNK_SIZE  128      /**< Bytes given to the UART at once */
+#define SERIAL_TX_POLICY      RB_BLOCK /**< Keep all logs, even if it slows down the loop */
+
+void serial_write(uint8_t * data, uint16_t len);
+void serial_print_stats(void);
 int  serial_init(void);
 void serial_main(void);
 
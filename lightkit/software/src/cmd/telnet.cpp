@@ -18,78 +18,217 @@ typedef enum
 	ESC_WAIT_SUB_COMMAND /**< Wait for the telnet sub-command to follow */
 } escape_state_e;
 
+/** A connected telnet client */
+typedef struct {
+	WiFiClient     client;        /**< TCP connection of the client */
+	escape_state_e escapingState; /**< Telnet commands filter state */
+	ring_buffer_t  tx;            /**< Bytes waiting to be sent to the client */
+	uint8_t        txBuffer[TELNET_TX_BUFFER_SIZE];
+} telnet_client_t;
+
 // Internal variables
-WiFiServer     telnetServer(TELNET_PORT);
-WiFiClient     telnetClient;
-escape_state_e escapingState;
+WiFiServer      telnetServer(TELNET_PORT);
+telnet_client_t telnetClients[TELNET_MAX_CLIENTS];
+static uint8_t  txSegment[TELNET_TX_MTU]; /**< Coalesced bytes given to TCP at once */
 
 // ==================
-//  FUNCTIONS
+//  STATIC FUNCTIONS
 // ==================
 
-void telnet_write(uint8_t * data, uint8_t len)
-{
-	if (telnetClient.connected()) {
-		telnetClient.write(data, len);
-	}
-}
-
-int telnet_init(void)
+/**
+ * @brief Accept a waiting client on the first free slot
+ * @note The client is rejected if all slots are used
+ */
+static void telnet_accept_client(void)
 {
-	escapingState = ESC_IDDLE;
+	WiFiClient newClient = telnetServer.available();
 
-	telnetServer.begin();
-	telnetServer.setNoDelay(true);
-	return 0;
-}
+	for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; ++i) {
+		telnet_client_t * pClient = &telnetClients[i];
 
-void telnet_main(void)
-{
-	uint8_t byte;
+		if (pClient->client && pClient->client.connected()) {
+			continue;
+		}
 
-	// Take the waiting client as active if none is currently handled
-	if (telnetServer.hasClient()) {
-		if (!telnetClient || !telnetClient.connected()) {
-			if (telnetClient) {
-				telnetClient.stop();
-			}
-			telnetClient = telnetServer.available();
-			telnetClient.flush();
+		// Free the slot from a previous connection
+		if (pClient->client) {
+			pClient->client.stop();
 		}
+		pClient->client        = newClient;
+		pClient->escapingState = ESC_IDDLE;
+		pClient->client.flush();
+		rb_clear(&pClient->tx);
+
+		// Give a fresh line buffer to the newcomer
+		term_session_open(TERM_SESSION_TELNET_0 + i);
+		return;
 	}
 
+	newClient.print("Too many telnet sessions, try again later\r\n");
+	newClient.stop();
+}
+
+/**
+ * @brief Read the data of a client and send it to its terminal session
+ *
+ * @param clientId Index of the client
+ */
+static void telnet_read_client(uint8_t clientId)
+{
+	telnet_client_t * pClient = &telnetClients[clientId];
+	uint8_t           byte;
+
 	// Read Data from client and send it to terminal
-	while (telnetClient.available()) {
-		byte = telnetClient.read();
+	while (pClient->client.available()) {
+		byte = pClient->client.read();
 
 		// Filter out telnet commands
-		switch (escapingState) {
+		switch (pClient->escapingState) {
 		case ESC_IDDLE:
 			if (byte == 0xFF) {
-				escapingState = ESC_WAIT_COMMAND;
+				pClient->escapingState = ESC_WAIT_COMMAND;
 				continue;
 			}
 			break;
 		case ESC_WAIT_COMMAND:
 			// See TELNET COMMAND STRUCTURE from RFC 854
 			if ((byte >= 0xF0) && (byte < 0xFF)) {
-				escapingState = ESC_WAIT_SUB_COMMAND;
+				pClient->escapingState = ESC_WAIT_SUB_COMMAND;
 				continue;
 			} else {
 				// Was not an escape sequence, oups, manage byte normally
-				escapingState = ESC_IDDLE;
+				pClient->escapingState = ESC_IDDLE;
 			}
 			break;
 		case ESC_WAIT_SUB_COMMAND:
 		default:
 			// Ignore params
-			escapingState = ESC_IDDLE;
+			pClient->escapingState = ESC_IDDLE;
 			continue;
 		}
 
 		// Manage the byte if not an escape sequence
-		term_rx(byte);
+		term_rx(TERM_SESSION_TELNET_0 + clientId, byte);
 	}
 }
 
-#endif
\ No newline at end of file
+/**
+ * @brief Send pending bytes of a client as MTU sized segments
+ * @note Only send what TCP can take right now, the rest waits for next call
+ *
+ * @param clientId Index of the client
+ */
+static void telnet_flush_client(uint8_t clientId)
+{
+	telnet_client_t * pClient = &telnetClients[clientId];
+	uint16_t          len;
+	int               room;
+
+	if (rb_is_empty(&pClient->tx)) {
+		return;
+	}
+
+	// Nobody to send to anymore
+	if (!pClient->client.connected()) {
+		rb_clear(&pClient->tx);
+		return;
+	}
+
+	while (!rb_is_empty(&pClient->tx)) {
+		room = pClient->client.availableForWrite();
+		if (room <= 0) {
+			break;
+		} else if (room > TELNET_TX_MTU) {
+			room = TELNET_TX_MTU;
+		}
+
+		len = rb_peek(&pClient->tx, txSegment, room);
+		len = pClient->client.write(txSegment, len);
+		if (len == 0) {
+			break;
+		}
+		rb_consume(&pClient->tx, len);
+	}
+}
+
+// ==================
+//  FUNCTIONS
+// ==================
+
+bool telnet_is_connected(uint8_t clientId)
+{
+	if (clientId >= TELNET_MAX_CLIENTS) {
+		return false;
+	}
+	return telnetClients[clientId].client.connected();
+}
+
+/**
+ * @brief Queue data to send to a client, sent by telnet_main()
+ * @note With RB_BLOCK policy, wait for the client when the queue is full
+ *
+ * @param clientId Index of the client
+ * @param data Data to send
+ * @param len Length of data
+ */
+void telnet_write(uint8_t clientId, uint8_t * data, uint16_t len)
+{
+	ring_buffer_t * pTx;
+	uint16_t        written;
+
+	if (!telnet_is_connected(clientId)) {
+		return;
+	}
+
+	pTx = &telnetClients[clientId].tx;
+	while (len > 0) {
+		written = rb_write(pTx, data, len);
+		data += written;
+		len -= written;
+
+		// Only reached with RB_BLOCK policy
+		if (len > 0) {
+			telnet_flush_client(clientId);
+			if (!telnet_is_connected(clientId)) {
+				return;
+			}
+			yield();
+		}
+	}
+}
+
+void telnet_print_stats(void)
+{
+	for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; ++i) {
+		ring_buffer_t * pTx = &telnetClients[i].tx;
+
+		log_raw("Telnet TX #%d: %u bytes, %u dropped, %u pending\n\r",
+				i, pTx->bytesOut, pTx->bytesDropped, rb_count(pTx));
+	}
+}
+
+int telnet_init(void)
+{
+	for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; ++i) {
+		telnetClients[i].escapingState = ESC_IDDLE;
+		rb_init(&telnetClients[i].tx, telnetClients[i].txBuffer, TELNET_TX_BUFFER_SIZE, TELNET_TX_POLICY);
+	}
+
+	telnetServer.begin();
+	telnetServer.setNoDelay(true);
+	return 0;
+}
+
+void telnet_main(void)
+{
+	if (telnetServer.hasClient()) {
+		telnet_accept_client();
+	}
+
+	for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; ++i) {
+		telnet_read_client(i);
+		telnet_flush_client(i);
+	}
+}
+
+#endif
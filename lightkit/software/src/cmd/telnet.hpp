@@ -10,9 +10,17 @@
 
 #include <Arduino.h>
 
-#define TELNET_PORT 23
+#include "tools/ring_buffer.hpp"
 
-void telnet_write(uint8_t * data, uint8_t len);
+#define TELNET_PORT           23
+#define TELNET_MAX_CLIENTS    2              /**< Number of simultaneous telnet sessions */
+#define TELNET_TX_BUFFER_SIZE 1024           /**< Bytes waiting to be sent, per client */
+#define TELNET_TX_MTU         536            /**< Biggest segment given to TCP (lwIP default MSS) */
+#define TELNET_TX_POLICY      RB_DROP_OLDEST /**< A slow client must not stall the loop */
+
+bool telnet_is_connected(uint8_t clientId);
+void telnet_write(uint8_t clientId, uint8_t * data, uint16_t len);
+void telnet_print_stats(void);
 int  telnet_init(void);
 void telnet_main(void);
 
@@ -11,7 +11,12 @@
 #include "global.hpp"
 #include "relay/relay.hpp"
 #include "serial.hpp"
+#include "telegram/telegram.hpp"
+#include "telegram/telegram_chat.hpp"
 #include "telnet.hpp"
+#include "temp/temp_history.hpp"
+#include "file_sys/file_sys.hpp"
+#include "io/inputs.hpp"
 #include "wifi/wifi.hpp"
 
 extern "C" {
@@ -20,6 +25,10 @@ extern "C" {
 
 #ifdef MODULE_TERM
 
+// Internal variables
+static cli_session sessions[TERM_SESSION_COUNT]; /**< Line buffer and history of each session */
+static uint8_t     activeSession;                /**< Session currently processing a command */
+
 //========================
 //	  STATIC FUNCTIONS
 //========================
@@ -41,6 +50,26 @@ int print_args(uint8_t argc, char * argv[])
 	return 0;
 }
 
+/**
+ * @brief Send data to a session
+ *
+ * @param sessionId The destination session
+ * @param data Data to send
+ * @param len Length of data
+ */
+static void term_write(uint8_t sessionId, uint8_t * data, uint16_t len)
+{
+	if (sessionId == TERM_SESSION_SERIAL) {
+#ifdef MODULE_SERIAL
+		serial_write(data, len);
+#endif
+	} else {
+#ifdef MODULE_TELNET
+		telnet_write(sessionId - TERM_SESSION_TELNET_0, data, len);
+#endif
+	}
+}
+
 // GENERIC TOOLS
 
 /**
@@ -100,6 +129,25 @@ static int call_print_status(uint8_t argc, char * argv[])
 	return 0;
 }
 
+static int call_print_term_stats(uint8_t argc, char * argv[])
+{
+#ifdef MODULE_SERIAL
+	serial_print_stats();
+#endif
+#ifdef MODULE_TELNET
+	telnet_print_stats();
+#endif
+	return 0;
+}
+
+#ifdef HAS_IOI2C_BOARD
+static int call_print_ioi2c_stats(uint8_t argc, char * argv[])
+{
+	inputs_print_ioi2c_stats();
+	return 0;
+}
+#endif
+
 static int call_flash_setting_reset(uint8_t argc, char * argv[])
 {
 	return cmd_flash_setting_reset();
@@ -162,15 +210,91 @@ static int call_stripled_set_anim(uint8_t argc, char * argv[])
 static int call_relay_set_state(uint8_t argc, char * argv[])
 {
 	int  ret;
+	int  index = (argc > 1) ? atoi(argv[1]) : RELAY_MAIN;
 	bool flag;
 
-	flag = relay_get_state();
-	ret  = call_set_bool(&flag, argc, argv);
+	if ((index < 0) || (index >= RELAY_COUNT)) {
+		term_print("Bad relay index: " + String(argv[1]));
+		return -1;
+	}
+
+	flag = relay_get_state(index);
+	ret  = parse_bool(&flag, argv[0]);
 	if (ret == 0) {
-		relay_set_state(flag);
+		relay_set_state(index, flag);
 	}
 	return ret;
 }
+
+static int call_relay_print_stats(uint8_t argc, char * argv[])
+{
+	relay_print_stats();
+	return 0;
+}
+#endif
+
+#ifdef MODULE_TEMPERATURE
+static int call_temp_print_history(uint8_t argc, char * argv[])
+{
+	int sensorIndex = atoi(argv[0]);
+	int level       = temp_history_parse_level(argv[1]);
+
+	if ((sensorIndex < 0) || (sensorIndex >= TEMP_HISTORY_SENSOR_COUNT)) {
+		term_print("Bad sensor index: " + String(argv[0]));
+		return -1;
+	}
+	if (level < 0) {
+		term_print("Unknown argument: " + String(argv[1]));
+		return -1;
+	}
+
+	term_print("minutes_ago;degrees\n\r");
+	term_print(temp_history_to_csv(sensorIndex, level, "\n\r"));
+	return 0;
+}
+#endif
+
+#ifdef MODULE_TELEGRAM
+static int call_telegram_print_stats(uint8_t argc, char * argv[])
+{
+	telegram_print_stats();
+	return 0;
+}
+
+static int call_telegram_chat_list(uint8_t argc, char * argv[])
+{
+	telegram_chat_print();
+	return 0;
+}
+
+static int call_telegram_chat_add(uint8_t argc, char * argv[])
+{
+	int64_t id   = strtoll(argv[0], NULL, 10);
+	int     role = telegram_chat_parse_role(argv[1]);
+
+	if (id == 0) {
+		term_print("Bad chat id: " + String(argv[0]));
+		return -1;
+	}
+	if (role < 0) {
+		term_print("Unknown role: " + String(argv[1]));
+		return -1;
+	}
+	if (telegram_chat_add(id, role) < 0) {
+		term_print("Chat list is full");
+		return -1;
+	}
+	return 0;
+}
+
+static int call_telegram_chat_del(uint8_t argc, char * argv[])
+{
+	if (telegram_chat_remove(strtoll(argv[0], NULL, 10)) != 0) {
+		term_print("Unknown chat: " + String(argv[0]));
+		return -1;
+	}
+	return 0;
+}
 #endif
 
 #ifdef MODULE_STATUS_LED
@@ -419,6 +543,225 @@ static int call_wifi_use_new_settings(uint8_t argc, char * argv[])
 	return ret;
 }
 
+// ===============
+// BATCH
+// ===============
+
+static char          batchBuffer[TERM_BATCH_BUFFER_SIZE]; /**< Lines of the batch, separated by '\n' */
+static uint16_t      batchLen;                            /**< Number of bytes used in batchBuffer */
+static uint8_t       batchSession;                        /**< Session recording a batch, TERM_SESSION_NONE if none */
+static bool          isBatchRunning;                      /**< Prevent batches from running batches */
+static wifi_handle_t batchWifiBackup;                     /**< Wifi settings under edition when the batch started */
+
+/**
+ * @brief Check that every line of batchBuffer fits in the CLI
+ * @details The CLI would silently cut a longer line and still run it
+ *
+ * @return 0: OK, else the number of the first line too long
+ */
+static uint16_t term_batch_check(void)
+{
+	const char * line = batchBuffer;
+	const char * end;
+	uint16_t     lineNumber;
+	uint16_t     lineLen;
+
+	for (lineNumber = 1; line != NULL; ++lineNumber, line = (end != NULL) ? (end + 1) : NULL) {
+		end     = strchr(line, '\n');
+		lineLen = (end != NULL) ? (end - line) : strlen(line);
+
+		// Same trimming as term_batch_run()
+		if ((lineLen > 0) && (line[lineLen - 1] == '\r')) {
+			--lineLen;
+		}
+		while ((lineLen > 0) && (*line == ' ')) {
+			++line;
+			--lineLen;
+		}
+		if (lineLen >= CLI_CMD_MAX_LEN) {
+			return lineNumber;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Execute all the lines of batchBuffer in a row
+ * @details Nothing is run if a line is too long. Stop on the first
+ * failing line: the wifi settings edited by the batch so far are
+ * discarded, as they are only staged until "wifi save". Other
+ * commands already ran are not undone.
+ * @note Empty lines and lines starting with '#' are skipped
+ *
+ * @return 0: all lines succeeded, else the result of the failing line
+ */
+static int term_batch_run(void)
+{
+	char *   line     = batchBuffer;
+	char *   nextLine = NULL;
+	uint16_t lineNumber;
+	uint16_t lineLen;
+	uint16_t okCount = 0;
+	int      ret     = 0;
+
+	batchBuffer[batchLen] = '\0';
+	batchLen              = 0;
+
+	lineNumber = term_batch_check();
+	if (lineNumber != 0) {
+		log_raw("Batch aborted: line %u is longer than %d characters, nothing was run\n\r", lineNumber, CLI_CMD_MAX_LEN - 1);
+		return -1;
+	}
+
+	isBatchRunning = true;
+	memcpy(&batchWifiBackup, &wifiHandleTmp, sizeof(batchWifiBackup));
+
+	for (lineNumber = 1; line != NULL; ++lineNumber, line = nextLine) {
+		// Cut the line
+		nextLine = strchr(line, '\n');
+		if (nextLine != NULL) {
+			*nextLine++ = '\0';
+		}
+
+		// Remove Windows line ending and leading spaces
+		lineLen = strlen(line);
+		if ((lineLen > 0) && (line[lineLen - 1] == '\r')) {
+			line[--lineLen] = '\0';
+		}
+		while (*line == ' ') {
+			++line;
+			--lineLen;
+		}
+		if ((lineLen == 0) || (*line == '#')) {
+			continue;
+		}
+
+		log_raw("[%u] %s\n\r", lineNumber, line);
+		ret = cli_execute_lb(line, lineLen);
+		if (ret != 0) {
+			break;
+		}
+		++okCount;
+	}
+
+	if (ret == 0) {
+		log_raw("Batch done: %u command(s) OK\n\r", okCount);
+	} else {
+		memcpy(&wifiHandleTmp, &batchWifiBackup, sizeof(wifiHandleTmp));
+		log_raw("Batch aborted: line %u failed (%d), %u command(s) OK before\n\r", lineNumber, ret, okCount);
+	}
+
+	isBatchRunning = false;
+	return ret;
+}
+
+/**
+ * @brief Tell if a line is the given command, ignoring surrounding spaces
+ *
+ * @param str The line
+ * @param cmd The command to look for
+ * @return boolean
+ */
+static bool term_is_line(const char * str, const char * cmd)
+{
+	uint16_t cmdLen = strlen(cmd);
+
+	str += strspn(str, " ");
+	if (strncmp(str, cmd, cmdLen) != 0) {
+		return false;
+	}
+	str += cmdLen;
+	return str[strspn(str, " ")] == '\0';
+}
+
+/**
+ * @brief Line callback of the sessions
+ * @details Record lines while the session is in batch mode,
+ * else execute them immediately
+ * @see lb_line_callback_t
+ *
+ * @param str The line
+ * @param len The length of the line
+ * @return The result of the command
+ */
+static int term_line_callback(const char * str, uint16_t len)
+{
+	if ((batchSession == TERM_SESSION_NONE) || (batchSession != activeSession)) {
+		return cli_execute_lb(str, len);
+	}
+
+	if (term_is_line(str, "batch end")) {
+		batchSession = TERM_SESSION_NONE;
+		return term_batch_run();
+	} else if (term_is_line(str, "batch cancel")) {
+		batchSession = TERM_SESSION_NONE;
+		batchLen     = 0;
+		log_raw("Batch canceled\n\r");
+		return 0;
+	}
+
+	// Keep room for '\n' and the final '\0'
+	if ((batchLen + len + 2) > TERM_BATCH_BUFFER_SIZE) {
+		batchSession = TERM_SESSION_NONE;
+		batchLen     = 0;
+		log_raw("Batch is too long (TERM_BATCH_BUFFER_SIZE = %d), canceled\n\r", TERM_BATCH_BUFFER_SIZE);
+		return -1;
+	}
+
+	memcpy(&batchBuffer[batchLen], str, len);
+	batchLen += len;
+	batchBuffer[batchLen++] = '\n';
+	return 0;
+}
+
+static int call_batch_begin(uint8_t argc, char * argv[])
+{
+	if (isBatchRunning || (batchSession != TERM_SESSION_NONE)) {
+		term_print("A batch is already in progress\n\r");
+		return -1;
+	}
+
+	batchSession = activeSession;
+	batchLen     = 0;
+	term_print("Recording batch, finish with \"batch end\" or \"batch cancel\"\n\r");
+	return 0;
+}
+
+static int call_batch_end(uint8_t argc, char * argv[])
+{
+	// Only reached when not recording, see term_line_callback()
+	term_print("No batch in progress, start one with \"batch begin\"\n\r");
+	return -1;
+}
+
+static int call_batch_run_file(uint8_t argc, char * argv[])
+{
+	String path = argv[0];
+	File   file;
+
+	if (isBatchRunning || (batchSession != TERM_SESSION_NONE)) {
+		term_print("A batch is already in progress\n\r");
+		return -1;
+	}
+
+	if (!file_sys_exist(path)) {
+		term_print("File not found: " + path + "\n\r");
+		return -1;
+	}
+
+	file = file_sys_open(path, "r");
+	if (file.size() >= TERM_BATCH_BUFFER_SIZE) {
+		log_raw("Batch file is too long (TERM_BATCH_BUFFER_SIZE = %d)\n\r", TERM_BATCH_BUFFER_SIZE);
+		file.close();
+		return -1;
+	}
+	batchLen = file.read((uint8_t *) batchBuffer, TERM_BATCH_BUFFER_SIZE - 1);
+	file.close();
+
+	return term_batch_run();
+}
+
 /**
  * @brief Create the command line interface
  */
@@ -438,6 +781,16 @@ static int term_create_cli_commands(void)
 		curTok = cli_add_token("status", "Print current status");
 		cli_set_callback(curTok, &call_print_status);
 		cli_add_children(tokLvl1, curTok);
+
+		curTok = cli_add_token("term", "Print terminal output statistics");
+		cli_set_callback(curTok, &call_print_term_stats);
+		cli_add_children(tokLvl1, curTok);
+
+#ifdef HAS_IOI2C_BOARD
+		curTok = cli_add_token("ioi2c", "Print IOI2C bus statistics");
+		cli_set_callback(curTok, &call_print_ioi2c_stats);
+		cli_add_children(tokLvl1, curTok);
+#endif
 	}
 	cli_add_children(tokRoot, tokLvl1);
 
@@ -478,10 +831,53 @@ static int term_create_cli_commands(void)
 #ifdef MODULE_RELAY
 	tokLvl1 = cli_add_token("relay", "Manage relay");
 	{
-		curTok = cli_add_token("set", "[on|off|toggle] Set the relay state");
+		curTok = cli_add_token("set", "[on|off|toggle] <index> Set the relay state");
 		cli_set_callback(curTok, &call_relay_set_state);
-		cli_set_argc(curTok, 1, 0);
+		cli_set_argc(curTok, 1, 1);
+		cli_add_children(tokLvl1, curTok);
+
+		curTok = cli_add_token("stats", "Print switch times and failures");
+		cli_set_callback(curTok, &call_relay_print_stats);
+		cli_add_children(tokLvl1, curTok);
+	}
+	cli_add_children(tokRoot, tokLvl1);
+#endif
+
+#ifdef MODULE_TEMPERATURE
+	tokLvl1 = cli_add_token("temp", "Manage temperature sensors");
+	{
+		curTok = cli_add_token("history", "<sensor> <raw|5min|hour> Print the history as CSV");
+		cli_set_callback(curTok, &call_temp_print_history);
+		cli_set_argc(curTok, 2, 0);
+		cli_add_children(tokLvl1, curTok);
+	}
+	cli_add_children(tokRoot, tokLvl1);
+#endif
+
+#ifdef MODULE_TELEGRAM
+	tokLvl1 = cli_add_token("tg", "Manage Telegram");
+	{
+		curTok = cli_add_token("stats", "Print connection statistics");
+		cli_set_callback(curTok, &call_telegram_print_stats);
 		cli_add_children(tokLvl1, curTok);
+
+		tokLvl2 = cli_add_token("chat", "Chats allowed to talk to the bot");
+		{
+			curTok = cli_add_token("list", "Print the chats and their role");
+			cli_set_callback(curTok, &call_telegram_chat_list);
+			cli_add_children(tokLvl2, curTok);
+
+			curTok = cli_add_token("add", "<id> <viewer|operator> Add a chat or change its role");
+			cli_set_callback(curTok, &call_telegram_chat_add);
+			cli_set_argc(curTok, 2, 0);
+			cli_add_children(tokLvl2, curTok);
+
+			curTok = cli_add_token("del", "<id> Remove a chat");
+			cli_set_callback(curTok, &call_telegram_chat_del);
+			cli_set_argc(curTok, 1, 0);
+			cli_add_children(tokLvl2, curTok);
+		}
+		cli_add_children(tokLvl1, tokLvl2);
 	}
 	cli_add_children(tokRoot, tokLvl1);
 #endif
@@ -615,6 +1011,27 @@ static int term_create_cli_commands(void)
 		cli_add_children(tokLvl1, curTok);
 	}
 	cli_add_children(tokRoot, tokLvl1);
+
+	tokLvl1 = cli_add_token("batch", "Run several commands in a row");
+	{
+		curTok = cli_add_token("begin", "Record next lines until \"batch end\"");
+		cli_set_callback(curTok, &call_batch_begin);
+		cli_add_children(tokLvl1, curTok);
+
+		curTok = cli_add_token("end", "Run recorded lines, stop on first error");
+		cli_set_callback(curTok, &call_batch_end);
+		cli_add_children(tokLvl1, curTok);
+
+		curTok = cli_add_token("cancel", "Forget recorded lines");
+		cli_set_callback(curTok, &call_batch_end);
+		cli_add_children(tokLvl1, curTok);
+
+		curTok = cli_add_token("run", "<path> Run lines of a file");
+		cli_set_callback(curTok, &call_batch_run_file);
+		cli_set_argc(curTok, 1, 0);
+		cli_add_children(tokLvl1, curTok);
+	}
+	cli_add_children(tokRoot, tokLvl1);
 	return 0;
 }
 
@@ -624,27 +1041,88 @@ static int term_create_cli_commands(void)
 
 int term_init(void)
 {
+	activeSession = TERM_SESSION_NONE;
+	batchSession  = TERM_SESSION_NONE;
+
 	cli_init();
 	term_create_cli_commands();
+
+#ifdef MODULE_SERIAL
+	term_session_open(TERM_SESSION_SERIAL);
+#endif
 	return 0;
 }
 
-void term_rx(uint8_t byte)
+/**
+ * @brief (Re)Start a session with an empty line buffer and history
+ *
+ * @param sessionId The session to open
+ */
+void term_session_open(uint8_t sessionId)
+{
+	if (sessionId >= TERM_SESSION_COUNT) {
+		return;
+	}
+
+	// A new user can't end the batch of the previous one
+	if (batchSession == sessionId) {
+		batchSession = TERM_SESSION_NONE;
+	}
+
+	// The prompt is printed on the opened session only
+	activeSession = sessionId;
+	cli_session_init(&sessions[sessionId]);
+	lb_set_valid_line_callback(&sessions[sessionId], &term_line_callback);
+	activeSession = TERM_SESSION_NONE;
+}
+
+/**
+ * @brief Give a byte received from a session to the CLI
+ *
+ * @param sessionId The session sending the byte
+ * @param byte The received byte
+ */
+void term_rx(uint8_t sessionId, uint8_t byte)
 {
-	cli_rx(byte);
+	if (sessionId >= TERM_SESSION_COUNT) {
+		return;
+	}
+
+	// Everything printed while processing the byte goes back to this session
+	activeSession = sessionId;
+	cli_rx(&sessions[sessionId], byte);
+	activeSession = TERM_SESSION_NONE;
 }
 
+/**
+ * @brief Print a string on the session currently processing a command
+ * @note Broadcast the string when no session is active
+ *
+ * @param str The string to print
+ */
 void term_print(String str)
 {
-	uint32_t  len  = str.length();
+	if (activeSession == TERM_SESSION_NONE) {
+		term_broadcast(str);
+		return;
+	}
+
+	term_write(activeSession, (uint8_t *) str.c_str(), str.length());
+}
+
+/**
+ * @brief Print a string on all the sessions
+ *
+ * @param str The string to print
+ */
+void term_broadcast(String str)
+{
+	uint16_t  len  = str.length();
 	uint8_t * data = (uint8_t *) str.c_str();
 
-#ifdef MODULE_SERIAL
-	serial_write(data, len);
-#endif
-#ifdef MODULE_TELNET
-	telnet_write(data, len);
-#endif
+	for (uint8_t i = 0; i < TERM_SESSION_COUNT; ++i) {
+		term_write(i, data, len);
+	}
 }
 
-#endif /* MODULE_TERM */
\ No newline at end of file
+#endif /* MODULE_TERM */
@@ -10,8 +10,20 @@
 
 #include <Arduino.h>
 
-void term_rx(uint8_t byte);
+#include "telnet.hpp"
+
+// Terminal sessions: one for serial and one per telnet client
+#define TERM_SESSION_SERIAL   0
+#define TERM_SESSION_TELNET_0 1
+#define TERM_SESSION_COUNT    (TERM_SESSION_TELNET_0 + TELNET_MAX_CLIENTS)
+#define TERM_SESSION_NONE     0xFF
+
+#define TERM_BATCH_BUFFER_SIZE 1024 /**< Maximum size of a batch script */
+
+void term_session_open(uint8_t sessionId);
+void term_rx(uint8_t sessionId, uint8_t byte);
 void term_print(String str);
+void term_broadcast(String str);
 int  term_init(void);
 
 #endif /* CMD_TERM_HPP */
\ No newline at end of file
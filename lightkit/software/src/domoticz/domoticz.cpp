@@ -6,50 +6,313 @@
   */
 
 #include "domoticz.hpp"
+#include "event/event.hpp"
 #include "global.hpp"
 #include "status_led/status_led.hpp"
 
 #ifdef MODULE_DOMOTICZ
 
-#include <ESP8266HTTPClient.h>
+#ifdef ESP32
+#include <WiFi.h>
+#else
+#include <ESP8266WiFi.h>
+#endif
+
+/**
+ * Requests are sent one after the other on a kept-alive connection,
+ * the reply is read a few bytes each tick so nothing waits for the server
+ */
+enum domoticz_state_e {
+	DOMOTICZ_STATE_IDLE = 0,    /**< Waiting for a value to send */
+	DOMOTICZ_STATE_STATUS_LINE, /**< Request is sent, waiting for "HTTP/1.1 200 OK" */
+	DOMOTICZ_STATE_HEADERS,     /**< Reading headers until the empty line */
+	DOMOTICZ_STATE_BODY         /**< Skipping the body */
+};
 
-HTTPClient http;
+// Structures
+struct domoticz_value_t {
+	uint8_t sensorID; /**< Domoticz device */
+	float   value;
+};
 
-uint8_t domoticz_send(String url)
+// Variables
+extern uint32_t                tick;
+static WiFiClient              client;
+static uint8_t                 domoticzState = DOMOTICZ_STATE_IDLE;
+static struct domoticz_value_t queue[DOMOTICZ_QUEUE_SIZE];
+static uint8_t                 queueHead   = 0; /**< Oldest value, the one being sent */
+static uint8_t                 queueCount  = 0;
+static uint32_t                nextTryTick = 0;
+static uint8_t                 failCount   = 0; /**< Failures in a row, for the back-off */
+static uint32_t                replyEndTick;    /**< Reply must be complete before this tick */
+static char                    line[DOMOTICZ_LINE_SIZE];
+static uint8_t                 lineLength;
+static int                     httpCode;
+static int32_t                 bodyLeft;     /**< Bytes of body still to read, -1 until the connection is closed */
+static bool                    isKeepAlive;  /**< Server keeps the connection open after the reply */
+static bool                    isReusedConn; /**< Request was sent on the connection of a previous one */
+
+/**
+ * @brief Queue a value, or update it if the device is already queued
+ *
+ * @param sensorID Domoticz device
+ * @param value The value
+ */
+static void domoticz_queue_value(uint8_t sensorID, float value)
 {
+	struct domoticz_value_t * pValue;
+
+	// Only the newest value matters when we are late
+	// The oldest one is skipped when it is in flight
+	for (uint8_t i = (domoticzState == DOMOTICZ_STATE_IDLE) ? 0 : 1; i < queueCount; i++) {
+		pValue = &queue[(queueHead + i) % DOMOTICZ_QUEUE_SIZE];
+		if (pValue->sensorID == sensorID) {
+			pValue->value = value;
+			return;
+		}
+	}
+
+	if (queueCount >= DOMOTICZ_QUEUE_SIZE) {
+		log_warn("Domoticz queue is full, oldest value is dropped");
+		queueHead = (queueHead + 1) % DOMOTICZ_QUEUE_SIZE;
+		queueCount--;
+		// The dropped one may be in flight, forget its reply
+		if (domoticzState != DOMOTICZ_STATE_IDLE) {
+			client.stop();
+			domoticzState = DOMOTICZ_STATE_IDLE;
+		}
+	}
+
+	pValue           = &queue[(queueHead + queueCount) % DOMOTICZ_QUEUE_SIZE];
+	pValue->sensorID = sensorID;
+	pValue->value    = value;
+	queueCount++;
+}
+
+/**
+ * @brief Send the request of the oldest value
+ *
+ * @return 0: OK, -1: Unable to connect
+ */
+static int domoticz_send_request(void)
+{
+	struct domoticz_value_t * pValue = &queue[queueHead];
+	String                    request;
+
+	isReusedConn = client.connected();
+	if (!isReusedConn) {
+		client.stop();
+		client.setTimeout(DOMOTICZ_CONNECT_TIMEOUT_MS);
+		if (!client.connect(DOMOTICZ_HOST, DOMOTICZ_PORT)) {
+			log_error("Unable to connect to Domoticz");
+			return -1;
+		}
+		client.setNoDelay(true);
+	}
+
 #ifdef MODULE_STATUS_LED
 	// Force led to blue until next status_led_main() call
 	status_led_set_color('b');
 #endif
-	http.begin(DOMOTICZ_HOST, DOMOTICZ_PORT, url);
-	http.setTimeout(DOMOTICZ_TIMEOUT_MS);
-	int httpCode = http.GET();
-	http.end();
+
+	// Format JSON à respecter pour l'API Domoticz - Domoticz JSON API
+	// /json.htm?type=command&param=udevice&idx=IDX&nvalue=0&svalue=TEMP
+	// https://www.domoticz.com/wiki/Domoticz_API/JSON_URL%27s#Temperature
+	request = "GET /json.htm?type=command&param=udevice&idx=";
+	request += String(pValue->sensorID);
+	request += "&nvalue=0&svalue=";
+	request += String(pValue->value);
+	request += " HTTP/1.1\r\nHost: " DOMOTICZ_HOST "\r\nConnection: keep-alive\r\n\r\n";
+	client.print(request);
+
+	lineLength    = 0;
+	replyEndTick  = tick + DOMOTICZ_TIMEOUT_MS;
+	domoticzState = DOMOTICZ_STATE_STATUS_LINE;
+
+	return 0;
+}
+
+/**
+ * @brief The request failed, try again later
+ */
+static void domoticz_retry_later(void)
+{
+	uint32_t retryDelay = DOMOTICZ_RETRY_MIN_MS;
+
+	client.stop();
+	domoticzState = DOMOTICZ_STATE_IDLE;
+	_set(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT);
+
+	for (uint8_t i = 0; (i < failCount) && (retryDelay < DOMOTICZ_RETRY_MAX_MS); i++) {
+		retryDelay *= 2;
+	}
+	if (retryDelay > DOMOTICZ_RETRY_MAX_MS) {
+		retryDelay = DOMOTICZ_RETRY_MAX_MS;
+	}
+	if (failCount < UINT8_MAX) {
+		failCount++;
+	}
+
+	nextTryTick = tick + retryDelay;
+	log_warn("Domoticz retry in %u ms", retryDelay);
+}
+
+/**
+ * @brief The reply is complete
+ */
+static void domoticz_end_reply(void)
+{
+	struct domoticz_value_t * pValue = &queue[queueHead];
 
 	if (httpCode == 200) {
+		log_info("Temperature sent for sensor %d", pValue->sensorID);
 		_unset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT);
-		return 0;
 	} else {
+		// The server refused it, sending it again would not help
 		log_error("Domoticz bad reply (http code = %d)", httpCode);
-		log_error("Request was: %s", url.c_str());
 		_set(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT);
-		return 1;
+	}
+
+	queueHead = (queueHead + 1) % DOMOTICZ_QUEUE_SIZE;
+	queueCount--;
+	failCount     = 0;
+	domoticzState = DOMOTICZ_STATE_IDLE;
+
+	if (!isKeepAlive) {
+		client.stop();
+	}
+}
+
+/**
+ * @brief Use a complete line of the reply
+ */
+static void domoticz_parse_line(void)
+{
+	if (domoticzState == DOMOTICZ_STATE_STATUS_LINE) {
+		// "HTTP/1.1 200 OK"
+		if ((lineLength < 12) || (strncmp(line, "HTTP/1.", 7) != 0)) {
+			httpCode = -1;
+		} else {
+			httpCode = atoi(&line[9]);
+		}
+		isKeepAlive   = (line[7] == '1');
+		bodyLeft      = -1;
+		domoticzState = DOMOTICZ_STATE_HEADERS;
+	} else if (lineLength == 0) {
+		// End of headers
+		if (bodyLeft < 0) {
+			// No length, the body ends with the connection
+			isKeepAlive = false;
+		}
+		domoticzState = DOMOTICZ_STATE_BODY;
+	} else if (strncasecmp(line, "Content-Length:", 15) == 0) {
+		bodyLeft = atoi(&line[15]);
+	} else if ((strncasecmp(line, "Connection:", 11) == 0) && (strstr(&line[11], "close") != NULL)) {
+		isKeepAlive = false;
+	}
+}
+
+/**
+ * @brief Read what is available of the reply
+ */
+static void domoticz_read_reply(void)
+{
+	for (uint16_t n = 0; (n < DOMOTICZ_READ_MAX_PER_TICK) && (client.available() > 0); n++) {
+		char c = (char) client.read();
+
+		if (domoticzState == DOMOTICZ_STATE_BODY) {
+			if (bodyLeft > 0) {
+				bodyLeft--;
+			}
+		} else if (c == '\n') {
+			line[lineLength] = '\0';
+			domoticz_parse_line();
+			lineLength = 0;
+		} else if ((c != '\r') && (lineLength < (DOMOTICZ_LINE_SIZE - 1))) {
+			line[lineLength++] = c;
+		}
+
+		if ((domoticzState == DOMOTICZ_STATE_BODY) && (bodyLeft == 0)) {
+			domoticz_end_reply();
+			return;
+		}
+	}
+
+	if ((domoticzState == DOMOTICZ_STATE_BODY) && (bodyLeft < 0) && !client.connected() && (client.available() == 0)) {
+		// Body without length is over
+		domoticz_end_reply();
+	} else if (!client.connected() && (client.available() == 0)) {
+		if (isReusedConn && (domoticzState == DOMOTICZ_STATE_STATUS_LINE) && (lineLength == 0)) {
+			// Server closed the idle connection before our request, open a new one
+			client.stop();
+			domoticzState = DOMOTICZ_STATE_IDLE;
+			return;
+		}
+		log_error("Domoticz closed the connection");
+		domoticz_retry_later();
+	} else if (tick > replyEndTick) {
+		log_error("Domoticz did not reply in time");
+		domoticz_retry_later();
+	}
+}
+
+/**
+ * @brief Retry as soon as we are back online
+ *
+ * @param pEvent The event
+ * @param arg Unused
+ */
+static void domoticz_event_callback(const struct event_t * pEvent, void * arg)
+{
+	if (pEvent->value != 0) {
+		failCount   = 0;
+		nextTryTick = 0;
+	} else {
+		client.stop();
+		domoticzState = DOMOTICZ_STATE_IDLE;
 	}
 }
 
+/**
+ * @brief Queue a temperature for Domoticz
+ * @details Sent by domoticz_main(), a value of the same device
+ * that is not sent yet is replaced
+ *
+ * @param sensorID Domoticz device
+ * @param degreesValue Temperature in celcius
+ */
 void domoticz_send_temperature(uint8_t sensorID, float degreesValue)
 {
-	// Format JSON à respecter pour l'API Domoticz - Domoticz JSON API
-	// /json.htm?type=command&param=udevice&idx=IDX&nvalue=0&svalue=TEMP
-	// https://www.domoticz.com/wiki/Domoticz_API/JSON_URL%27s#Temperature
-	String url = "/json.htm?type=command&param=udevice&idx=";
-	url += String(sensorID);
-	url += "&nvalue=0&svalue=";
-	url += String(degreesValue);
+	domoticz_queue_value(sensorID, degreesValue);
+}
+
+int domoticz_init(void)
+{
+	queueHead     = 0;
+	queueCount    = 0;
+	failCount     = 0;
+	nextTryTick   = 0;
+	domoticzState = DOMOTICZ_STATE_IDLE;
 
-	if (domoticz_send(url) == 0) {
-		log_info("Temperature sent for sensor %d", sensorID);
+	CHECK_CALL(event_subscribe(event_mask(EVENT_WIFI_STATE), EVENT_SOURCE_ANY, domoticz_event_callback, NULL))
+
+	return 0;
+}
+
+void domoticz_main(void)
+{
+	if (domoticzState != DOMOTICZ_STATE_IDLE) {
+		domoticz_read_reply();
+		return;
+	}
+
+	if ((queueCount == 0) || (tick < nextTryTick) || _isunset(STATUS_WIFI, STATUS_WIFI_IS_CO)) {
+		return;
+	}
+
+	if (domoticz_send_request() != 0) {
+		domoticz_retry_later();
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
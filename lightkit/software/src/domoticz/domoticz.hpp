@@ -10,7 +10,15 @@
 
 #include <Arduino.h>
 
+#define DOMOTICZ_QUEUE_SIZE         8          /** Values waiting to be sent, a new value of a queued device replaces the old one */
+#define DOMOTICZ_CONNECT_TIMEOUT_MS 500        /** Connecting is the only blocking step, keep it short */
+#define DOMOTICZ_RETRY_MIN_MS       1000       /** Delay after the first failure, doubled at each new one */
+#define DOMOTICZ_RETRY_MAX_MS       5*60*1000  /** Longest delay between two tries */
+#define DOMOTICZ_LINE_SIZE          64         /** Longest header line kept, longer ones are truncated */
+#define DOMOTICZ_READ_MAX_PER_TICK  128        /** Bytes of the reply read each tick */
+
 void domoticz_send_temperature(uint8_t sensorID, float degreesValue);
-void domoticz_init(void);
+int  domoticz_init(void);
+void domoticz_main(void);
 
 #endif /* DOMOTICZ_DOMOTICZ_HPP */
@@ -1,9 +1,24 @@
 #include "ioi2c_driver.h"
 
-IOI2CDriver::IOI2CDriver(uint32_t sda, uint32_t scl, uint8_t addr7bits)
+/**
+ * @brief Create a device
+ * @note The bus must be started by the owner of the TwoWire instance
+ *
+ * @param wire I2C controller the device is connected to
+ * @param addr7bits Address of the device
+ */
+IOI2CDriver::IOI2CDriver(TwoWire * wire, uint8_t addr7bits)
 {
-	mAddr7bits = addr7bits;
-	Wire.begin(sda, scl);
+	mWire             = wire;
+	mAddr7bits        = addr7bits;
+	mInValue          = 0xFF;
+	mIsDirty          = false;
+	mStatus           = IOI2CDriver::STATUS_NONE;
+	mTransactionCount = 0;
+	mErrorCount       = 0;
+	mErrorStreak      = 0;
+	mBackoffMs        = IOI2C_BACKOFF_MIN_MS;
+	mNextRetryTime    = 0;
 }
 
 IOI2CDriver::~IOI2CDriver(void)
@@ -21,6 +36,7 @@ void IOI2CDriver::begin(void)
 
 /**
  * @brief Write the new value of output specified by number
+ * @details The value is only sent by the next flush()
  *
  * @param number Output to write
  * @param value Boolean
@@ -42,7 +58,28 @@ void IOI2CDriver::output_write(uint8_t number, uint8_t value)
 		mOutValue |= bitValue;
 	}
 
-	update_outputs();
+	mIsDirty = true;
+}
+
+/**
+ * @brief Send the output values if they changed since the last flush
+ * @note An offline device keeps them until it answers again
+ */
+void IOI2CDriver::flush(void)
+{
+	if (mIsDirty && can_transfer()) {
+		update_outputs();
+	}
+}
+
+/**
+ * @brief Tell if some output values are waiting to be sent
+ *
+ * @return true if a flush() is needed
+ */
+bool IOI2CDriver::is_dirty(void)
+{
+	return mIsDirty;
 }
 
 /**
@@ -50,47 +87,104 @@ void IOI2CDriver::output_write(uint8_t number, uint8_t value)
  */
 void IOI2CDriver::update_outputs(void)
 {
-	Wire.beginTransmission(mAddr7bits);
-	Wire.write(mOutValue);
-	Wire.endTransmission(); // Can't block if SDA is low (like an other Master on the line)
+	bool isSuccess;
+
+	mTransactionCount++;
+	mIsDirty = false;
+
+	mWire->beginTransmission(mAddr7bits);
+	mWire->write(mOutValue);
+	isSuccess = (mWire->endTransmission() == 0); // Can't block if SDA is low (like an other Master on the line)
+
+	on_transfer(isSuccess);
+
+	// Send them again once the device is back
+	if (!isSuccess) {
+		mIsDirty = true;
+	}
 }
 
 /**
- * @brief Read inputs
+ * @brief Read the port of the device in one transaction
+ * @details The value is kept until the next scan, input_read()
+ * and get_status() are served from it
+ *
+ * @return IOI2CDriver::Status
+ */
+IOI2CDriver::Status IOI2CDriver::scan(void)
+{
+	if (!can_transfer()) {
+		return mStatus;
+	}
+
+	mTransactionCount++;
+
+	if (mWire->requestFrom(mAddr7bits, (uint8_t) 1) != 1) {
+		on_transfer(false);
+		return mStatus;
+	}
+
+	mInValue = mWire->read();
+	on_transfer(true);
+	return mStatus;
+}
+
+/**
+ * @brief Read inputs from the last scan
  *
  * @param number Input to read
- * @return boolean
+ * @return boolean, -1 if the last scan failed
  */
 int8_t IOI2CDriver::input_read(uint8_t number)
 {
-	uint8_t byteValue;
-
 	if (number >= IOI2C_INPUT_COUNT) {
 		return -1;
 	}
 
-	if (Wire.requestFrom(mAddr7bits, (uint8_t) 1) != 1) {
-		return -1;
+	// Never scanned yet
+	if (mStatus == IOI2CDriver::STATUS_NONE) {
+		scan();
 	}
 
-	byteValue = Wire.read();
+	if (mStatus != IOI2CDriver::STATUS_OK) {
+		return -1;
+	}
 
 	// Do inversion here
-	return (byteValue & (0x80 >> number)) == 0;
+	return (mInValue & (0x80 >> number)) == 0;
 }
 
 /**
- * @brief Get the status of the device
+ * @brief Get the status of the device from the last scan
  *
  * @return IOI2CDriver::Status
  */
 IOI2CDriver::Status IOI2CDriver::get_status(void)
 {
-	if (Wire.requestFrom(mAddr7bits, (uint8_t) 1) != 1) {
-		return IOI2CDriver::STATUS_COMM_ERROR;
+	if (mStatus == IOI2CDriver::STATUS_NONE) {
+		scan();
 	}
 
-	return IOI2CDriver::STATUS_OK;
+	return mStatus;
+}
+
+/**
+ * @brief Get a printable name of the status
+ *
+ * @return String
+ */
+const char * IOI2CDriver::get_status_name(void)
+{
+	switch (mStatus) {
+	case IOI2CDriver::STATUS_OK:
+		return "OK";
+	case IOI2CDriver::STATUS_COMM_ERROR:
+		return "COMM_ERROR";
+	case IOI2CDriver::STATUS_OFFLINE:
+		return "OFFLINE";
+	default:
+		return "NONE";
+	}
 }
 
 /**
@@ -102,3 +196,81 @@ uint8_t IOI2CDriver::get_address(void)
 {
 	return mAddr7bits;
 }
+
+/**
+ * @brief Return the number of transactions sent to the device
+ *
+ * @return Read and write transactions
+ */
+uint32_t IOI2CDriver::get_transaction_count(void)
+{
+	return mTransactionCount;
+}
+
+/**
+ * @brief Return the number of failed transactions
+ *
+ * @return Transactions not acknowledged by the device
+ */
+uint32_t IOI2CDriver::get_error_count(void)
+{
+	return mErrorCount;
+}
+
+/**
+ * @brief Tell if the device can be accessed now
+ *
+ * @return false while an offline device waits for its next retry
+ */
+bool IOI2CDriver::can_transfer(void)
+{
+	if (mStatus != IOI2CDriver::STATUS_OFFLINE) {
+		return true;
+	}
+
+	return (int32_t) (millis() - mNextRetryTime) >= 0;
+}
+
+/**
+ * @brief Update the status of the device after a transaction
+ * @details A device is offline after IOI2C_OFFLINE_ERROR_COUNT errors in a row,
+ * then retried with a delay doubled on each failure. When it answers again,
+ * outputs are sent back as the device may have been power cycled.
+ *
+ * @param isSuccess Result of the transaction
+ */
+void IOI2CDriver::on_transfer(bool isSuccess)
+{
+	if (isSuccess) {
+		if (mStatus == IOI2CDriver::STATUS_OFFLINE) {
+			mIsDirty = true;
+		}
+
+		mErrorStreak = 0;
+		mBackoffMs   = IOI2C_BACKOFF_MIN_MS;
+		mStatus      = IOI2CDriver::STATUS_OK;
+		return;
+	}
+
+	mErrorCount++;
+
+	if (mErrorStreak < UINT8_MAX) {
+		mErrorStreak++;
+	}
+
+	if (mErrorStreak < IOI2C_OFFLINE_ERROR_COUNT) {
+		mStatus = IOI2CDriver::STATUS_COMM_ERROR;
+		return;
+	}
+
+	// Already offline: wait longer
+	if (mStatus == IOI2CDriver::STATUS_OFFLINE) {
+		mBackoffMs *= 2;
+		if (mBackoffMs > IOI2C_BACKOFF_MAX_MS) {
+			mBackoffMs = IOI2C_BACKOFF_MAX_MS;
+		}
+	}
+
+	mStatus        = IOI2CDriver::STATUS_OFFLINE;
+	mNextRetryTime = millis() + mBackoffMs;
+}
\ No newline at end of file
@@ -17,30 +17,72 @@
 #define IOI2C_6_ADDR 0x26
 #define IOI2C_7_ADDR 0x27
 
+#define IOI2C_CLOCK_STANDARD  100000  // Max for PCF8574
+#define IOI2C_CLOCK_FAST      400000  // Needs PCA9674 like expanders
+#define IOI2C_CLOCK_FAST_PLUS 1000000 // Needs PCA9674 like expanders, ESP32 only
+
+#define IOI2C_OFFLINE_ERROR_COUNT 3     // Consecutive errors before a device is considered offline
+#define IOI2C_BACKOFF_MIN_MS      100   // First retry delay of an offline device
+#define IOI2C_BACKOFF_MAX_MS      10000 // Retry delay is doubled up to this one
+
+/** An I2C bus: controller, pins and clock */
+struct IOI2CBus {
+	TwoWire * wire;
+	uint8_t   sda;
+	uint8_t   scl;
+	uint32_t  clock;
+};
+
+#define IOI2C_BUS(wire, sda, scl, clock) { &(wire), sda, scl, clock }
+
+/** A device on a bus: [15:8] bus index, [6:0] address */
+#define IOI2C_DEV(bus, addr) ((uint16_t) (((bus) << 8) | (addr)))
+#define ioi2c_dev_bus(dev)   ((dev) >> 8)
+#define ioi2c_dev_addr(dev)  ((dev) & 0x7F)
+
 class IOI2CDriver {
 	public:
 	enum Status
 	{
 		STATUS_NONE,
 		STATUS_OK,
-		STATUS_COMM_ERROR
+		STATUS_COMM_ERROR, // Last transaction failed
+		STATUS_OFFLINE     // Too many errors, only retried after a back-off delay
 	};
 
 	public:
-	IOI2CDriver(uint32_t sda, uint32_t scl, uint8_t addr7bits);
+	IOI2CDriver(TwoWire * wire, uint8_t addr7bits);
 	~IOI2CDriver();
 
 	void begin(void);
 
 	void                output_write(uint8_t number, uint8_t value);
 	void                update_outputs(void);
+	void                flush(void);
+	bool                is_dirty(void);
+	IOI2CDriver::Status scan(void);
 	int8_t              input_read(uint8_t number);
 	IOI2CDriver::Status get_status(void);
 	uint8_t             get_address(void);
+	const char *        get_status_name(void);
+	uint32_t            get_transaction_count(void);
+	uint32_t            get_error_count(void);
 
 	private:
-	uint8_t mAddr7bits;
-	uint8_t mOutValue; // Bit 0: S1, Bit 1: S2...
+	TwoWire *           mWire;
+	uint8_t             mAddr7bits;
+	uint8_t             mOutValue;         // Bit 0: S1, Bit 1: S2...
+	bool                mIsDirty;          // mOutValue not sent yet
+	uint8_t             mInValue;          // Port value read by the last scan
+	IOI2CDriver::Status mStatus;           // Result of the last transaction
+	uint32_t            mTransactionCount; // Transactions sent on the bus
+	uint32_t            mErrorCount;       // Transactions which failed
+	uint8_t             mErrorStreak;      // Consecutive failed transactions
+	uint32_t            mBackoffMs;        // Current retry delay when offline
+	uint32_t            mNextRetryTime;    // millis() of the next try when offline
+
+	bool can_transfer(void);
+	void on_transfer(bool isSuccess);
 };
 
 #endif // IOI2C_DRIVER
\ No newline at end of file
@@ -1,29 +1,155 @@
 #include "ioi2c_group.h"
 
-IOI2CGroup::IOI2CGroup(uint32_t sda, uint32_t scl, const uint8_t * addr7bitsTable, uint8_t deviceCount)
+/**
+ * @brief Create a group of devices spread over one or several buses
+ * @details Output and input numbers follow the order of deviceTable.
+ * On ESP32, each bus can use its own controller (Wire, Wire1).
+ *
+ * @param busTable Buses used by the group, must stay valid
+ * @param busCount Size of busTable
+ * @param deviceTable Devices built with IOI2C_DEV()
+ * @param deviceCount Size of deviceTable
+ */
+IOI2CGroup::IOI2CGroup(const IOI2CBus * busTable, uint8_t busCount, const uint16_t * deviceTable, uint8_t deviceCount)
 {
+	if (busCount > IOI2C_GROUP_MAX_BUS) {
+		busCount = IOI2C_GROUP_MAX_BUS;
+	}
+
 	if (deviceCount > IOI2C_GROUP_MAX_DEVICE) {
 		deviceCount = IOI2C_GROUP_MAX_DEVICE;
 	}
 
-	mDeviceCount = deviceCount;
+	mIsChanged   = false;
+	mIntPin      = -1;
+	mBusTable    = busTable;
+	mBusCount    = busCount;
+	mDeviceCount = 0;
 
-	for (uint8_t i = 0; i < mDeviceCount; ++i) {
-		mDeviceTable[i] = new IOI2CDriver(sda, scl, addr7bitsTable[i]);
+	mBusClearCount = 0;
+	for (uint8_t i = 0; i < IOI2C_GROUP_MAX_BUS; ++i) {
+		mNextBusClearTime[i] = 0;
+	}
+
+	for (uint8_t i = 0; i < deviceCount; ++i) {
+		// Stop on an unknown bus, next devices would be shifted otherwise
+		if (ioi2c_dev_bus(deviceTable[i]) >= mBusCount) {
+			break;
+		}
+
+		mDeviceTable[i] = new IOI2CDriver(mBusTable[ioi2c_dev_bus(deviceTable[i])].wire, ioi2c_dev_addr(deviceTable[i]));
+		mDeviceCount++;
 	}
 }
 
 IOI2CGroup::~IOI2CGroup()
 {
+	// The interrupt holds a pointer on this group
+	if (mIntPin >= 0) {
+		detachInterrupt(digitalPinToInterrupt(mIntPin));
+	}
 }
 
+/**
+ * @brief Start each bus once, then the devices
+ */
 void IOI2CGroup::begin(void)
 {
+	for (uint8_t i = 0; i < mBusCount; ++i) {
+		bus_begin(i);
+	}
+
 	for (uint8_t i = 0; i < mDeviceCount; ++i) {
 		mDeviceTable[i]->begin();
 	}
 }
 
+/**
+ * @brief Start the controller of a bus with its pins and clock
+ *
+ * @param busIndex Index in the bus table
+ */
+void IOI2CGroup::bus_begin(uint8_t busIndex)
+{
+	const IOI2CBus * pBus = &mBusTable[busIndex];
+
+	pBus->wire->begin(pBus->sda, pBus->scl);
+	pBus->wire->setClock(pBus->clock);
+}
+
+/**
+ * @brief Release a bus where a device holds SDA low
+ * @details A device reset in the middle of a read keeps SDA low until it
+ * has clocked out its byte: stop the controller, send up to 9 clocks
+ * on SCL, then a STOP, and start the controller again
+ *
+ * @param busIndex Index in the bus table
+ */
+void IOI2CGroup::bus_clear(uint8_t busIndex)
+{
+	const IOI2CBus * pBus = &mBusTable[busIndex];
+
+	mBusClearCount++;
+	mNextBusClearTime[busIndex] = millis() + IOI2C_BUS_CLEAR_PERIOD_MS;
+
+#ifdef ESP32
+	// Give the pins back to the GPIO matrix, the I2C peripheral still drives them otherwise
+	pBus->wire->end();
+#endif
+	pinMode(pBus->sda, INPUT_PULLUP);
+	pinMode(pBus->scl, OUTPUT_OPEN_DRAIN);
+
+	for (uint8_t i = 0; (i < 9) && (digitalRead(pBus->sda) == LOW); ++i) {
+		digitalWrite(pBus->scl, LOW);
+		delayMicroseconds(5);
+		digitalWrite(pBus->scl, HIGH);
+		delayMicroseconds(5);
+	}
+
+	// STOP: SDA rises while SCL is high
+	pinMode(pBus->sda, OUTPUT_OPEN_DRAIN);
+	digitalWrite(pBus->sda, LOW);
+	delayMicroseconds(5);
+	digitalWrite(pBus->sda, HIGH);
+	delayMicroseconds(5);
+
+	bus_begin(busIndex);
+}
+
+/**
+ * @brief Use the INT line of the devices to know when inputs change
+ * @details INT is open drain and active low, the INT of chained devices
+ * can share the same GPIO
+ *
+ * @param intPin GPIO connected to the INT line
+ */
+void IOI2CGroup::begin_interrupt(uint8_t intPin)
+{
+	mIntPin = intPin;
+
+	pinMode(intPin, INPUT_PULLUP);
+	attachInterruptArg(digitalPinToInterrupt(intPin), IOI2CGroup::on_interrupt, this, FALLING);
+
+	// Read the ports once to release INT
+	mIsChanged = true;
+}
+
+/**
+ * @brief INT line of a group falls
+ *
+ * @param arg The group
+ */
+void ICACHE_RAM_ATTR IOI2CGroup::on_interrupt(void * arg)
+{
+	((IOI2CGroup *) arg)->mIsChanged = true;
+}
+
+/**
+ * @brief Change an output, it is sent on the bus by the next commit()
+ *
+ * @param number Output to write, across all devices
+ * @param value Boolean
+ */
 void IOI2CGroup::output_write(uint8_t number, uint8_t value)
 {
 	uint8_t deviceIndex = number / IOI2C_OUTPUT_COUNT;
@@ -36,6 +162,81 @@ void IOI2CGroup::output_write(uint8_t number, uint8_t value)
 	mDeviceTable[deviceIndex]->output_write(outputIndex, value);
 }
 
+/**
+ * @brief Change several outputs and send them right away
+ * @details Outputs of a same device are sent in one transaction,
+ * so they all switch at the same time
+ *
+ * @param numberTable Outputs to write, across all devices
+ * @param valueTable Boolean of each output
+ * @param count Size of the tables
+ */
+void IOI2CGroup::output_write_multiple(const uint8_t * numberTable, const uint8_t * valueTable, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; ++i) {
+		output_write(numberTable[i], valueTable[i]);
+	}
+
+	commit();
+}
+
+/**
+ * @brief Send the outputs changed since the last commit,
+ * one transaction per modified device
+ */
+void IOI2CGroup::commit(void)
+{
+	for (uint8_t i = 0; i < mDeviceCount; ++i) {
+		mDeviceTable[i]->flush();
+	}
+}
+
+/**
+ * @brief Read the inputs of every device, one transaction per device
+ * @details Call it once per polling period, input_read() uses the result
+ */
+void IOI2CGroup::scan(void)
+{
+	// Cleared first, so a change during the scan asks for another one
+	mIsChanged = false;
+
+	// An idle bus has SDA high
+	for (uint8_t i = 0; i < mBusCount; ++i) {
+		if ((digitalRead(mBusTable[i].sda) == LOW) && ((int32_t) (millis() - mNextBusClearTime[i]) >= 0)) {
+			bus_clear(i);
+		}
+	}
+
+	for (uint8_t i = 0; i < mDeviceCount; ++i) {
+		mDeviceTable[i]->scan();
+	}
+
+	// A device only releases INT once its port was read
+	if (has_interrupt() && (digitalRead(mIntPin) == LOW)) {
+		mIsChanged = true;
+	}
+}
+
+/**
+ * @brief Tell if the INT line is used
+ *
+ * @return true if begin_interrupt() was called
+ */
+bool IOI2CGroup::has_interrupt(void)
+{
+	return mIntPin >= 0;
+}
+
+/**
+ * @brief Tell if an input changed since the last scan()
+ *
+ * @return true if a scan() is needed
+ */
+bool IOI2CGroup::is_changed(void)
+{
+	return mIsChanged;
+}
+
 int8_t IOI2CGroup::input_read(uint8_t number)
 {
 	uint8_t deviceIndex = number / IOI2C_INPUT_COUNT;
@@ -46,4 +247,45 @@ int8_t IOI2CGroup::input_read(uint8_t number)
 	}
 
 	return mDeviceTable[deviceIndex]->input_read(outputIndex);
+}
+
+uint8_t IOI2CGroup::get_device_count(void)
+{
+	return mDeviceCount;
+}
+
+IOI2CDriver * IOI2CGroup::get_device(uint8_t deviceIndex)
+{
+	if (deviceIndex >= mDeviceCount) {
+		return NULL;
+	}
+
+	return mDeviceTable[deviceIndex];
+}
+
+uint32_t IOI2CGroup::get_transaction_count(void)
+{
+	uint32_t count = 0;
+
+	for (uint8_t i = 0; i < mDeviceCount; ++i) {
+		count += mDeviceTable[i]->get_transaction_count();
+	}
+
+	return count;
+}
+
+uint32_t IOI2CGroup::get_error_count(void)
+{
+	uint32_t count = 0;
+
+	for (uint8_t i = 0; i < mDeviceCount; ++i) {
+		count += mDeviceTable[i]->get_error_count();
+	}
+
+	return count;
+}
+
+uint32_t IOI2CGroup::get_bus_clear_count(void)
+{
+	return mBusClearCount;
 }
\ No newline at end of file
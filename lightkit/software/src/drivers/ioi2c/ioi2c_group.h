@@ -4,20 +4,46 @@
 #include "ioi2c_driver.h"
 
 #define IOI2C_GROUP_MAX_DEVICE 5
+#define IOI2C_GROUP_MAX_BUS    2
+
+#define IOI2C_BUS_CLEAR_PERIOD_MS 1000 // Minimum time between two bus clears of a same bus
 
 class IOI2CGroup {
 public:
-	IOI2CGroup(uint32_t sda, uint32_t scl, const uint8_t * addr7bitsTable, uint8_t deviceCount);
+	IOI2CGroup(const IOI2CBus * busTable, uint8_t busCount, const uint16_t * deviceTable, uint8_t deviceCount);
 	~IOI2CGroup();
 
 	void begin(void);
+	void begin_interrupt(uint8_t intPin);
 
 	void output_write(uint8_t number, uint8_t value);
+	void output_write_multiple(const uint8_t * numberTable, const uint8_t * valueTable, uint8_t count);
+	void commit(void);
+	void scan(void);
+	bool has_interrupt(void);
+	bool is_changed(void);
 	int8_t input_read(uint8_t number);
 
+	uint8_t       get_device_count(void);
+	IOI2CDriver * get_device(uint8_t deviceIndex);
+	uint32_t      get_transaction_count(void);
+	uint32_t      get_error_count(void);
+	uint32_t      get_bus_clear_count(void);
+
 private:
-	uint8_t mDeviceCount;
-	IOI2CDriver * mDeviceTable[IOI2C_GROUP_MAX_DEVICE];
+	static void on_interrupt(void * arg);
+
+	void bus_begin(uint8_t busIndex);
+	void bus_clear(uint8_t busIndex);
+
+	volatile bool    mIsChanged; // Set when the INT line falls
+	int16_t          mIntPin;    // -1 if the INT line is not wired
+	const IOI2CBus * mBusTable;
+	uint8_t          mBusCount;
+	uint32_t         mNextBusClearTime[IOI2C_GROUP_MAX_BUS];
+	uint32_t         mBusClearCount;
+	uint8_t          mDeviceCount;
+	IOI2CDriver *    mDeviceTable[IOI2C_GROUP_MAX_DEVICE];
 };
 
 #endif // IOI2C_GROUP_H
\ No newline at end of file
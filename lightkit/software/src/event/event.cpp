@@ -0,0 +1,137 @@
+/**
+  * @file   event.cpp
+  * @brief  Publish/subscribe events between modules
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "event.hpp"
+
+// Structures
+struct event_subscriber_t {
+	uint32_t         typeMask; /**< event_mask() of the types to receive */
+	uint8_t          source;   /**< Source to receive or EVENT_SOURCE_ANY */
+	event_callback_t callback;
+	void *           arg;
+};
+
+// Variables
+extern uint32_t                  tick;
+static struct event_t            eventQueue[EVENT_QUEUE_SIZE];
+static uint8_t                   eventHead = 0;
+static uint8_t                   eventTail = 0;
+static uint32_t                  eventDropped         = 0; /**< Events lost because the queue was full */
+static uint32_t                  eventDroppedReported = 0;
+static struct event_subscriber_t eventSubscribers[EVENT_MAX_SUBSCRIBERS];
+static uint8_t                   eventSubscriberCount = 0;
+
+static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0, "EVENT_QUEUE_SIZE must be a power of 2");
+static_assert(EVENT_TYPE_COUNT <= 32, "Event types must fit in the subscriber mask");
+
+/**
+ * @brief Call the subscribers of an event
+ *
+ * @param pEvent The event
+ */
+static void event_dispatch(const struct event_t * pEvent)
+{
+	for (uint8_t i = 0; i < eventSubscriberCount; i++) {
+		struct event_subscriber_t * pSub = &eventSubscribers[i];
+
+		if (_isunset(pSub->typeMask, event_mask(pEvent->type))) {
+			continue;
+		}
+		if ((pSub->source != EVENT_SOURCE_ANY) && (pSub->source != pEvent->source)) {
+			continue;
+		}
+
+		pSub->callback(pEvent, pSub->arg);
+	}
+}
+
+int event_init(void)
+{
+	eventHead            = 0;
+	eventTail            = 0;
+	eventSubscriberCount = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Register a callback for some events
+ * @note Must be called during init, callbacks are never removed
+ *
+ * @param typeMask event_mask() of the types to receive
+ * @param source Only receive events from this source, EVENT_SOURCE_ANY for all
+ * @param callback Called from event_main() with the event and arg
+ * @param arg Given back to the callback
+ * @return 0: OK, -1: Too many subscribers
+ */
+int event_subscribe(uint32_t typeMask, uint8_t source, event_callback_t callback, void * arg)
+{
+	struct event_subscriber_t * pSub;
+
+	if (eventSubscriberCount >= EVENT_MAX_SUBSCRIBERS) {
+		log_error("Too many event subscribers");
+		return -1;
+	}
+
+	pSub           = &eventSubscribers[eventSubscriberCount++];
+	pSub->typeMask = typeMask;
+	pSub->source   = source;
+	pSub->callback = callback;
+	pSub->arg      = arg;
+
+	return 0;
+}
+
+/**
+ * @brief Queue an event, it is dispatched by the next event_main()
+ * @note Not to be called from an ISR
+ *
+ * @param type One of event_type_e
+ * @param source Index of the sender
+ * @param value Payload
+ * @return 0: OK, -1: Queue is full, event is dropped
+ */
+int event_publish(uint8_t type, uint8_t source, int32_t value)
+{
+	uint8_t next = (eventHead + 1) & (EVENT_QUEUE_SIZE - 1);
+
+	if (next == eventTail) {
+		eventDropped++;
+		return -1;
+	}
+
+	eventQueue[eventHead].type   = type;
+	eventQueue[eventHead].source = source;
+	eventQueue[eventHead].value  = value;
+	eventQueue[eventHead].tick   = tick;
+	eventHead                    = next;
+
+	return 0;
+}
+
+/**
+ * @brief Dispatch queued events
+ * @details Events published by a callback are dispatched on the next call,
+ * so a loop between two modules can't block the main loop
+ */
+void event_main(void)
+{
+	uint8_t head = eventHead;
+
+	while (eventTail != head) {
+		// Copy it as the slot may be reused by a callback
+		struct event_t event = eventQueue[eventTail];
+
+		eventTail = (eventTail + 1) & (EVENT_QUEUE_SIZE - 1);
+		event_dispatch(&event);
+	}
+
+	if (eventDropped != eventDroppedReported) {
+		eventDroppedReported = eventDropped;
+		log_warn("Event queue is full, %u events dropped", eventDroppedReported);
+	}
+}
@@ -0,0 +1,53 @@
+/**
+  * @file   event.hpp
+  * @brief  Publish/subscribe events between modules
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef EVENT_EVENT_HPP
+#define EVENT_EVENT_HPP
+
+#include "global.hpp"
+
+#define EVENT_QUEUE_SIZE      16   /**< Events waiting for event_main(), power of 2 */
+#define EVENT_MAX_SUBSCRIBERS 12   /**< Callbacks that can be registered */
+#define EVENT_SOURCE_ANY      0xFF /**< Subscribe to all the sources of a type */
+
+/** Types of event, the meaning of source and value depends on it */
+enum event_type_e {
+	EVENT_INPUT_RISING = 0, /**< source: input index */
+	EVENT_INPUT_FALLING,    /**< source: input index */
+	EVENT_INPUT_LONG_HIGH,  /**< source: input index */
+	EVENT_INPUT_LONG_LOW,   /**< source: input index */
+	EVENT_TEMP_VALUE,       /**< source: sensor index, value: temperature in 1/100 °C */
+	EVENT_TEMP_FAULT,       /**< source: sensor index, value: 1 faulty, 0 back to normal */
+	EVENT_RELAY_STATE,      /**< source: relay index, value: 1 closed, 0 open */
+	EVENT_RELAY_FEEDBACK,   /**< source: relay index, value: 1 feedback is good, 0 relay is faulty */
+	EVENT_WIFI_STATE,       /**< value: 1 connected as client, 0 disconnected */
+	EVENT_ALERT,            /**< value: 1 alert is active, 0 inactive */
+	EVENT_DETECTION,        /**< value: How long the detection lasts in ms */
+	EVENT_TYPE_COUNT
+};
+
+/** MACROS */
+#define event_mask(type) (1UL << (type))
+
+#define EVENT_MASK_INPUT_EDGE (event_mask(EVENT_INPUT_RISING) | event_mask(EVENT_INPUT_FALLING))
+
+// Structures
+struct event_t {
+	uint8_t  type;   /**< One of event_type_e */
+	uint8_t  source; /**< Index of the sender, see event_type_e */
+	int32_t  value;  /**< Payload, see event_type_e */
+	uint32_t tick;   /**< When the event was published */
+};
+
+typedef void (*event_callback_t)(const struct event_t * pEvent, void * arg);
+
+int  event_init(void);
+int  event_subscribe(uint32_t typeMask, uint8_t source, event_callback_t callback, void * arg);
+int  event_publish(uint8_t type, uint8_t source, int32_t value);
+void event_main(void);
+
+#endif /* EVENT_EVENT_HPP */
@@ -21,7 +21,9 @@ extern uint32_t tick;
  */
 static void feu_rouge_set_color(uint32_t color)
 {
-	static uint32_t prevColor = UINT32_MAX;
+	static uint32_t prevColor     = UINT32_MAX;
+	const uint32_t  outputTable[] = { OUTPUTS_TRAFFIC_LIGHT_RED, OUTPUTS_TRAFFIC_LIGHT_YELLOW, OUTPUTS_TRAFFIC_LIGHT_GREEN };
+	bool            stateTable[3];
 
 	if (color == prevColor) {
 		return; // nothing to do
@@ -29,9 +31,11 @@ static void feu_rouge_set_color(uint32_t color)
 
 	prevColor = color;
 
-	output_set(OUTPUTS_TRAFFIC_LIGHT_RED, _isset(color, COLOR_MASK_RED));
-	output_set(OUTPUTS_TRAFFIC_LIGHT_YELLOW, _isset(color, COLOR_MASK_YELLOW));
-	output_set(OUTPUTS_TRAFFIC_LIGHT_GREEN, _isset(color, COLOR_MASK_GREEN));
+	// Switch all the lights at once to avoid an intermediate color
+	stateTable[0] = _isset(color, COLOR_MASK_RED);
+	stateTable[1] = _isset(color, COLOR_MASK_YELLOW);
+	stateTable[2] = _isset(color, COLOR_MASK_GREEN);
+	output_set_multiple(outputTable, stateTable, 3);
 }
 
 /**
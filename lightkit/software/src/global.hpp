@@ -52,6 +52,8 @@
 #define I_N                                         0                       /** Input no-pull-up */
 #define I_U                                         1                       /** Input pull-up */
 #define I_A                                         2                       /** Input analog */
+#define I_NI                                        3                       /** Input no-pull-up, edges caught by interrupt */
+#define I_UI                                        4                       /** Input pull-up, edges caught by interrupt */
 
 /** Maximum size of module name ('\0' included) */
 #define MODULE_NAME_SIZE_MAX 16
@@ -97,19 +99,20 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #define MODULE_MQTT
 
     /* MODULE TEMPERATURE */
     #define TEMP_1_WIRE_PIN                         2
     #define TEMP_SENSOR_RESOLUTION                  10
-    #define TEMP_MAX_SENSOR_SUPPORTED               2
+    #define TEMP_MAX_SENSOR_SUPPORTED               16                    /** Sensors found after this count are ignored [1; 32] */
     #define TEMP_POLLING_PERIOD_MS                  1*60*1000
 
     /* MODULE_DOMOTICZ */
     #define DOMOTICZ_HOST                           "192.168.0.32"
     #define DOMOTICZ_PORT                           8080
     #define DOMOTICZ_TIMEOUT_MS                     3*1000
-    #define DOMOTICZ_SENSOR_ID_INSIDE               3
-    #define DOMOTICZ_SENSOR_ID_OUTSIDE              4
+    #define DOMOTICZ_SENSOR_IDS                     {3, 4}                /** Domoticz device of each temperature sensor, following sensors are not sent */
 
     /* MODULE_STATUS_LED */
     #define STATUS_LED_TYPE                         STATUS_LED_TYPE_NEOPIXEL  /** LED Type, see constant below */
@@ -129,7 +132,7 @@
     #define INPUTS_OPT_ALARM_IMPULSION_MODE_EN     0                     /** Option jumper JP2 define alarm method used for relay or buzzer (Impulsion of constant) */
 
     /* MODULE_OUTPUTS */
-    #define OUTPUTS_COUNT                           2                    /** Number of outputs managed by the module */
+    #define OUTPUTS_COUNT                           1                    /** Number of outputs managed by the module */
     #define OUTPUTS_PINS                            {12}                 /** Define the pin of the output with following format: {x, y, z} */
     // Aliases
     #define OUTPUTS_BUZZER                          0                    /** Output for the buzzer is the first output declared above */
@@ -147,15 +150,13 @@
 
     /** SCRIPT */
     #define SCRIPT_DOMOTICZ_UPT_PERIOD              10*60*1000            /** Period of time between two domoticz transactions */
-    #define SCRIPT_TEMP_CHECK_PERIOD                10*1000               /** Period between two sensor mesures */
 
     #define METHOD_THRESHOLD                        0                     /** Alert is set active when sensor value is above a specified threshold */
     #define METHOD_DIFFERENTIAL                     1                     /** Alert is set active when the mathematical value difference is above a specified threshold */
     #define SCRIPT_TEMP_ALERT_METHOD                METHOD_THRESHOLD      /** Select the method of comparaison to use to trigger temp alert */
 
     // For METHOD_THRESHOLD
-    #define SCRIPT_TEMP_ALERT_SENSOR_0              27                    /** High level in degrees */
-    #define SCRIPT_TEMP_ALERT_SENSOR_1              30                    /** Low level in degrees */
+    #define SCRIPT_TEMP_ALERT_SENSORS               {27, 30}              /** High level in degrees of each sensor, following sensors don't trigger the alert */
 
     // For METHOD_DIFFERENTIAL
     #define SCRIPT_TEMP_ALERT_DIFF_THRESHOLD        1.0                   /** Threshold  in degrees to overpass before setting alert active (Don't forget to add SCRIPT_TEMP_ALERT_HYSTERESIS when choosing this value) */
@@ -207,11 +208,13 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #undef MODULE_MQTT
 
     /* MODULE TEMPERATURE */
     #define TEMP_1_WIRE_PIN                         D4
     #define TEMP_SENSOR_RESOLUTION                  10
-    #define TEMP_MAX_SENSOR_SUPPORTED               2
+    #define TEMP_MAX_SENSOR_SUPPORTED               16                    /** Sensors found after this count are ignored [1; 32] */
     #define TEMP_POLLING_PERIOD_MS                  1*60*1000
 
     /* MODULE_TELEGRAM */
@@ -252,15 +255,13 @@
     /** SCRIPT */
     #define SCRIPT_TELEGRAM_UPT_PERIOD              60*60*1000			  /** Period of time between two telegram message when auto send is enabled */
     #define SCRIPT_TELEGRAM_CONN_OK_NOTIFY_PERIOD   12*60*60*1000         /** Period of time between two telegram message indicating connexion is OK (Put 0 to disable) */
-    #define SCRIPT_TEMP_CHECK_PERIOD                4*1000				  /** Period between two sensor mesures */
 
     #define METHOD_THRESHOLD                        0                     /** Alert is set active when sensor value is above a specified threshold */
     #define METHOD_DIFFERENTIAL                     1                     /** Alert is set active when the mathematical value difference is above a specified threshold */
     #define SCRIPT_TEMP_ALERT_METHOD                METHOD_THRESHOLD      /** Select the method of comparaison to use to trigger temp alert */
 
     // For METHOD_THRESHOLD
-    #define SCRIPT_TEMP_ALERT_SENSOR_0              28.0			      /** High level in degrees */
-    #define SCRIPT_TEMP_ALERT_SENSOR_1              35.0			      /** Low level in degrees */
+    #define SCRIPT_TEMP_ALERT_SENSORS               {28.0, 35.0}		  /** High level in degrees of each sensor, following sensors don't trigger the alert */
 
     // For METHOD_DIFFERENTIAL
     #define SCRIPT_TEMP_ALERT_DIFF_THRESHOLD        1.0                   /** Threshold  in degrees to overpass before setting alert active (Don't forget to add SCRIPT_TEMP_ALERT_HYSTERESIS when choosing this value) */
@@ -300,6 +301,8 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #define MODULE_MQTT
 
     /* MODULE_STRIPLED */
     #define STRIPLED_PIN                            2                     /** Output pin for the strip command */
@@ -309,7 +312,7 @@
     /* MODULE_INPUTS */
     #define INPUTS_COUNT                           4                     /** Number of inputs managed by the module */
     #define INPUTS_PINS                            {32, 4, 25, 26}       /** Define the pin of the input with following format: {x, y, z} */
-    #define INPUTS_MODES                           {I_U, I_N, I_N, I_A}  /** Define the init mode of the input pin (N, U or A) */
+    #define INPUTS_MODES                           {I_U, I_NI, I_N, I_A} /** Define the init mode of the input pin (N, U, NI, UI or A) */
     #define INPUTS_LONG_HOLD_TIME                  3*1000                /** Hold time in ms for long press on input */
     // Aliases
     #define INPUTS_OPT_WEB_SERVER_DISPLAY          0                     /** Option jumper JP1 is set as the first button in the module */
@@ -348,6 +351,8 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #undef MODULE_MQTT
 
     /* MODULE_STRIPLED */
     #define STRIPLED_PIN                            2                     /** Output pin for the strip command */
@@ -378,6 +383,8 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #undef MODULE_MQTT
 
     /* MODULE_STRIPLED */
     #define STRIPLED_PIN                            2                     /** Output pin for the strip command */
@@ -411,6 +418,8 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #undef MODULE_MQTT
 
     /* MODULE_STRIPLED */
     #define STRIPLED_PIN                            D2                    /** Output pin for the strip command */
@@ -441,14 +450,16 @@
     #define MODULE_SERIAL
     #define MODULE_TELNET
     #define MODULE_TERM
+    #define MODULE_RPC
+    #undef MODULE_MQTT
     #define MODULE_FEU_ROUGE
     #define MODULE_BUZZER
 
     /** IOI2C BOARD */
     #define HAS_IOI2C_BOARD                  // We have an IOI2C board connected to I2C bus
-    #define IOI2C_SDA 4                      // I2C interface to use to communicate with IOI2C boards
-    #define IOI2C_SCL 5
-    #define IOI2C_ADDRESSES { IOI2C_0_ADDR } // Adresses of IOI2C board (if chained, use coma separated list)
+    #define IOI2C_BUSES     { IOI2C_BUS(Wire, 4, 5, IOI2C_CLOCK_STANDARD) } // I2C buses used by IOI2C boards: controller, SDA, SCL, clock (Wire1 is ESP32 only)
+    #define IOI2C_ADDRESSES { IOI2C_DEV(0, IOI2C_0_ADDR) }                 // Bus index and address of IOI2C boards (if chained, use coma separated list)
+    // #define IOI2C_INT_PIN D6                                             // INT line of IOI2C boards (optional, chained INT can share it): ports are read on change only
 
     /* MODULE_INPUTS */
     #define INPUTS_COUNT                           2                     /** Number of inputs managed by the module */
@@ -487,6 +498,9 @@
     #define BUZZERS_OUTPUTS                        { \
                                                        OUTPUTS_BUZZER \
                                                    }
+    #define BUZZERS_TYPES                          { \
+                                                       BUZZER_TYPE_ON_OFF \
+                                                   }                     /** BUZZER_TYPE_ON_OFF (active buzzer) or BUZZER_TYPE_PWM (passive buzzer on a native pin) */
 
     // Aliases
     #define BUZZERS_ALARM                          0                     /** A buzzer to signal something */
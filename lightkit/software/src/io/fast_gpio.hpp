@@ -0,0 +1,137 @@
+/**
+  * @file   fast_gpio.hpp
+  * @brief  Direct register access to native GPIO
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef IO_FAST_GPIO_HPP
+#define IO_FAST_GPIO_HPP
+
+#include <Arduino.h>
+
+#ifdef ESP32
+#include "soc/gpio_struct.h"
+#else
+#include "esp8266_peri.h"
+#endif
+
+/**
+ * digitalWrite()/digitalRead() look the pin up in tables and check it on each
+ * call. These functions write the set/clear registers directly, which is safe
+ * from an ISR as each write only changes the bits of the mask. GPIO16 has no
+ * such registers, its read-modify-write is done with the interrupts masked.
+ *
+ * Masks cover the first bank: GPIO 0 to 15 on ESP8266, 0 to 31 on ESP32.
+ * GPIO16 (ESP8266) and GPIO 32 to 39 (ESP32) are handled by the pin functions.
+ * The pin must already be configured with pinMode().
+ */
+
+/** MACROS */
+#define fast_gpio_mask(pin) (1UL << (pin))
+
+#ifdef ESP32
+#define FAST_GPIO_MASK_PIN_COUNT 32
+#else
+#define FAST_GPIO_MASK_PIN_COUNT 16
+#endif
+
+#define is_fast_gpio_mask_pin(pin) ((pin) < FAST_GPIO_MASK_PIN_COUNT)
+
+/**
+ * @brief Set and clear several pins of the first bank
+ * @details Each mask is applied by a single register write,
+ * a pin in both masks ends cleared
+ *
+ * @param setMask Pins to set high
+ * @param clearMask Pins to set low
+ */
+static inline void fast_gpio_write_mask(uint32_t setMask, uint32_t clearMask)
+{
+#ifdef ESP32
+	if (setMask) {
+		GPIO.out_w1ts = setMask;
+	}
+	if (clearMask) {
+		GPIO.out_w1tc = clearMask;
+	}
+#else
+	if (setMask) {
+		GPOS = setMask;
+	}
+	if (clearMask) {
+		GPOC = clearMask;
+	}
+#endif
+}
+
+/**
+ * @brief Read all the pins of the first bank at once
+ *
+ * @return One bit per pin
+ */
+static inline uint32_t fast_gpio_read_mask(void)
+{
+#ifdef ESP32
+	return GPIO.in;
+#else
+	return GPI;
+#endif
+}
+
+/**
+ * @brief Write a native pin
+ *
+ * @param pin GPIO number
+ * @param state New level
+ */
+static inline void fast_gpio_write(uint8_t pin, bool state)
+{
+	if (is_fast_gpio_mask_pin(pin)) {
+		if (state) {
+			fast_gpio_write_mask(fast_gpio_mask(pin), 0);
+		} else {
+			fast_gpio_write_mask(0, fast_gpio_mask(pin));
+		}
+		return;
+	}
+
+#ifdef ESP32
+	if (state) {
+		GPIO.out1_w1ts.val = fast_gpio_mask(pin - 32);
+	} else {
+		GPIO.out1_w1tc.val = fast_gpio_mask(pin - 32);
+	}
+#else
+	// GPIO16 has its own register without set/clear, an ISR must not write it in between
+	uint32_t savedPs = xt_rsil(15);
+
+	if (state) {
+		GP16O |= 1;
+	} else {
+		GP16O &= ~1;
+	}
+	xt_wsr_ps(savedPs);
+#endif
+}
+
+/**
+ * @brief Read a native pin
+ *
+ * @param pin GPIO number
+ * @return Level of the pin
+ */
+static inline bool fast_gpio_read(uint8_t pin)
+{
+	if (is_fast_gpio_mask_pin(pin)) {
+		return (fast_gpio_read_mask() & fast_gpio_mask(pin)) != 0;
+	}
+
+#ifdef ESP32
+	return (GPIO.in1.val & fast_gpio_mask(pin - 32)) != 0;
+#else
+	return (GP16I & 0x01) != 0;
+#endif
+}
+
+#endif /* IO_FAST_GPIO_HPP */
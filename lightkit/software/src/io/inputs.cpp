@@ -8,6 +8,7 @@
 #define IO_INPUTS_CPP
 
 #include "inputs.hpp"
+#include "event/event.hpp"
 
 #ifdef MODULE_INPUTS
 
@@ -16,15 +17,181 @@ extern uint32_t tick;
 static uint32_t inputNextTick           = 0;
 struct input_t  inputData[INPUTS_COUNT] = { 0 };
 
-int inputs_init(void)
+// Pins and modes are checked at compile time
+static constexpr uint32_t inputPinTable[]  = INPUTS_PINS;
+static constexpr uint8_t  inputModeTable[] = INPUTS_MODES;
+static_assert(sizeof(inputPinTable) / sizeof(uint32_t) == INPUTS_COUNT, "INPUTS_PINS must have INPUTS_COUNT pins");
+static_assert(sizeof(inputModeTable) == INPUTS_COUNT, "INPUTS_MODES must have INPUTS_COUNT modes");
+static_assert(io_are_valid_inputs(inputPinTable, INPUTS_COUNT), "INPUTS_PINS has an invalid pin");
+
+// Edge queue: filled by inputs_isr(), emptied by inputs_main()
+// Lock free as there is only one producer and one consumer
+static volatile struct input_edge_t edgeQueue[INPUTS_EDGE_QUEUE_SIZE];
+static volatile uint8_t             edgeHead    = 0; /**< Written by the ISR only */
+static volatile uint8_t             edgeTail    = 0; /**< Written by inputs_main() only */
+static volatile uint32_t            edgeDropped = 0; /**< Edges lost because the queue was full */
+static uint32_t                     edgeDroppedReported = 0;
+#ifdef HAS_IOI2C_BOARD
+static IOI2CDriver::Status ioi2cPrevStatus[IOI2C_GROUP_MAX_DEVICE] = { IOI2CDriver::STATUS_NONE };
+#endif
+#if defined(HAS_IOI2C_BOARD) && defined(IOI2C_INT_PIN)
+static uint32_t ioi2cNextScanTick = 0;
+#endif
+
+/**
+ * @brief Record the edge of an interrupt input
+ * @note All GPIO interrupts have the same priority,
+ * so this ISR is the only producer of the queue
+ *
+ * @param arg Index of the input
+ */
+static void ICACHE_RAM_ATTR inputs_isr(void * arg)
+{
+	uint8_t i    = (uint8_t) (uintptr_t) arg;
+	uint8_t head = edgeHead;
+	uint8_t next = (head + 1) & (INPUTS_EDGE_QUEUE_SIZE - 1);
+
+	if (next == edgeTail) {
+		edgeDropped = edgeDropped + 1;
+		return;
+	}
+
+	edgeQueue[head].input  = i;
+	edgeQueue[head].isHigh = fast_gpio_read(inputData[i].pin);
+	edgeQueue[head].tick   = tick;
+
+	// Publish the edge once it is complete
+	edgeHead = next;
+}
+
+/**
+ * @brief Update the state of an input on a new edge
+ *
+ * @param i Index of the input
+ * @param isHigh New level of the input
+ * @param edgeTick When the edge happened
+ */
+static void input_set_edge(uint8_t i, bool isHigh, uint32_t edgeTick)
+{
+	_unset(inputData[i].state, INPUT_STATE_LONG_SENT);
+	if (isHigh) {
+		inputData[i].risingTick = edgeTick;
+		_set(inputData[i].state, INPUT_STATE_RISING);
+		_set(inputData[i].state, INPUT_STATE_IS_HIGH);
+		event_publish(EVENT_INPUT_RISING, i, 1);
+	} else {
+		inputData[i].fallingTick = edgeTick;
+		_set(inputData[i].state, INPUT_STATE_FALLING);
+		_unset(inputData[i].state, INPUT_STATE_IS_HIGH);
+		event_publish(EVENT_INPUT_FALLING, i, 0);
+	}
+}
+
+/**
+ * @brief Update the state of an input with a stable level
+ * and detect long holds, published once per hold
+ *
+ * @param i Index of the input
+ * @param isHigh Level of the input
+ */
+static void input_set_level(uint8_t i, bool isHigh)
+{
+	if (isHigh) {
+		_set(inputData[i].state, INPUT_STATE_IS_HIGH);
+		if (_isunset(inputData[i].state, INPUT_STATE_LONG_SENT) && (tick >= (inputData[i].risingTick + INPUTS_LONG_HOLD_TIME))) {
+			_set(inputData[i].state, INPUT_STATE_LONG_HIGH);
+			_set(inputData[i].state, INPUT_STATE_LONG_SENT);
+			event_publish(EVENT_INPUT_LONG_HIGH, i, 1);
+		}
+	} else {
+		_unset(inputData[i].state, INPUT_STATE_IS_HIGH);
+		if (_isunset(inputData[i].state, INPUT_STATE_LONG_SENT) && (tick >= (inputData[i].fallingTick + INPUTS_LONG_HOLD_TIME))) {
+			_set(inputData[i].state, INPUT_STATE_LONG_LOW);
+			_set(inputData[i].state, INPUT_STATE_LONG_SENT);
+			event_publish(EVENT_INPUT_LONG_LOW, i, 0);
+		}
+	}
+}
+
+/**
+ * @brief Debounce the edges caught by interrupt
+ * @details The first edge is accepted right away, next ones are ignored
+ * during INPUTS_DEBOUNCE_MS. The level is read again at the end of this
+ * time in case the input did not come back to the accepted level.
+ */
+static void inputs_process_edges(void)
 {
-	const uint32_t inputPins[INPUTS_COUNT]  = INPUTS_PINS;
-	const uint8_t  inputModes[INPUTS_COUNT] = INPUTS_MODES;
+	uint8_t tail = edgeTail;
+
+	while (tail != edgeHead) {
+		volatile struct input_edge_t * pEdge = &edgeQueue[tail];
+		struct input_t *               pIn   = &inputData[pEdge->input];
+
+		if ((pEdge->tick - pIn->lastEdgeTick) < INPUTS_DEBOUNCE_MS) {
+			// Bouncing
+			pIn->needResync = true;
+		} else if (pEdge->isHigh != is_input_high(pEdge->input)) {
+			input_set_edge(pEdge->input, pEdge->isHigh, pEdge->tick);
+			pIn->lastEdgeTick = pEdge->tick;
+		}
+
+		tail     = (tail + 1) & (INPUTS_EDGE_QUEUE_SIZE - 1);
+		edgeTail = tail;
+	}
+
+	for (uint8_t i = 0; i < INPUTS_COUNT; i++) {
+		struct input_t * pIn = &inputData[i];
+		bool             isHigh;
+
+		if (!pIn->needResync || ((tick - pIn->lastEdgeTick) < INPUTS_DEBOUNCE_MS)) {
+			continue;
+		}
+		pIn->needResync = false;
+
+		isHigh = input_read(pIn->pin);
+		if (isHigh != is_input_high(i)) {
+			input_set_edge(i, isHigh, tick);
+			pIn->lastEdgeTick = tick;
+		}
+	}
+
+	if (edgeDropped != edgeDroppedReported) {
+		edgeDroppedReported = edgeDropped;
+		log_warn("Input edge queue is full, %u edges dropped", edgeDroppedReported);
+	}
+}
+
+/**
+ * @brief Attach an interrupt on both edges of an input
+ *
+ * @param i Index of the input
+ * @return 0: OK, -1: The pin can't interrupt, it will be polled
+ */
+static int input_attach_interrupt(uint8_t i)
+{
+	uint32_t pin = inputData[i].pin;
+
+	if (!is_io_special_none(pin) || (digitalPinToInterrupt(pin) < 0)) {
+		log_warn("Input %d can't interrupt, polling it instead", i);
+		return -1;
+	}
+
+	// Start from the current level, without edge
+	if (input_read(pin)) {
+		_set(inputData[i].state, INPUT_STATE_IS_HIGH);
+	}
+
+	inputData[i].isInterrupt = true;
+	attachInterruptArg(digitalPinToInterrupt(pin), inputs_isr, (void *) (uintptr_t) i, CHANGE);
+	return 0;
+}
 
+int inputs_init(void)
+{
 	for (uint8_t i = 0; i < INPUTS_COUNT; i++) {
 		// We do a hard copy here
-		inputData[i].pin  = inputPins[i];
-		inputData[i].mode = inputModes[i];
+		inputData[i].pin  = inputPinTable[i];
+		inputData[i].mode = inputModeTable[i];
 
 		if (is_io_special_none(inputData[i].pin)) {
 			switch (inputData[i].mode) {
@@ -34,41 +201,97 @@ int inputs_init(void)
 			case I_U:
 				pinMode(inputData[i].pin, INPUT_PULLUP);
 				break;
+			case I_NI:
+				pinMode(inputData[i].pin, INPUT);
+				break;
+			case I_UI:
+				pinMode(inputData[i].pin, INPUT_PULLUP);
+				break;
 			case I_A:
 				/* Analog pins are init in analogRead() */
 				break;
 			default:
-				log_error("Unkwnon input mode: %d", inputModes[i]);
+				log_error("Unkwnon input mode: %d", inputModeTable[i]);
 				break;
 			}
 		}
+
+		if (is_input_mode_interrupt(inputData[i].mode)) {
+			input_attach_interrupt(i);
+		}
 	}
 
+#if defined(HAS_IOI2C_BOARD) && defined(IOI2C_INT_PIN)
+	ioi2cGroup.begin_interrupt(IOI2C_INT_PIN);
+#endif
+
 	return 0;
 }
 
 uint8_t input_read(uint32_t specialPin)
 {
-	if (is_io_special_none(specialPin)) {
-		return digitalRead(specialPin);
+	int8_t read = io_read(specialPin);
+
+	if (read < 0) {
+		return 0; // IOI2C device status changes are logged by inputs_ioi2c_scan()
 	}
 
+	return (uint8_t) read;
+}
+
 #ifdef HAS_IOI2C_BOARD
-	int8_t read;
+/**
+ * @brief Refresh the IOI2C ports, one read per device
+ * @details Inputs are then served from its result. With the INT line,
+ * ports are only read when they changed: the last read is still valid
+ * otherwise, so polled inputs can be debounced from it.
+ */
+static void inputs_ioi2c_scan(void)
+{
+#ifdef IOI2C_INT_PIN
+	if (!ioi2cGroup.is_changed() && (tick < ioi2cNextScanTick)) {
+		return;
+	}
+	ioi2cNextScanTick = tick + IOI2C_SAFETY_POLL_MS;
+#endif
+
+	ioi2cGroup.scan();
+
+	// Only log when a device goes offline or comes back
+	for (uint8_t i = 0; i < ioi2cGroup.get_device_count(); i++) {
+		IOI2CDriver *       pDevice = ioi2cGroup.get_device(i);
+		IOI2CDriver::Status status  = pDevice->get_status();
+
+		if ((status == ioi2cPrevStatus[i]) || (status == IOI2CDriver::STATUS_COMM_ERROR)) {
+			continue;
+		}
 
-	if (is_io_special_ioi2c(specialPin)) {
-		read = ioi2cGroup.input_read(io_special_get_pin(specialPin));
-		if (read < 0) {
-			log_error("Unable to read input from IOI2C device");
-			return 0;
+		if (status == IOI2CDriver::STATUS_OFFLINE) {
+			log_error("IOI2C device 0x%02X is offline", pDevice->get_address());
+		} else if (ioi2cPrevStatus[i] == IOI2CDriver::STATUS_OFFLINE) {
+			log_info("IOI2C device 0x%02X is back", pDevice->get_address());
 		}
-		return (uint8_t) read;
+		ioi2cPrevStatus[i] = status;
 	}
-#endif
+}
 
-	log_warn("Unsupported special input function");
-	return 0;
+/**
+ * @brief Print the transactions made on the IOI2C bus
+ */
+void inputs_print_ioi2c_stats(void)
+{
+	log_raw("IOI2C: %u transactions, %u errors, %u bus clears\n\r",
+			ioi2cGroup.get_transaction_count(), ioi2cGroup.get_error_count(), ioi2cGroup.get_bus_clear_count());
+
+	for (uint8_t i = 0; i < ioi2cGroup.get_device_count(); i++) {
+		IOI2CDriver * pDevice = ioi2cGroup.get_device(i);
+
+		log_raw("  0x%02X: %-10s %u transactions, %u errors\n\r",
+				pDevice->get_address(), pDevice->get_status_name(),
+				pDevice->get_transaction_count(), pDevice->get_error_count());
+	}
 }
+#endif
 
 uint16_t input_analog_read(uint32_t i)
 {
@@ -86,10 +309,16 @@ uint16_t input_analog_read(uint32_t i)
 
 void inputs_main(void)
 {
+	inputs_process_edges();
+
 	if (tick < inputNextTick) {
 		return;
 	}
-	inputNextTick = tick + 10;
+	inputNextTick = tick + INPUTS_POLLING_PERIOD_MS;
+
+#ifdef HAS_IOI2C_BOARD
+	inputs_ioi2c_scan();
+#endif
 
 	for (uint8_t i = 0; i < INPUTS_COUNT; i++) {
 		// Do not read Analog pins
@@ -97,6 +326,19 @@ void inputs_main(void)
 			continue;
 		}
 
+		// Edges are already known, only look for long holds
+		if (inputData[i].isInterrupt) {
+			input_set_level(i, is_input_high(i));
+			continue;
+		}
+
+#ifdef HAS_IOI2C_BOARD
+		// Keep the last state while the device does not answer
+		if (is_io_special_ioi2c(inputData[i].pin) && (ioi2cGroup.input_read(io_special_get_pin(inputData[i].pin)) < 0)) {
+			continue;
+		}
+#endif
+
 		// Shift 1 bit
 		inputData[i].reads <<= 1;
 
@@ -107,29 +349,25 @@ void inputs_main(void)
 
 		// High
 		if (inputData[i].reads == 0xFF) {
-			_set(inputData[i].state, INPUT_STATE_IS_HIGH);
-			if (tick >= (inputData[i].risingTick + INPUTS_LONG_HOLD_TIME)) {
-				_set(inputData[i].state, INPUT_STATE_LONG_HIGH);
-				inputData[i].risingTick = 0;
-			}
+			input_set_level(i, true);
 		}
 		// Low
 		else if (inputData[i].reads == 0x00) {
-			_unset(inputData[i].state, INPUT_STATE_IS_HIGH);
-			if (tick >= (inputData[i].fallingTick + INPUTS_LONG_HOLD_TIME)) {
-				_set(inputData[i].state, INPUT_STATE_LONG_LOW);
-				inputData[i].fallingTick = 0;
-			}
+			input_set_level(i, false);
 		}
 		// Rising
 		else if (inputData[i].reads == 0x0F) {
 			inputData[i].risingTick = tick;
+			_unset(inputData[i].state, INPUT_STATE_LONG_SENT);
 			_set(inputData[i].state, INPUT_STATE_RISING);
+			event_publish(EVENT_INPUT_RISING, i, 1);
 		}
 		// Falling
 		else if (inputData[i].reads == 0xF0) {
 			inputData[i].fallingTick = tick;
+			_unset(inputData[i].state, INPUT_STATE_LONG_SENT);
 			_set(inputData[i].state, INPUT_STATE_FALLING);
+			event_publish(EVENT_INPUT_FALLING, i, 0);
 		}
 	}
 }
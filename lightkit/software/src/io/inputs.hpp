@@ -18,6 +18,17 @@
 #define INPUT_STATE_LONG_HIGH 0x04
 #define INPUT_STATE_LONG_LOW  0x08
 #define INPUT_STATE_IS_HIGH   0x10
+#define INPUT_STATE_LONG_SENT 0x20 /**< Long hold of the current level is published, cleared by the next edge */
+
+/* Sampling */
+#define INPUTS_POLLING_PERIOD_MS 10 /**< Polled inputs are read at this period, an edge needs 4 reads */
+#define INPUTS_EDGE_QUEUE_SIZE   16 /**< Edges caught by interrupt waiting for inputs_main(), power of 2 */
+#ifndef INPUTS_DEBOUNCE_MS
+#define INPUTS_DEBOUNCE_MS 20 /**< Interrupt inputs ignore edges during this time after an accepted one */
+#endif
+#ifndef IOI2C_SAFETY_POLL_MS
+#define IOI2C_SAFETY_POLL_MS 1000 /**< With IOI2C_INT_PIN, IOI2C ports are still read at this period in case INT was missed */
+#endif
 
 // Structures
 struct input_t {
@@ -27,6 +38,16 @@ struct input_t {
 	uint8_t  state;
 	uint32_t risingTick;
 	uint32_t fallingTick;
+	bool     isInterrupt;  /**< Edges are caught by interrupt instead of polling */
+	bool     needResync;   /**< Edges were ignored during debounce, read the level once it ends */
+	uint32_t lastEdgeTick; /**< Tick of the last accepted edge (Interrupt only) */
+};
+
+/** An edge caught by interrupt */
+struct input_edge_t {
+	uint8_t  input;  /**< Index in inputData[] */
+	uint8_t  isHigh; /**< Level read right after the edge */
+	uint32_t tick;   /**< When the edge happened */
 };
 
 /** extern variable used in the macro below */
@@ -48,10 +69,15 @@ extern struct input_t inputData[INPUTS_COUNT];
 #define reset_input_falling(i) _unset(inputData[i].state, INPUT_STATE_FALLING)
 #define reset_input_rising(i)  _unset(inputData[i].state, INPUT_STATE_RISING)
 
+#define is_input_mode_interrupt(mode) (((mode) == I_NI) || ((mode) == I_UI))
+
 int      inputs_init();
 uint8_t  input_read(uint32_t i);
 uint16_t input_analog_read(uint32_t i);
 void     inputs_main();
+#ifdef HAS_IOI2C_BOARD
+void     inputs_print_ioi2c_stats(void);
+#endif
 
 #endif /** MODULE_INPUTS */
 #endif /* IO_INPUTS_HPP */
\ No newline at end of file
@@ -11,6 +11,7 @@
 // clang-format off
 
 #include "global.hpp"
+#include "fast_gpio.hpp"
 
 #ifdef HAS_IOI2C_BOARD
 #include "drivers/ioi2c/ioi2c_group.h"
@@ -21,6 +22,15 @@
 #define IO_SPECIAL_MASK       (0x3 << IO_SPECIAL)
 #define io_special_get_pin(i) (i & ~IO_SPECIAL_MASK)
 
+#define io_special_get_type(i) (i & IO_SPECIAL_MASK)
+
+/** Number of native GPIO */
+#ifdef ESP32
+#define IO_NATIVE_PIN_COUNT   40
+#else
+#define IO_NATIVE_PIN_COUNT   17
+#endif
+
 /** MACROS */
 #define IO_SPECIAL_NONE       0
 #define io_special_none(i)    (i)
@@ -32,12 +42,105 @@
 
 #ifdef HAS_IOI2C_BOARD
     #ifdef IO_OUTPUTS_CPP
-        const uint8_t ioi2cAddrArray[] = IOI2C_ADDRESSES;
-        IOI2CGroup    ioi2cGroup(IOI2C_SDA, IOI2C_SCL, ioi2cAddrArray, sizeof(ioi2cAddrArray));
+        const IOI2CBus ioi2cBusArray[]  = IOI2C_BUSES;
+        const uint16_t ioi2cAddrArray[] = IOI2C_ADDRESSES;
+        IOI2CGroup     ioi2cGroup(ioi2cBusArray, sizeof(ioi2cBusArray) / sizeof(IOI2CBus),
+                                  ioi2cAddrArray, sizeof(ioi2cAddrArray) / sizeof(uint16_t));
     #else
-        extern const uint8_t ioi2cAddrArray[];
-        extern IOI2CGroup    ioi2cGroup;
+        extern const IOI2CBus ioi2cBusArray[];
+        extern const uint16_t ioi2cAddrArray[];
+        extern IOI2CGroup     ioi2cGroup;
     #endif
 #endif
 
+/**
+ * Backends of the pins, one specialization per IO_SPECIAL_* type
+ * The type is known at compile time from the pin tables, so a call
+ * with a constant pin goes straight to the backend.
+ * A new IO board (shift registers, MCP23017...) only needs its own
+ * IO_SPECIAL_* value and specialization below.
+ */
+template <uint32_t special>
+struct io_driver;
+
+template <>
+struct io_driver<IO_SPECIAL_NONE> {
+    static constexpr bool is_valid_input(uint32_t pin)  { return pin < IO_NATIVE_PIN_COUNT; }
+    static constexpr bool is_valid_output(uint32_t pin) { return pin < IO_NATIVE_PIN_COUNT; }
+    static inline int8_t  read(uint32_t pin)            { return fast_gpio_read(pin); }
+    static inline void    write(uint32_t pin, bool state) { fast_gpio_write(pin, state); }
+};
+
+#ifdef HAS_IOI2C_BOARD
+template <>
+struct io_driver<IO_SPECIAL_IOI2C> {
+    static constexpr bool is_valid_input(uint32_t pin)  { return pin < (IOI2C_GROUP_MAX_DEVICE * IOI2C_INPUT_COUNT); }
+    static constexpr bool is_valid_output(uint32_t pin) { return pin < (IOI2C_GROUP_MAX_DEVICE * IOI2C_OUTPUT_COUNT); }
+    static inline int8_t  read(uint32_t pin)            { return ioi2cGroup.input_read(pin); }
+    static inline void    write(uint32_t pin, bool state) { ioi2cGroup.output_write(pin, state); }
+};
+#endif
+
+/** Compile time checks of the pin tables */
+constexpr bool io_is_valid_input(uint32_t pin)
+{
+    return (io_special_get_type(pin) == IO_SPECIAL_NONE)  ? io_driver<IO_SPECIAL_NONE>::is_valid_input(pin) :
+#ifdef HAS_IOI2C_BOARD
+           (io_special_get_type(pin) == IO_SPECIAL_IOI2C) ? io_driver<IO_SPECIAL_IOI2C>::is_valid_input(io_special_get_pin(pin)) :
+#endif
+           false;
+}
+
+constexpr bool io_is_valid_output(uint32_t pin)
+{
+    return (io_special_get_type(pin) == IO_SPECIAL_NONE)  ? io_driver<IO_SPECIAL_NONE>::is_valid_output(pin) :
+#ifdef HAS_IOI2C_BOARD
+           (io_special_get_type(pin) == IO_SPECIAL_IOI2C) ? io_driver<IO_SPECIAL_IOI2C>::is_valid_output(io_special_get_pin(pin)) :
+#endif
+           false;
+}
+
+constexpr bool io_are_valid_inputs(const uint32_t * pins, uint32_t count)
+{
+    return (count == 0) || (io_is_valid_input(pins[0]) && io_are_valid_inputs(pins + 1, count - 1));
+}
+
+constexpr bool io_are_valid_outputs(const uint32_t * pins, uint32_t count)
+{
+    return (count == 0) || (io_is_valid_output(pins[0]) && io_are_valid_outputs(pins + 1, count - 1));
+}
+
+/**
+ * @brief Read a pin through its backend
+ * @return Level of the pin, -1 if it can't be read
+ */
+static inline int8_t io_read(uint32_t pin)
+{
+    switch (io_special_get_type(pin)) {
+#ifdef HAS_IOI2C_BOARD
+    case IO_SPECIAL_IOI2C:
+        return io_driver<IO_SPECIAL_IOI2C>::read(io_special_get_pin(pin));
+#endif
+    default:
+        return io_driver<IO_SPECIAL_NONE>::read(pin);
+    }
+}
+
+/**
+ * @brief Write a pin through its backend
+ */
+static inline void io_write(uint32_t pin, bool state)
+{
+    switch (io_special_get_type(pin)) {
+#ifdef HAS_IOI2C_BOARD
+    case IO_SPECIAL_IOI2C:
+        io_driver<IO_SPECIAL_IOI2C>::write(io_special_get_pin(pin), state);
+        break;
+#endif
+    default:
+        io_driver<IO_SPECIAL_NONE>::write(pin, state);
+        break;
+    }
+}
+
 #endif /* IO_IO_HPP */
\ No newline at end of file
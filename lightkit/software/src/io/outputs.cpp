@@ -12,7 +12,6 @@
 #ifdef MODULE_OUTPUTS
 
 struct output_t {
-	uint32_t pin;
 	bool     state;
 	uint32_t timeout;
 	bool     delayedState;
@@ -22,17 +21,17 @@ struct output_t {
 extern uint32_t        tick;
 static struct output_t outputData[OUTPUTS_COUNT] = { 0 };
 
+// Pins are checked at compile time
+static constexpr uint32_t outputPinTable[] = OUTPUTS_PINS;
+static_assert(sizeof(outputPinTable) / sizeof(uint32_t) == OUTPUTS_COUNT, "OUTPUTS_PINS must have OUTPUTS_COUNT pins");
+static_assert(io_are_valid_outputs(outputPinTable, OUTPUTS_COUNT), "OUTPUTS_PINS has an invalid pin");
+
 int outputs_init(void)
 {
-	const uint32_t outputPins[OUTPUTS_COUNT] = OUTPUTS_PINS;
-
 	for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) {
-		// Save the pin into the structure
-		outputData[i].pin = outputPins[i];
-
-		if (is_io_special_none(outputData[i].pin)) {
+		if (is_io_special_none(outputPinTable[i])) {
 			// Configure the pin as output
-			pinMode(outputData[i].pin, OUTPUT);
+			pinMode(outputPinTable[i], OUTPUT);
 		}
 	}
 
@@ -43,23 +42,55 @@ int outputs_init(void)
 	return 0;
 }
 
+/**
+ * @brief Set an output
+ * @note Outputs behind an IOI2C board are sent by output_main()
+ *
+ * @param i Index of the output
+ * @param state New state
+ */
 void output_set(uint32_t i, bool state)
 {
 	outputData[i].state = state;
+	io_write(outputPinTable[i], state);
+}
+
+/**
+ * @brief Set several outputs at the same time
+ * @details Native outputs of the first GPIO bank are written together with
+ * one set and one clear register write. Outputs behind an IOI2C board are
+ * sent right away, in one transaction per device
+ *
+ * @param outputTable Index of the outputs
+ * @param stateTable New state of each output
+ * @param count Size of the tables
+ */
+void output_set_multiple(const uint32_t * outputTable, const bool * stateTable, uint8_t count)
+{
+	uint32_t setMask   = 0;
+	uint32_t clearMask = 0;
+
+	for (uint8_t i = 0; i < count; i++) {
+		uint32_t pin = outputPinTable[outputTable[i]];
+
+		if (!is_io_special_none(pin) || !is_fast_gpio_mask_pin(pin)) {
+			output_set(outputTable[i], stateTable[i]);
+			continue;
+		}
 
-	if (is_io_special_none(outputData[i].pin)) {
-		digitalWrite(outputData[i].pin, state);
-		return;
+		outputData[outputTable[i]].state = stateTable[i];
+		if (stateTable[i]) {
+			setMask |= fast_gpio_mask(pin);
+		} else {
+			clearMask |= fast_gpio_mask(pin);
+		}
 	}
 
+	fast_gpio_write_mask(setMask, clearMask);
+
 #ifdef HAS_IOI2C_BOARD
-	if (is_io_special_ioi2c(outputData[i].pin)) {
-		ioi2cGroup.output_write(io_special_get_pin(outputData[i].pin), state);
-		return;
-	}
+	ioi2cGroup.commit();
 #endif
-
-	log_warn("Unsupported special output function : pin = 0x%02X", outputData[i].pin);
 }
 
 void output_delayed_set(uint32_t i, bool state, uint32_t delay)
@@ -77,6 +108,17 @@ bool output_get(uint32_t i)
 	return outputData[i].state;
 }
 
+/**
+ * @brief Get the pin of an output
+ *
+ * @param i Index of the output
+ * @return Pin, with its IO_SPECIAL_* bits
+ */
+uint32_t output_get_pin(uint32_t i)
+{
+	return outputPinTable[i];
+}
+
 void output_main(void)
 {
 	for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) {
@@ -88,6 +130,11 @@ void output_main(void)
 			output_set(i, outputData[i].delayedState);
 		}
 	}
+
+#ifdef HAS_IOI2C_BOARD
+	// Send all the IOI2C outputs changed during this loop
+	ioi2cGroup.commit();
+#endif
 }
 
 #endif /* MODULE_OUTPUTS */
\ No newline at end of file
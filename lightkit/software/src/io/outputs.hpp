@@ -12,11 +12,13 @@
 
 #ifdef MODULE_OUTPUTS
 
-int  outputs_init();
-void output_set(uint32_t i, bool state);
-void output_delayed_set(uint8_t i, bool state, uint32_t delay);
-bool output_get(uint8_t i);
-void output_main(void);
+int      outputs_init();
+void     output_set(uint32_t i, bool state);
+void     output_set_multiple(const uint32_t * outputTable, const bool * stateTable, uint8_t count);
+void     output_delayed_set(uint32_t i, bool state, uint32_t delay);
+bool     output_get(uint32_t i);
+uint32_t output_get_pin(uint32_t i);
+void     output_main(void);
 
 #endif /** MODULE_OUTPUTS */
 #endif /* IO_OUTPUTS_HPP */
\ No newline at end of file
@@ -11,14 +11,18 @@
 #include "cmd/serial.hpp"
 #include "cmd/telnet.hpp"
 #include "cmd/term.hpp"
+#include "domoticz/domoticz.hpp"
+#include "event/event.hpp"
 #include "feu_rouge/feu_rouge.hpp"
 #include "file_sys/file_sys.hpp"
 #include "flash/flash.hpp"
 #include "global.hpp"
 #include "io/inputs.hpp"
 #include "io/outputs.hpp"
+#include "mqtt/mqtt.hpp"
 #include "ota/ota.hpp"
 #include "relay/relay.hpp"
+#include "rpc/rpc.hpp"
 #include "script/script.hpp"
 #include "status_led/status_led.hpp"
 #include "stripled/stripled.hpp"
@@ -27,6 +31,10 @@
 #include "web/web_server.hpp"
 #include "wifi/wifi.hpp"
 
+#ifndef ESP32
+#include <core_esp8266_waveform.h>
+#endif
+
 uint32_t tick = 0, lastTick = 0;
 
 /**
@@ -39,6 +47,34 @@ void ICACHE_RAM_ATTR tick_interrupt(void)
 	tick++;
 }
 
+#ifndef ESP32
+/**
+ * @brief Increment tick from the waveform generator of ESP8266
+ * @details The generator owns Timer1 for tone() and analogWrite(),
+ * it calls us back on its own interrupt. It may do it earlier than asked,
+ * so ticks are counted from the CPU cycle counter.
+ *
+ * @return Microseconds until the next tick
+ */
+static uint32_t ICACHE_RAM_ATTR tick_timer1_callback(void)
+{
+	static uint32_t nextTickCycle = 0;
+	uint32_t        now           = ESP.getCycleCount();
+
+	if ((int32_t) (now - nextTickCycle) >= 0) {
+		tick_interrupt();
+		nextTickCycle += microsecondsToClockCycles(1000);
+
+		// First call or interrupts were masked for more than a tick
+		if ((int32_t) (now - nextTickCycle) >= 0) {
+			nextTickCycle = now + microsecondsToClockCycles(1000);
+		}
+	}
+
+	return clockCyclesToMicroseconds(nextTickCycle - now);
+}
+#endif
+
 static int config_tick(void)
 {
 	// In both ESP32 and ESP8266, timers are working with a 80MHz clock
@@ -51,9 +87,8 @@ static int config_tick(void)
 	timerAlarmEnable(timer);
 #else
 	// Timer0 is used for wifi on ESP8266
-	timer1_attachInterrupt(tick_interrupt);
-	timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
-	timer1_write(5000); // 80MHz / 16 / 5000 = 1kHz
+	// Timer1 is shared with the waveform generator (tone, PWM)
+	setTimer1Callback(tick_timer1_callback);
 #endif
 
 	return 0;
@@ -73,6 +108,7 @@ static int init_modules(void)
 	log_info("Starting %s", FIRMWARE_VERSION);
 
 	CHECK_CALL(status_init())
+	CHECK_CALL(event_init())
 	CHECK_CALL(flash_init())
 	CHECK_CALL(file_sys_init())
 #ifdef MODULE_INPUTS
@@ -87,6 +123,9 @@ static int init_modules(void)
 	CHECK_CALL(wifi_init())
 #ifdef MODULE_TELNET /* Needs to be after wifi init */
 	CHECK_CALL(telnet_init())
+#endif
+#ifdef MODULE_RPC /* Needs to be after wifi init */
+	CHECK_CALL(rpc_init())
 #endif
 	CHECK_CALL(ota_init())
 #ifdef MODULE_WEBSERVER
@@ -95,6 +134,12 @@ static int init_modules(void)
 #ifdef MODULE_TEMPERATURE
 	CHECK_CALL(temp_init())
 #endif
+#ifdef MODULE_DOMOTICZ
+	CHECK_CALL(domoticz_init())
+#endif
+#ifdef MODULE_MQTT
+	CHECK_CALL(mqtt_init())
+#endif
 #ifdef MODULE_STRIPLED
 	CHECK_CALL(stripled_init())
 #endif
@@ -110,6 +155,7 @@ static int init_modules(void)
 #ifdef MODULE_BUZZER
 	CHECK_CALL(buzzer_init())
 #endif
+	CHECK_CALL(script_init())
 	return 0;
 }
 
@@ -144,6 +190,12 @@ void loop(void)
 #ifdef MODULE_TEMPERATURE
 		temp_main();
 #endif
+#ifdef MODULE_DOMOTICZ
+		domoticz_main();
+#endif
+#ifdef MODULE_MQTT
+		mqtt_main();
+#endif
 #ifdef MODULE_STRIPLED
 		stripled_main();
 #endif
@@ -153,6 +205,9 @@ void loop(void)
 #ifdef MODULE_TELNET
 		telnet_main();
 #endif
+#ifdef MODULE_RPC
+		rpc_main();
+#endif
 #ifdef MODULE_STATUS_LED
 		status_led_main();
 #endif
@@ -168,6 +223,7 @@ void loop(void)
 #ifdef MODULE_BUZZER
 		buzzer_main();
 #endif
+		event_main();
 		script_main();
 	}
 }
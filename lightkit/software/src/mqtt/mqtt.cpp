@@ -0,0 +1,860 @@
+/**
+  * @file   mqtt.cpp
+  * @brief  Publish the state of the board to a MQTT broker
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "mqtt.hpp"
+#include "cmd/cmd.hpp"
+#include "event/event.hpp"
+#include "relay/relay.hpp"
+
+#ifdef MODULE_MQTT
+
+#ifdef ESP32
+#include <WiFi.h>
+#else
+#include <ESP8266WiFi.h>
+#endif
+
+/* Control packets, MQTT 3.1.1 section 2.2 */
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PUBACK     0x40
+#define MQTT_SUBSCRIBE  0x82 /**< With the reserved bit set */
+#define MQTT_SUBACK     0x90
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+#define MQTT_PUBLISH_DUP    0x08
+#define MQTT_PUBLISH_QOS1   0x02
+#define MQTT_PUBLISH_RETAIN 0x01
+
+#define MQTT_CONNECT_USER        0x80
+#define MQTT_CONNECT_PWD         0x40
+#define MQTT_CONNECT_WILL_RETAIN 0x20
+#define MQTT_CONNECT_WILL_QOS1   0x08
+#define MQTT_CONNECT_WILL        0x04
+#define MQTT_CONNECT_CLEAN       0x02 /**< Not used: the broker keeps our session */
+
+#define MQTT_TX_HEADER_SIZE 5 /**< Type and up to 4 bytes of remaining length */
+
+enum mqtt_state_e {
+	MQTT_STATE_DISCONNECTED = 0, /**< Waiting for WiFi or for the next try */
+	MQTT_STATE_CONNECTING,       /**< CONNECT is sent, waiting for CONNACK */
+	MQTT_STATE_CONNECTED
+};
+
+/** Packets are read a few bytes each tick */
+enum mqtt_rx_state_e {
+	MQTT_RX_TYPE = 0,
+	MQTT_RX_LENGTH,
+	MQTT_RX_BODY
+};
+
+// Structures
+struct mqtt_msg_t {
+	char     topic[MQTT_TOPIC_SIZE]; /**< Without the prefix */
+	char     payload[MQTT_PAYLOAD_SIZE];
+	uint8_t  flags;    /**< MQTT_PUBLISH_* */
+	uint16_t packetId; /**< QoS 1 only, kept when sent again */
+	bool     isSent;   /**< QoS 1 waiting for PUBACK */
+	uint32_t sentTick;
+};
+
+// Variables
+extern uint32_t          tick;
+static WiFiClient        client;
+static bool              isEnabled   = false;
+static uint8_t           mqttState   = MQTT_STATE_DISCONNECTED;
+static uint32_t          nextTryTick = 0;
+static uint8_t           failCount   = 0; /**< Failures in a row, for the back-off */
+static uint32_t          connackEndTick;
+static uint32_t          lastTxTick;
+static uint32_t          lastRxTick;
+static uint32_t          lastPingTick;
+static char              topicPrefix[MQTT_PREFIX_SIZE];
+static char              clientId[24];
+static uint16_t          nextPacketId = 1;
+static struct mqtt_msg_t queue[MQTT_QUEUE_SIZE];
+static uint8_t           queueCount = 0;
+
+// Packet being built
+static uint8_t  txBuffer[MQTT_TX_BUFFER_SIZE];
+static uint16_t txLength;
+static bool     txOverflow;
+
+// Packet being read
+static uint8_t  rxState = MQTT_RX_TYPE;
+static uint8_t  rxType;
+static uint32_t rxLength;
+static uint8_t  rxShift;
+static uint32_t rxIndex;
+static uint8_t  rxBuffer[MQTT_RX_BUFFER_SIZE];
+
+#ifdef MODULE_STRIPLED
+// Strip state last published
+static uint32_t stripNextCheckTick = 0;
+static bool     isStripKnown       = false; /**< Publish everything on the next check */
+static bool     stripState, stripDemo;
+static uint8_t  stripBrightness, stripAnim;
+static uint32_t stripColor;
+#endif
+
+/**
+ * @brief Start to build a packet
+ */
+static void mqtt_tx_begin(void)
+{
+	txLength   = MQTT_TX_HEADER_SIZE;
+	txOverflow = false;
+}
+
+static void mqtt_tx_bytes(const void * data, uint16_t length)
+{
+	if (length == 0) {
+		return;
+	}
+	if ((txLength + length) > MQTT_TX_BUFFER_SIZE) {
+		txOverflow = true;
+		return;
+	}
+	memcpy(&txBuffer[txLength], data, length);
+	txLength += length;
+}
+
+static void mqtt_tx_u16(uint16_t value)
+{
+	uint8_t bytes[2] = {(uint8_t) (value >> 8), (uint8_t) value};
+
+	mqtt_tx_bytes(bytes, 2);
+}
+
+/**
+ * @brief Add a string, prefixed by its length
+ *
+ * @param str The string
+ * @param suffix Appended to str, can be NULL
+ */
+static void mqtt_tx_string(const char * str, const char * suffix)
+{
+	uint16_t length       = strlen(str);
+	uint16_t suffixLength = (suffix != NULL) ? strlen(suffix) : 0;
+
+	mqtt_tx_u16(length + suffixLength);
+	mqtt_tx_bytes(str, length);
+	mqtt_tx_bytes(suffix, suffixLength);
+}
+
+/**
+ * @brief Add the fixed header and send the packet
+ *
+ * @param type Packet type and flags
+ * @return 0: OK, -1: Packet is too big or the connection is lost
+ */
+static int mqtt_tx_send(uint8_t type)
+{
+	uint32_t remaining = txLength - MQTT_TX_HEADER_SIZE;
+	uint8_t  lengthBytes[4];
+	uint8_t  lengthSize = 0;
+	uint16_t start;
+
+	if (txOverflow) {
+		log_error("MQTT packet is too big");
+		return -1;
+	}
+
+	do {
+		lengthBytes[lengthSize] = remaining & 0x7F;
+		remaining >>= 7;
+		if (remaining > 0) {
+			_set(lengthBytes[lengthSize], 0x80);
+		}
+		lengthSize++;
+	} while (remaining > 0);
+
+	// The header is written just before the body
+	start           = MQTT_TX_HEADER_SIZE - 1 - lengthSize;
+	txBuffer[start] = type;
+	memcpy(&txBuffer[start + 1], lengthBytes, lengthSize);
+
+	if (client.write(&txBuffer[start], txLength - start) != (size_t) (txLength - start)) {
+		return -1;
+	}
+	lastTxTick = tick;
+
+	return 0;
+}
+
+/**
+ * @brief Remove a message from the queue
+ *
+ * @param index Index of the message
+ */
+static void mqtt_queue_remove(uint8_t index)
+{
+	queueCount--;
+	memmove(&queue[index], &queue[index + 1], (queueCount - index) * sizeof(struct mqtt_msg_t));
+}
+
+/**
+ * @brief Send again a QoS 1 message that was not acknowledged
+ *
+ * @param index Index of the message
+ */
+static void mqtt_queue_resend(uint8_t index)
+{
+	queue[index].isSent = false;
+	_set(queue[index].flags, MQTT_PUBLISH_DUP);
+}
+
+/**
+ * @brief Get an identifier for a QoS 1 message or a subscription
+ *
+ * @return The identifier, never 0
+ */
+static uint16_t mqtt_next_packet_id(void)
+{
+	if (nextPacketId == 0) {
+		nextPacketId = 1;
+	}
+	return nextPacketId++;
+}
+
+/**
+ * @brief The connection failed, try again later
+ */
+static void mqtt_retry_later(void)
+{
+	uint32_t retryDelay = MQTT_RETRY_MIN_MS;
+
+	client.stop();
+	mqttState = MQTT_STATE_DISCONNECTED;
+	rxState   = MQTT_RX_TYPE;
+
+	// In-flight messages are sent again once connected
+	for (uint8_t i = 0; i < queueCount; i++) {
+		if (queue[i].isSent) {
+			mqtt_queue_resend(i);
+		}
+	}
+
+	for (uint8_t i = 0; (i < failCount) && (retryDelay < MQTT_RETRY_MAX_MS); i++) {
+		retryDelay *= 2;
+	}
+	if (retryDelay > MQTT_RETRY_MAX_MS) {
+		retryDelay = MQTT_RETRY_MAX_MS;
+	}
+	if (failCount < UINT8_MAX) {
+		failCount++;
+	}
+
+	nextTryTick = tick + retryDelay;
+	log_warn("MQTT retry in %u ms", retryDelay);
+}
+
+/**
+ * @brief Open the connection and send CONNECT
+ *
+ * @return 0: OK, -1: Error
+ */
+static int mqtt_connect(void)
+{
+	uint8_t flags = MQTT_CONNECT_WILL | MQTT_CONNECT_WILL_QOS1 | MQTT_CONNECT_WILL_RETAIN;
+
+	client.stop();
+	client.setTimeout(MQTT_CONNECT_TIMEOUT_MS);
+	if (!client.connect(P_MQTT_HOST, P_MQTT_PORT)) {
+		log_error("Unable to connect to MQTT broker");
+		return -1;
+	}
+	client.setNoDelay(true);
+
+	if (strlen(P_MQTT_USER) > 0) {
+		_set(flags, MQTT_CONNECT_USER | MQTT_CONNECT_PWD);
+	}
+
+	mqtt_tx_begin();
+	mqtt_tx_string("MQTT", NULL);
+	txBuffer[txLength++] = 4; // Protocol level: 3.1.1
+	txBuffer[txLength++] = flags;
+	mqtt_tx_u16(MQTT_KEEP_ALIVE_S);
+	mqtt_tx_string(clientId, NULL);
+	// The broker tells we are gone if we disappear
+	mqtt_tx_string(topicPrefix, "status");
+	mqtt_tx_string("offline", NULL);
+	if (_isset(flags, MQTT_CONNECT_USER)) {
+		mqtt_tx_string(P_MQTT_USER, NULL);
+		mqtt_tx_string(P_MQTT_PWD, NULL);
+	}
+
+	if (mqtt_tx_send(MQTT_CONNECT) != 0) {
+		return -1;
+	}
+
+	rxState        = MQTT_RX_TYPE;
+	lastRxTick     = tick;
+	lastPingTick   = tick;
+	connackEndTick = tick + MQTT_CONNACK_TIMEOUT_MS;
+	mqttState      = MQTT_STATE_CONNECTING;
+
+	return 0;
+}
+
+/**
+ * @brief Send the next message of the queue
+ *
+ * @return 1: A message was sent, 0: Nothing to send, -1: Connection is lost
+ */
+static int mqtt_send_next(void)
+{
+	struct mqtt_msg_t * pMsg = NULL;
+	uint8_t             index;
+
+	for (index = 0; index < queueCount; index++) {
+		if (!queue[index].isSent) {
+			pMsg = &queue[index];
+			break;
+		}
+	}
+	if (pMsg == NULL) {
+		return 0;
+	}
+
+	mqtt_tx_begin();
+	mqtt_tx_string(topicPrefix, pMsg->topic);
+	if (_isset(pMsg->flags, MQTT_PUBLISH_QOS1)) {
+		if (pMsg->packetId == 0) {
+			pMsg->packetId = mqtt_next_packet_id();
+		}
+		mqtt_tx_u16(pMsg->packetId);
+	}
+	mqtt_tx_bytes(pMsg->payload, strlen(pMsg->payload));
+
+	if (mqtt_tx_send(MQTT_PUBLISH | pMsg->flags) != 0) {
+		return -1;
+	}
+
+	if (_isset(pMsg->flags, MQTT_PUBLISH_QOS1)) {
+		pMsg->isSent   = true;
+		pMsg->sentTick = tick;
+	} else {
+		mqtt_queue_remove(index);
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Publish the states that are only sent on change
+ */
+static void mqtt_publish_states(void)
+{
+	mqtt_publish("status", "online", 1, true);
+	mqtt_publish("alert", _isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT) ? "1" : "0", 1, true);
+#ifdef MODULE_RELAY
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		char topic[MQTT_TOPIC_SIZE];
+
+		snprintf(topic, sizeof(topic), "relay/%u", i);
+		mqtt_publish(topic, relay_get_state(i) ? "1" : "0", 1, true);
+	}
+#endif
+#ifdef MODULE_STRIPLED
+	isStripKnown = false;
+#endif
+}
+
+/**
+ * @brief The broker accepted the connection
+ *
+ * @param isSessionPresent The broker still has our subscriptions
+ */
+static void mqtt_on_connected(bool isSessionPresent)
+{
+	log_info("MQTT connected to %s", P_MQTT_HOST);
+
+	mqttState = MQTT_STATE_CONNECTED;
+	failCount = 0;
+
+#ifdef MODULE_STRIPLED
+	if (!isSessionPresent) {
+		mqtt_tx_begin();
+		mqtt_tx_u16(mqtt_next_packet_id());
+		mqtt_tx_string(topicPrefix, "strip/+/set");
+		txBuffer[txLength++] = 1; // QoS
+		if (mqtt_tx_send(MQTT_SUBSCRIBE) != 0) {
+			mqtt_retry_later();
+			return;
+		}
+	}
+#endif
+
+	mqtt_publish_states();
+}
+
+#ifdef MODULE_STRIPLED
+/**
+ * @brief Apply a command received on "<prefix>strip/<name>/set"
+ *
+ * @param name What to set: state, brightness, anim, color or demo
+ * @param value The payload
+ */
+static void mqtt_strip_command(const char * name, const char * value)
+{
+	bool isOn = (strcmp(value, "1") == 0) || (strcmp(value, "on") == 0);
+
+	if (strcmp(name, "state") == 0) {
+		cmd_set_state(isOn);
+	} else if (strcmp(name, "demo") == 0) {
+		cmd_set_demo_mode(isOn);
+	} else if (strcmp(name, "brightness") == 0) {
+		if (strcmp(value, "auto") == 0) {
+			cmd_set_brightness_auto(true);
+		} else {
+			cmd_set_brightness(atoi(value));
+		}
+	} else if (strcmp(name, "anim") == 0) {
+		cmd_set_animation(atoi(value));
+	} else if (strcmp(name, "color") == 0) {
+		cmd_set_color(strtoul(value, NULL, 16));
+	} else {
+		log_warn("Unknown MQTT strip command: %s", name);
+		return;
+	}
+
+	// Publish the new state right away
+	stripNextCheckTick = 0;
+}
+
+/**
+ * @brief Publish what changed on the strip
+ */
+static void mqtt_strip_check(void)
+{
+	char payload[MQTT_PAYLOAD_SIZE];
+
+	if (tick < stripNextCheckTick) {
+		return;
+	}
+	stripNextCheckTick = tick + MQTT_STRIP_CHECK_PERIOD_MS;
+
+	if (!isStripKnown || (stripState != cmd_get_state())) {
+		stripState = cmd_get_state();
+		mqtt_publish("strip/state", stripState ? "1" : "0", 1, true);
+	}
+	if (!isStripKnown || (stripDemo != cmd_get_demo_mode())) {
+		stripDemo = cmd_get_demo_mode();
+		mqtt_publish("strip/demo", stripDemo ? "1" : "0", 0, true);
+	}
+	if (!isStripKnown || (stripBrightness != cmd_get_brightness())) {
+		stripBrightness = cmd_get_brightness();
+		snprintf(payload, sizeof(payload), "%u", stripBrightness);
+		mqtt_publish("strip/brightness", payload, 0, true);
+	}
+	if (!isStripKnown || (stripAnim != cmd_get_animation())) {
+		stripAnim = cmd_get_animation();
+		snprintf(payload, sizeof(payload), "%u", stripAnim);
+		mqtt_publish("strip/anim", payload, 0, true);
+	}
+	if (!isStripKnown || (stripColor != cmd_get_color())) {
+		stripColor = cmd_get_color();
+		snprintf(payload, sizeof(payload), "%06X", stripColor & 0xFFFFFF);
+		mqtt_publish("strip/color", payload, 0, true);
+	}
+
+	isStripKnown = true;
+}
+#endif
+
+/**
+ * @brief Handle a PUBLISH from the broker
+ *
+ * @param topic The topic, not null terminated
+ * @param topicLength Length of topic
+ * @param payload The payload, not null terminated
+ * @param payloadLength Length of payload
+ */
+static void mqtt_on_message(const char * topic, uint16_t topicLength, const char * payload, uint16_t payloadLength)
+{
+	uint16_t prefixLength = strlen(topicPrefix);
+	char     name[MQTT_TOPIC_SIZE];
+	char     value[MQTT_PAYLOAD_SIZE];
+
+	if ((topicLength <= prefixLength) || (strncmp(topic, topicPrefix, prefixLength) != 0)) {
+		return;
+	}
+	topic += prefixLength;
+	topicLength -= prefixLength;
+
+	if (topicLength >= sizeof(name)) {
+		return;
+	}
+	memcpy(name, topic, topicLength);
+	name[topicLength] = '\0';
+
+	if (payloadLength >= sizeof(value)) {
+		payloadLength = sizeof(value) - 1;
+	}
+	memcpy(value, payload, payloadLength);
+	value[payloadLength] = '\0';
+
+#ifdef MODULE_STRIPLED
+	// "strip/<name>/set"
+	if ((strncmp(name, "strip/", 6) == 0) && (topicLength > 10) && (strcmp(&name[topicLength - 4], "/set") == 0)) {
+		name[topicLength - 4] = '\0';
+		mqtt_strip_command(&name[6], value);
+		return;
+	}
+#endif
+
+	log_warn("Unexpected MQTT topic: %s", name);
+}
+
+/**
+ * @brief Handle a complete packet from the broker
+ */
+static void mqtt_handle_packet(void)
+{
+	uint16_t received = (rxLength < MQTT_RX_BUFFER_SIZE) ? rxLength : MQTT_RX_BUFFER_SIZE;
+	uint16_t topicLength, offset, packetId;
+	uint8_t  qos;
+
+	switch (rxType & 0xF0) {
+	case MQTT_CONNACK:
+		if ((mqttState != MQTT_STATE_CONNECTING) || (received < 2)) {
+			break;
+		}
+		if (rxBuffer[1] != 0) {
+			log_error("MQTT broker refused the connection (code = %d)", rxBuffer[1]);
+			mqtt_retry_later();
+		} else {
+			mqtt_on_connected(_isset(rxBuffer[0], 0x01));
+		}
+		break;
+	case MQTT_PUBACK:
+		if (received < 2) {
+			break;
+		}
+		packetId = (rxBuffer[0] << 8) | rxBuffer[1];
+		for (uint8_t i = 0; i < queueCount; i++) {
+			if (queue[i].isSent && (queue[i].packetId == packetId)) {
+				mqtt_queue_remove(i);
+				break;
+			}
+		}
+		break;
+	case MQTT_SUBACK:
+		if ((received >= 3) && (rxBuffer[2] == 0x80)) {
+			log_error("MQTT subscription refused");
+		}
+		break;
+	case MQTT_PUBLISH:
+		if (received < 2) {
+			break;
+		}
+		qos         = (rxType >> 1) & 0x03;
+		topicLength = (rxBuffer[0] << 8) | rxBuffer[1];
+		offset      = 2 + topicLength;
+		if ((offset + ((qos > 0) ? 2 : 0)) > received) {
+			log_warn("MQTT message is too big, ignored");
+			break;
+		}
+
+		if (rxLength <= MQTT_RX_BUFFER_SIZE) {
+			uint16_t payloadOffset = offset + ((qos > 0) ? 2 : 0);
+
+			mqtt_on_message((const char *) &rxBuffer[2], topicLength, (const char *) &rxBuffer[payloadOffset], rxLength - payloadOffset);
+		} else {
+			log_warn("MQTT message is too big, ignored");
+		}
+
+		// Acknowledge it anyway or the broker sends it again
+		// QoS 2 is never sent to us as we subscribe with QoS 1
+		if (qos == 1) {
+			mqtt_tx_begin();
+			mqtt_tx_bytes(&rxBuffer[offset], 2);
+			if (mqtt_tx_send(MQTT_PUBACK) != 0) {
+				mqtt_retry_later();
+			}
+		}
+		break;
+	case MQTT_PINGRESP:
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Read what is available from the broker
+ */
+static void mqtt_read(void)
+{
+	for (uint16_t n = 0; (n < MQTT_READ_MAX_PER_TICK) && (client.available() > 0); n++) {
+		uint8_t c = (uint8_t) client.read();
+
+		lastRxTick = tick;
+
+		switch (rxState) {
+		case MQTT_RX_TYPE:
+			rxType   = c;
+			rxLength = 0;
+			rxShift  = 0;
+			rxState  = MQTT_RX_LENGTH;
+			break;
+		case MQTT_RX_LENGTH:
+			rxLength |= (uint32_t) (c & 0x7F) << rxShift;
+			rxShift += 7;
+			if (_isset(c, 0x80)) {
+				if (rxShift > 21) {
+					log_error("MQTT bad packet length");
+					mqtt_retry_later();
+					return;
+				}
+				break;
+			}
+			rxIndex = 0;
+			rxState = MQTT_RX_BODY;
+			break;
+		case MQTT_RX_BODY:
+			if (rxIndex < MQTT_RX_BUFFER_SIZE) {
+				rxBuffer[rxIndex] = c;
+			}
+			rxIndex++;
+			break;
+		default:
+			rxState = MQTT_RX_TYPE;
+			break;
+		}
+
+		if ((rxState == MQTT_RX_BODY) && (rxIndex >= rxLength)) {
+			rxState = MQTT_RX_TYPE;
+			mqtt_handle_packet();
+			if (mqttState == MQTT_STATE_DISCONNECTED) {
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Publish the events of other modules
+ *
+ * @param pEvent The event
+ * @param arg Unused
+ */
+static void mqtt_event_callback(const struct event_t * pEvent, void * arg)
+{
+	char topic[MQTT_TOPIC_SIZE];
+	char payload[MQTT_PAYLOAD_SIZE];
+
+	switch (pEvent->type) {
+	case EVENT_TEMP_VALUE:
+		snprintf(topic, sizeof(topic), "temp/%u", pEvent->source);
+		snprintf(payload, sizeof(payload), "%.2f", pEvent->value / 100.0);
+		mqtt_publish(topic, payload, 0, true);
+		break;
+	case EVENT_TEMP_FAULT:
+		snprintf(topic, sizeof(topic), "temp/%u/fault", pEvent->source);
+		mqtt_publish(topic, (pEvent->value != 0) ? "1" : "0", 1, true);
+		break;
+	case EVENT_INPUT_RISING:
+	case EVENT_INPUT_FALLING:
+		snprintf(topic, sizeof(topic), "input/%u", pEvent->source);
+		mqtt_publish(topic, (pEvent->type == EVENT_INPUT_RISING) ? "1" : "0", 0, true);
+		break;
+	case EVENT_RELAY_STATE:
+		snprintf(topic, sizeof(topic), "relay/%u", pEvent->source);
+		mqtt_publish(topic, (pEvent->value != 0) ? "1" : "0", 1, true);
+		break;
+	case EVENT_ALERT:
+		mqtt_publish("alert", (pEvent->value != 0) ? "1" : "0", 1, true);
+		break;
+	case EVENT_WIFI_STATE:
+		if (pEvent->value != 0) {
+			failCount   = 0;
+			nextTryTick = 0;
+		} else if (mqttState != MQTT_STATE_DISCONNECTED) {
+			mqtt_retry_later();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Queue a message for the broker
+ * @details A message of the same topic that is not sent yet is replaced.
+ * When the queue is full, the oldest QoS 0 message is dropped, or the oldest one.
+ *
+ * @param topic Topic, without the "lightkit/<module name>/" prefix
+ * @param payload The payload
+ * @param qos 0 or 1
+ * @param retain The broker keeps the last value for new subscribers
+ * @return 0: OK, -1: Topic or payload is too long
+ */
+int mqtt_publish(const char * topic, const char * payload, uint8_t qos, bool retain)
+{
+	struct mqtt_msg_t * pMsg = NULL;
+	uint8_t             flags;
+
+	if (!isEnabled) {
+		return 0;
+	}
+
+	if ((strlen(topic) >= MQTT_TOPIC_SIZE) || (strlen(payload) >= MQTT_PAYLOAD_SIZE)) {
+		log_error("MQTT message is too long: %s", topic);
+		return -1;
+	}
+
+	flags = ((qos > 0) ? MQTT_PUBLISH_QOS1 : 0) | (retain ? MQTT_PUBLISH_RETAIN : 0);
+
+	// Only the newest value matters when we are late
+	for (uint8_t i = 0; i < queueCount; i++) {
+		if (!queue[i].isSent && (strcmp(queue[i].topic, topic) == 0)) {
+			pMsg = &queue[i];
+			break;
+		}
+	}
+
+	if (pMsg == NULL) {
+		if (queueCount >= MQTT_QUEUE_SIZE) {
+			uint8_t dropped = 0;
+
+			for (uint8_t i = 0; i < queueCount; i++) {
+				if (_isunset(queue[i].flags, MQTT_PUBLISH_QOS1)) {
+					dropped = i;
+					break;
+				}
+			}
+			log_warn("MQTT queue is full, %s is dropped", queue[dropped].topic);
+			mqtt_queue_remove(dropped);
+		}
+
+		pMsg = &queue[queueCount++];
+		strcpy(pMsg->topic, topic);
+		pMsg->packetId = 0;
+		pMsg->isSent   = false;
+	} else if (pMsg->packetId != 0) {
+		// Sent before but not acknowledged, this is a new message now
+		pMsg->packetId = 0;
+	}
+
+	strcpy(pMsg->payload, payload);
+	pMsg->flags = flags;
+
+	return 0;
+}
+
+bool mqtt_is_connected(void)
+{
+	return (mqttState == MQTT_STATE_CONNECTED);
+}
+
+int mqtt_init(void)
+{
+	String  mac = WiFi.macAddress();
+	uint8_t j   = 0;
+
+	if (strlen(P_MQTT_HOST) == 0) {
+		log_info("MQTT is disabled, no broker defined");
+		return 0;
+	}
+
+	// The client ID must not change to keep the session on the broker
+	strcpy(clientId, "lightkit-");
+	j = strlen(clientId);
+	for (uint8_t i = 0; (i < mac.length()) && (j < (sizeof(clientId) - 1)); i++) {
+		if (mac[i] != ':') {
+			clientId[j++] = mac[i];
+		}
+	}
+	clientId[j] = '\0';
+
+	snprintf(topicPrefix, sizeof(topicPrefix), MQTT_TOPIC_ROOT "%s/", cmd_get_module_name().c_str());
+
+	isEnabled   = true;
+	mqttState   = MQTT_STATE_DISCONNECTED;
+	nextTryTick = 0;
+	queueCount  = 0;
+
+	CHECK_CALL(event_subscribe(EVENT_MASK_INPUT_EDGE | event_mask(EVENT_TEMP_VALUE) | event_mask(EVENT_TEMP_FAULT) | event_mask(EVENT_RELAY_STATE) | event_mask(EVENT_ALERT) | event_mask(EVENT_WIFI_STATE),
+	                           EVENT_SOURCE_ANY, mqtt_event_callback, NULL))
+
+	return 0;
+}
+
+void mqtt_main(void)
+{
+	int ret;
+
+	if (!isEnabled) {
+		return;
+	}
+
+	switch (mqttState) {
+	case MQTT_STATE_DISCONNECTED:
+		if ((tick >= nextTryTick) && _isset(STATUS_WIFI, STATUS_WIFI_IS_CO)) {
+			if (mqtt_connect() != 0) {
+				mqtt_retry_later();
+			}
+		}
+		break;
+	case MQTT_STATE_CONNECTING:
+		mqtt_read();
+		if ((mqttState == MQTT_STATE_CONNECTING) && (tick > connackEndTick)) {
+			log_error("MQTT broker did not accept the connection in time");
+			mqtt_retry_later();
+		}
+		break;
+	case MQTT_STATE_CONNECTED:
+		mqtt_read();
+		if (mqttState != MQTT_STATE_CONNECTED) {
+			break;
+		}
+
+		if (!client.connected() && (client.available() == 0)) {
+			log_error("MQTT broker closed the connection");
+			mqtt_retry_later();
+			break;
+		}
+		if ((tick - lastRxTick) > (MQTT_KEEP_ALIVE_S * 1500UL)) {
+			log_error("MQTT broker is not answering");
+			mqtt_retry_later();
+			break;
+		}
+
+#ifdef MODULE_STRIPLED
+		mqtt_strip_check();
+#endif
+
+		for (uint8_t i = 0; i < queueCount; i++) {
+			if (queue[i].isSent && ((tick - queue[i].sentTick) > MQTT_PUBACK_TIMEOUT_MS)) {
+				mqtt_queue_resend(i);
+			}
+		}
+
+		// One packet per tick. QoS 0 publishes get no answer: ping also when
+		// nothing was received for a while, or a live broker is taken for dead
+		ret = mqtt_send_next();
+		if ((ret == 0) && ((tick - lastPingTick) >= (MQTT_KEEP_ALIVE_S * 500UL))
+		    && (((tick - lastTxTick) >= (MQTT_KEEP_ALIVE_S * 500UL)) || ((tick - lastRxTick) >= (MQTT_KEEP_ALIVE_S * 500UL)))) {
+			mqtt_tx_begin();
+			ret          = mqtt_tx_send(MQTT_PINGREQ);
+			lastPingTick = tick;
+		}
+		if (ret < 0) {
+			mqtt_retry_later();
+		}
+		break;
+	default:
+		mqttState = MQTT_STATE_DISCONNECTED;
+		break;
+	}
+}
+
+#endif
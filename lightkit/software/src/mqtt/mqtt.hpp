@@ -0,0 +1,42 @@
+/**
+  * @file   mqtt.hpp
+  * @brief  Publish the state of the board to a MQTT broker
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef MQTT_MQTT_HPP
+#define MQTT_MQTT_HPP
+
+#include "global.hpp"
+
+/* Broker, see private.hpp */
+#ifndef P_MQTT_HOST
+#define P_MQTT_HOST ""   /** Leave empty to disable MQTT */
+#define P_MQTT_PORT 1883
+#define P_MQTT_USER ""   /** Leave empty for anonymous access */
+#define P_MQTT_PWD  ""
+#endif
+
+#define MQTT_TOPIC_ROOT            "lightkit/" /** Topics are MQTT_TOPIC_ROOT "<module name>/<topic>" */
+#define MQTT_KEEP_ALIVE_S          60          /** Broker drops us after 1.5 times this without a packet */
+#define MQTT_CONNECT_TIMEOUT_MS    500         /** Connecting is the only blocking step, keep it short */
+#define MQTT_CONNACK_TIMEOUT_MS    5*1000      /** Time given to the broker to accept the connection */
+#define MQTT_RETRY_MIN_MS          1000        /** Delay after the first failure, doubled at each new one */
+#define MQTT_RETRY_MAX_MS          5*60*1000   /** Longest delay between two connections */
+#define MQTT_PUBACK_TIMEOUT_MS     10*1000     /** QoS 1 message is sent again after this time */
+#define MQTT_QUEUE_SIZE            12          /** Messages waiting for the broker, the oldest are dropped */
+#define MQTT_TOPIC_SIZE            24          /** Longest topic, without the prefix */
+#define MQTT_PAYLOAD_SIZE          16          /** Longest payload */
+#define MQTT_PREFIX_SIZE           (sizeof(MQTT_TOPIC_ROOT) + MODULE_NAME_SIZE_MAX + 1)
+#define MQTT_TX_BUFFER_SIZE        256         /** Biggest packet sent, CONNECT with credentials */
+#define MQTT_RX_BUFFER_SIZE        128         /** Biggest packet received, bigger ones are ignored */
+#define MQTT_READ_MAX_PER_TICK     128         /** Bytes read from the broker each tick */
+#define MQTT_STRIP_CHECK_PERIOD_MS 500         /** Time between two checks of the strip state */
+
+int  mqtt_init(void);
+void mqtt_main(void);
+int  mqtt_publish(const char * topic, const char * payload, uint8_t qos, bool retain);
+bool mqtt_is_connected(void);
+
+#endif /* MQTT_MQTT_HPP */
@@ -22,4 +22,9 @@
 
 #define P_TELEGRAM_CONV_TOKEN ""
 
+#define P_MQTT_HOST ""
+#define P_MQTT_PORT 1883
+#define P_MQTT_USER ""
+#define P_MQTT_PWD  ""
+
 #endif /* PRIVATE_HPP */
@@ -6,112 +6,366 @@
   */
 
 #include "relay.hpp"
+#include "event/event.hpp"
 #include "global.hpp"
 #include "io/outputs.hpp"
-#include "script/script.hpp"
 
 #ifdef MODULE_RELAY
 
+/**
+ * Each command is checked against the feedback: its first edge gives the
+ * switch time, the next ones in RELAY_DEBOUNCE_MS are bounces. Once the
+ * feedback is quiet, its level must match the command, or the command
+ * is sent again up to RELAY_CHECK_BEFORE_ERROR times.
+ *
+ * Feedback pins that can't interrupt (GPIO16 on ESP8266) are read on
+ * each call of relay_main(), so edges are timed to the ms.
+ */
+struct relay_t {
+	struct relay_config_t config;
+	bool                  theoreticalState; /**< true: is close, false: is open */
+	bool                  isClosed;         /**< Feedback, once it is quiet */
+	bool                  isInterrupt;      /**< Edges are caught by interrupt instead of polling */
+	bool                  lastLevel;        /**< Level of the feedback on the last poll (Polling only) */
+	bool                  needResync;       /**< Feedback moved, read it once it is quiet */
+	bool                  isWaiting;        /**< Command is sent, feedback did not follow yet */
+	bool                  isMeasured;       /**< Switch time of the last command is known */
+	bool                  isFaulty;
+	uint8_t               checkCountBeforeError; /**< Soft will try to re-send the command n times before declaring error */
+	uint32_t              commandTick;
+	uint32_t              commandUs;
+	uint32_t              lastEdgeTick;
+	uint32_t              nextToggleTick;
+	uint32_t              nextCheckTick; /**< Feedback is read at least at this period, in case an edge was missed */
+	struct relay_stats_t  stats;
+};
+
 extern uint32_t tick;
-uint32_t        nextRelayToggleTick   = UINT32_MAX;
-uint32_t        nextRelayCheckTick    = 0;
-bool            relayTheoreticalState = false;                    /** true: is close, false: is open */
-uint8_t         checkCountBeforeError = RELAY_CHECK_BEFORE_ERROR; /** Soft will try to re-send the command n times before declaring error */
+static struct relay_t relays[RELAY_COUNT];
+
+// Wiring is checked at compile time
+static constexpr struct relay_config_t relayConfigTable[] = RELAY_CONFIGS;
+static_assert(sizeof(relayConfigTable) / sizeof(relayConfigTable[0]) == RELAY_COUNT, "RELAY_CONFIGS must have RELAY_COUNT relays");
+
+// Edge queue: filled by relay_isr(), emptied by relay_main()
+// Lock free as there is only one producer and one consumer
+static volatile struct relay_edge_t edgeQueue[RELAY_EDGE_QUEUE_SIZE];
+static volatile uint8_t             edgeHead    = 0; /**< Written by the ISR only */
+static volatile uint8_t             edgeTail    = 0; /**< Written by relay_main() only */
+static volatile uint32_t            edgeDropped = 0; /**< Edges lost because the queue was full */
+static uint32_t                     edgeDroppedReported = 0;
+
+/**
+ * @brief Record an edge of a feedback pin
+ *
+ * @param arg Index of the relay
+ */
+static void ICACHE_RAM_ATTR relay_isr(void * arg)
+{
+	uint8_t head = edgeHead;
+	uint8_t next = (head + 1) & (RELAY_EDGE_QUEUE_SIZE - 1);
+
+	if (next == edgeTail) {
+		edgeDropped = edgeDropped + 1;
+		return;
+	}
+
+	edgeQueue[head].relay = (uint8_t) (uintptr_t) arg;
+	edgeQueue[head].tick  = tick;
+	edgeQueue[head].us    = micros();
+
+	// Publish the edge once it is complete
+	edgeHead = next;
+}
+
+/**
+ * @brief Read the feedback of a relay
+ *
+ * @param pRelay The relay
+ * @return true: Feedback pin is high, the relay is open
+ */
+static inline bool relay_read_feedback(const struct relay_t * pRelay)
+{
+	return fast_gpio_read(pRelay->config.feedbackPin);
+}
+
+/**
+ * @brief Time the switch of a relay and count its bounces
+ *
+ * @param pRelay The relay
+ * @param edgeTick When the edge happened, in ticks
+ * @param edgeUs When the edge happened, from micros()
+ */
+static void relay_handle_edge(struct relay_t * pRelay, uint32_t edgeTick, uint32_t edgeUs)
+{
+	uint32_t switchUs;
+
+	if (pRelay->needResync && ((edgeTick - pRelay->lastEdgeTick) < RELAY_DEBOUNCE_MS)) {
+		pRelay->stats.bounceCount++;
+	} else if (pRelay->isWaiting && !pRelay->isMeasured) {
+		switchUs = edgeUs - pRelay->commandUs;
+
+		pRelay->isMeasured = true;
+		pRelay->stats.switchCount++;
+		pRelay->stats.switchTotalUs += switchUs;
+		if (switchUs > pRelay->stats.switchMaxUs) {
+			pRelay->stats.switchMaxUs = switchUs;
+		}
+	}
+
+	pRelay->lastEdgeTick = edgeTick;
+	pRelay->needResync   = true;
+}
+
+/**
+ * @brief Use the edges caught by interrupt, poll the other feedbacks
+ */
+static void relay_process_edges(void)
+{
+	uint8_t tail = edgeTail;
+
+	while (tail != edgeHead) {
+		volatile struct relay_edge_t * pEdge = &edgeQueue[tail];
+
+		relay_handle_edge(&relays[pEdge->relay], pEdge->tick, pEdge->us);
+
+		tail     = (tail + 1) & (RELAY_EDGE_QUEUE_SIZE - 1);
+		edgeTail = tail;
+	}
+
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		struct relay_t * pRelay = &relays[i];
+		bool             level;
+
+		if (pRelay->isInterrupt) {
+			continue;
+		}
+
+		level = relay_read_feedback(pRelay);
+		if (level != pRelay->lastLevel) {
+			pRelay->lastLevel = level;
+			relay_handle_edge(pRelay, tick, micros());
+		}
+	}
+
+	if (edgeDropped != edgeDroppedReported) {
+		edgeDroppedReported = edgeDropped;
+		log_warn("Relay edge queue is full, %u edges dropped", edgeDroppedReported);
+	}
+}
+
+/**
+ * @brief Send the command of a relay to its outputs
+ *
+ * @param pRelay The relay
+ */
+static void relay_drive(struct relay_t * pRelay)
+{
+	uint8_t alias = pRelay->config.cmdAlias;
+
+	if (pRelay->config.openAlias == RELAY_NO_ALIAS) {
+		output_set(alias, pRelay->theoreticalState);
+	} else {
+		// Bistable: a pulse on the coil of the new state
+		if (!pRelay->theoreticalState) {
+			alias = pRelay->config.openAlias;
+		}
+		output_set(alias, true);
+		output_delayed_set(alias, false, RELAY_BISTABLE_ON_TIME_MS);
+	}
+
+	pRelay->commandTick = tick;
+	pRelay->commandUs   = micros();
+	pRelay->isWaiting   = true;
+	pRelay->isMeasured  = false;
+	pRelay->stats.actuationCount++;
+}
 
-void relay_set_state(bool isClose)
+/**
+ * @brief Raise STATUS_APPLI_RELAY_FAULT when a relay is faulty
+ */
+static void relay_update_fault_status(void)
 {
-#ifdef RELAY_IS_BISTABLE
-	uint8_t alias = (isClose) ? RELAY_CMD_1_ALIAS : RELAY_CMD_2_ALIAS;
-
-	output_set(alias, true);
-	output_delayed_set(alias, false, RELAY_BISTABLE_ON_TIME_MS);
-#else
-	output_set(RELAY_CMD_ALIAS, isClose);
-#endif
-	relayTheoreticalState = isClose;
-
-	// Force to check the relay in 1 sec
-	nextRelayCheckTick = tick + 1000;
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		if (relays[i].isFaulty) {
+			_set(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT);
+			return;
+		}
+	}
+	_unset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT);
 }
 
-bool relay_get_theoretical_state(void)
+/**
+ * @brief Compare the quiet feedback of a relay with its command
+ *
+ * @param index Index of the relay
+ */
+static void relay_check_feedback(uint8_t index)
 {
-	return relayTheoreticalState;
+	struct relay_t * pRelay = &relays[index];
+
+	if (pRelay->isClosed == pRelay->theoreticalState) {
+		pRelay->isWaiting = false;
+
+		if (pRelay->isFaulty) {
+			pRelay->isFaulty = false;
+			relay_update_fault_status();
+			log_info("Relay %d feedback is good again", index);
+			event_publish(EVENT_RELAY_FEEDBACK, index, 1);
+		}
+
+		// Reset error counter
+		pRelay->checkCountBeforeError = RELAY_CHECK_BEFORE_ERROR;
+		return;
+	}
+
+	// Give the command time to act, and do nothing if fault is already declared
+	if ((pRelay->isWaiting && ((tick - pRelay->commandTick) < RELAY_SWITCH_TIMEOUT_MS)) || pRelay->isFaulty) {
+		return;
+	}
+
+	pRelay->stats.failCount++;
+	if (pRelay->checkCountBeforeError > 0) {
+		--pRelay->checkCountBeforeError;
+		log_warn("Bad feedback for relay %d: %d/%d", index, RELAY_CHECK_BEFORE_ERROR - pRelay->checkCountBeforeError, RELAY_CHECK_BEFORE_ERROR);
+	}
+
+	if (pRelay->checkCountBeforeError == 0) {
+		pRelay->isWaiting = false;
+		pRelay->isFaulty  = true;
+		relay_update_fault_status();
+		log_error("Relay %d seems to be broken (Bad feedback)", index);
+		event_publish(EVENT_RELAY_FEEDBACK, index, 0);
+	} else {
+		// Try to resend command
+		relay_drive(pRelay);
+	}
+}
+
+bool relay_get_theoretical_state(uint8_t index)
+{
+	if (index >= RELAY_COUNT) {
+		return false;
+	}
+	return relays[index].theoreticalState;
 }
 
-bool relay_get_state(void)
+bool relay_get_state(uint8_t index)
 {
-	return digitalRead(RELAY_FEEDBACK_PIN) ? false : true;
+	if (index >= RELAY_COUNT) {
+		return false;
+	}
+	return relays[index].isClosed;
 }
 
-bool relay_toogle_state(void)
+void relay_set_state(uint8_t index, bool isClose)
 {
-	relay_set_state(!relayTheoreticalState);
+	struct relay_t * pRelay;
+
+	if (index >= RELAY_COUNT) {
+		return;
+	}
+	pRelay = &relays[index];
+
+	if (pRelay->theoreticalState != isClose) {
+		event_publish(EVENT_RELAY_STATE, index, isClose);
+	}
+	pRelay->theoreticalState = isClose;
+
+	relay_drive(pRelay);
+}
+
+bool relay_toogle_state(uint8_t index)
+{
+	relay_set_state(index, !relay_get_theoretical_state(index));
 
 	// Return new state
-	return relayTheoreticalState;
+	return relay_get_theoretical_state(index);
+}
+
+void relay_set_toogle_timeout(uint8_t index, uint32_t timeoutMs)
+{
+	if (index >= RELAY_COUNT) {
+		return;
+	}
+	relays[index].nextToggleTick = tick + timeoutMs;
 }
 
-void relay_set_toogle_timeout(uint32_t timeoutMs)
+/**
+ * @brief Print the state and the statistics of the relays
+ */
+void relay_print_stats(void)
 {
-	nextRelayToggleTick = tick + timeoutMs;
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		struct relay_t * pRelay = &relays[i];
+
+		log_raw("Relay %d: %s%s, %u actuations, %u failures\n\r", i, pRelay->isClosed ? "closed" : "open",
+				pRelay->isFaulty ? " (faulty)" : "", pRelay->stats.actuationCount, pRelay->stats.failCount);
+		log_raw("  Switch time: mean %u us, max %u us over %u switches, %u bounces\n\r",
+				(pRelay->stats.switchCount > 0) ? (pRelay->stats.switchTotalUs / pRelay->stats.switchCount) : 0,
+				pRelay->stats.switchMaxUs, pRelay->stats.switchCount, pRelay->stats.bounceCount);
+	}
+	if (edgeDropped > 0) {
+		log_raw("Relay edges dropped: %u\n\r", edgeDropped);
+	}
 }
 
 int relay_init(void)
 {
-	pinMode(RELAY_FEEDBACK_PIN, INPUT);
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		struct relay_t * pRelay = &relays[i];
+		uint8_t          pin    = relayConfigTable[i].feedbackPin;
+
+		memset(pRelay, 0, sizeof(*pRelay));
+		pRelay->config                = relayConfigTable[i];
+		pRelay->checkCountBeforeError = RELAY_CHECK_BEFORE_ERROR;
+		pRelay->nextToggleTick        = UINT32_MAX;
 
-	// Set relay open
-	relay_set_state(false);
+		pinMode(pin, INPUT);
+		pRelay->lastLevel = relay_read_feedback(pRelay);
+		pRelay->isClosed  = !pRelay->lastLevel;
+
+		if (digitalPinToInterrupt(pin) < 0) {
+			log_info("Relay %d feedback can't interrupt, polling it instead", i);
+		} else {
+			pRelay->isInterrupt = true;
+			attachInterruptArg(digitalPinToInterrupt(pin), relay_isr, (void *) (uintptr_t) i, CHANGE);
+		}
+
+		// Set relay open
+		relay_set_state(i, false);
+	}
 
 	return 0;
 }
 
 void relay_main(void)
 {
-	// When timeout expires, toggle the relay state by using theorical state
-	if (tick > nextRelayToggleTick) {
-		nextRelayToggleTick = UINT32_MAX;
-		relay_toogle_state();
-	}
-
-	if (tick > nextRelayCheckTick) {
-		// Does the relay have the right state ?
-		if (relay_get_state() != relayTheoreticalState) {
-			// Do nothing if fault is already declared
-			if (_isunset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT)) {
-				// Try to resend command
-				relay_set_state(relayTheoreticalState);
-
-				if (checkCountBeforeError > 0) {
-					--checkCountBeforeError;
-					log_warn("Bad feedback for relay %d/%d", RELAY_CHECK_BEFORE_ERROR - checkCountBeforeError, RELAY_CHECK_BEFORE_ERROR);
-				}
-
-				if (checkCountBeforeError == 0) {
-					_set(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT);
-					log_error("Relay seems to be broken (Bad feedback)");
-
-					// Inform script module of the event
-					script_relay_feedback_event();
-				}
-			}
-		} else {
-			// Do nothing if fault is already declared
-			if (_isset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT)) {
-				_unset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT);
+	relay_process_edges();
 
-				// Inform script module of the event
-				script_relay_feedback_event();
-			}
+	for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+		struct relay_t * pRelay = &relays[i];
+
+		// When timeout expires, toggle the relay state by using theorical state
+		if (tick > pRelay->nextToggleTick) {
+			pRelay->nextToggleTick = UINT32_MAX;
+			relay_toogle_state(i);
+		}
 
-			// Reset error counter
-			checkCountBeforeError = RELAY_CHECK_BEFORE_ERROR;
+		if (pRelay->needResync) {
+			if ((tick - pRelay->lastEdgeTick) < RELAY_DEBOUNCE_MS) {
+				// Still bouncing
+				continue;
+			}
+			pRelay->needResync = false;
+			pRelay->isClosed   = !relay_read_feedback(pRelay);
+		} else if (tick >= pRelay->nextCheckTick) {
+			pRelay->nextCheckTick = tick + RELAY_CHECK_PERIOD;
+			pRelay->isClosed      = !relay_read_feedback(pRelay);
 		}
-		// EasyFix: Exceptional case, this has to be after relay_set_state() because
-		// it overwrites the variable "nextRelayCheckTick" and we don't want that here
-		nextRelayCheckTick = tick + RELAY_CHECK_PERIOD;
+
+		relay_check_feedback(i);
 	}
 }
 
-#endif /** MODULE_RELAY */
\ No newline at end of file
+#endif /** MODULE_RELAY */
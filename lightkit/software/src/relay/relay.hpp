@@ -8,14 +8,60 @@
 #ifndef RELAY_RELAY_HPP
 #define RELAY_RELAY_HPP
 
-#include <Arduino.h>
+#include "global.hpp"
 
-bool relay_get_theoretical_state(void);
-bool relay_get_state(void);
-void relay_set_toogle_timeout(uint32_t timeoutMs);
-void relay_set_state(bool isClose);
-bool relay_toogle_state(void);
+#define RELAY_MAIN     0    /** Relay of the alert, driven by the script and the remote commands */
+#define RELAY_NO_ALIAS 0xFF /** Open output of a monostable relay */
+
+/** Boards with one relay only define RELAY_FEEDBACK_PIN and its command outputs */
+#ifndef RELAY_COUNT
+#define RELAY_COUNT 1
+#ifdef RELAY_IS_BISTABLE
+#define RELAY_CONFIGS {{RELAY_FEEDBACK_PIN, RELAY_CMD_1_ALIAS, RELAY_CMD_2_ALIAS}}
+#else
+#define RELAY_CONFIGS {{RELAY_FEEDBACK_PIN, RELAY_CMD_ALIAS, RELAY_NO_ALIAS}}
+#endif
+#endif
+
+#ifndef RELAY_BISTABLE_ON_TIME_MS
+#define RELAY_BISTABLE_ON_TIME_MS 50 /** Length of the pulse on a coil of a bistable relay */
+#endif
+#ifndef RELAY_SWITCH_TIMEOUT_MS
+#define RELAY_SWITCH_TIMEOUT_MS 200 /** Feedback must reach the commanded state within this time */
+#endif
+#define RELAY_DEBOUNCE_MS       20 /** Edges closer than this to the previous one are bounces */
+#define RELAY_EDGE_QUEUE_SIZE   16 /** Feedback edges waiting for relay_main(), power of 2 */
+
+/** Wiring of a relay, see RELAY_CONFIGS */
+struct relay_config_t {
+	uint8_t feedbackPin; /**< Low when the relay is closed */
+	uint8_t cmdAlias;    /**< Output of the command, of the closing coil for a bistable relay */
+	uint8_t openAlias;   /**< Output of the opening coil for a bistable relay, RELAY_NO_ALIAS otherwise */
+};
+
+/** A feedback edge, caught by interrupt or by polling */
+struct relay_edge_t {
+	uint8_t  relay; /**< Index of the relay */
+	uint32_t tick;  /**< When the edge happened */
+	uint32_t us;    /**< Same, from micros() to time the switch */
+};
+
+struct relay_stats_t {
+	uint32_t actuationCount; /**< Commands sent, retries included */
+	uint32_t switchCount;    /**< Actuations with a measured switch time */
+	uint32_t switchTotalUs;
+	uint32_t switchMaxUs;
+	uint32_t bounceCount; /**< Edges seen during RELAY_DEBOUNCE_MS after another one */
+	uint32_t failCount;   /**< Feedback did not follow the command */
+};
+
+bool relay_get_theoretical_state(uint8_t index);
+bool relay_get_state(uint8_t index);
+void relay_set_toogle_timeout(uint8_t index, uint32_t timeoutMs);
+void relay_set_state(uint8_t index, bool isClose);
+bool relay_toogle_state(uint8_t index);
+void relay_print_stats(void);
 int  relay_init(void);
 void relay_main(void);
 
-#endif /* RELAY_RELAY_HPP */
\ No newline at end of file
+#endif /* RELAY_RELAY_HPP */
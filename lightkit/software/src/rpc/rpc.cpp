@@ -0,0 +1,497 @@
+/**
+  * @file   rpc.cpp
+  * @brief  Binary control protocol over TCP
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "rpc.hpp"
+#include "cmd/cmd.hpp"
+#include "feu_rouge/feu_rouge.hpp"
+#include "global.hpp"
+#include "relay/relay.hpp"
+#include "temp/temp_history.hpp"
+
+#ifdef ESP32
+#include <WiFi.h>
+#else
+#include <ESP8266WiFi.h>
+#endif
+
+#ifdef MODULE_RPC
+
+#define RPC_CHECK_LEN(expected)       \
+	if (len != (expected)) {          \
+		return RPC_STATUS_BAD_LENGTH; \
+	}
+
+// Internal variables
+static WiFiServer rpcServer(RPC_PORT);
+static WiFiClient rpcClient;
+static uint8_t    rxBuffer[RPC_RX_BUFFER_SIZE];
+static uint16_t   rxLen;
+static uint8_t    txBuffer[RPC_TX_BUFFER_SIZE];
+static uint16_t   txLen;
+
+// ==================
+//  TOOLS
+// ==================
+
+static uint16_t rpc_get_u16(const uint8_t * p)
+{
+	return (uint16_t) p[0] | ((uint16_t) p[1] << 8);
+}
+
+static uint32_t rpc_get_u32(const uint8_t * p)
+{
+	return (uint32_t) rpc_get_u16(p) | ((uint32_t) rpc_get_u16(p + 2) << 16);
+}
+
+static void rpc_put_u16(uint8_t * p, uint16_t value)
+{
+	p[0] = value & 0xFF;
+	p[1] = value >> 8;
+}
+
+static void rpc_put_u32(uint8_t * p, uint32_t value)
+{
+	rpc_put_u16(p, value & 0xFFFF);
+	rpc_put_u16(p + 2, value >> 16);
+}
+
+/**
+ * @brief Copy a string into a response payload
+ *
+ * @param out Response payload
+ * @param pOutLen Length of the payload
+ * @param str The string, without its ending '\0'
+ */
+static void rpc_put_string(uint8_t * out, uint16_t * pOutLen, const char * str)
+{
+	uint16_t len = strlen(str);
+
+	if (len > (RPC_FRAME_MAX_LEN - (RPC_RESPONSE_HEADER - 2))) {
+		len = RPC_FRAME_MAX_LEN - (RPC_RESPONSE_HEADER - 2);
+	}
+	memcpy(out, str, len);
+	*pOutLen = len;
+}
+
+// ==================
+//  OPCODES
+// ==================
+
+/**
+ * @brief Opcodes 0x0X: board
+ *
+ * @param opcode The request opcode
+ * @param in Request payload
+ * @param len Length of request payload
+ * @param out Response payload
+ * @param pOutLen Length of response payload
+ * @return See rpc_status_e
+ */
+static int8_t rpc_exec_board(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+	char name[MODULE_NAME_SIZE_MAX];
+
+	switch (opcode) {
+	case RPC_OP_PING:
+		// Response header is 1 byte longer than the request one
+		if (len > (RPC_FRAME_MAX_LEN - (RPC_RESPONSE_HEADER - 2))) {
+			return RPC_STATUS_BAD_LENGTH;
+		}
+		memcpy(out, in, len);
+		*pOutLen = len;
+		return RPC_STATUS_OK;
+	case RPC_OP_GET_VERSION:
+		RPC_CHECK_LEN(0);
+		rpc_put_string(out, pOutLen, FIRMWARE_VERSION);
+		return RPC_STATUS_OK;
+	case RPC_OP_GET_STATUS:
+		RPC_CHECK_LEN(0);
+		memcpy(out, boardStatus, NB_STATUS);
+		*pOutLen = NB_STATUS;
+		return RPC_STATUS_OK;
+	case RPC_OP_GET_MODULE_NAME:
+		RPC_CHECK_LEN(0);
+		rpc_put_string(out, pOutLen, cmd_get_module_name().c_str());
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_MODULE_NAME:
+		if ((len == 0) || (len >= MODULE_NAME_SIZE_MAX)) {
+			return RPC_STATUS_BAD_LENGTH;
+		}
+		memcpy(name, in, len);
+		name[len] = '\0';
+		return (cmd_set_module_name(String(name)) == 0) ? RPC_STATUS_OK : RPC_STATUS_ERROR;
+	case RPC_OP_RESET:
+		RPC_CHECK_LEN(0);
+		cmd_reset_module();
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_STATUS_LED:
+#ifdef MODULE_STATUS_LED
+		RPC_CHECK_LEN(1);
+		cmd_set_status_led(in[0]);
+		return RPC_STATUS_OK;
+#else
+		return RPC_STATUS_NOT_SUPPORTED;
+#endif
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+}
+
+/**
+ * @brief Opcodes 0x1X: strip led
+ * @see rpc_exec_board() for parameters
+ */
+static int8_t rpc_exec_stripled(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+#ifdef MODULE_STRIPLED
+	switch (opcode) {
+	case RPC_OP_GET_STATE:
+		RPC_CHECK_LEN(0);
+		out[0]   = cmd_get_state();
+		*pOutLen = 1;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_STATE:
+		RPC_CHECK_LEN(1);
+		return (cmd_set_state(in[0] != 0) == 0) ? RPC_STATUS_OK : RPC_STATUS_ERROR;
+	case RPC_OP_GET_BRIGHTNESS:
+		RPC_CHECK_LEN(0);
+		out[0]   = cmd_get_brightness();
+		*pOutLen = 1;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_BRIGHTNESS:
+		RPC_CHECK_LEN(1);
+		if ((in[0] == 0) || (in[0] > 100)) {
+			return RPC_STATUS_ERROR;
+		}
+		cmd_set_brightness(in[0]);
+		return RPC_STATUS_OK;
+	case RPC_OP_GET_COLOR:
+		RPC_CHECK_LEN(0);
+		rpc_put_u32(out, cmd_get_color());
+		*pOutLen = 4;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_COLOR:
+		RPC_CHECK_LEN(4);
+		// Black is refused by cmd_set_color()
+		if ((rpc_get_u32(in) & 0xFFFFFF) == 0) {
+			return RPC_STATUS_ERROR;
+		}
+		cmd_set_color(rpc_get_u32(in));
+		return RPC_STATUS_OK;
+	case RPC_OP_GET_ANIMATION:
+		RPC_CHECK_LEN(0);
+		out[0]   = cmd_get_animation();
+		*pOutLen = 1;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_ANIMATION:
+		RPC_CHECK_LEN(1);
+		return (cmd_set_animation(in[0]) == 0) ? RPC_STATUS_OK : RPC_STATUS_ERROR;
+	case RPC_OP_GET_DEMO_MODE:
+		RPC_CHECK_LEN(0);
+		out[0]   = cmd_get_demo_mode();
+		*pOutLen = 1;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_DEMO_MODE:
+		RPC_CHECK_LEN(1);
+		return (cmd_set_demo_mode(in[0] != 0) == 0) ? RPC_STATUS_OK : RPC_STATUS_ERROR;
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+#else
+	return RPC_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Opcodes 0x2X: relay
+ * @see rpc_exec_board() for parameters
+ */
+static int8_t rpc_exec_relay(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+#ifdef MODULE_RELAY
+	switch (opcode) {
+	case RPC_OP_GET_RELAY:
+		RPC_CHECK_LEN(0);
+		out[0]   = relay_get_state(RELAY_MAIN);
+		out[1]   = relay_get_theoretical_state(RELAY_MAIN);
+		*pOutLen = 2;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_RELAY:
+		RPC_CHECK_LEN(1);
+		relay_set_state(RELAY_MAIN, in[0] != 0);
+		return RPC_STATUS_OK;
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+#else
+	return RPC_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Opcodes 0x3X: buzzer
+ * @see rpc_exec_board() for parameters
+ */
+static int8_t rpc_exec_buzzer(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+#ifdef MODULE_BUZZER
+	switch (opcode) {
+	case RPC_OP_SET_BUZZER:
+		RPC_CHECK_LEN(3);
+		return (cmd_set_buzzer(in[0], in[1], in[2] != 0) == 0) ? RPC_STATUS_OK : RPC_STATUS_ERROR;
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+#else
+	return RPC_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Opcodes 0x4X: feu rouge
+ * @see rpc_exec_board() for parameters
+ */
+static int8_t rpc_exec_feu_rouge(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+#ifdef MODULE_FEU_ROUGE
+	switch (opcode) {
+	case RPC_OP_GET_FEU_ROUGE:
+		RPC_CHECK_LEN(0);
+		out[0]   = feu_rouge_get_fct_mode();
+		*pOutLen = 1;
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_FEU_ROUGE:
+		RPC_CHECK_LEN(1);
+		if (in[0] > MODE_FCT_DISCO) {
+			return RPC_STATUS_ERROR;
+		}
+		feu_rouge_set_fct_mode((FEU_ROUGE_MODE_FCT_E) in[0]);
+		return RPC_STATUS_OK;
+	case RPC_OP_SET_FEU_ROUGE_COL:
+		RPC_CHECK_LEN(1);
+		if (in[0] > COLOR_CMD_RED_YELLOW_GREEN) {
+			return RPC_STATUS_ERROR;
+		}
+		feu_rouge_mode_fct_color((COLOR_CMD_E) in[0]);
+		return RPC_STATUS_OK;
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+#else
+	return RPC_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Opcodes 0x5X: temperature
+ * @details The history is bigger than a frame: the host asks for pages,
+ * starting at the sample "first", until it has read "count" samples.
+ * Samples are in 1/100 °C, oldest first, TEMP_HISTORY_NO_VALUE when unknown
+ * @see rpc_exec_board() for parameters
+ */
+static int8_t rpc_exec_temp(uint8_t opcode, const uint8_t * in, uint16_t len, uint8_t * out, uint16_t * pOutLen)
+{
+#ifdef MODULE_TEMPERATURE
+	int16_t samples[TEMP_HISTORY_LARGEST_COUNT];
+	uint8_t count;
+	uint8_t pageCount;
+	uint8_t k;
+
+	switch (opcode) {
+	case RPC_OP_GET_TEMP_HISTORY:
+		RPC_CHECK_LEN(3);
+		if ((in[0] >= TEMP_HISTORY_SENSOR_COUNT) || (in[1] >= TEMP_HISTORY_LEVEL_COUNT)) {
+			return RPC_STATUS_ERROR;
+		}
+		count = temp_history_get(in[0], in[1], samples, TEMP_HISTORY_LARGEST_COUNT);
+		if (in[2] > count) {
+			return RPC_STATUS_ERROR;
+		}
+
+		pageCount = count - in[2];
+		if (pageCount > RPC_TEMP_HISTORY_PAGE) {
+			pageCount = RPC_TEMP_HISTORY_PAGE;
+		}
+		out[0] = count;
+		out[1] = in[2];
+		for (k = 0; k < pageCount; ++k) {
+			rpc_put_u16(&out[2 + 2 * k], (uint16_t) samples[in[2] + k]);
+		}
+		*pOutLen = 2 + 2 * pageCount;
+		return RPC_STATUS_OK;
+	default:
+		return RPC_STATUS_UNKNOWN;
+	}
+#else
+	return RPC_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+// ==================
+//  FRAMES
+// ==================
+
+/**
+ * @brief Send the coalesced responses
+ */
+static void rpc_flush(void)
+{
+	if (txLen > 0) {
+		rpcClient.write(txBuffer, txLen);
+		txLen = 0;
+	}
+}
+
+/**
+ * @brief Execute a request and append its response to txBuffer
+ *
+ * @param frame The request, starting at its len field
+ */
+static void rpc_handle_frame(const uint8_t * frame)
+{
+	uint16_t  len     = rpc_get_u16(frame) - (RPC_REQUEST_HEADER - 2);
+	uint8_t   opcode  = frame[4];
+	uint8_t * resp    = &txBuffer[txLen];
+	uint16_t  respLen = 0;
+	int8_t    status;
+
+	// Keep room for the biggest response
+	if ((txLen + 2 + RPC_FRAME_MAX_LEN) > RPC_TX_BUFFER_SIZE) {
+		rpc_flush();
+		resp = txBuffer;
+	}
+
+	switch (opcode & 0xF0) {
+	case 0x00:
+		status = rpc_exec_board(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	case 0x10:
+		status = rpc_exec_stripled(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	case 0x20:
+		status = rpc_exec_relay(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	case 0x30:
+		status = rpc_exec_buzzer(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	case 0x40:
+		status = rpc_exec_feu_rouge(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	case 0x50:
+		status = rpc_exec_temp(opcode, &frame[RPC_REQUEST_HEADER], len, &resp[RPC_RESPONSE_HEADER], &respLen);
+		break;
+	default:
+		status = RPC_STATUS_UNKNOWN;
+		break;
+	}
+
+	// Errors have no payload
+	if (status != RPC_STATUS_OK) {
+		respLen = 0;
+	}
+
+	rpc_put_u16(&resp[0], respLen + (RPC_RESPONSE_HEADER - 2));
+	resp[2] = frame[2]; // Echo reqId
+	resp[3] = frame[3];
+	resp[4] = opcode;
+	resp[5] = (uint8_t) status;
+	txLen += RPC_RESPONSE_HEADER + respLen;
+}
+
+/**
+ * @brief Execute all the complete requests waiting in rxBuffer
+ * @return 0: OK, -1: protocol error, connection must be closed
+ */
+static int rpc_process_frames(void)
+{
+	uint16_t offset = 0;
+	uint16_t frameLen;
+	uint8_t  frameCount;
+
+	for (frameCount = 0; frameCount < RPC_MAX_FRAMES_PER_CALL; ++frameCount) {
+		if ((rxLen - offset) < 2) {
+			break;
+		}
+
+		frameLen = rpc_get_u16(&rxBuffer[offset]);
+		if ((frameLen < (RPC_REQUEST_HEADER - 2)) || (frameLen > RPC_FRAME_MAX_LEN)) {
+			log_warn("RPC: bad frame length %u", frameLen);
+			return -1;
+		}
+
+		// Wait for the end of the frame
+		if ((rxLen - offset) < (2 + frameLen)) {
+			break;
+		}
+
+		rpc_handle_frame(&rxBuffer[offset]);
+		offset += 2 + frameLen;
+	}
+
+	// Keep the incomplete frame for next call
+	rxLen -= offset;
+	memmove(rxBuffer, &rxBuffer[offset], rxLen);
+	return 0;
+}
+
+// ==================
+//  FUNCTIONS
+// ==================
+
+int rpc_init(void)
+{
+	rxLen = 0;
+	txLen = 0;
+
+	rpcServer.begin();
+	rpcServer.setNoDelay(true);
+	return 0;
+}
+
+void rpc_main(void)
+{
+	int available;
+	int readLen;
+
+	// The newest client wins: a host that lost its connection can always come back
+	if (rpcServer.hasClient()) {
+		if (rpcClient) {
+			rpcClient.stop();
+		}
+		rpcClient = rpcServer.available();
+		rpcClient.setNoDelay(true);
+		rxLen = 0;
+		txLen = 0;
+	}
+
+	if (!rpcClient || !rpcClient.connected()) {
+		return;
+	}
+
+	// Take what fits, the rest stays in TCP buffers
+	available = rpcClient.available();
+	if ((available > 0) && (rxLen < RPC_RX_BUFFER_SIZE)) {
+		if (available > (RPC_RX_BUFFER_SIZE - rxLen)) {
+			available = RPC_RX_BUFFER_SIZE - rxLen;
+		}
+		readLen = rpcClient.read(&rxBuffer[rxLen], available);
+		if (readLen > 0) {
+			rxLen += readLen;
+		}
+	}
+
+	if (rpc_process_frames() != 0) {
+		rpcClient.stop();
+		rxLen = 0;
+		txLen = 0;
+		return;
+	}
+
+	rpc_flush();
+}
+
+#endif /* MODULE_RPC */
@@ -0,0 +1,74 @@
+/**
+  * @file   rpc.hpp
+  * @brief  Binary control protocol over TCP
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef RPC_RPC_HPP
+#define RPC_RPC_HPP
+
+#include <Arduino.h>
+
+/**
+ * All integers are little endian
+ *
+ * Request:  [len u16][reqId u16][opcode u8][payload]
+ * Response: [len u16][reqId u16][opcode u8][status s8][payload]
+ *
+ * len counts the bytes following it. Requests can be pipelined:
+ * they are processed in order and answered in order, reqId is echoed
+ */
+
+#define RPC_PORT                2323
+#define RPC_FRAME_MAX_LEN       128 /**< Maximum value of len, longer frames close the connection */
+#define RPC_RX_BUFFER_SIZE      512 /**< Bytes of pipelined requests waiting to be processed */
+#define RPC_TX_BUFFER_SIZE      512 /**< Responses are coalesced here before being sent */
+#define RPC_REQUEST_HEADER      5   /**< len + reqId + opcode */
+#define RPC_RESPONSE_HEADER     6   /**< len + reqId + opcode + status */
+#define RPC_MAX_FRAMES_PER_CALL 16  /**< Requests processed by rpc_main() before giving back the hand */
+#define RPC_TEMP_HISTORY_PAGE   60  /**< Samples per RPC_OP_GET_TEMP_HISTORY response, to fit in a frame */
+
+/** Status of a response */
+typedef enum
+{
+	RPC_STATUS_OK            = 0,
+	RPC_STATUS_ERROR         = -1, /**< The command failed */
+	RPC_STATUS_UNKNOWN       = -2, /**< Unknown opcode */
+	RPC_STATUS_BAD_LENGTH    = -3, /**< Payload length does not match the opcode */
+	RPC_STATUS_NOT_SUPPORTED = -4  /**< The module is not available on this board */
+} rpc_status_e;
+
+/** Opcodes, payload of request -> payload of response */
+typedef enum
+{
+	RPC_OP_PING              = 0x01, /**< any -> same bytes */
+	RPC_OP_GET_VERSION       = 0x02, /**< - -> firmware version string */
+	RPC_OP_GET_STATUS        = 0x03, /**< - -> boardStatus[NB_STATUS] */
+	RPC_OP_GET_MODULE_NAME   = 0x04, /**< - -> name string */
+	RPC_OP_SET_MODULE_NAME   = 0x05, /**< name string -> - */
+	RPC_OP_RESET             = 0x06, /**< - -> - */
+	RPC_OP_SET_STATUS_LED    = 0x07, /**< u8 isEnabled -> - */
+	RPC_OP_GET_STATE         = 0x10, /**< - -> u8 isOn */
+	RPC_OP_SET_STATE         = 0x11, /**< u8 isOn -> - */
+	RPC_OP_GET_BRIGHTNESS    = 0x12, /**< - -> u8 [0; 100] */
+	RPC_OP_SET_BRIGHTNESS    = 0x13, /**< u8 ]0; 100] -> - */
+	RPC_OP_GET_COLOR         = 0x14, /**< - -> u32 color */
+	RPC_OP_SET_COLOR         = 0x15, /**< u32 color -> - */
+	RPC_OP_GET_ANIMATION     = 0x16, /**< - -> u8 animID */
+	RPC_OP_SET_ANIMATION     = 0x17, /**< u8 animID -> - */
+	RPC_OP_GET_DEMO_MODE     = 0x18, /**< - -> u8 isInDemoMode */
+	RPC_OP_SET_DEMO_MODE     = 0x19, /**< u8 isInDemoMode -> - */
+	RPC_OP_GET_RELAY         = 0x20, /**< - -> u8 state, u8 theoretical state */
+	RPC_OP_SET_RELAY         = 0x21, /**< u8 isClose -> - */
+	RPC_OP_SET_BUZZER        = 0x30, /**< u8 id, u8 melody, u8 repeat -> - */
+	RPC_OP_GET_FEU_ROUGE     = 0x40, /**< - -> u8 FEU_ROUGE_MODE_FCT_E */
+	RPC_OP_SET_FEU_ROUGE     = 0x41, /**< u8 FEU_ROUGE_MODE_FCT_E -> - */
+	RPC_OP_SET_FEU_ROUGE_COL = 0x42, /**< u8 COLOR_CMD_E -> - */
+	RPC_OP_GET_TEMP_HISTORY  = 0x50  /**< u8 sensor, u8 level, u8 first -> u8 count, u8 first, s16 samples[] */
+} rpc_opcode_e;
+
+int  rpc_init(void);
+void rpc_main(void);
+
+#endif /* RPC_RPC_HPP */
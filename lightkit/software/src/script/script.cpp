@@ -9,6 +9,7 @@
 #include "buzzer/buzzer.hpp"
 #include "cmd/cmd.hpp"
 #include "domoticz/domoticz.hpp"
+#include "event/event.hpp"
 #include "feu_rouge/feu_rouge.hpp"
 #include "io/inputs.hpp"
 #include "io/outputs.hpp"
@@ -18,13 +19,16 @@
 
 extern uint32_t tick;
 uint32_t        nextResetTick             = 0;
-uint32_t        nextTempCheckTick         = 0;
 uint32_t        nextDomoticzUpdateTick    = 0;
 uint32_t        nextSecondRelayImpulsTick = UINT32_MAX; // Disabled at startup
 uint32_t        nextBuzzerPulseTick       = UINT32_MAX; // Disabled at startup
 bool            isInAlertOld              = false;
 bool            isAutoTempMsgEnabled      = false;
 
+#if defined(BOARD_TEMP_TELEGRAM)
+bool isOptEnabled = true; // Polled inputs start low, a rising edge comes if the switch is OFF
+#endif
+
 #if defined(MODULE_TEMPERATURE) && defined(MODULE_TELEGRAM)
 uint32_t nextTelegramUpdateTick = SCRIPT_TELEGRAM_UPT_PERIOD; // Skip first call
 #endif
@@ -41,19 +45,14 @@ uint8_t  feuRougeDemoStep       = 0;
 // CONSTANTS
 #if defined(SCRIPT_TEMP_ALERT_METHOD) && (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
 // Using extern and const together: https://stackoverflow.com/a/2190981
-extern const float sensorThreshold[TEMP_MAX_SENSOR_SUPPORTED];
-const float        sensorThreshold[TEMP_MAX_SENSOR_SUPPORTED] = {
-    SCRIPT_TEMP_ALERT_SENSOR_0,
-    SCRIPT_TEMP_ALERT_SENSOR_1
-};
-const float sensorThresholdHigh[TEMP_MAX_SENSOR_SUPPORTED] = {
-	SCRIPT_TEMP_ALERT_SENSOR_0 + SCRIPT_TEMP_ALERT_HYSTERESIS,
-	SCRIPT_TEMP_ALERT_SENSOR_1 + SCRIPT_TEMP_ALERT_HYSTERESIS
-};
-const float sensorThresholdLow[TEMP_MAX_SENSOR_SUPPORTED] = {
-	SCRIPT_TEMP_ALERT_SENSOR_0 - SCRIPT_TEMP_ALERT_HYSTERESIS,
-	SCRIPT_TEMP_ALERT_SENSOR_1 - SCRIPT_TEMP_ALERT_HYSTERESIS
-};
+extern const float   sensorThreshold[];
+extern const uint8_t sensorThresholdCount;
+const float          sensorThreshold[]    = SCRIPT_TEMP_ALERT_SENSORS;
+const uint8_t        sensorThresholdCount = sizeof(sensorThreshold) / sizeof(float);
+#endif
+
+#if defined(MODULE_TEMPERATURE) && defined(MODULE_DOMOTICZ)
+static const uint8_t domoticzSensorIds[] = DOMOTICZ_SENSOR_IDS;
 #endif
 
 /***************************************
@@ -69,151 +68,239 @@ const float sensorThresholdLow[TEMP_MAX_SENSOR_SUPPORTED] = {
 static void script_send_relay_impulse(uint32_t impulseDurationMs)
 {
 	// Set relay to ON
-	relay_set_state(true);
+	relay_set_state(RELAY_MAIN, true);
 	// Turn it OFF after impulseDurationMs milliseconds
-	relay_set_toogle_timeout(impulseDurationMs);
+	relay_set_toogle_timeout(RELAY_MAIN, impulseDurationMs);
 }
 #endif
 
-/***************************************
-                FUNCTIONS
- ***************************************/
-
+#if defined(BOARD_TEMP_DOMOTICZ) || defined(BOARD_TEMP_TELEGRAM)
 /**
- * @brief Main function of script module
+ * @brief Compute the temperature alert from the last sensor values
  */
-void script_main(void)
+static void script_check_temp_alert(void)
 {
-#if defined(MODULE_TEMPERATURE) && defined(MODULE_DOMOTICZ)
-	if ((isAutoTempMsgEnabled == true) && (tick > nextDomoticzUpdateTick)) {
-		nextDomoticzUpdateTick = tick + SCRIPT_DOMOTICZ_UPT_PERIOD;
+	bool isTempAlarmDisabled = false;
 
-		// Send all sensor values
-		for (byte i = 0; i < temp_get_nb_sensor(); ++i) {
-			uint8_t sensorId = (i == DEVICE_INDEX_0) ? DOMOTICZ_SENSOR_ID_INSIDE : DOMOTICZ_SENSOR_ID_OUTSIDE;
-			domoticz_send_temperature(sensorId, temp_get_value(i));
-		}
-	}
+#if defined(BOARD_TEMP_TELEGRAM)
+	/** Force alarm off if OPT is enabled */
+	isTempAlarmDisabled = isOptEnabled;
 #endif
 
-#if defined(MODULE_TEMPERATURE) && defined(MODULE_TELEGRAM)
-	if ((isAutoTempMsgEnabled == true) && (tick > nextTelegramUpdateTick)) {
-		nextTelegramUpdateTick = tick + SCRIPT_TELEGRAM_UPT_PERIOD;
+#if (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
+	bool atLeastOneIsAbove = false;
+	bool allAreBelow       = true;
 
-		// Send all sensor values
-		for (byte i = 0; i < temp_get_nb_sensor(); ++i) {
-			telegram_send_msg_temperature(i, temp_get_value(i));
+	// For each sensor with a threshold
+	for (int i = 0; (i < temp_get_nb_sensor()) && (i < sensorThresholdCount); ++i) {
+		float sensorTemp = temp_get_value(i);
+
+		// Ignore faulty sensors
+		if (temp_is_faulty(i)) {
+			continue;
+		}
+
+		if (sensorTemp >= (sensorThreshold[i] + SCRIPT_TEMP_ALERT_HYSTERESIS)) {
+			atLeastOneIsAbove = true;
+		}
+		if (sensorTemp >= (sensorThreshold[i] - SCRIPT_TEMP_ALERT_HYSTERESIS)) {
+			allAreBelow = false;
 		}
 	}
-#endif
 
-#if defined(BOARD_TEMP_TELEGRAM)
-	/** Send a Telegram message when OPT just changed
-     *
-     *  Note: Here we use INPUTS_OPT_TEMP_ALARM_EN define
-     *  whatever the version BUZZER or RELAY
-     */
-	if (is_input_falling(INPUTS_OPT_TEMP_ALARM_EN)) {
-		reset_input_falling(INPUTS_OPT_TEMP_ALARM_EN);
-		telegram_send_opt_changed(true);
-		nextTempCheckTick = 0; // Force update of temperature
-	} else if (is_input_rising(INPUTS_OPT_TEMP_ALARM_EN)) {
-		reset_input_rising(INPUTS_OPT_TEMP_ALARM_EN);
-		telegram_send_opt_changed(false);
-		nextTempCheckTick = 0; // Force update of temperature
+	// Define the new state of the alert
+	if (isTempAlarmDisabled) {
+		_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+	} else if (atLeastOneIsAbove) {
+		_set(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+	} else if (allAreBelow) {
+		_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+	}
+#elif (SCRIPT_TEMP_ALERT_METHOD == METHOD_DIFFERENTIAL)
+
+	if (isTempAlarmDisabled) {
+		// Force Off
+		_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+	} else if (temp_get_nb_sensor() < 2) {
+		// We need at least 2 sensors to make a difference
+	} else if (temp_is_faulty(DEVICE_INDEX_0) || temp_is_faulty(DEVICE_INDEX_1)) {
+		// We need both sensor fully operationnal to continue
+	} else {
+		// Take the absolute value of the difference
+		float diffTemp = fabs(temp_get_value(DEVICE_INDEX_1) - temp_get_value(DEVICE_INDEX_0));
+
+		if (diffTemp >= (SCRIPT_TEMP_ALERT_DIFF_THRESHOLD + SCRIPT_TEMP_ALERT_HYSTERESIS)) {
+			_set(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+		} else if (diffTemp <= (SCRIPT_TEMP_ALERT_DIFF_THRESHOLD - SCRIPT_TEMP_ALERT_HYSTERESIS)) {
+			_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+		}
 	}
 #endif
 
-	// Temperature alarm
-#if defined(BOARD_TEMP_DOMOTICZ) || defined(BOARD_TEMP_TELEGRAM)
-	if (tick > nextTempCheckTick) {
-		nextTempCheckTick = tick + SCRIPT_TEMP_CHECK_PERIOD;
+	// Detect edges
+	if (isInAlertOld != _isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT)) {
+		isInAlertOld = _isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
+		log_error("Script alert is now %s", isInAlertOld ? "active" : "inactive");
 
-		bool isTempAlarmDisabled = false;
+		// Tell other modules that alert level changed
+		event_publish(EVENT_ALERT, 0, isInAlertOld);
 
-#if defined(BOARD_TEMP_TELEGRAM)
-		/** Force alarm off if OPT is enabled
-         *  Switch is ON when signal is LOW */
-		isTempAlarmDisabled = is_input_low(INPUTS_OPT_TEMP_ALARM_EN);
+#if defined(MODULE_RELAY)
+		script_relay_set_event(isInAlertOld);
 #endif
 
-#if (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
-		bool atLeastOneIsAbove = false;
-		bool allAreBelow       = true;
+#if defined(BOARD_TEMP_DOMOTICZ_BUZZER) || defined(BOARD_TEMP_TELEGRAM_BUZZER)
+		// Are we configured in impulsion mode ?
+		if (is_input_low(INPUTS_OPT_ALARM_IMPULSION_MODE_EN)) {
+			// Either stop pulse (UINT32_MAX) or start now (0)
+			nextBuzzerPulseTick = isInAlertOld ? 0 : UINT32_MAX;
+		} else {
+			// Start/Stop the buzzer in continuous mode
+			output_set(OUTPUTS_BUZZER, isInAlertOld);
+		}
+#endif
+	}
+}
 
-		// For each sensor
-		for (int i = 0; i < temp_get_nb_sensor(); ++i) {
-			float sensorTemp = temp_get_value(i);
+/**
+ * @brief Check the alert each time a sensor is read
+ *
+ * @param pEvent EVENT_TEMP_VALUE or EVENT_TEMP_FAULT
+ * @param arg Unused
+ */
+static void script_temp_event_callback(const struct event_t * pEvent, void * arg)
+{
+	script_check_temp_alert();
+}
+#endif
 
-			// Ignore faulty sensors
-			if (_isset(STATUS_TEMP, STATUS_TEMP_1_FAULT << i)) {
-				continue;
-			}
+#if defined(BOARD_TEMP_TELEGRAM)
+/**
+ * @brief Send a Telegram message when OPT just changed
+ * @note Here we use INPUTS_OPT_TEMP_ALARM_EN define
+ * whatever the version BUZZER or RELAY
+ *
+ * @param pEvent Edge of INPUTS_OPT_TEMP_ALARM_EN
+ * @param arg Unused
+ */
+static void script_opt_event_callback(const struct event_t * pEvent, void * arg)
+{
+	// Switch is ON when signal is LOW
+	isOptEnabled = (pEvent->type == EVENT_INPUT_FALLING);
+	telegram_send_opt_changed(isOptEnabled);
 
-			if (sensorTemp >= sensorThresholdHigh[i]) {
-				atLeastOneIsAbove = true;
-			}
-			if (sensorTemp >= sensorThresholdLow[i]) {
-				allAreBelow = false;
-			}
-		}
+	// Alert may change without waiting for the next measure
+	script_check_temp_alert();
+}
+#endif
 
-		// Define the new state of the alert
-		if (isTempAlarmDisabled) {
-			_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-		} else if (atLeastOneIsAbove) {
-			_set(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-		} else if (allAreBelow) {
-			_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-		}
-#elif (SCRIPT_TEMP_ALERT_METHOD == METHOD_DIFFERENTIAL)
+#ifdef BOARD_RING
+/**
+ * @brief Publish a detection when the PIR detector triggers
+ *
+ * @param pEvent Edge of INPUTS_PIR_DETECTOR
+ * @param arg Unused
+ */
+static void script_pir_event_callback(const struct event_t * pEvent, void * arg)
+{
+	uint32_t duration;
 
-		if (isTempAlarmDisabled) {
-			// Force Off
-			_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-		} else if (temp_get_nb_sensor() < 2) {
-			// We need at least 2 sensors to make a difference
-		} else if (_isset(STATUS_TEMP, STATUS_TEMP_1_FAULT | STATUS_TEMP_2_FAULT)) {
-			// We need both sensor fully operationnal to continue
-		} else {
-			// Take the absolute value of the difference
-			float diffTemp = fabs(temp_get_value(DEVICE_INDEX_1) - temp_get_value(DEVICE_INDEX_0));
+	/** Is the jumper set to enable the detector ? */
+	if (is_input_high(INPUTS_PIR_DETECTOR_ENABLE)) {
+		return;
+	}
 
-			if (diffTemp >= (SCRIPT_TEMP_ALERT_DIFF_THRESHOLD + SCRIPT_TEMP_ALERT_HYSTERESIS)) {
-				_set(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-			} else if (diffTemp <= (SCRIPT_TEMP_ALERT_DIFF_THRESHOLD - SCRIPT_TEMP_ALERT_HYSTERESIS)) {
-				_unset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-			}
-		}
+	// Detection ! Turn on the strip
+	duration = input_analog_read(INPUTS_PIR_DETECTOR_DELAY);
+	// Convert to [0; MAX min - 1 min], 12 bits so 4095
+	duration = ((duration * ((DETECTOR_MAX_DURATION_MIN - 1) * 60)) / 4095) * 1000;
+	// Convert to [1 min; MAX min]
+	duration += 1 * 60 * 1000;
+
+	event_publish(EVENT_DETECTION, 0, duration);
+	log_info("Detection triggered ! Delay = %dmin", duration / (1000 * 60));
+}
 #endif
 
-		// Detect edges
-		if (isInAlertOld != _isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT)) {
-			isInAlertOld = _isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT);
-			log_error("Script alert is now %s", isInAlertOld ? "active" : "inactive");
+#if defined(BOARD_FEU_ROUGE)
+/**
+ * @brief Use the door switch to control the light
+ *
+ * @param pEvent Edge of INPUTS_DOOR_SWITCH
+ * @param arg Unused
+ */
+static void script_door_event_callback(const struct event_t * pEvent, void * arg)
+{
+	if (feu_rouge_get_fct_mode() != MODE_FCT_DOOR) {
+		return;
+	}
 
-#ifdef MODULE_TELEGRAM
-			// Tell telegram client that alert level changed
-			telegram_send_alert(isInAlertOld);
+	if (pEvent->type == EVENT_INPUT_FALLING) {
+		feu_rouge_mode_fct_door(DOOR_CMD_SOMEONE_COME_IN);
+	} else {
+		feu_rouge_mode_fct_door(DOOR_CMD_SOMEONE_COME_OUT);
+	}
+}
 #endif
 
-#if defined(MODULE_RELAY)
-			script_relay_set_event(isInAlertOld);
+/***************************************
+                FUNCTIONS
+ ***************************************/
+
+/**
+ * @brief Subscribe to the events handled by the script
+ */
+int script_init(void)
+{
+#if defined(BOARD_TEMP_DOMOTICZ) || defined(BOARD_TEMP_TELEGRAM)
+	CHECK_CALL(event_subscribe(event_mask(EVENT_TEMP_VALUE) | event_mask(EVENT_TEMP_FAULT),
+							   EVENT_SOURCE_ANY, script_temp_event_callback, NULL))
+#endif
+#if defined(BOARD_TEMP_TELEGRAM)
+	CHECK_CALL(event_subscribe(EVENT_MASK_INPUT_EDGE, INPUTS_OPT_TEMP_ALARM_EN, script_opt_event_callback, NULL))
+#endif
+#ifdef BOARD_RING
+#if (DETECTOR_INVERSE_POLARITY == 0)
+	CHECK_CALL(event_subscribe(event_mask(EVENT_INPUT_RISING), INPUTS_PIR_DETECTOR, script_pir_event_callback, NULL))
+#else
+	CHECK_CALL(event_subscribe(event_mask(EVENT_INPUT_FALLING), INPUTS_PIR_DETECTOR, script_pir_event_callback, NULL))
+#endif
+#endif
+#if defined(BOARD_FEU_ROUGE)
+	CHECK_CALL(event_subscribe(EVENT_MASK_INPUT_EDGE, INPUTS_DOOR_SWITCH, script_door_event_callback, NULL))
 #endif
 
-#if defined(BOARD_TEMP_DOMOTICZ_BUZZER) || defined(BOARD_TEMP_TELEGRAM_BUZZER)
-			// Are we configured in impulsion mode ?
-			if (is_input_low(INPUTS_OPT_ALARM_IMPULSION_MODE_EN)) {
-				// Either stop pulse (UINT32_MAX) or start now (0)
-				nextBuzzerPulseTick = isInAlertOld ? 0 : UINT32_MAX;
-			} else {
-				// Start/Stop the buzzer in continuous mode
-				output_set(OUTPUTS_BUZZER, isInAlertOld);
-			}
+	return 0;
+}
+
+/**
+ * @brief Main function of script module
+ */
+void script_main(void)
+{
+#if defined(MODULE_TEMPERATURE) && defined(MODULE_DOMOTICZ)
+	if ((isAutoTempMsgEnabled == true) && (tick > nextDomoticzUpdateTick)) {
+		nextDomoticzUpdateTick = tick + SCRIPT_DOMOTICZ_UPT_PERIOD;
+
+		// Send all sensor values that have a device
+		for (byte i = 0; (i < temp_get_nb_sensor()) && (i < sizeof(domoticzSensorIds)); ++i) {
+			domoticz_send_temperature(domoticzSensorIds[i], temp_get_value(i));
+		}
+	}
 #endif
+
+#if defined(MODULE_TEMPERATURE) && defined(MODULE_TELEGRAM)
+	if ((isAutoTempMsgEnabled == true) && (tick > nextTelegramUpdateTick)) {
+		nextTelegramUpdateTick = tick + SCRIPT_TELEGRAM_UPT_PERIOD;
+
+		// Send all sensor values
+		for (byte i = 0; i < temp_get_nb_sensor(); ++i) {
+			telegram_send_msg_temperature(i, temp_get_value(i));
 		}
 	}
+#endif
 
+#if defined(BOARD_TEMP_DOMOTICZ) || defined(BOARD_TEMP_TELEGRAM)
 #if defined(MODULE_TELEGRAM) && (SCRIPT_TELEGRAM_CONN_OK_NOTIFY_PERIOD > 0)
 	// Send a brief message to say connection is OK
 	if (tick > nextTelegramConnOkNotify) {
@@ -245,40 +332,6 @@ void script_main(void)
 #endif
 #endif // End of BOARD_TEMP_DOMOTICZ || BOARD_TEMP_TELEGRAM
 
-#ifdef BOARD_RING
-	static uint32_t detectorEndTick = UINT32_MAX;
-
-	/** Is the jumper set to enable the detector ? */
-	if (is_input_low(INPUTS_PIR_DETECTOR_ENABLE)) {
-/** PIR Detector */
-#if (DETECTOR_INVERSE_POLARITY == 0)
-		if (is_input_rising(INPUTS_PIR_DETECTOR)) {
-			reset_input_rising(INPUTS_PIR_DETECTOR);
-#else
-		if (is_input_falling(INPUTS_PIR_DETECTOR)) {
-			reset_input_falling(INPUTS_PIR_DETECTOR);
-#endif
-			// Detection ! Turn on the strip
-			uint32_t duration = input_analog_read(INPUTS_PIR_DETECTOR_DELAY);
-			// Convert to [0; MAX min - 1 min], 12 bits so 4095
-			duration = ((duration * ((DETECTOR_MAX_DURATION_MIN - 1) * 60)) / 4095) * 1000;
-			// Convert to [1 min; MAX min]
-			duration += 1 * 60 * 1000;
-			// Set the moment of closure
-			detectorEndTick = tick + duration;
-
-			cmd_set_state(true);
-			log_info("Detection triggered ! Delay = %dmin", duration / (1000 * 60));
-		}
-	}
-
-	// Detector duration end
-	if (tick > detectorEndTick) {
-		cmd_set_state(false);
-		detectorEndTick = UINT32_MAX;
-	}
-#endif
-
 #if defined(BOARD_FEU_ROUGE)
 	{
 		FEU_ROUGE_MODE_FCT_E fctMode;
@@ -314,15 +367,6 @@ void script_main(void)
 					feuRougeDemoStep = 0;
 				}
 			}
-		} else if (fctMode == MODE_FCT_DOOR) {
-			if (is_input_falling(INPUTS_DOOR_SWITCH)) {
-				reset_input_falling(INPUTS_DOOR_SWITCH);
-				feu_rouge_mode_fct_door(DOOR_CMD_SOMEONE_COME_IN);
-			}
-			if (is_input_rising(INPUTS_DOOR_SWITCH)) {
-				reset_input_rising(INPUTS_DOOR_SWITCH);
-				feu_rouge_mode_fct_door(DOOR_CMD_SOMEONE_COME_OUT);
-			}
 		}
 	}
 #endif
@@ -337,19 +381,6 @@ void script_main(void)
 	}
 }
 
-#if defined(MODULE_RELAY)
-/**
- * @brief Called when RELAY fault is set or cleared
- */
-void script_relay_feedback_event(void)
-{
-#if defined(MODULE_TELEGRAM)
-	bool isOk = _isunset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT);
-	telegram_send_msg_relay_feedback(isOk);
-#endif
-}
-#endif
-
 #if defined(MODULE_RELAY)
 void script_relay_set_event(bool isClosed)
 {
@@ -366,7 +397,7 @@ void script_relay_set_event(bool isClosed)
 #endif
 	} else {
 		// No impulsion, just set the relay ON when alert is ON and vice versa
-		relay_set_state(isClosed);
+		relay_set_state(RELAY_MAIN, isClosed);
 	}
 }
 #endif
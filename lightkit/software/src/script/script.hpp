@@ -10,9 +10,9 @@
 
 #include "global.hpp"
 
+int  script_init(void);
 void script_main(void);
 #if defined(MODULE_RELAY)
-void script_relay_feedback_event(void);
 void script_relay_set_event(bool isClosed);
 #endif
 void script_delayed_reset(uint32_t tickCount);
@@ -40,8 +40,7 @@ extern uint8_t boardStatus[NB_STATUS];
 #define STATUS_WIFI_DOMOTICZ_FAULT    0x08
 
 /* STATUS_TEMP */
-#define STATUS_TEMP_1_FAULT 0x01
-#define STATUS_TEMP_2_FAULT 0x02
+#define STATUS_TEMP_FAULT 0x01 /** At least one sensor is faulty, see temp_is_faulty() */
 
 /* STATUS_SCRIPT */
 #define STATUS_SCRIPT_IN_ALERT 0x01
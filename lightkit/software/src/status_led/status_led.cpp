@@ -85,7 +85,7 @@ void status_led_main(void)
 	} else if (_isunset(STATUS_WIFI, STATUS_WIFI_IS_CO)) {
 		status_led[1].timeOn  = 100;
 		status_led[1].timeOff = 900;
-	} else if (_isset(STATUS_TEMP, STATUS_TEMP_1_FAULT | STATUS_TEMP_2_FAULT)) {
+	} else if (_isset(STATUS_TEMP, STATUS_TEMP_FAULT)) {
 		status_led[1].timeOn  = 200;
 		status_led[1].timeOff = 1800;
 	} else if (_isset(STATUS_APPLI, STATUS_APPLI_ERROR) || _isset(STATUS_APPLI, STATUS_APPLI_FILESYSTEM)) {
@@ -178,7 +178,7 @@ void status_led_main(void)
 		status_led[0].timeOn  = 0;
 		status_led[0].timeOff = 500;
 		status_led[0].color   = '-';
-	} else if (_isset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT) || _isset(STATUS_TEMP, STATUS_TEMP_1_FAULT | STATUS_TEMP_2_FAULT)) {
+	} else if (_isset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT) || _isset(STATUS_TEMP, STATUS_TEMP_FAULT)) {
 		// Hardware Fault
 		status_led[0].timeOn  = 100;
 		status_led[0].timeOff = 900;
@@ -6,6 +6,7 @@
   */
 
 #include "stripled.hpp"
+#include "event/event.hpp"
 #include "flash/flash.hpp"
 #include "global.hpp"
 #include "io/inputs.hpp"
@@ -30,6 +31,9 @@ uint32_t autoBrightTick;
 /** Indicate the period in tick between two stripled refresh */
 uint32_t refreshPeriod = STRIPLED_MAX_REFRESH_PERIOD;
 
+/** When the strip turns off after a detection */
+static uint32_t detectionEndTick = UINT32_MAX;
+
 // Externals
 extern uint32_t tick;
 
@@ -152,6 +156,15 @@ void stripled_set_state(bool isOn)
 	refresh_now();
 }
 
+/**
+ * Turn the strip on for the duration of a detection
+ */
+static void stripled_event_callback(const struct event_t * pEvent, void * arg)
+{
+	stripled_set_state(true);
+	detectionEndTick = tick + pEvent->value;
+}
+
 /********************************
  *          Init
  ********************************/
@@ -197,6 +210,8 @@ int stripled_init(void)
 
 	ws2812fx.start();
 
+	CHECK_CALL(event_subscribe(event_mask(EVENT_DETECTION), EVENT_SOURCE_ANY, stripled_event_callback, NULL))
+
 	return 0;
 }
 
@@ -216,6 +231,12 @@ void stripled_main(void)
 		}
 	}
 
+	// Detection duration end
+	if (tick > detectionEndTick) {
+		detectionEndTick = UINT32_MAX;
+		stripled_set_state(false);
+	}
+
 	// Update demo mode
 	if (stripledParams->isInDemoMode) {
 		if (tick >= demoTick) {
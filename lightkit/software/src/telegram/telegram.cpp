@@ -5,7 +5,7 @@
   * @date   12/08/2020
   */
 
-#include <UniversalTelegramBot.h>
+#include <ArduinoJson.h>
 #include <WiFiClientSecure.h>
 #include <stdlib.h>
 #ifdef ESP32
@@ -14,239 +14,945 @@
 #include <ESP8266WiFi.h>
 #endif
 
+#include "event/event.hpp"
 #include "global.hpp"
 #include "io/inputs.hpp"
 #include "relay/relay.hpp"
 #include "script/script.hpp"
 #include "telegram.hpp"
+#include "telegram_chat.hpp"
 #include "temp/temp.hpp"
+#include "temp/temp_history.hpp"
+#include "tools/str_buffer.hpp"
 
 #ifdef MODULE_TELEGRAM
 
+/**
+ * One TLS connection is kept open to the Bot API. getUpdates is a long poll,
+ * its reply is read a few bytes each tick so nothing waits for the server.
+ * A message to send waits for the end of the poll, which is kept short:
+ * closing the connection to send at once would cost a TLS handshake.
+ */
+enum telegram_state_e {
+	TELEGRAM_STATE_IDLE = 0,    /**< No request in flight */
+	TELEGRAM_STATE_STATUS_LINE, /**< Request is sent, waiting for "HTTP/1.1 200 OK" */
+	TELEGRAM_STATE_HEADERS,     /**< Reading headers until the empty line */
+	TELEGRAM_STATE_BODY         /**< Reading the body */
+};
+
+enum telegram_request_e {
+	TELEGRAM_REQUEST_POLL = 0, /**< getUpdates */
+	TELEGRAM_REQUEST_SEND      /**< sendMessage of the first queued message */
+};
+
+/** Queued messages are sent by priority, then from the oldest */
+enum telegram_priority_e {
+	TELEGRAM_PRIORITY_ALERT = 0, /**< Alert goes on or off */
+	TELEGRAM_PRIORITY_REPLY,     /**< Reply to a command */
+	TELEGRAM_PRIORITY_STATUS,    /**< Change of state, the pending ones are merged */
+	TELEGRAM_PRIORITY_PERIODIC   /**< Sent again later anyway, dropped first */
+};
+
+/** A queued message with the same key is replaced by the new one */
+enum telegram_key_e {
+	TELEGRAM_KEY_NONE = 0,
+	TELEGRAM_KEY_CONN_OK,
+	TELEGRAM_KEY_TEMP /**< + sensor index */
+};
+
 // STRUCT
 struct telegram_cmd_t {
-	char text[TG_CMD_TEXT_LEN];
-	char desc[TG_CMD_DESC_LEN];
-	String (*callback)(String);
+	char     text[TG_CMD_TEXT_LEN];
+	char     desc[TG_CMD_DESC_LEN];
+	uint32_t hash; /**< Of text, see telegram_hash() */
+	uint8_t  role; /**< Lowest role allowed to use it, see telegram_role_e */
+	void (*callback)(str_buffer_t *, uint8_t); /**< Writes the reply */
+};
+
+struct telegram_msg_t {
+	int64_t  chatId;    /**< Chat out of the list, the only one it is sent to, 0: See chatMask */
+	uint16_t chatMask;  /**< Chats it is still to be sent to, one bit per chat index */
+	uint8_t  chatIndex; /**< Chat it is sent to when in flight */
+	uint8_t  priority;  /**< See telegram_priority_e */
+	uint8_t  key;       /**< See telegram_key_e */
+	char     text[TELEGRAM_MSG_SIZE];
+};
+
+struct telegram_stats_t {
+	uint32_t handshakeCount;
+	uint32_t handshakeTotalMs; /**< Main loop is blocked during the handshake */
+	uint32_t handshakeMaxMs;
+	uint32_t pollCount;
+	uint32_t pollTotalMs;
+	uint32_t pollShortCount; /**< Polls without wait between two batches of messages */
+	uint32_t sendCount;
+	uint32_t sendTotalMs;
+	uint32_t mergeCount; /**< Messages merged in a queued one */
+	uint32_t dropCount;  /**< Messages dropped because the queue is full */
+	uint32_t errorCount;
 };
 
 // EXTERNS
 extern uint32_t tick;
-extern float    sensorThreshold[TEMP_MAX_SENSOR_SUPPORTED];
+extern const float   sensorThreshold[];
+extern const uint8_t sensorThresholdCount;
 extern bool     isAutoTempMsgEnabled;
 
 // STATIC
-static uint32_t             nextCheckTick = 0;
-static String               linkedChat;
-static WiFiClientSecure     wiFiClientSecure;
-static UniversalTelegramBot TBot(TELEGRAM_CONV_TOKEN, wiFiClientSecure);
-static String               dummyMessages[TELEGRAM_DUMMY_MSG_COUNT] = {
+static WiFiClientSecure        client;
+#ifdef ESP8266
+static BearSSL::Session        tlsSession; /**< A reconnection resumes it instead of a full handshake */
+#endif
+static bool                    isEnabled     = false;
+static uint8_t                 telegramState = TELEGRAM_STATE_IDLE;
+static uint8_t                 requestType;
+static uint32_t                requestTick;  /**< When the request was sent */
+static uint32_t                replyEndTick; /**< Reply must be complete before this tick */
+static uint32_t                nextTryTick    = 0;
+static uint8_t                 failCount      = 0; /**< Failures in a row, for the back-off */
+static uint32_t                nextUpdateId   = 0; /**< Confirms the updates before this one */
+static bool                    isLongPoll;         /**< Poll in flight can wait for TELEGRAM_POLL_TIMEOUT_S */
+static uint8_t                 sendsSincePoll = 0;
+static struct telegram_msg_t   txQueue[TELEGRAM_TX_QUEUE_SIZE];
+static uint8_t                 txCount       = 0;  /**< From the oldest to the newest */
+static int8_t                  inFlightIndex = -1; /**< Message sent, waiting for the reply, -1: None */
+static char                    txBuffer[TELEGRAM_TX_BUFFER_SIZE];
+static char                    rxBuffer[TELEGRAM_RX_BUFFER_SIZE];
+static uint16_t                rxLength;
+static bool                    rxOverflow;
+static char                    line[TELEGRAM_LINE_SIZE];
+static uint8_t                 lineLength;
+static int                     httpCode;
+static int32_t                 bodyLeft;     /**< Bytes of body still to read, -1 until the connection is closed */
+static bool                    isKeepAlive;  /**< Server keeps the connection open after the reply */
+static bool                    isReusedConn; /**< Request was sent on the connection of a previous one */
+static struct telegram_stats_t stats;
+static const char *            dummyMessages[TELEGRAM_DUMMY_MSG_COUNT] = {
     TG_MSG_DUMMY_1,
     TG_MSG_DUMMY_2,
     TG_MSG_DUMMY_3
 };
-static char   dummyBytes[3 * 8 + 1];
-static String reply        = "";
-static String keyboardJson = "";
+static char         dummyBytes[3 * 8 + 1];
+static char         replyBuffer[TELEGRAM_MSG_SIZE]; /**< Nothing is allocated, the heap is kept for the TLS handshake */
+static str_buffer_t reply;
+static char         keyboardJson[TELEGRAM_KEYBOARD_SIZE];
 
 static struct telegram_cmd_t telegramCmds[TG_CMD_MAX];
 static uint32_t              telegramCmdsCount;
+static int8_t                telegramCmdSlots[TG_CMD_HASH_SIZE]; /**< Index in telegramCmds, -1: Empty slot */
+
+/**
+ * @brief Remove a message from the queue
+ *
+ * @param index Index in txQueue
+ */
+static void telegram_queue_remove(uint8_t index)
+{
+	// The message in flight keeps its index
+	if (inFlightIndex == index) {
+		inFlightIndex = -1;
+	} else if (inFlightIndex > index) {
+		inFlightIndex--;
+	}
+
+	for (uint8_t i = index; i < (txCount - 1); i++) {
+		txQueue[i] = txQueue[i + 1];
+	}
+	txCount--;
+}
 
 /**
- * @brief Send a reply to the linked chat
+ * @brief Find the message to send
+ *
+ * @return Index in txQueue, -1: Queue is empty
+ */
+static int telegram_queue_first(void)
+{
+	int first = -1;
+
+	for (uint8_t i = 0; i < txCount; i++) {
+		if ((first < 0) || (txQueue[i].priority < txQueue[first].priority)) {
+			first = i;
+		}
+	}
+
+	return first;
+}
+
+/**
+ * @brief Make room for a new message
+ *
+ * @param priority Priority of the new message
+ * @return 0: OK, -1: Only more important messages are queued
+ */
+static int telegram_queue_make_room(uint8_t priority)
+{
+	int victim = -1;
+
+	// The oldest of the least important ones
+	for (uint8_t i = 0; i < txCount; i++) {
+		if ((i != inFlightIndex) && ((victim < 0) || (txQueue[i].priority > txQueue[victim].priority))) {
+			victim = i;
+		}
+	}
+
+	stats.dropCount++;
+	if ((victim < 0) || (txQueue[victim].priority < priority)) {
+		log_warn("Telegram queue is full, new message is dropped");
+		return -1;
+	}
+
+	log_warn("Telegram queue is full, a message is dropped");
+	telegram_queue_remove(victim);
+	return 0;
+}
+
+/**
+ * @brief Queue a message for some chats
+ * @details Sent by telegram_main(), it stays queued
+ * while WiFi is down
+ *
+ * @param chatMask The chats, one bit per chat index
+ * @param chatId A chat out of the list, with chatMask 0, else 0
+ * @param priority See telegram_priority_e
+ * @param key See telegram_key_e
+ * @param msg The string to send
+ */
+static void telegram_queue_msg(uint16_t chatMask, int64_t chatId, uint8_t priority, uint8_t key, const char * msg)
+{
+	struct telegram_msg_t * pMsg;
+	size_t                  length;
+
+	for (uint8_t i = 0; i < txCount; i++) {
+		pMsg = &txQueue[i];
+		if ((pMsg->chatMask != chatMask) || (pMsg->chatId != chatId) || (i == inFlightIndex)) {
+			continue;
+		}
+
+		if ((key != TELEGRAM_KEY_NONE) && (pMsg->key == key)) {
+			// Only the newest value matters
+			snprintf(pMsg->text, TELEGRAM_MSG_SIZE, "%s", msg);
+			stats.mergeCount++;
+			return;
+		}
+		length = strlen(pMsg->text);
+		if ((priority == TELEGRAM_PRIORITY_STATUS) && (pMsg->priority == TELEGRAM_PRIORITY_STATUS) && ((length + 1 + strlen(msg)) < TELEGRAM_MERGE_MAX_LEN)) {
+			// One message tells all the changes
+			snprintf(&pMsg->text[length], TELEGRAM_MSG_SIZE - length, "\n%s", msg);
+			stats.mergeCount++;
+			return;
+		}
+	}
+
+	if ((txCount >= TELEGRAM_TX_QUEUE_SIZE) && (telegram_queue_make_room(priority) != 0)) {
+		return;
+	}
+
+	pMsg           = &txQueue[txCount++];
+	pMsg->chatId   = chatId;
+	pMsg->chatMask = chatMask;
+	pMsg->priority = priority;
+	pMsg->key      = key;
+	snprintf(pMsg->text, TELEGRAM_MSG_SIZE, "%s", msg);
+}
+
+/**
+ * @brief Send a message to the subscribed chats
  * with a special inline keyboard
  *
  * @param msg The string to send
+ * @param priority See telegram_priority_e
+ * @param key See telegram_key_e
  */
-static void telegram_send(String msg)
+static void telegram_send(const char * msg, uint8_t priority, uint8_t key)
 {
+	uint16_t chatMask = telegram_chat_get_subscribers();
+
 	// We have nowhere to send this message
-	if (linkedChat == "") {
+	if (chatMask == 0) {
+		if (priority == TELEGRAM_PRIORITY_ALERT) {
+			log_warn("No Telegram chat is subscribed, alert is dropped");
+		}
 		return;
 	}
 
-	TBot.sendMessageWithReplyKeyboard(linkedChat, msg, "Markdown", keyboardJson);
+	telegram_queue_msg(chatMask, 0, priority, key, msg);
+}
+
+/**
+ * @brief Close the connection
+ * @details The message in flight is sent again
+ * on the next connection
+ */
+static void telegram_disconnect(void)
+{
+	client.stop();
+	telegramState = TELEGRAM_STATE_IDLE;
+	inFlightIndex = -1;
+}
+
+/**
+ * @brief Write the sendMessage request of a message in txBuffer
+ *
+ * @param pMsg The message
+ * @param chatId The chat to send it to
+ * @return The length of the request, -1: Message is too long
+ */
+static int telegram_build_send_request(const struct telegram_msg_t * pMsg, int64_t chatId)
+{
+	StaticJsonDocument<TELEGRAM_JSON_SIZE> json;
+	size_t                                 bodyLength;
+	int                                    headerLength;
+
+	// Strings are not copied, they live until the request is written
+	json["chat_id"]                  = chatId;
+	json["text"]                     = (const char *) pMsg->text;
+	json["parse_mode"]               = "Markdown";
+	json["reply_markup"]["keyboard"] = serialized((const char *) keyboardJson);
+	if (json.overflowed()) {
+		return -1;
+	}
+
+	bodyLength   = measureJson(json);
+	headerLength = snprintf(txBuffer, TELEGRAM_TX_BUFFER_SIZE,
+							"POST /bot" TELEGRAM_CONV_TOKEN "/sendMessage HTTP/1.1\r\n"
+							"Host: " TELEGRAM_HOST "\r\n"
+							"Connection: keep-alive\r\n"
+							"Content-Type: application/json\r\n"
+							"Content-Length: %u\r\n\r\n",
+							(unsigned int) bodyLength);
+	if ((headerLength < 0) || ((headerLength + bodyLength) >= TELEGRAM_TX_BUFFER_SIZE)) {
+		return -1;
+	}
+	serializeJson(json, &txBuffer[headerLength], TELEGRAM_TX_BUFFER_SIZE - headerLength);
+
+	return headerLength + bodyLength;
+}
+
+/**
+ * @brief Open the TLS connection
+ * @details This blocks the main loop, from ~2s for a full
+ * handshake to a few hundreds of ms for a resumed session
+ *
+ * @return 0: OK, -1: Unable to connect
+ */
+static int telegram_connect(void)
+{
+	uint32_t startTick = tick;
+	uint32_t duration;
+
+	client.stop();
+	client.setTimeout(TELEGRAM_CONNECT_TIMEOUT_MS);
+	if (!client.connect(TELEGRAM_HOST, TELEGRAM_PORT)) {
+		log_error("Unable to connect to Telegram");
+		return -1;
+	}
+
+	// The tick is incremented by interrupt, it counts the blocked time
+	duration = tick - startTick;
+	stats.handshakeCount++;
+	stats.handshakeTotalMs += duration;
+	if (duration > stats.handshakeMaxMs) {
+		stats.handshakeMaxMs = duration;
+	}
+	log_info("Connected to Telegram in %u ms", duration);
+
+	return 0;
+}
+
+/**
+ * @brief Find the next chat a message is sent to
+ *
+ * @param pMsg The message
+ * @return The chat index, -1: No chat left
+ */
+static int telegram_next_chat(struct telegram_msg_t * pMsg)
+{
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if ((pMsg->chatMask & (1 << i)) == 0) {
+			continue;
+		}
+		if (telegram_chat_get(i) != NULL) {
+			return i;
+		}
+		// Chat was removed from the list
+		pMsg->chatMask &= ~(1 << i);
+	}
+
+	return -1;
 }
 
 /**
- * @brief Send a brief message to explain all available commands
+ * @brief Send the first message to its next chat, or poll
+ * @details Messages are sent back to back, up to TELEGRAM_SENDS_PER_POLL,
+ * then a poll that does not wait checks for commands
+ *
+ * @return 0: OK, -1: Unable to connect
  */
-static String telegram_append_motd(String msg)
+static int telegram_send_request(void)
 {
-	msg += FIRMWARE_VERSION "\n\n";
+	int     first = telegram_queue_first();
+	int     chatIndex;
+	int64_t chatId;
+	int     length;
+
+	if ((first >= 0) && (sendsSincePoll < TELEGRAM_SENDS_PER_POLL)) {
+		chatId = txQueue[first].chatId;
+		if (chatId == 0) {
+			chatIndex = telegram_next_chat(&txQueue[first]);
+			if (chatIndex < 0) {
+				telegram_queue_remove(first);
+				return 0;
+			}
+			txQueue[first].chatIndex = chatIndex;
+			chatId                   = telegram_chat_get(chatIndex)->id;
+		}
+		length = telegram_build_send_request(&txQueue[first], chatId);
+		if (length < 0) {
+			log_error("Telegram message is too long, it is dropped");
+			telegram_queue_remove(first);
+			return 0;
+		}
+		inFlightIndex = first;
+		requestType   = TELEGRAM_REQUEST_SEND;
+		replyEndTick  = TELEGRAM_REPLY_TIMEOUT_MS;
+		sendsSincePoll++;
+	} else {
+		isLongPoll = (first < 0);
+		if (!isLongPoll) {
+			stats.pollShortCount++;
+		}
+		// One update at most, so the reply fits in rxBuffer
+		length = snprintf(txBuffer, TELEGRAM_TX_BUFFER_SIZE,
+						  "GET /bot" TELEGRAM_CONV_TOKEN "/getUpdates?offset=%u&limit=1&timeout=%u"
+						  "&allowed_updates=%%5B%%22message%%22%%5D HTTP/1.1\r\n"
+						  "Host: " TELEGRAM_HOST "\r\n"
+						  "Connection: keep-alive\r\n\r\n",
+						  nextUpdateId, isLongPoll ? TELEGRAM_POLL_TIMEOUT_S : 0);
+		requestType    = TELEGRAM_REQUEST_POLL;
+		replyEndTick   = (TELEGRAM_POLL_TIMEOUT_S * 1000) + (TELEGRAM_REPLY_TIMEOUT_MS);
+		sendsSincePoll = 0;
+	}
+
+	isReusedConn = client.connected();
+	if (!isReusedConn && (telegram_connect() != 0)) {
+		return -1;
+	}
+
+	client.write((const uint8_t *) txBuffer, length);
+
+	lineLength    = 0;
+	rxLength      = 0;
+	rxOverflow    = false;
+	requestTick   = tick;
+	replyEndTick += tick;
+	telegramState = TELEGRAM_STATE_STATUS_LINE;
+
+	return 0;
+}
+
+/**
+ * @brief The request failed, try again later
+ */
+static void telegram_retry_later(void)
+{
+	uint32_t retryDelay = TELEGRAM_RETRY_MIN_MS;
+
+	telegram_disconnect();
+	stats.errorCount++;
+
+	for (uint8_t i = 0; (i < failCount) && (retryDelay < TELEGRAM_RETRY_MAX_MS); i++) {
+		retryDelay *= 2;
+	}
+	if (retryDelay > TELEGRAM_RETRY_MAX_MS) {
+		retryDelay = TELEGRAM_RETRY_MAX_MS;
+	}
+	if (failCount < UINT8_MAX) {
+		failCount++;
+	}
+
+	nextTryTick = tick + retryDelay;
+	log_warn("Telegram retry in %u ms", retryDelay);
+}
+
+/**
+ * @brief Write a brief message to explain all available commands
+ *
+ * @param pMsg Where to write it
+ */
+static void telegram_append_motd(str_buffer_t * pMsg)
+{
+	sb_append(pMsg, FIRMWARE_VERSION "\n\n");
 
 	for (uint8_t i = 0; i < telegramCmdsCount; ++i) {
-		msg += String(telegramCmds[i].text);
-		msg += ": ";
-		msg += String(telegramCmds[i].desc);
-		msg += "\n";
+		sb_printf(pMsg, "%s: %s\n", telegramCmds[i].text, telegramCmds[i].desc);
+	}
+}
+
+/**
+ * @brief FNV-1a hash of a command
+ *
+ * @param text The command
+ * @param length Length of the command
+ * @return The hash
+ */
+static uint32_t telegram_hash(const char * text, uint8_t length)
+{
+	uint32_t hash = 2166136261UL;
+
+	for (uint8_t i = 0; i < length; i++) {
+		hash ^= (uint8_t) text[i];
+		hash *= 16777619UL;
 	}
 
-	return msg;
+	return hash;
+}
+
+/**
+ * @brief Add a command
+ *
+ * @param text The command, with its '/'
+ * @param desc Its description
+ * @param role Lowest role allowed to use it, see telegram_role_e
+ * @param callback Builds the reply
+ * @return 0: OK, -1: Too many commands
+ */
+static int telegram_add_cmd(const char * text, const char * desc, uint8_t role, void (*callback)(str_buffer_t *, uint8_t))
+{
+	struct telegram_cmd_t * pCmd;
+	uint8_t                 slot;
+
+	if (telegramCmdsCount >= TG_CMD_MAX) {
+		log_error("Too many Telegram commands (TG_CMD_MAX = %d)", TG_CMD_MAX);
+		return -1;
+	}
+
+	pCmd = &telegramCmds[telegramCmdsCount];
+	strncpy(pCmd->text, text, TG_CMD_TEXT_LEN - 1);
+	strncpy(pCmd->desc, desc, TG_CMD_DESC_LEN - 1);
+	pCmd->hash     = telegram_hash(pCmd->text, strlen(pCmd->text));
+	pCmd->role     = role;
+	pCmd->callback = callback;
+
+	// Open addressing, the table is always bigger than the command count
+	slot = pCmd->hash & (TG_CMD_HASH_SIZE - 1);
+	while (telegramCmdSlots[slot] >= 0) {
+		slot = (slot + 1) & (TG_CMD_HASH_SIZE - 1);
+	}
+	telegramCmdSlots[slot] = telegramCmdsCount++;
+
+	return 0;
+}
+
+/**
+ * @brief Find the command of a message
+ * @details Arguments and the bot name of "/cmd@bot" are ignored
+ *
+ * @param text The message
+ * @return The command, NULL: Unknown command
+ */
+static const struct telegram_cmd_t * telegram_find_cmd(const char * text)
+{
+	uint8_t  length = strcspn(text, " @");
+	uint32_t hash   = telegram_hash(text, length);
+	uint8_t  slot   = hash & (TG_CMD_HASH_SIZE - 1);
+
+	while (telegramCmdSlots[slot] >= 0) {
+		struct telegram_cmd_t * pCmd = &telegramCmds[telegramCmdSlots[slot]];
+
+		if ((pCmd->hash == hash) && (strncmp(pCmd->text, text, length) == 0) && (pCmd->text[length] == '\0')) {
+			return pCmd;
+		}
+		slot = (slot + 1) & (TG_CMD_HASH_SIZE - 1);
+	}
+
+	return NULL;
 }
 
 /**
  * @brief Execute commands received from telegram
  *
- * @param message The message object given by Telegram API
+ * @param chatId The chat that sent the message
+ * @param text The text of the message
  */
-static void telegram_handle_new_message(telegramMessage * message)
+static void telegram_handle_new_message(int64_t chatId, const char * text)
 {
-	uint8_t i;
+	const struct telegram_cmd_t * pCmd;
+	int                           chatIndex;
+	char                          idStr[TELEGRAM_CHAT_ID_SIZE];
+
+	log_info("TBot says: %s", text);
 
 	// Reset reply
-	reply = "";
+	sb_clear(&reply);
 
-	// Save the chat to wich the reply must be send
-	linkedChat = String(message->chat_id);
+	chatIndex = telegram_chat_find(chatId);
+	if ((chatIndex < 0) && telegram_chat_is_empty()) {
+		// The first chat owns the board
+		chatIndex = telegram_chat_add(chatId, TELEGRAM_ROLE_OPERATOR);
+		log_info("Telegram chat %s owns the board", telegram_chat_id_to_str(idStr, chatId));
+	}
+	if (chatIndex < 0) {
+		// Not stored: an operator adds it with "tg chat add"
+		telegram_chat_id_to_str(idStr, chatId);
+		log_warn("Telegram chat %s is not allowed", idStr);
+		sb_printf(&reply, EMOJI_CROSS_MARK " " TG_MSG_UNKNOWN_CHAT "%s", idStr);
+		telegram_queue_msg(0, chatId, TELEGRAM_PRIORITY_REPLY, TELEGRAM_KEY_NONE, sb_str(&reply));
+		return;
+	}
 
 	// Search for a known command
-	for (i = 0; i < telegramCmdsCount; ++i) {
-		if (strncmp(telegramCmds[i].text, message->text.c_str(), TG_CMD_TEXT_LEN) == 0) {
-			reply = telegramCmds[i].callback(reply);
-			break;
+	pCmd = telegram_find_cmd(text);
+	if (pCmd != NULL) {
+		if (telegram_chat_get(chatIndex)->role >= pCmd->role) {
+			pCmd->callback(&reply, chatIndex);
+		} else {
+			sb_append(&reply, EMOJI_CROSS_MARK " " TG_MSG_NOT_ALLOWED);
 		}
-	}
-
-	// Command not found in telegramCmds ?
-	if (i == telegramCmdsCount) {
-		if (message->text[0] == '/') {
+	} else {
+		if (text[0] == '/') {
 			// Command not supported
-			reply = EMOJI_QUESTION_MARK " " TG_MSG_UNKNOWN_CMD "\n\n";
-			reply = telegram_append_motd(reply);
+			sb_append(&reply, EMOJI_QUESTION_MARK " " TG_MSG_UNKNOWN_CMD "\n\n");
+			telegram_append_motd(&reply);
 		} else {
 			// Init rand()
 			srand(tick);
 
 			// Send a dummy message when message is not a command
 			uint8_t randomInt = rand() % TELEGRAM_DUMMY_MSG_COUNT;
-			reply             = dummyMessages[randomInt];
+			sb_append(&reply, dummyMessages[randomInt]);
 		}
 	}
 
-	telegram_send(reply);
+	if (reply.isTruncated) {
+		log_warn("Telegram reply is truncated");
+	}
+	telegram_queue_msg(1 << chatIndex, 0, TELEGRAM_PRIORITY_REPLY, TELEGRAM_KEY_NONE, sb_str(&reply));
+}
+
+/**
+ * @brief Use the reply of getUpdates
+ */
+static void telegram_parse_updates(void)
+{
+	StaticJsonDocument<128>                filter;
+	StaticJsonDocument<TELEGRAM_JSON_SIZE> json;
+	JsonObject                             message;
+	const char *                           pUpdateId;
+
+	// The id is read first as parsing changes the buffer
+	pUpdateId = strstr(rxBuffer, "\"update_id\":");
+	if (pUpdateId == NULL) {
+		// Long poll is over without any update
+		return;
+	}
+	nextUpdateId = strtoul(&pUpdateId[12], NULL, 10) + 1;
+
+	// Skip what we can not read, or we would get it again and again
+	if (rxOverflow) {
+		log_warn("Telegram update %u is too long, it is skipped", nextUpdateId - 1);
+		return;
+	}
+
+	filter["result"][0]["message"]["chat"]["id"] = true;
+	filter["result"][0]["message"]["text"]       = true;
+	if (deserializeJson(json, rxBuffer, rxLength, DeserializationOption::Filter(filter)) != DeserializationError::Ok) {
+		log_error("Telegram update %u can not be parsed", nextUpdateId - 1);
+		return;
+	}
+
+	message = json["result"][0]["message"];
+	if (message["text"].is<const char *>()) {
+		telegram_handle_new_message(message["chat"]["id"].as<int64_t>(), message["text"].as<const char *>());
+	}
+}
+
+/**
+ * @brief The reply is complete
+ */
+static void telegram_end_reply(void)
+{
+	uint32_t duration = tick - requestTick;
+	uint8_t  index;
+
+	rxBuffer[rxLength] = '\0';
+	telegramState      = TELEGRAM_STATE_IDLE;
+	if (!isKeepAlive) {
+		client.stop();
+	}
+
+	if (requestType == TELEGRAM_REQUEST_POLL) {
+		if (httpCode != 200) {
+			// Bad token, or another client is polling
+			log_error("Telegram bad reply to getUpdates (http code = %d)", httpCode);
+			telegram_retry_later();
+			return;
+		}
+		stats.pollCount++;
+		stats.pollTotalMs += duration;
+		telegram_parse_updates();
+	} else {
+		if (httpCode == 200) {
+			stats.sendCount++;
+			stats.sendTotalMs += duration;
+		} else {
+			// The server refused it, sending it again would not help
+			log_error("Telegram refused the message (http code = %d)", httpCode);
+			stats.errorCount++;
+		}
+		// Exactly the message sent, even if a dropped one moved it
+		if (inFlightIndex >= 0) {
+			index         = inFlightIndex;
+			inFlightIndex = -1;
+			if (txQueue[index].chatId == 0) {
+				txQueue[index].chatMask &= ~(1 << txQueue[index].chatIndex);
+			}
+			if (txQueue[index].chatMask == 0) {
+				telegram_queue_remove(index);
+			}
+		}
+	}
+
+	failCount = 0;
+}
+
+/**
+ * @brief Use a complete line of the reply
+ */
+static void telegram_parse_line(void)
+{
+	if (telegramState == TELEGRAM_STATE_STATUS_LINE) {
+		// "HTTP/1.1 200 OK"
+		if ((lineLength < 12) || (strncmp(line, "HTTP/1.", 7) != 0)) {
+			httpCode = -1;
+		} else {
+			httpCode = atoi(&line[9]);
+		}
+		isKeepAlive   = (line[7] == '1');
+		bodyLeft      = -1;
+		telegramState = TELEGRAM_STATE_HEADERS;
+	} else if (lineLength == 0) {
+		// End of headers
+		if (bodyLeft < 0) {
+			// No length, the body ends with the connection
+			isKeepAlive = false;
+		}
+		telegramState = TELEGRAM_STATE_BODY;
+	} else if (strncasecmp(line, "Content-Length:", 15) == 0) {
+		bodyLeft = atoi(&line[15]);
+	} else if ((strncasecmp(line, "Connection:", 11) == 0) && (strstr(&line[11], "close") != NULL)) {
+		isKeepAlive = false;
+	}
+}
+
+/**
+ * @brief Read what is available of the reply
+ */
+static void telegram_read_reply(void)
+{
+	for (uint16_t n = 0; (n < TELEGRAM_READ_MAX_PER_TICK) && (client.available() > 0); n++) {
+		char c = (char) client.read();
+
+		if (telegramState == TELEGRAM_STATE_BODY) {
+			if (rxLength < (TELEGRAM_RX_BUFFER_SIZE - 1)) {
+				rxBuffer[rxLength++] = c;
+			} else {
+				rxOverflow = true;
+			}
+			if (bodyLeft > 0) {
+				bodyLeft--;
+			}
+		} else if (c == '\n') {
+			line[lineLength] = '\0';
+			telegram_parse_line();
+			lineLength = 0;
+		} else if ((c != '\r') && (lineLength < (TELEGRAM_LINE_SIZE - 1))) {
+			line[lineLength++] = c;
+		}
+
+		if ((telegramState == TELEGRAM_STATE_BODY) && (bodyLeft == 0)) {
+			telegram_end_reply();
+			return;
+		}
+	}
+
+	if ((telegramState == TELEGRAM_STATE_BODY) && (bodyLeft < 0) && !client.connected() && (client.available() == 0)) {
+		// Body without length is over
+		telegram_end_reply();
+	} else if (!client.connected() && (client.available() == 0)) {
+		if (isReusedConn && (telegramState == TELEGRAM_STATE_STATUS_LINE) && (lineLength == 0)) {
+			// Server closed the idle connection before our request, open a new one
+			telegram_disconnect();
+			return;
+		}
+		log_error("Telegram closed the connection");
+		telegram_retry_later();
+	} else if (tick > replyEndTick) {
+		log_error("Telegram did not reply in time");
+		telegram_retry_later();
+	}
 }
 
 // =====================
 // COMMAND CALLBACKS
 // =====================
 
-static String telegram_cmd_status(String reply)
+static void telegram_cmd_status(str_buffer_t * pReply, uint8_t chatIndex)
 {
-	reply += FIRMWARE_VERSION "\n";
-	reply += EMOJI_NUMBER_SIGN " " TG_MSG_IP_ADDRESS + WiFi.localIP().toString() + "\n";
+	IPAddress ip = WiFi.localIP();
+
+	sb_append(pReply, FIRMWARE_VERSION "\n");
+	sb_printf(pReply, EMOJI_NUMBER_SIGN " " TG_MSG_IP_ADDRESS "%d.%d.%d.%d\n", ip[0], ip[1], ip[2], ip[3]);
 
 	// Is the script in alert ?
 	if (_isset(STATUS_SCRIPT, STATUS_SCRIPT_IN_ALERT)) {
-		reply += EMOJI_RED_REVOLVING_LIGHT " " TG_MSG_ALERT_IS_ON "\n";
+		sb_append(pReply, EMOJI_RED_REVOLVING_LIGHT " " TG_MSG_ALERT_IS_ON "\n");
 	}
 
 #ifdef MODULE_RELAY
 	// Specialized error messages
 	if (_isset(STATUS_APPLI, STATUS_APPLI_RELAY_FAULT)) {
-		reply += EMOJI_CROSS_MARK " " TG_MSG_BAD_RELAY_FEEDBACK "\n";
+		sb_append(pReply, EMOJI_CROSS_MARK " " TG_MSG_BAD_RELAY_FEEDBACK "\n");
 	} else {
-		reply += EMOJI_GREEN_CHECK " " TG_MSG_GOOD_RELAY_FEEDBACK "\n";
+		sb_append(pReply, EMOJI_GREEN_CHECK " " TG_MSG_GOOD_RELAY_FEEDBACK "\n");
 	}
 #endif
 
 #ifdef MODULE_TEMPERATURE
 	// Check sensors
-	for (int i = 0; i < TEMP_MAX_SENSOR_SUPPORTED; ++i) {
-		reply += "`Temp. " + String(i) + "] `";
+	for (int i = 0; i < temp_get_nb_sensor(); ++i) {
+		sb_printf(pReply, "`Temp. %d] `", i);
 
-		// Is the sensor used ?
-		if (i >= temp_get_nb_sensor()) {
-			reply += TG_MSG_UNUSED_TEMP_SENSOR "\n";
+		// Test the state of the sensor
+		if (temp_is_faulty(i)) {
+			sb_append(pReply, EMOJI_CROSS_MARK " " TG_MSG_BAD_TEMP_SENSOR "\n");
 		} else {
-			// Test the state of the sensor
-			if (_isset(STATUS_TEMP, STATUS_TEMP_1_FAULT << i)) {
-				reply += EMOJI_CROSS_MARK " " TG_MSG_BAD_TEMP_SENSOR "\n";
-			} else {
-				reply += EMOJI_GREEN_CHECK " " + String(temp_get_value(i)) + " 'C\n";
-			}
+			sb_printf(pReply, EMOJI_GREEN_CHECK " %.2f 'C\n", temp_get_value(i));
 		}
 	}
 #endif
-
-	return reply;
 }
 
-static String telegram_cmd_start(String reply)
+static void telegram_cmd_start(str_buffer_t * pReply, uint8_t chatIndex)
 {
 	isAutoTempMsgEnabled = true;
 
-	reply = EMOJI_ROCKET " " TG_MSG_HAD_BEEN_STARTED "\n\n";
-	reply = telegram_append_motd(reply);
-
-	return reply;
+	sb_clear(pReply);
+	sb_append(pReply, EMOJI_ROCKET " " TG_MSG_HAD_BEEN_STARTED "\n\n");
+	telegram_append_motd(pReply);
 }
 
-static String telegram_cmd_stop(String reply)
+static void telegram_cmd_stop(str_buffer_t * pReply, uint8_t chatIndex)
 {
 	isAutoTempMsgEnabled = false;
 
-	reply += EMOJI_CROSS_MARK " " TG_MSG_HAD_BEEN_STOPPED;
-	return reply;
+	sb_append(pReply, EMOJI_CROSS_MARK " " TG_MSG_HAD_BEEN_STOPPED);
+}
+
+static void telegram_cmd_subscribe(str_buffer_t * pReply, uint8_t chatIndex)
+{
+	telegram_chat_subscribe(chatIndex, true);
+
+	sb_append(pReply, EMOJI_GREEN_CHECK " " TG_MSG_SUBSCRIBED);
+}
+
+static void telegram_cmd_unsubscribe(str_buffer_t * pReply, uint8_t chatIndex)
+{
+	telegram_chat_subscribe(chatIndex, false);
+
+	sb_append(pReply, EMOJI_CROSS_MARK " " TG_MSG_UNSUBSCRIBED);
 }
 
 #if defined(MODULE_TEMPERATURE)
-static String telegram_cmd_sensors(String reply)
+static void telegram_cmd_sensors(str_buffer_t * pReply, uint8_t chatIndex)
 {
 	// Indicate the mode used
 #if (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
-	reply += TG_MSG_ALERT_METHOD_THRESHOLD "\n";
+	sb_append(pReply, TG_MSG_ALERT_METHOD_THRESHOLD "\n");
 #elif (SCRIPT_TEMP_ALERT_METHOD == METHOD_DIFFERENTIAL)
-	reply += TG_MSG_ALERT_METHOD_DIFFERENTIAL + String(SCRIPT_TEMP_ALERT_DIFF_THRESHOLD) + "°C)\n";
+	sb_printf(pReply, TG_MSG_ALERT_METHOD_DIFFERENTIAL "%.2f°C)\n", SCRIPT_TEMP_ALERT_DIFF_THRESHOLD);
+#endif
+	// Display addresses, and thresholds without sensor
+	int count = temp_get_nb_sensor();
+#if (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
+	if (count < sensorThresholdCount) {
+		count = sensorThresholdCount;
+	}
 #endif
-	// Display addresses
-	for (int i = 0; i < TEMP_MAX_SENSOR_SUPPORTED; ++i) {
-		reply += "`Temp. " + String(i) + "] `";
+	for (int i = 0; i < count; ++i) {
+		sb_printf(pReply, "`Temp. %d] `", i);
 
 		// Is the sensor used ?
 		if (i >= temp_get_nb_sensor()) {
-			reply += TG_MSG_UNUSED_TEMP_SENSOR;
+			sb_append(pReply, TG_MSG_UNUSED_TEMP_SENSOR);
 		} else {
-			reply += String(temp_get_address(dummyBytes, i));
+			sb_append(pReply, temp_get_address(dummyBytes, i));
 		}
 
 		// Display the configure threshold
 #if (SCRIPT_TEMP_ALERT_METHOD == METHOD_THRESHOLD)
-		reply += " (" TG_MSG_SENSOR_THRESHOLD ": " + String(sensorThreshold[i]) + "°C)";
+		if (i < sensorThresholdCount) {
+			sb_printf(pReply, " (" TG_MSG_SENSOR_THRESHOLD ": %.2f°C)", sensorThreshold[i]);
+		}
 #endif
 		// Add ending line
-		reply += "\n";
+		sb_append(pReply, "\n");
 	}
+}
+#endif
+
+#if defined(MODULE_TEMPERATURE)
+static void telegram_cmd_history(str_buffer_t * pReply, uint8_t chatIndex)
+{
+	struct temp_history_stats_t hour, day;
+	uint8_t                     count = temp_get_nb_sensor();
+
+	if (count > TEMP_HISTORY_SENSOR_COUNT) {
+		count = TEMP_HISTORY_SENSOR_COUNT;
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		sb_printf(pReply, "`Temp. %d] `", i);
 
-	return reply;
+		// Last hour from the raw samples, last day from the hourly ones
+		if (temp_history_get_stats(i, TEMP_HISTORY_LEVEL_RAW, (60 * 60 * 1000) / (TEMP_POLLING_PERIOD_MS), &hour) != 0) {
+			sb_append(pReply, TG_MSG_NO_HISTORY "\n");
+			continue;
+		}
+		sb_printf(pReply, "1h: %.2f / %.2f 'C (%.2f 'C/h)", hour.min / 100.0, hour.max / 100.0, hour.trend / 100.0);
+
+		if (temp_history_get_stats(i, TEMP_HISTORY_LEVEL_LONG, 24, &day) == 0) {
+			sb_printf(pReply, ", 24h: %.2f / %.2f 'C", day.min / 100.0, day.max / 100.0);
+		}
+		sb_append(pReply, "\n");
+	}
 }
 #endif
 
 #if defined(MODULE_RELAY)
-static String telegram_cmd_relay(String reply)
+static void telegram_cmd_relay(str_buffer_t * pReply, uint8_t chatIndex)
 {
 	/** Force alarm off if OPT is enabled
       *  Switch is set when signal is LOW */
 	if (is_input_low(INPUTS_OPT_TEMP_ALARM_EN)) {
-		reply += EMOJI_INFORMATION_MARK " ";
+		sb_append(pReply, EMOJI_INFORMATION_MARK " ");
 
-		script_relay_set_event(!relay_get_theoretical_state());
+		script_relay_set_event(!relay_get_theoretical_state(RELAY_MAIN));
 
 		if (is_input_low(INPUTS_OPT_ALARM_IMPULSION_MODE_EN)) {
-			reply += TG_MSG_RELAY_SEND_IMPULSE "\n";
+			sb_append(pReply, TG_MSG_RELAY_SEND_IMPULSE "\n");
 		} else {
-			if (relay_get_theoretical_state() == true) {
-				reply += TG_MSG_RELAY_IS_NOW_ON "\n";
+			if (relay_get_theoretical_state(RELAY_MAIN) == true) {
+				sb_append(pReply, TG_MSG_RELAY_IS_NOW_ON "\n");
 			} else {
-				reply += TG_MSG_RELAY_IS_NOW_OFF "\n";
+				sb_append(pReply, TG_MSG_RELAY_IS_NOW_OFF "\n");
 			}
 		}
 
 	} else {
-		reply = EMOJI_INFORMATION_MARK " " TG_MSG_RELAY_CANT_BE_CTRL "\n\n";
+		sb_clear(pReply);
+		sb_append(pReply, EMOJI_INFORMATION_MARK " " TG_MSG_RELAY_CANT_BE_CTRL "\n\n");
 	}
-
-	return reply;
 }
 #endif
 
@@ -254,55 +960,87 @@ static String telegram_cmd_relay(String reply)
 // FUNCTIONS
 // =====================
 
+/**
+ * @brief Tell the linked chat about the events of other modules
+ *
+ * @param pEvent The event
+ * @param arg Unused
+ */
+static void telegram_event_callback(const struct event_t * pEvent, void * arg)
+{
+	switch (pEvent->type) {
+	case EVENT_ALERT:
+		telegram_send_alert(pEvent->value != 0);
+		break;
+	case EVENT_RELAY_FEEDBACK:
+		telegram_send_msg_relay_feedback(pEvent->value != 0);
+		break;
+	case EVENT_WIFI_STATE:
+		// Get pending messages as soon as we are back online
+		if (pEvent->value != 0) {
+			failCount   = 0;
+			nextTryTick = 0;
+		} else {
+			telegram_disconnect();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 /**
  * @brief Inititalize the telegram module
  */
 int telegram_init(void)
 {
 	struct telegram_cmd_t * pCmd;
+	str_buffer_t            keyboard;
 
-	nextCheckTick = 0;
+	sb_init(&reply, replyBuffer, TELEGRAM_MSG_SIZE);
+	sendsSincePoll = 0;
+	txCount        = 0;
+	inFlightIndex  = -1;
+	failCount      = 0;
+	nextTryTick    = 0;
+	telegramState  = TELEGRAM_STATE_IDLE;
+	isEnabled      = (strlen(TELEGRAM_CONV_TOKEN) > 0);
+	if (!isEnabled) {
+		log_warn("Telegram token is empty, module is disabled");
+	}
 
 	// This is the simplest way of getting this working
 	// if you are passing sensitive information, or controlling
 	// something important, please either use certStore or at
 	// least client.setFingerPrint
 	// https://github.com/witnessmenow/Universal-Arduino-Telegram-Bot/issues/104#issuecomment-485255312
-	wiFiClientSecure.setInsecure();
-
-	// Define which command are available
-	pCmd = &telegramCmds[telegramCmdsCount++];
-	strncpy(pCmd->text, "/status", TG_CMD_TEXT_LEN);
-	strncpy(pCmd->desc, TG_MSG_CMD_STATUS, TG_CMD_DESC_LEN);
-	pCmd->callback = &telegram_cmd_status;
-
-	pCmd = &telegramCmds[telegramCmdsCount++];
-	strncpy(pCmd->text, "/start", TG_CMD_TEXT_LEN);
-	strncpy(pCmd->desc, TG_MSG_CMD_START, TG_CMD_DESC_LEN);
-	pCmd->callback = &telegram_cmd_start;
+	client.setInsecure();
+#ifdef ESP8266
+	client.setSession(&tlsSession);
+#endif
 
-	pCmd = &telegramCmds[telegramCmdsCount++];
-	strncpy(pCmd->text, "/stop", TG_CMD_TEXT_LEN);
-	strncpy(pCmd->desc, TG_MSG_CMD_STOP, TG_CMD_DESC_LEN);
-	pCmd->callback = &telegram_cmd_stop;
+	CHECK_CALL(telegram_chat_load())
 
+	// Define which command are available
+	telegramCmdsCount = 0;
+	memset(telegramCmdSlots, -1, sizeof(telegramCmdSlots));
+	CHECK_CALL(telegram_add_cmd("/status", TG_MSG_CMD_STATUS, TELEGRAM_ROLE_VIEWER, &telegram_cmd_status))
+	CHECK_CALL(telegram_add_cmd("/start", TG_MSG_CMD_START, TELEGRAM_ROLE_OPERATOR, &telegram_cmd_start))
+	CHECK_CALL(telegram_add_cmd("/stop", TG_MSG_CMD_STOP, TELEGRAM_ROLE_OPERATOR, &telegram_cmd_stop))
 #if defined(MODULE_TEMPERATURE)
-	pCmd = &telegramCmds[telegramCmdsCount++];
-	strncpy(pCmd->text, "/sensors", TG_CMD_TEXT_LEN);
-	strncpy(pCmd->desc, TG_MSG_CMD_SENSORS, TG_CMD_DESC_LEN);
-	pCmd->callback = &telegram_cmd_sensors;
+	CHECK_CALL(telegram_add_cmd("/sensors", TG_MSG_CMD_SENSORS, TELEGRAM_ROLE_VIEWER, &telegram_cmd_sensors))
+	CHECK_CALL(telegram_add_cmd("/history", TG_MSG_CMD_HISTORY, TELEGRAM_ROLE_VIEWER, &telegram_cmd_history))
 #endif
-
 #if defined(MODULE_RELAY)
-	pCmd = &telegramCmds[telegramCmdsCount++];
-	strncpy(pCmd->text, "/relay", TG_CMD_TEXT_LEN);
-	strncpy(pCmd->desc, TG_MSG_CMD_RELAY, TG_CMD_DESC_LEN);
-	pCmd->callback = &telegram_cmd_relay;
+	CHECK_CALL(telegram_add_cmd("/relay", TG_MSG_CMD_RELAY, TELEGRAM_ROLE_OPERATOR, &telegram_cmd_relay))
 #endif
+	CHECK_CALL(telegram_add_cmd("/subscribe", TG_MSG_CMD_SUBSCRIBE, TELEGRAM_ROLE_VIEWER, &telegram_cmd_subscribe))
+	CHECK_CALL(telegram_add_cmd("/unsubscribe", TG_MSG_CMD_UNSUBSCRIBE, TELEGRAM_ROLE_VIEWER, &telegram_cmd_unsubscribe))
 
 	// Build keyboardJson
 	// Model: "[[\"/start\", \"/stop\"], [\"/status\", \"/sensors\"]]";
-	keyboardJson = "[";
+	sb_init(&keyboard, keyboardJson, TELEGRAM_KEYBOARD_SIZE);
+	sb_append(&keyboard, "[");
 	for (uint8_t i = 0; i < telegramCmdsCount; ++i) {
 		// Get the shortcut
 		pCmd = &telegramCmds[i];
@@ -310,19 +1048,27 @@ int telegram_init(void)
 		if ((i & 1) == 0) { // Left column
 			// Add a coma between columns
 			if (i > 0) {
-				keyboardJson += ",";
+				sb_append(&keyboard, ",");
 			}
 
-			keyboardJson += "[\"" + String(pCmd->text) + "\"";
+			sb_printf(&keyboard, "[\"%s\"", pCmd->text);
 		} else { // Right column
-			keyboardJson += ",\"" + String(pCmd->text) + "\"]";
+			sb_printf(&keyboard, ",\"%s\"]", pCmd->text);
 		}
 	}
 	// Close the last couple if count is odd
 	if (telegramCmdsCount & 1) {
-		keyboardJson += "]";
+		sb_append(&keyboard, "]");
+	}
+	sb_append(&keyboard, "]");
+	if (keyboard.isTruncated) {
+		// Would be an invalid JSON
+		log_error("Telegram keyboard is too long (TELEGRAM_KEYBOARD_SIZE = %d)", TELEGRAM_KEYBOARD_SIZE);
+		return -1;
 	}
-	keyboardJson += "]";
+
+	CHECK_CALL(event_subscribe(event_mask(EVENT_ALERT) | event_mask(EVENT_RELAY_FEEDBACK) | event_mask(EVENT_WIFI_STATE),
+							   EVENT_SOURCE_ANY, telegram_event_callback, NULL))
 
 	return 0;
 }
@@ -332,21 +1078,22 @@ int telegram_init(void)
  */
 void telegram_main(void)
 {
-	int msgNumber;
+	if (!isEnabled) {
+		return;
+	}
 
-	if (tick >= nextCheckTick) {
-		nextCheckTick = tick + TELEGRAM_CHECK_PERIOD_MS;
+	if (telegramState != TELEGRAM_STATE_IDLE) {
+		// Queued messages wait for the end of the poll, on the same connection
+		telegram_read_reply();
+		return;
+	}
 
-		do {
-			// This take a loooot of time (2.8s)
-			msgNumber = TBot.getUpdates(TBot.last_message_received + 1);
+	if ((tick < nextTryTick) || _isunset(STATUS_WIFI, STATUS_WIFI_IS_CO)) {
+		return;
+	}
 
-			// For each messages
-			for (int i = 0; i < msgNumber; i++) {
-				log_info("TBot says: %s", TBot.messages[i].text.c_str());
-				telegram_handle_new_message(&TBot.messages[i]);
-			}
-		} while (msgNumber);
+	if (telegram_send_request() != 0) {
+		telegram_retry_later();
 	}
 }
 
@@ -359,8 +1106,10 @@ void telegram_main(void)
  */
 void telegram_send_msg_temperature(uint8_t sensorID, float degreesValue)
 {
-	String msg = String(sensorID) + "] " + TG_MSG_TEMPERATURE_IS + String(degreesValue) + "'C";
-	telegram_send(msg);
+	char msg[64];
+
+	snprintf(msg, sizeof(msg), "%d] " TG_MSG_TEMPERATURE_IS "%.2f'C", sensorID, degreesValue);
+	telegram_send(msg, TELEGRAM_PRIORITY_PERIODIC, TELEGRAM_KEY_TEMP + sensorID);
 }
 
 /**
@@ -371,9 +1120,9 @@ void telegram_send_msg_temperature(uint8_t sensorID, float degreesValue)
 void telegram_send_alert(bool isInAlert)
 {
 	if (isInAlert) {
-		telegram_send(EMOJI_RED_REVOLVING_LIGHT " " TG_MSG_ALERT_GOES_ON " " EMOJI_RED_REVOLVING_LIGHT);
+		telegram_send(EMOJI_RED_REVOLVING_LIGHT " " TG_MSG_ALERT_GOES_ON " " EMOJI_RED_REVOLVING_LIGHT, TELEGRAM_PRIORITY_ALERT, TELEGRAM_KEY_NONE);
 	} else {
-		telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_ALERT_GOES_OFF);
+		telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_ALERT_GOES_OFF, TELEGRAM_PRIORITY_ALERT, TELEGRAM_KEY_NONE);
 	}
 }
 
@@ -385,9 +1134,9 @@ void telegram_send_alert(bool isInAlert)
 void telegram_send_opt_changed(bool isOptEnabled)
 {
 	if (isOptEnabled) {
-		telegram_send(EMOJI_INFORMATION_MARK " " TG_MSG_OPT_GOES_ON);
+		telegram_send(EMOJI_INFORMATION_MARK " " TG_MSG_OPT_GOES_ON, TELEGRAM_PRIORITY_STATUS, TELEGRAM_KEY_NONE);
 	} else {
-		telegram_send(EMOJI_INFORMATION_MARK " " TG_MSG_OPT_GOES_OFF);
+		telegram_send(EMOJI_INFORMATION_MARK " " TG_MSG_OPT_GOES_OFF, TELEGRAM_PRIORITY_STATUS, TELEGRAM_KEY_NONE);
 	}
 }
 
@@ -396,7 +1145,7 @@ void telegram_send_opt_changed(bool isOptEnabled)
  */
 void telegram_send_conn_ok(void)
 {
-	telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_CONNECTION_OK);
+	telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_CONNECTION_OK, TELEGRAM_PRIORITY_PERIODIC, TELEGRAM_KEY_CONN_OK);
 }
 
 /**
@@ -405,10 +1154,25 @@ void telegram_send_conn_ok(void)
 void telegram_send_msg_relay_feedback(bool isOk)
 {
 	if (isOk) {
-		telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_GOOD_RELAY_FEEDBACK);
+		telegram_send(EMOJI_GREEN_CHECK " " TG_MSG_GOOD_RELAY_FEEDBACK, TELEGRAM_PRIORITY_STATUS, TELEGRAM_KEY_NONE);
 	} else {
-		telegram_send(EMOJI_CROSS_MARK " " TG_MSG_BAD_RELAY_FEEDBACK);
+		telegram_send(EMOJI_CROSS_MARK " " TG_MSG_BAD_RELAY_FEEDBACK, TELEGRAM_PRIORITY_STATUS, TELEGRAM_KEY_NONE);
 	}
 }
 
-#endif
\ No newline at end of file
+/**
+ * @brief Print the statistics of the connection to Telegram
+ */
+void telegram_print_stats(void)
+{
+	log_raw("Telegram handshakes: %u, mean %u ms, max %u ms\n\r", stats.handshakeCount,
+			(stats.handshakeCount > 0) ? (stats.handshakeTotalMs / stats.handshakeCount) : 0, stats.handshakeMaxMs);
+	log_raw("Telegram polls: %u, mean %u ms, %u between messages\n\r", stats.pollCount,
+			(stats.pollCount > 0) ? (stats.pollTotalMs / stats.pollCount) : 0, stats.pollShortCount);
+	log_raw("Telegram messages: %u sent, mean %u ms, %u pending\n\r", stats.sendCount,
+			(stats.sendCount > 0) ? (stats.sendTotalMs / stats.sendCount) : 0, txCount);
+	log_raw("Telegram queue: %u merged, %u dropped\n\r", stats.mergeCount, stats.dropCount);
+	log_raw("Telegram errors: %u\n\r", stats.errorCount);
+}
+
+#endif
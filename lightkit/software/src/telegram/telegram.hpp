@@ -10,13 +10,30 @@
 
 #include <Arduino.h>
 
-#define TELEGRAM_CHECK_PERIOD_MS 5 * 1000 /** Time between two check for new telegram messages (Should not be under 2.8s because telegram update takes time) */
-#define TELEGRAM_DUMMY_MSG_COUNT 3        /** Number of dummy messages available */
+#define TELEGRAM_HOST               "api.telegram.org"
+#define TELEGRAM_PORT               443
+#define TELEGRAM_POLL_TIMEOUT_S     2          /** Telegram holds getUpdates until a message comes or this time is over, queued messages wait for it */
+#define TELEGRAM_CONNECT_TIMEOUT_MS 5*1000     /** Connecting is the only blocking step, a full TLS handshake takes ~2s on ESP8266 */
+#define TELEGRAM_REPLY_TIMEOUT_MS   10*1000    /** Time given to the server to reply, added to the long poll timeout */
+#define TELEGRAM_RETRY_MIN_MS       1000       /** Delay after the first failure, doubled at each new one */
+#define TELEGRAM_RETRY_MAX_MS       5*60*1000  /** Longest delay between two tries */
+#define TELEGRAM_TX_QUEUE_SIZE      6          /** Messages waiting to be sent, the least important are dropped */
+#define TELEGRAM_MSG_SIZE           640        /** Longest message, with the '\0', longer ones are truncated */
+#define TELEGRAM_MERGE_MAX_LEN      256        /** Status messages are merged up to this length */
+#define TELEGRAM_KEYBOARD_SIZE      192        /** JSON of the command keyboard */
+#define TELEGRAM_SENDS_PER_POLL     4          /** Messages sent before checking for commands, a broadcast takes one per chat */
+#define TELEGRAM_TX_BUFFER_SIZE     1024       /** Biggest request sent, longer messages are dropped */
+#define TELEGRAM_RX_BUFFER_SIZE     1024       /** Biggest reply body parsed, updates with a longer one are skipped */
+#define TELEGRAM_LINE_SIZE          64         /** Longest header line kept, longer ones are truncated */
+#define TELEGRAM_READ_MAX_PER_TICK  256        /** Bytes of the reply read each tick */
+#define TELEGRAM_JSON_SIZE          256        /** Parsed update, only the used fields are kept */
+#define TELEGRAM_DUMMY_MSG_COUNT    3          /** Number of dummy messages available */
 
 // COMMANDS
-#define TG_CMD_TEXT_LEN 16
-#define TG_CMD_DESC_LEN 64
-#define TG_CMD_MAX      5
+#define TG_CMD_TEXT_LEN  16
+#define TG_CMD_DESC_LEN  64
+#define TG_CMD_MAX       10
+#define TG_CMD_HASH_SIZE 16 /** Slots of the command hash table, a power of 2 above TG_CMD_MAX */
 
 // EMOJIS
 // https://apps.timwhitlock.info/emoji/tables/unicode
@@ -31,11 +48,14 @@
 // Traducted messages
 #if (G_LANG == G_LANG_FR)
 
-#define TG_MSG_CMD_STATUS  "Choisissez l'une des options suivantes"
-#define TG_MSG_CMD_START   "Démarre l'annonce de la température sur Telegram"
-#define TG_MSG_CMD_STOP    "Arrête l'annonce de la température sur Telegram"
-#define TG_MSG_CMD_SENSORS "Affiche les adresses des capteurs de température"
-#define TG_MSG_CMD_RELAY   "Permet la commande du relais quand l'alarme est forcée à OFF"
+#define TG_MSG_CMD_STATUS      "Choisissez l'une des options suivantes"
+#define TG_MSG_CMD_START       "Démarre l'annonce de la température sur Telegram"
+#define TG_MSG_CMD_STOP        "Arrête l'annonce de la température sur Telegram"
+#define TG_MSG_CMD_SENSORS     "Affiche les adresses des capteurs de température"
+#define TG_MSG_CMD_RELAY       "Permet la commande du relais quand l'alarme est forcée à OFF"
+#define TG_MSG_CMD_HISTORY     "Affiche l'évolution des températures"
+#define TG_MSG_CMD_SUBSCRIBE   "Reçoit les alertes dans cette conversation"
+#define TG_MSG_CMD_UNSUBSCRIBE "Ne reçoit plus les alertes"
 
 #define TG_MSG_CHOOSE_OPTION             "Choisissez l'une des options suivantes"
 #define TG_MSG_CONNECTION_OK             "La connexion est OK"
@@ -46,6 +66,11 @@
 #define TG_MSG_GOOD_RELAY_FEEDBACK       "Le relais retourne le bon état"
 #define TG_MSG_BAD_TEMP_SENSOR           "Le capteur est défectueux"
 #define TG_MSG_UNUSED_TEMP_SENSOR        "Capteur non utilisé"
+#define TG_MSG_NO_HISTORY                "Pas encore d'historique"
+#define TG_MSG_NOT_ALLOWED               "Cette conversation n'a pas le droit d'utiliser cette commande"
+#define TG_MSG_UNKNOWN_CHAT              "Cette conversation n'est pas autorisée, un opérateur peut l'ajouter avec : tg chat add "
+#define TG_MSG_SUBSCRIBED                "Les alertes seront envoyées ici"
+#define TG_MSG_UNSUBSCRIBED              "Les alertes ne seront plus envoyées ici"
 #define TG_MSG_HAD_BEEN_STARTED          "Le système est désormais en marche"
 #define TG_MSG_HAD_BEEN_STOPPED          "Le système est désormais arrété"
 #define TG_MSG_ALERT_GOES_ON             "L'ALERTE EST DÉSORMAIS ACTIVE"
@@ -67,11 +92,14 @@
 
 #elif (G_LANG == G_LANG_EN)
 
-#define TG_MSG_CMD_STATUS  "Return the status of the system"
-#define TG_MSG_CMD_START   "Starting temperature announcement on telegram"
-#define TG_MSG_CMD_STOP    "Stopping temperature announcement on telegram"
-#define TG_MSG_CMD_SENSORS "Show temperature sensor addresses"
-#define TG_MSG_CMD_RELAY   "Allow the control of the relay when alarm is forced OFF"
+#define TG_MSG_CMD_STATUS      "Return the status of the system"
+#define TG_MSG_CMD_START       "Starting temperature announcement on telegram"
+#define TG_MSG_CMD_STOP        "Stopping temperature announcement on telegram"
+#define TG_MSG_CMD_SENSORS     "Show temperature sensor addresses"
+#define TG_MSG_CMD_RELAY       "Allow the control of the relay when alarm is forced OFF"
+#define TG_MSG_CMD_HISTORY     "Show how the temperatures changed"
+#define TG_MSG_CMD_SUBSCRIBE   "Receive the alerts in this chat"
+#define TG_MSG_CMD_UNSUBSCRIBE "Stop receiving the alerts"
 
 #define TG_MSG_CHOOSE_OPTION             "Choose one of the following options"
 #define TG_MSG_CONNECTION_OK             "Connection is OK"
@@ -82,6 +110,11 @@
 #define TG_MSG_GOOD_RELAY_FEEDBACK       "Relay returns a valid feedback"
 #define TG_MSG_BAD_TEMP_SENSOR           "Sensor is faulty"
 #define TG_MSG_UNUSED_TEMP_SENSOR        "Sensor is unused"
+#define TG_MSG_NO_HISTORY                "No history yet"
+#define TG_MSG_NOT_ALLOWED               "This chat is not allowed to use this command"
+#define TG_MSG_UNKNOWN_CHAT              "This chat is not allowed, an operator can add it with: tg chat add "
+#define TG_MSG_SUBSCRIBED                "Alerts will be sent here"
+#define TG_MSG_UNSUBSCRIBED              "Alerts will no longer be sent here"
 #define TG_MSG_HAD_BEEN_STARTED          "System is now started"
 #define TG_MSG_HAD_BEEN_STOPPED          "System is now stopped"
 #define TG_MSG_ALERT_GOES_ON             "ALERT IS NOW ON"
@@ -110,5 +143,6 @@ void telegram_send_alert(bool isInAlert);
 void telegram_send_opt_changed(bool isOptEnabled);
 void telegram_send_conn_ok(void);
 void telegram_send_msg_relay_feedback(bool isOk);
+void telegram_print_stats(void);
 
 #endif /* TELEGRAM_TELEGRAM_HPP */
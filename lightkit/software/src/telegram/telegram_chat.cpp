@@ -0,0 +1,307 @@
+/**
+  * @file   telegram_chat.cpp
+  * @brief  Chats allowed to talk to the Telegram bot
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "telegram_chat.hpp"
+#include "file_sys/file_sys.hpp"
+#include "global.hpp"
+
+#ifdef MODULE_TELEGRAM
+
+// STATIC
+static struct telegram_chat_t chats[TELEGRAM_CHAT_MAX];
+static const char *           roleNames[] = {"viewer", "operator"}; /**< See telegram_role_e */
+
+/**
+ * @brief Read the chat list from the file system
+ *
+ * @return 0: OK, -1: Error
+ */
+int telegram_chat_load(void)
+{
+	String  path  = TELEGRAM_CHAT_FILE_PATH;
+	uint8_t count = 0;
+	File    file;
+
+	memset(chats, 0, sizeof(chats));
+
+	if (!file_sys_exist(path)) {
+		return 0;
+	}
+
+	file = file_sys_open(path, "r");
+	if (!file) {
+		log_error("Unable to open %s", TELEGRAM_CHAT_FILE_PATH);
+		return -1;
+	}
+
+	while (file.available() && (count < TELEGRAM_CHAT_MAX)) {
+		String  line = file.readStringUntil('\n');
+		char    roleStr[12];
+		char *  pEnd;
+		int     isSubscribed, role;
+		int64_t id;
+
+		line.trim();
+		if ((line.length() == 0) || line.startsWith("#")) {
+			continue;
+		}
+
+		id = strtoll(line.c_str(), &pEnd, 10);
+		if ((id == 0)
+		    || (sscanf(pEnd, "%11s %d", roleStr, &isSubscribed) != 2)
+		    || ((role = telegram_chat_parse_role(roleStr)) < 0)) {
+			log_warn("Ignored chat \"%s\"", line.c_str());
+			continue;
+		}
+
+		chats[count].id           = id;
+		chats[count].role         = role;
+		chats[count].isSubscribed = (isSubscribed != 0);
+		count++;
+	}
+	file.close();
+
+	log_info("%d Telegram chats loaded", count);
+	return 0;
+}
+
+/**
+ * @brief Write the chat list in the file system
+ *
+ * @return 0: OK, -1: Error
+ */
+int telegram_chat_save(void)
+{
+	String path = TELEGRAM_CHAT_FILE_PATH;
+	char   line[TELEGRAM_CHAT_ID_SIZE + 16];
+	char   idStr[TELEGRAM_CHAT_ID_SIZE];
+	File   file;
+
+	file = file_sys_open(path, "w");
+	if (!file) {
+		log_error("Unable to open %s", TELEGRAM_CHAT_FILE_PATH);
+		return -1;
+	}
+
+	file.print("# <chat id> <viewer|operator> <subscribed 0|1>\n");
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if (chats[i].id == 0) {
+			continue;
+		}
+		snprintf(line, sizeof(line), "%s %s %d\n", telegram_chat_id_to_str(idStr, chats[i].id),
+				 roleNames[chats[i].role], chats[i].isSubscribed ? 1 : 0);
+		file.print(line);
+	}
+	file.close();
+
+	return 0;
+}
+
+/**
+ * @brief Find a chat in the list
+ *
+ * @param id Telegram chat id
+ * @return Index of the chat, -1: Unknown chat
+ */
+int telegram_chat_find(int64_t id)
+{
+	if (id == 0) {
+		return -1;
+	}
+
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if (chats[i].id == id) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Add a chat to the list, or change its role
+ * @details New chats are subscribed, they can send /unsubscribe
+ *
+ * @param id Telegram chat id
+ * @param role See telegram_role_e
+ * @return Index of the chat, -1: List is full
+ */
+int telegram_chat_add(int64_t id, uint8_t role)
+{
+	int index = telegram_chat_find(id);
+
+	if ((id == 0) || (role > TELEGRAM_ROLE_OPERATOR)) {
+		return -1;
+	}
+
+	if (index < 0) {
+		// Removed chats leave a free slot, indexes of the others do not change
+		for (uint8_t i = 0; (index < 0) && (i < TELEGRAM_CHAT_MAX); i++) {
+			if (chats[i].id == 0) {
+				index = i;
+			}
+		}
+		if (index < 0) {
+			return -1;
+		}
+		chats[index].id           = id;
+		chats[index].isSubscribed = true;
+	}
+	chats[index].role = role;
+
+	telegram_chat_save();
+	return index;
+}
+
+/**
+ * @brief Remove a chat from the list
+ *
+ * @param id Telegram chat id
+ * @return 0: OK, -1: Unknown chat
+ */
+int telegram_chat_remove(int64_t id)
+{
+	int index = telegram_chat_find(id);
+
+	if (index < 0) {
+		return -1;
+	}
+
+	memset(&chats[index], 0, sizeof(chats[index]));
+	telegram_chat_save();
+	return 0;
+}
+
+/**
+ * @brief Choose whether a chat receives the alerts and the periodic messages
+ *
+ * @param index Index of the chat
+ * @param isSubscribed true to receive them
+ * @return 0: OK, -1: Unknown chat
+ */
+int telegram_chat_subscribe(uint8_t index, bool isSubscribed)
+{
+	if ((index >= TELEGRAM_CHAT_MAX) || (chats[index].id == 0)) {
+		return -1;
+	}
+
+	if (chats[index].isSubscribed != isSubscribed) {
+		chats[index].isSubscribed = isSubscribed;
+		telegram_chat_save();
+	}
+	return 0;
+}
+
+/**
+ * @brief Get a chat of the list
+ *
+ * @param index Index of the chat
+ * @return The chat, NULL: Unused slot
+ */
+const struct telegram_chat_t * telegram_chat_get(uint8_t index)
+{
+	if ((index >= TELEGRAM_CHAT_MAX) || (chats[index].id == 0)) {
+		return NULL;
+	}
+	return &chats[index];
+}
+
+/**
+ * @brief Get the chats that receive the alerts and the periodic messages
+ *
+ * @return One bit per chat index
+ */
+uint16_t telegram_chat_get_subscribers(void)
+{
+	uint16_t mask = 0;
+
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if ((chats[i].id != 0) && chats[i].isSubscribed) {
+			mask |= (1 << i);
+		}
+	}
+
+	return mask;
+}
+
+/**
+ * @brief Tell if no chat is known yet
+ */
+bool telegram_chat_is_empty(void)
+{
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if (chats[i].id != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Parse the name of a role
+ *
+ * @param str "viewer" or "operator"
+ * @return See telegram_role_e, -1: Unknown role
+ */
+int telegram_chat_parse_role(const char * str)
+{
+	for (uint8_t i = 0; i < (sizeof(roleNames) / sizeof(roleNames[0])); i++) {
+		if (strcmp(str, roleNames[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Convert a chat id to a string
+ * @details printf does not handle 64 bits integers everywhere
+ *
+ * @param str Output of at least TELEGRAM_CHAT_ID_SIZE bytes
+ * @param id Telegram chat id
+ * @return str
+ */
+char * telegram_chat_id_to_str(char * str, int64_t id)
+{
+	char     digits[TELEGRAM_CHAT_ID_SIZE];
+	uint8_t  count = 0;
+	uint64_t value = (id < 0) ? (0 - (uint64_t) id) : (uint64_t) id;
+	char *   p     = str;
+
+	do {
+		digits[count++] = '0' + (value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	if (id < 0) {
+		*p++ = '-';
+	}
+	while (count > 0) {
+		*p++ = digits[--count];
+	}
+	*p = '\0';
+
+	return str;
+}
+
+/**
+ * @brief Print the chat list
+ */
+void telegram_chat_print(void)
+{
+	char idStr[TELEGRAM_CHAT_ID_SIZE];
+
+	for (uint8_t i = 0; i < TELEGRAM_CHAT_MAX; i++) {
+		if (chats[i].id == 0) {
+			continue;
+		}
+		log_raw("#%d: %s %s%s\n\r", i, telegram_chat_id_to_str(idStr, chats[i].id),
+				roleNames[chats[i].role], chats[i].isSubscribed ? ", subscribed" : "");
+	}
+}
+
+#endif
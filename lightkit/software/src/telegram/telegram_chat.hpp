@@ -0,0 +1,41 @@
+/**
+  * @file   telegram_chat.hpp
+  * @brief  Chats allowed to talk to the Telegram bot
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef TELEGRAM_TELEGRAM_CHAT_HPP
+#define TELEGRAM_TELEGRAM_CHAT_HPP
+
+#include <Arduino.h>
+
+#define TELEGRAM_CHAT_MAX       8                     /** Chats known by the bot [1; 16] */
+#define TELEGRAM_CHAT_FILE_PATH "/telegram_chats.txt" /** One chat per line: "<id> <viewer|operator> <subscribed 0|1>" */
+#define TELEGRAM_CHAT_ID_SIZE   21                    /** Longest chat id as a string, with the sign */
+
+enum telegram_role_e {
+	TELEGRAM_ROLE_VIEWER = 0, /**< Reads the state of the board */
+	TELEGRAM_ROLE_OPERATOR    /**< Also controls it */
+};
+
+struct telegram_chat_t {
+	int64_t id;           /**< 0: Unused slot */
+	uint8_t role;         /**< See telegram_role_e */
+	bool    isSubscribed; /**< Receives the alerts and the periodic messages */
+};
+
+int                            telegram_chat_load(void);
+int                            telegram_chat_save(void);
+int                            telegram_chat_find(int64_t id);
+int                            telegram_chat_add(int64_t id, uint8_t role);
+int                            telegram_chat_remove(int64_t id);
+int                            telegram_chat_subscribe(uint8_t index, bool isSubscribed);
+const struct telegram_chat_t * telegram_chat_get(uint8_t index);
+uint16_t                       telegram_chat_get_subscribers(void);
+bool                           telegram_chat_is_empty(void);
+int                            telegram_chat_parse_role(const char * str);
+char *                         telegram_chat_id_to_str(char * str, int64_t id);
+void                           telegram_chat_print(void);
+
+#endif /* TELEGRAM_TELEGRAM_CHAT_HPP */
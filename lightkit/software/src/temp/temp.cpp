@@ -9,28 +9,112 @@
 #include <OneWire.h>
 
 #include "domoticz/domoticz.hpp"
+#include "event/event.hpp"
 #include "global.hpp"
 #include "status_led/status_led.hpp"
 #include "temp.hpp"
+#include "temp_history.hpp"
 
 #ifdef MODULE_TEMPERATURE
 
-extern uint32_t tick;
-uint32_t        tempNextMesureTick = 0;
-
-OneWire           oneWire(TEMP_1_WIRE_PIN);
-DallasTemperature sensors(&oneWire);
-// Stockage des adresses des thermometres
-byte          sensorCount                               = 0;
-DeviceAddress sensorAddrList[TEMP_MAX_SENSOR_SUPPORTED] = {};
+/* OneWire commands */
+#define ONEWIRE_CMD_SEARCH_ROM       0xF0
+#define ONEWIRE_CMD_MATCH_ROM        0x55
+#define ONEWIRE_CMD_SKIP_ROM         0xCC
+#define DS18X20_CMD_CONVERT_T        0x44
+#define DS18X20_CMD_WRITE_SCRATCHPAD 0x4E
+#define DS18X20_CMD_READ_SCRATCHPAD  0xBE
+#define DS18X20_CMD_READ_POWER       0xB4
+
+#define DS18S20_FAMILY          0x10 /**< Older sensor with 0.5°C resolution */
+#define DS18X20_SCRATCHPAD_SIZE 9
+#define DS18X20_ROM_BITS        (8 * sizeof(DeviceAddress))
+
+/* Configuration written before each conversion */
+#define DS18X20_ALARM_HIGH      0x7F                                         /**< Alarms are not used */
+#define DS18X20_ALARM_LOW       0x80                                         /**< Alarms are not used */
+#define DS18X20_CONFIG          (((TEMP_SENSOR_RESOLUTION - 9) << 5) | 0x1F)
+#define TEMP_CONVERSION_TIME    ((750 >> (12 - TEMP_SENSOR_RESOLUTION)) + 1) /**< In ms */
+#define DS18S20_CONVERSION_TIME 751                                          /**< In ms, DS18S20 ignores the resolution */
+
+/* Steps of a scratchpad read, one bus operation each */
+#define TEMP_READ_STEP_RESET      0
+#define TEMP_READ_STEP_MATCH_ROM  1
+#define TEMP_READ_STEP_ROM        2                                                     /**< 8 steps, one per byte */
+#define TEMP_READ_STEP_CMD        (TEMP_READ_STEP_ROM + sizeof(DeviceAddress))
+#define TEMP_READ_STEP_SCRATCHPAD (TEMP_READ_STEP_CMD + 1)                              /**< 9 steps, one per byte */
+#define TEMP_READ_STEP_DONE       (TEMP_READ_STEP_SCRATCHPAD + DS18X20_SCRATCHPAD_SIZE)
+
+/* Operations of a sequence that are not a byte to write */
+#define TEMP_SEQ_RESET      0x100 /**< Reset pulse, the sequence stops if no sensor answers */
+#define TEMP_SEQ_READ_POWER 0x200 /**< Read the power supply bit */
+
+#define TEMP_SEARCH_BITS_PER_TICK 4 /**< A ROM bit takes 3 time slots, about 0.2 ms */
 
-float sensorValue[TEMP_MAX_SENSOR_SUPPORTED] = {};
+/**
+ * A bit-banged OneWire byte takes about 0.6 ms and a reset about 1 ms,
+ * so the bus is handled in small operations and only one is done per tick
+ */
+enum temp_state_e {
+	TEMP_STATE_SEARCH_RESET = 0, /**< Enumeration: one ROM search after the other */
+	TEMP_STATE_SEARCH_CMD,       /**< ... */
+	TEMP_STATE_SEARCH_BITS,      /**< ... TEMP_SEARCH_BITS_PER_TICK bits each tick */
+	TEMP_STATE_IDLE,             /**< Waiting for the next measure */
+	TEMP_STATE_SEQUENCE,         /**< Running tempSeq, a broadcast to all sensors */
+	TEMP_STATE_CONVERTING,       /**< Waiting for the end of conversion */
+	TEMP_STATE_READ              /**< Reading scratchpads, see TEMP_READ_STEP_* */
+};
+
+// Structures
+struct temp_sensor_t {
+	DeviceAddress address;
+	float         value;
+};
+
+// Sequences
+static const uint16_t tempPowerSequence[] = {
+	TEMP_SEQ_RESET, ONEWIRE_CMD_SKIP_ROM, DS18X20_CMD_READ_POWER, TEMP_SEQ_READ_POWER
+};
+static const uint16_t tempConvertSequence[] = {
+	TEMP_SEQ_RESET, ONEWIRE_CMD_SKIP_ROM, DS18X20_CMD_WRITE_SCRATCHPAD, DS18X20_ALARM_HIGH, DS18X20_ALARM_LOW, DS18X20_CONFIG,
+	TEMP_SEQ_RESET, ONEWIRE_CMD_SKIP_ROM, DS18X20_CMD_CONVERT_T
+};
+
+static_assert(TEMP_MAX_SENSOR_SUPPORTED <= 32, "Faults of all sensors must fit in sensorFaultMask");
 
-char * sensor_addr_to_string(char * str, DeviceAddress address)
+extern uint32_t tick;
+uint32_t        tempNextMesureTick = 0;
+static uint8_t  tempState          = TEMP_STATE_SEARCH_RESET;
+static uint32_t tempConversionEndTick;
+static uint16_t tempConversionTime = TEMP_CONVERSION_TIME; /**< Of the slowest sensor on the bus, in ms */
+static uint8_t  tempReadIndex; /**< Sensor being read */
+static uint8_t  tempReadStep;  /**< One of TEMP_READ_STEP_* */
+static uint8_t  tempScratchpad[DS18X20_SCRATCHPAD_SIZE];
+static bool     tempIsParasite = false;
+
+// Sequence being run
+static const uint16_t * tempSeq;
+static uint8_t          tempSeqLength;
+static uint8_t          tempSeqIndex;
+
+// ROM search, kept between two searches
+static DeviceAddress searchRom;
+static uint8_t       searchBit;             /**< Next bit to find */
+static uint8_t       searchLastDiscrepancy; /**< Last bit where we took 1 instead of 0, 1-based, 0: None */
+static uint8_t       searchLastZero;        /**< Last bit where we took 0 instead of 1 in this search */
+
+OneWire oneWire(TEMP_1_WIRE_PIN);
+
+// Stockage des thermometres, triés par adresse | Sensors, sorted by address
+static struct temp_sensor_t sensorTable[TEMP_MAX_SENSOR_SUPPORTED];
+static uint8_t              sensorCount     = 0;
+static uint32_t             sensorFaultMask = 0; /**< One bit per sensor */
+
+char * sensor_addr_to_string(char * str, const uint8_t * address)
 {
 	char * strOld = str;
 
-	for (byte index = 0; index < sizeof(address); index++) {
+	for (byte index = 0; index < sizeof(DeviceAddress); index++) {
 		if (index > 0) {
 			str += sprintf(str, "-");
 		}
@@ -42,95 +126,217 @@ char * sensor_addr_to_string(char * str, DeviceAddress address)
 }
 
 /**
- * @brief Search for new addresses on the OneWire bus
- * Results are saved in addressList
- * @param maxLen: maximum number of address to find
- * @return The number of address found
+ * @brief Add a sensor found on the bus
+ * @details The table is kept sorted, highest ROM code first,
+ * so indexes do not depend on the order of discovery
+ *
+ * @param address ROM code of the sensor
  */
-byte get_onewire_address(DeviceAddress addressList[], byte maxLen)
+static void temp_add_sensor(const uint8_t * address)
 {
-	byte index = 0;
+	char    strTemp[3 * 8 + 1];
+	uint8_t i;
 
-	while (true) {
-		if (oneWire.search(addressList[index]) != 1) {
-			oneWire.reset_search();
+	if (sensorCount >= TEMP_MAX_SENSOR_SUPPORTED) {
+		log_warn("Too many sensors, %s is ignored", sensor_addr_to_string(strTemp, address));
+		return;
+	}
+
+	for (i = sensorCount; i > 0; i--) {
+		if (memcmp(address, sensorTable[i - 1].address, sizeof(DeviceAddress)) < 0) {
 			break;
+		}
+		sensorTable[i] = sensorTable[i - 1];
+	}
+
+	memcpy(sensorTable[i].address, address, sizeof(DeviceAddress));
+	sensorTable[i].value = DEVICE_DISCONNECTED_C;
+	sensorCount++;
+}
+
+/**
+ * @brief Find the next bits of the current ROM search
+ * @details Maxim application note 187: when sensors answer both 0 and 1
+ * on a bit, the path not taken is remembered for the next search.
+ *
+ * @return 0: Search continues, 1: A ROM code is complete, -1: No answer
+ */
+static int8_t temp_search_step(void)
+{
+	for (uint8_t n = 0; n < TEMP_SEARCH_BITS_PER_TICK; n++) {
+		uint8_t bitNumber = searchBit + 1;
+		uint8_t byteIndex = searchBit / 8;
+		uint8_t bitMask   = 1 << (searchBit % 8);
+		uint8_t idBit     = oneWire.read_bit();
+		uint8_t cmpIdBit  = oneWire.read_bit();
+		bool    direction;
+
+		if (idBit && cmpIdBit) {
+			return -1;
+		}
+
+		if (idBit != cmpIdBit) {
+			// All the remaining sensors have the same bit
+			direction = idBit;
 		} else {
-			// Count this new sensor
-			++index;
-			// Do we have reach the limit ?
-			if (index >= maxLen) {
-				break;
+			// Discrepancy, follow the previous path until the last one, then take 1
+			if (bitNumber < searchLastDiscrepancy) {
+				direction = _isset(searchRom[byteIndex], bitMask);
+			} else {
+				direction = (bitNumber == searchLastDiscrepancy);
 			}
+			if (!direction) {
+				searchLastZero = bitNumber;
+			}
+		}
+
+		if (direction) {
+			_set(searchRom[byteIndex], bitMask);
+		} else {
+			_unset(searchRom[byteIndex], bitMask);
+		}
+		oneWire.write_bit(direction);
+
+		if (++searchBit >= DS18X20_ROM_BITS) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Start to run a sequence of bus operations
+ *
+ * @param sequence Bytes to write or TEMP_SEQ_*
+ * @param length Number of operations
+ */
+static void temp_start_sequence(const uint16_t * sequence, uint8_t length)
+{
+	tempSeq       = sequence;
+	tempSeqLength = length;
+	tempSeqIndex  = 0;
+	tempState     = TEMP_STATE_SEQUENCE;
+}
+
+/**
+ * @brief Do the next operation of the running sequence
+ *
+ * @return 0: Sequence continues, 1: Sequence is over, -1: No sensor answered
+ */
+static int8_t temp_sequence_step(void)
+{
+	uint16_t op     = tempSeq[tempSeqIndex++];
+	bool     isLast = (tempSeqIndex >= tempSeqLength);
+
+	if (op == TEMP_SEQ_RESET) {
+		if (oneWire.reset() == 0) {
+			return -1;
 		}
-		delay(100);
+	} else if (op == TEMP_SEQ_READ_POWER) {
+		// Parasite powered sensors pull the bus low
+		tempIsParasite = (oneWire.read_bit() == 0);
+	} else {
+		// Parasite powered sensors need the bus held high after the last command
+		oneWire.write((uint8_t) op, isLast && tempIsParasite);
 	}
 
-	return index;
+	return isLast ? 1 : 0;
 }
 
 /**
- * @brief Write the thermometers address into sensorAddrList
- * @note It can write 1 or 2 addresses
+ * @brief Convert a scratchpad into degrees
+ *
+ * @param family First byte of the ROM code
+ * @param scratchpad The 9 bytes read from the sensor
+ * @return Temperature in celcius or DEVICE_DISCONNECTED_C
  */
-void get_sensor_address(void)
+static float temp_scratchpad_to_celsius(uint8_t family, const uint8_t * scratchpad)
 {
-	DeviceAddress addressList[TEMP_MAX_SENSOR_SUPPORTED];
+	int16_t raw;
 
-	sensorCount = get_onewire_address(addressList, TEMP_MAX_SENSOR_SUPPORTED);
+	if (OneWire::crc8(scratchpad, DS18X20_SCRATCHPAD_SIZE - 1) != scratchpad[DS18X20_SCRATCHPAD_SIZE - 1]) {
+		return DEVICE_DISCONNECTED_C;
+	}
 
-	// ONLY FOR DEBUG
-	// sensorCount = 2;
-	// for (byte index = 0; index < sizeof(DeviceAddress); index++) {
-	//   addressList[0][index] = 2 * index;
-	//   addressList[1][index] = 10 * index;
-	// }
+	raw = (int16_t) ((scratchpad[1] << 8) | scratchpad[0]);
 
-	if (sensorCount == 0) {
-		log_warn("No sensor found");
-	} else if (sensorCount == 1) {
-		memcpy(sensorAddrList[0], addressList[0], sizeof(DeviceAddress));
-	} else if (sensorCount == 2) {
-		// The addresses smaller goes in first position
-		for (byte index = 0; index < sizeof(DeviceAddress); index++) {
-			if (addressList[0][index] > addressList[1][index]) {
-				memcpy(sensorAddrList[0], addressList[0], sizeof(DeviceAddress));
-				memcpy(sensorAddrList[1], addressList[1], sizeof(DeviceAddress));
-			} else if (addressList[0][index] < addressList[1][index]) {
-				memcpy(sensorAddrList[0], addressList[1], sizeof(DeviceAddress));
-				memcpy(sensorAddrList[1], addressList[0], sizeof(DeviceAddress));
-			} else {
-				continue;
-			}
-			break; // If we copied, leave loop
+	if (family == DS18S20_FAMILY) {
+		// 0.5°C resolution, extended with COUNT_REMAIN
+		raw = ((raw & 0xFFFE) << 3) - 4 + (16 - scratchpad[6]);
+	} else {
+		// Low bits are undefined under 12 bits of resolution
+		uint8_t unusedBits = 3 - ((scratchpad[4] >> 5) & 0x03);
+		raw &= ~((1 << unusedBits) - 1);
+	}
+
+	// 1/16 °C per LSB
+	return raw / 16.0f;
+}
+
+/**
+ * @brief Do the next bus operation of a scratchpad read
+ *
+ * @param deviceAddress The sensor being read
+ * @return true when the read is over, result is in tempScratchpad
+ */
+static bool temp_read_step(const uint8_t * deviceAddress)
+{
+	uint8_t step = tempReadStep++;
+
+	if (step == TEMP_READ_STEP_RESET) {
+		if (oneWire.reset() == 0) {
+			// No sensor answered, the scratchpad is invalid
+			memset(tempScratchpad, 0xFF, sizeof(tempScratchpad));
+			return true;
 		}
+	} else if (step == TEMP_READ_STEP_MATCH_ROM) {
+		oneWire.write(ONEWIRE_CMD_MATCH_ROM);
+	} else if (step < TEMP_READ_STEP_CMD) {
+		oneWire.write(deviceAddress[step - TEMP_READ_STEP_ROM]);
+	} else if (step == TEMP_READ_STEP_CMD) {
+		oneWire.write(DS18X20_CMD_READ_SCRATCHPAD);
 	} else {
-		log_error("Unsupported sensor number: %d", sensorCount);
+		tempScratchpad[step - TEMP_READ_STEP_SCRATCHPAD] = oneWire.read();
 	}
+
+	return tempReadStep >= TEMP_READ_STEP_DONE;
 }
 
 /**
- *  Read the value of the specified sensor and send it
+ *  Save the value of the specified sensor and send it
  **/
-void manage_sensor(uint8_t deviceIndex, DeviceAddress deviceAddress)
+void manage_sensor(uint8_t deviceIndex, float degreesValue)
 {
+	uint32_t faultBit = 1UL << deviceIndex;
 
 	// ONLY FOR DEBUG
-	// sensorValue[deviceIndex] = (deviceIndex == 0) ? 14.0 : 28.1;
+	// sensorTable[deviceIndex].value = (deviceIndex == 0) ? 14.0 : 28.1;
 	// return;
 
-	float degreesValue = sensors.getTempC(deviceAddress);
-
 	if (degreesValue == DEVICE_DISCONNECTED_C) {
-		_set(STATUS_TEMP, STATUS_TEMP_1_FAULT << deviceIndex);
+		if (_isunset(sensorFaultMask, faultBit)) {
+			event_publish(EVENT_TEMP_FAULT, deviceIndex, 1);
+		}
+		_set(sensorFaultMask, faultBit);
+		_set(STATUS_TEMP, STATUS_TEMP_FAULT);
+		temp_history_add(deviceIndex, TEMP_HISTORY_NO_VALUE);
 		log_error("Sensor %d: error getting temperature", deviceIndex);
 		return;
 	}
 
-	_unset(STATUS_TEMP, STATUS_TEMP_1_FAULT << deviceIndex);
+	if (_isset(sensorFaultMask, faultBit)) {
+		event_publish(EVENT_TEMP_FAULT, deviceIndex, 0);
+		_unset(sensorFaultMask, faultBit);
+		if (sensorFaultMask == 0) {
+			_unset(STATUS_TEMP, STATUS_TEMP_FAULT);
+		}
+	}
 
 	// Save data
-	sensorValue[deviceIndex] = degreesValue;
+	sensorTable[deviceIndex].value = degreesValue;
+	event_publish(EVENT_TEMP_VALUE, deviceIndex, (int32_t) lroundf(degreesValue * 100));
+	temp_history_add(deviceIndex, (int16_t) lroundf(degreesValue * 100));
 
 	// Log
 	log_info("Sensor %d is %.2f°C", deviceIndex, degreesValue);
@@ -144,11 +350,26 @@ void manage_sensor(uint8_t deviceIndex, DeviceAddress deviceAddress)
  */
 float temp_get_value(uint8_t deviceIndex)
 {
-	if (deviceIndex >= TEMP_MAX_SENSOR_SUPPORTED) {
+	if (deviceIndex >= sensorCount) {
 		return DEVICE_DISCONNECTED_C;
 	}
 
-	return sensorValue[deviceIndex];
+	return sensorTable[deviceIndex].value;
+}
+
+/**
+ * @brief Tell if the last read of a sensor failed
+ *
+ * @param deviceIndex The index of the sensor
+ * @return true if faulty
+ */
+bool temp_is_faulty(uint8_t deviceIndex)
+{
+	if (deviceIndex >= sensorCount) {
+		return true;
+	}
+
+	return _isset(sensorFaultMask, 1UL << deviceIndex);
 }
 
 /**
@@ -161,60 +382,181 @@ float temp_get_value(uint8_t deviceIndex)
  */
 char * temp_get_address(char * str, uint8_t deviceIndex)
 {
-	if (deviceIndex >= TEMP_MAX_SENSOR_SUPPORTED) {
+	if (deviceIndex >= sensorCount) {
 		str[0] = '\0';
 	} else {
-		sensor_addr_to_string(str, sensorAddrList[deviceIndex]);
+		sensor_addr_to_string(str, sensorTable[deviceIndex].address);
 	}
 	return str;
 }
 
+/**
+ * @brief Get the ROM code of a sensor
+ *
+ * @param deviceIndex The index of the sensor
+ * @return The sizeof(DeviceAddress) bytes of the code or NULL
+ */
+const uint8_t * temp_get_rom(uint8_t deviceIndex)
+{
+	if (deviceIndex >= sensorCount) {
+		return NULL;
+	}
+
+	return sensorTable[deviceIndex].address;
+}
+
 uint8_t temp_get_nb_sensor(void)
 {
 	return (uint8_t) sensorCount;
 }
 
-int temp_init(void)
+/**
+ * @brief Start a new enumeration of the bus
+ */
+static void temp_start_search(void)
+{
+	sensorCount           = 0;
+	sensorFaultMask       = 0;
+	searchLastDiscrepancy = 0;
+	tempConversionTime    = TEMP_CONVERSION_TIME;
+	tempState             = TEMP_STATE_SEARCH_RESET;
+	_unset(STATUS_TEMP, STATUS_TEMP_FAULT);
+}
+
+/**
+ * @brief Log the sensors once the enumeration is over
+ */
+static void temp_end_search(void)
 {
 	char strTemp[3 * 8 + 1];
-	log_info("Locating OneWire devices... ");
-	get_sensor_address();
 
-	sensors.begin();
+	// Histories follow the sensors, whatever their new index
+	temp_history_load();
+
+	if (sensorCount == 0) {
+		log_warn("No sensor found");
+		tempState = TEMP_STATE_IDLE;
+		return;
+	}
 
 	for (byte sensorIndex = 0; sensorIndex < sensorCount; sensorIndex++) {
 		// Print device name and address
-		log_info("Device [%d/%d]: %s", sensorIndex + 1, sensorCount, sensor_addr_to_string(strTemp, sensorAddrList[sensorIndex]));
+		log_info("Device [%d/%d]: %s", sensorIndex + 1, sensorCount, sensor_addr_to_string(strTemp, sensorTable[sensorIndex].address));
 
-		// Vérifie si les capteurs sont connectés | check and report if sensors are conneted
-		if (!sensors.getAddress(sensorAddrList[sensorIndex], sensorIndex)) {
-			log_error("Unable to find address for Device %d", sensorIndex + 1);
-			continue;
+		// All the sensors are read when the slowest one is done
+		if (sensorTable[sensorIndex].address[0] == DS18S20_FAMILY) {
+			tempConversionTime = DS18S20_CONVERSION_TIME;
 		}
-		// set the resolution to 9 bit per device
-		sensors.setResolution(sensorAddrList[sensorIndex], TEMP_SENSOR_RESOLUTION);
-
-		// On vérifie que le capteur est correctement configuré | Check that sensor is correctly configured
-		log_info("Resolution: %d bits", sensors.getResolution(sensorAddrList[sensorIndex]));
 	}
 
+	// Measure right after the power supply check
+	tempNextMesureTick = 0;
+	temp_start_sequence(tempPowerSequence, sizeof(tempPowerSequence) / sizeof(uint16_t));
+}
+
+int temp_init(void)
+{
+	CHECK_CALL(temp_history_init())
+
+	log_info("Locating OneWire devices... ");
+
+	// Enumeration is done by temp_main()
+	temp_start_search();
+
 	return 0;
 }
 
 void temp_main(void)
 {
-	if (tick > tempNextMesureTick) {
-		tempNextMesureTick = tick + TEMP_POLLING_PERIOD_MS;
+	int8_t ret;
+
+	temp_history_main();
 
-		if (sensorCount > 0) {
-			sensors.requestTemperatures();
+	switch (tempState) {
+	case TEMP_STATE_SEARCH_RESET:
+		if (oneWire.reset() == 0) {
+			temp_end_search();
+		} else {
+			tempState = TEMP_STATE_SEARCH_CMD;
+		}
+		break;
+	case TEMP_STATE_SEARCH_CMD:
+		oneWire.write(ONEWIRE_CMD_SEARCH_ROM);
+		searchBit      = 0;
+		searchLastZero = 0;
+		tempState      = TEMP_STATE_SEARCH_BITS;
+		break;
+	case TEMP_STATE_SEARCH_BITS:
+		ret = temp_search_step();
+		if (ret == 0) {
+			break;
+		}
 
-			// print the device information
-			for (byte sensorIndex = 0; sensorIndex < sensorCount; sensorIndex++) {
-				manage_sensor(sensorIndex, sensorAddrList[sensorIndex]);
+		if ((ret > 0) && (OneWire::crc8(searchRom, sizeof(DeviceAddress) - 1) == searchRom[sizeof(DeviceAddress) - 1])) {
+			temp_add_sensor(searchRom);
+			searchLastDiscrepancy = searchLastZero;
+		} else {
+			log_error("OneWire search failed");
+			searchLastDiscrepancy = 0;
+		}
+
+		// Other sensors are left on a path not taken yet
+		if (searchLastDiscrepancy != 0) {
+			tempState = TEMP_STATE_SEARCH_RESET;
+		} else {
+			temp_end_search();
+		}
+		break;
+	case TEMP_STATE_IDLE:
+		if (tick > tempNextMesureTick) {
+			tempNextMesureTick = tick + TEMP_POLLING_PERIOD_MS;
+
+			if (sensorCount > 0) {
+				temp_start_sequence(tempConvertSequence, sizeof(tempConvertSequence) / sizeof(uint16_t));
+			} else {
+				// Sensors may have been plugged since
+				temp_start_search();
+			}
+		}
+		break;
+	case TEMP_STATE_SEQUENCE:
+		ret = temp_sequence_step();
+		if (ret < 0) {
+			log_error("No sensor answered on OneWire bus");
+			tempState = TEMP_STATE_IDLE;
+		} else if (ret > 0) {
+			if (tempSeq == tempConvertSequence) {
+				// All the sensors convert at the same time
+				tempConversionEndTick = tick + tempConversionTime;
+				tempState             = TEMP_STATE_CONVERTING;
+			} else {
+				tempState = TEMP_STATE_IDLE;
 			}
 		}
+		break;
+	case TEMP_STATE_CONVERTING:
+		if (tick >= tempConversionEndTick) {
+			tempReadIndex = 0;
+			tempReadStep  = TEMP_READ_STEP_RESET;
+			tempState     = TEMP_STATE_READ;
+		}
+		break;
+	case TEMP_STATE_READ:
+		if (!temp_read_step(sensorTable[tempReadIndex].address)) {
+			break;
+		}
+
+		manage_sensor(tempReadIndex, temp_scratchpad_to_celsius(sensorTable[tempReadIndex].address[0], tempScratchpad));
+
+		tempReadStep = TEMP_READ_STEP_RESET;
+		if (++tempReadIndex >= sensorCount) {
+			tempState = TEMP_STATE_IDLE;
+		}
+		break;
+	default:
+		tempState = TEMP_STATE_IDLE;
+		break;
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
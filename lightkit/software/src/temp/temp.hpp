@@ -13,10 +13,12 @@
 #define DEVICE_INDEX_0 0
 #define DEVICE_INDEX_1 1
 
-float   temp_get_value(uint8_t deviceIndex);
-char *  temp_get_address(char * str, uint8_t deviceIndex);
-uint8_t temp_get_nb_sensor(void);
-int     temp_init(void);
-void    temp_main(void);
+float           temp_get_value(uint8_t deviceIndex);
+bool            temp_is_faulty(uint8_t deviceIndex);
+char *          temp_get_address(char * str, uint8_t deviceIndex);
+const uint8_t * temp_get_rom(uint8_t deviceIndex);
+uint8_t         temp_get_nb_sensor(void);
+int             temp_init(void);
+void            temp_main(void);
 
 #endif /* TEMP_TEMP_HPP */
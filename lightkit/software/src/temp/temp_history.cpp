@@ -0,0 +1,736 @@
+/**
+  * @file   temp_history.cpp
+  * @brief  Keep the past values of temperature sensors
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include <DallasTemperature.h>
+
+#include "file_sys/file_sys.hpp"
+#include "temp.hpp"
+#include "temp_history.hpp"
+
+#ifdef MODULE_TEMPERATURE
+
+#define TEMP_HISTORY_FILE_MAGIC   0x48544C4B /**< "KLTH" */
+#define TEMP_HISTORY_FILE_VERSION 1
+
+/** Samples of a level that make one sample of the next level */
+#define TEMP_HISTORY_RAW_PER_MEDIUM  ((TEMP_HISTORY_MEDIUM_PERIOD_MS) / (TEMP_POLLING_PERIOD_MS))
+#define TEMP_HISTORY_MEDIUM_PER_LONG ((TEMP_HISTORY_LONG_PERIOD_MS) / (TEMP_HISTORY_MEDIUM_PERIOD_MS))
+
+#define TEMP_HISTORY_MAX_COUNT 255 /**< Counts are stored in a byte */
+
+static_assert(((TEMP_HISTORY_MEDIUM_PERIOD_MS) % (TEMP_POLLING_PERIOD_MS)) == 0, "Medium period must be a multiple of TEMP_POLLING_PERIOD_MS");
+static_assert(((TEMP_HISTORY_LONG_PERIOD_MS) % (TEMP_HISTORY_MEDIUM_PERIOD_MS)) == 0, "Long period must be a multiple of the medium one");
+static_assert(TEMP_HISTORY_RAW_PER_MEDIUM > 0, "TEMP_POLLING_PERIOD_MS is longer than the medium period");
+static_assert(TEMP_HISTORY_RAW_COUNT <= TEMP_HISTORY_MAX_COUNT, "Raw level is too big");
+static_assert(TEMP_HISTORY_MEDIUM_COUNT <= TEMP_HISTORY_MAX_COUNT, "Medium level is too big");
+static_assert(TEMP_HISTORY_LONG_COUNT <= TEMP_HISTORY_MAX_COUNT, "Long level is too big");
+static_assert(TEMP_HISTORY_SENSOR_COUNT <= TEMP_MAX_SENSOR_SUPPORTED, "More history than sensors");
+static_assert((TEMP_HISTORY_RAW_COUNT <= TEMP_HISTORY_LARGEST_COUNT) && (TEMP_HISTORY_LONG_COUNT <= TEMP_HISTORY_LARGEST_COUNT), "TEMP_HISTORY_LARGEST_COUNT is wrong");
+
+// Structures
+struct temp_history_ring_t {
+	int16_t * samples;  /**< Absolute values in 1/100 °C, TEMP_HISTORY_NO_VALUE when missing */
+	uint8_t   size;     /**< Capacity */
+	uint8_t   head;     /**< Next slot to write */
+	uint8_t   count;    /**< Valid slots */
+	uint8_t   pending;  /**< Samples added since the last push to the next level */
+	uint8_t   sumCount; /**< Samples in sum, faulty ones are not counted */
+	int32_t   sum;      /**< Sum of the pending samples */
+};
+
+struct temp_history_sensor_t {
+	DeviceAddress              rom; /**< Sensor that owns this history, 0 when none */
+	struct temp_history_ring_t levels[TEMP_HISTORY_LEVEL_COUNT];
+};
+
+// Variables
+extern uint32_t                     tick;
+static int16_t                      historyRaw[TEMP_HISTORY_SENSOR_COUNT][TEMP_HISTORY_RAW_COUNT];
+static int16_t                      historyMedium[TEMP_HISTORY_SENSOR_COUNT][TEMP_HISTORY_MEDIUM_COUNT];
+static int16_t                      historyLong[TEMP_HISTORY_SENSOR_COUNT][TEMP_HISTORY_LONG_COUNT];
+static struct temp_history_sensor_t historySensors[TEMP_HISTORY_SENSOR_COUNT];
+static uint32_t                     historyNextSaveTick = TEMP_HISTORY_SAVE_PERIOD_MS;
+static bool                         historyIsDirty      = false; /**< Samples were added since the last save */
+static uint8_t                      historyBuffer[TEMP_HISTORY_ENCODED_SIZE(TEMP_HISTORY_LARGEST_COUNT)];
+static File                         historyFile;          /**< Open while a save is in progress */
+static uint8_t                      historySaveBlock = 0; /**< Next level block to write + 1, 0: No save in progress */
+
+static const uint8_t historyRatios[TEMP_HISTORY_LEVEL_COUNT] = {
+	TEMP_HISTORY_RAW_PER_MEDIUM, TEMP_HISTORY_MEDIUM_PER_LONG, 0
+};
+static const char * const historyLevelNames[TEMP_HISTORY_LEVEL_COUNT] = {
+	"raw", "5min", "hour"
+};
+
+/**
+ * @brief Empty a ring, keeping its storage
+ *
+ * @param pRing The ring
+ */
+static void temp_history_clear_ring(struct temp_history_ring_t * pRing)
+{
+	pRing->head     = 0;
+	pRing->count    = 0;
+	pRing->pending  = 0;
+	pRing->sumCount = 0;
+	pRing->sum      = 0;
+}
+
+/**
+ * @brief Mean of the pending samples, rounded to the nearest
+ *
+ * @param pRing The ring
+ * @return The mean or TEMP_HISTORY_NO_VALUE if no sample was valid
+ */
+static int16_t temp_history_pending_mean(const struct temp_history_ring_t * pRing)
+{
+	int32_t half;
+
+	if (pRing->sumCount == 0) {
+		return TEMP_HISTORY_NO_VALUE;
+	}
+
+	half = (pRing->sum >= 0) ? (pRing->sumCount / 2) : -(pRing->sumCount / 2);
+	return (int16_t) ((pRing->sum + half) / pRing->sumCount);
+}
+
+/**
+ * @brief Add a sample to a level, and to the next ones when enough samples were added
+ *
+ * @param pSensor History of the sensor
+ * @param level One of temp_history_level_e
+ * @param value In 1/100 °C or TEMP_HISTORY_NO_VALUE
+ */
+static void temp_history_push(struct temp_history_sensor_t * pSensor, uint8_t level, int16_t value)
+{
+	struct temp_history_ring_t * pRing = &pSensor->levels[level];
+
+	pRing->samples[pRing->head] = value;
+	pRing->head                 = (pRing->head + 1) % pRing->size;
+	if (pRing->count < pRing->size) {
+		pRing->count++;
+	}
+
+	if (historyRatios[level] == 0) {
+		return;
+	}
+
+	if (value != TEMP_HISTORY_NO_VALUE) {
+		pRing->sum += value;
+		pRing->sumCount++;
+	}
+
+	if (++pRing->pending >= historyRatios[level]) {
+		int16_t mean = temp_history_pending_mean(pRing);
+
+		pRing->pending  = 0;
+		pRing->sumCount = 0;
+		pRing->sum      = 0;
+		temp_history_push(pSensor, level + 1, mean);
+	}
+}
+
+/**
+ * @brief Write an unsigned varint, 7 bits per byte, low bits first
+ *
+ * @param buffer Where to write
+ * @param value The value
+ * @return Number of bytes written
+ */
+static uint8_t temp_history_write_varint(uint8_t * buffer, uint32_t value)
+{
+	uint8_t length = 0;
+
+	while (value >= 0x80) {
+		buffer[length++] = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	buffer[length++] = (uint8_t) value;
+
+	return length;
+}
+
+/**
+ * @brief Read an unsigned varint
+ *
+ * @param buffer Where to read
+ * @param size Bytes available
+ * @param pValue Filled with the value
+ * @return Number of bytes read, 0 if the buffer ends before the varint
+ */
+static uint8_t temp_history_read_varint(const uint8_t * buffer, uint16_t size, uint32_t * pValue)
+{
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; (i < size) && (i < 5); i++) {
+		value |= (uint32_t) (buffer[i] & 0x7F) << (7 * i);
+		if (_isunset(buffer[i], 0x80)) {
+			*pValue = value;
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Fill a ring from a block made by temp_history_encode()
+ *
+ * @param pRing The ring, cleared first
+ * @param buffer The block
+ * @param size Size of the block
+ * @return 0: OK, -1: Block is corrupted
+ */
+static int temp_history_decode(struct temp_history_ring_t * pRing, const uint8_t * buffer, uint16_t size)
+{
+	uint32_t count, zigzag;
+	uint16_t offset = 0;
+	int32_t  value  = 0;
+	uint8_t  length;
+
+	temp_history_clear_ring(pRing);
+
+	length = temp_history_read_varint(buffer, size, &count);
+	if (length == 0) {
+		return -1;
+	}
+	offset += length;
+
+	for (uint32_t i = 0; i < count; i++) {
+		length = temp_history_read_varint(&buffer[offset], size - offset, &zigzag);
+		if (length == 0) {
+			temp_history_clear_ring(pRing);
+			return -1;
+		}
+		offset += length;
+
+		value += (int32_t) (zigzag >> 1) ^ -((int32_t) (zigzag & 1));
+		if ((value < INT16_MIN) || (value > INT16_MAX)) {
+			temp_history_clear_ring(pRing);
+			return -1;
+		}
+
+		// Only keep the newest ones if the level was bigger when saved
+		pRing->samples[pRing->head] = (int16_t) value;
+		pRing->head                 = (pRing->head + 1) % pRing->size;
+		if (pRing->count < pRing->size) {
+			pRing->count++;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Tell if the sensors found on the bus are not the ones of the histories
+ *
+ * @return true if a history changes of sensor
+ */
+static bool temp_history_sensors_changed(void)
+{
+	static const DeviceAddress noRom = { 0 };
+
+	for (uint8_t i = 0; i < TEMP_HISTORY_SENSOR_COUNT; i++) {
+		const uint8_t * rom = temp_get_rom(i);
+
+		if (memcmp(historySensors[i].rom, (rom != NULL) ? rom : noRom, sizeof(DeviceAddress)) != 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Bind the histories to the sensors found on the bus
+ * @details Histories whose sensor is gone are cleared
+ */
+static void temp_history_bind_sensors(void)
+{
+	for (uint8_t i = 0; i < TEMP_HISTORY_SENSOR_COUNT; i++) {
+		struct temp_history_sensor_t * pSensor = &historySensors[i];
+		const uint8_t *                rom     = temp_get_rom(i);
+
+		if ((rom != NULL) && (memcmp(pSensor->rom, rom, sizeof(DeviceAddress)) == 0)) {
+			continue;
+		}
+
+		for (uint8_t level = 0; level < TEMP_HISTORY_LEVEL_COUNT; level++) {
+			temp_history_clear_ring(&pSensor->levels[level]);
+		}
+
+		if (rom != NULL) {
+			memcpy(pSensor->rom, rom, sizeof(DeviceAddress));
+		} else {
+			memset(pSensor->rom, 0, sizeof(DeviceAddress));
+		}
+	}
+}
+
+/**
+ * @brief Find the history of a sensor
+ *
+ * @param rom ROM code of the sensor
+ * @return The history or NULL if the sensor has none
+ */
+static struct temp_history_sensor_t * temp_history_find(const uint8_t * rom)
+{
+	for (uint8_t i = 0; i < TEMP_HISTORY_SENSOR_COUNT; i++) {
+		if (memcmp(historySensors[i].rom, rom, sizeof(DeviceAddress)) == 0) {
+			return &historySensors[i];
+		}
+	}
+
+	return NULL;
+}
+
+int temp_history_init(void)
+{
+	static int16_t * const storages[TEMP_HISTORY_LEVEL_COUNT] = {
+		&historyRaw[0][0], &historyMedium[0][0], &historyLong[0][0]
+	};
+	static const uint8_t sizes[TEMP_HISTORY_LEVEL_COUNT] = {
+		TEMP_HISTORY_RAW_COUNT, TEMP_HISTORY_MEDIUM_COUNT, TEMP_HISTORY_LONG_COUNT
+	};
+
+	for (uint8_t i = 0; i < TEMP_HISTORY_SENSOR_COUNT; i++) {
+		memset(historySensors[i].rom, 0, sizeof(DeviceAddress));
+
+		for (uint8_t level = 0; level < TEMP_HISTORY_LEVEL_COUNT; level++) {
+			struct temp_history_ring_t * pRing = &historySensors[i].levels[level];
+
+			pRing->samples = storages[level] + i * sizes[level];
+			pRing->size    = sizes[level];
+			temp_history_clear_ring(pRing);
+		}
+	}
+
+	historyIsDirty = false;
+	if (historySaveBlock > 0) {
+		historyFile.close();
+		historySaveBlock = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Bind the histories to the sensors and restore them from the file system
+ * @details Nothing is done while the sensors are the same,
+ * the histories in RAM are then the newest
+ * @note Called by the temp module at the end of each enumeration
+ */
+void temp_history_load(void)
+{
+	String   path = TEMP_HISTORY_FILE_PATH;
+	File     file;
+	uint32_t magic;
+	uint8_t  header[2]; // Version, sensor count
+
+	if (!temp_history_sensors_changed()) {
+		return;
+	}
+
+	// Do not lose what was measured before the sensors disappeared
+	if (historyIsDirty || (historySaveBlock > 0)) {
+		temp_history_save();
+	}
+
+	temp_history_bind_sensors();
+
+	if (!file_sys_exist(path)) {
+		return;
+	}
+
+	file = file_sys_open(path, "r");
+	if (!file) {
+		log_error("Unable to open %s", TEMP_HISTORY_FILE_PATH);
+		return;
+	}
+
+	if ((file.read((uint8_t *) &magic, sizeof(magic)) != sizeof(magic))
+	    || (magic != TEMP_HISTORY_FILE_MAGIC)
+	    || (file.read(header, sizeof(header)) != sizeof(header))
+	    || (header[0] != TEMP_HISTORY_FILE_VERSION)) {
+		log_warn("%s is not a valid history", TEMP_HISTORY_FILE_PATH);
+		file.close();
+		return;
+	}
+
+	for (uint8_t i = 0; i < header[1]; i++) {
+		DeviceAddress                  rom;
+		struct temp_history_sensor_t * pSensor;
+
+		if (file.read(rom, sizeof(rom)) != sizeof(rom)) {
+			break;
+		}
+		// Family code is never 0, such a ROM is a history without sensor
+		pSensor = (rom[0] != 0) ? temp_history_find(rom) : NULL;
+
+		for (uint8_t level = 0; level < TEMP_HISTORY_LEVEL_COUNT; level++) {
+			uint16_t size;
+
+			if ((file.read((uint8_t *) &size, sizeof(size)) != sizeof(size))
+			    || (size > sizeof(historyBuffer))
+			    || (file.read(historyBuffer, size) != size)) {
+				log_warn("%s is truncated", TEMP_HISTORY_FILE_PATH);
+				file.close();
+				return;
+			}
+
+			if ((pSensor != NULL) && (temp_history_decode(&pSensor->levels[level], historyBuffer, size) != 0)) {
+				log_warn("Sensor history level %d is corrupted", level);
+			}
+		}
+	}
+
+	file.close();
+
+	// Mark the time the board was off
+	for (uint8_t i = 0; i < TEMP_HISTORY_SENSOR_COUNT; i++) {
+		if (historySensors[i].levels[TEMP_HISTORY_LEVEL_RAW].count > 0) {
+			temp_history_push(&historySensors[i], TEMP_HISTORY_LEVEL_RAW, TEMP_HISTORY_NO_VALUE);
+		}
+	}
+
+	log_info("Temperature history restored");
+}
+
+/**
+ * @brief Open the file and write its header, the levels are written by
+ * temp_history_save_block()
+ * @details A save in progress starts again
+ *
+ * @return 0: OK, -1: Error
+ */
+static int temp_history_save_start(void)
+{
+	String   path  = TEMP_HISTORY_FILE_PATH;
+	uint32_t magic = TEMP_HISTORY_FILE_MAGIC;
+	uint8_t  header[2];
+
+	if (historySaveBlock > 0) {
+		historyFile.close();
+		historySaveBlock = 0;
+	}
+
+	historyFile = file_sys_open(path, "w");
+	if (!historyFile) {
+		log_error("Unable to open %s", TEMP_HISTORY_FILE_PATH);
+		return -1;
+	}
+
+	header[0] = TEMP_HISTORY_FILE_VERSION;
+	header[1] = TEMP_HISTORY_SENSOR_COUNT;
+	historyFile.write((uint8_t *) &magic, sizeof(magic));
+	historyFile.write(header, sizeof(header));
+
+	// Samples added from now are for the next save
+	historyIsDirty   = false;
+	historySaveBlock = 1;
+
+	return 0;
+}
+
+/**
+ * @brief Write the next level of a save in progress, the file is closed after the last one
+ */
+static void temp_history_save_block(void)
+{
+	uint8_t  sensorIndex = (historySaveBlock - 1) / TEMP_HISTORY_LEVEL_COUNT;
+	uint8_t  level       = (historySaveBlock - 1) % TEMP_HISTORY_LEVEL_COUNT;
+	uint16_t size        = temp_history_encode(sensorIndex, level, historyBuffer, sizeof(historyBuffer));
+
+	if (level == 0) {
+		historyFile.write(historySensors[sensorIndex].rom, sizeof(DeviceAddress));
+	}
+	historyFile.write((uint8_t *) &size, sizeof(size));
+	historyFile.write(historyBuffer, size);
+
+	if (historySaveBlock < (TEMP_HISTORY_SENSOR_COUNT * TEMP_HISTORY_LEVEL_COUNT)) {
+		historySaveBlock++;
+	} else {
+		historyFile.close();
+		historySaveBlock = 0;
+	}
+}
+
+/**
+ * @brief Write the histories in the file system at once
+ * @details Samples that are not yet aggregated into the next level are not saved
+ *
+ * @return 0: OK, -1: Error
+ */
+int temp_history_save(void)
+{
+	if (temp_history_save_start() != 0) {
+		return -1;
+	}
+
+	while (historySaveBlock > 0) {
+		temp_history_save_block();
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Save the histories periodically
+ * @details One level is written per call, so the flash
+ * never holds the loop for a whole file
+ */
+void temp_history_main(void)
+{
+	if (historySaveBlock > 0) {
+		temp_history_save_block();
+		return;
+	}
+
+	if (tick < historyNextSaveTick) {
+		return;
+	}
+	historyNextSaveTick = tick + TEMP_HISTORY_SAVE_PERIOD_MS;
+
+	if (historyIsDirty) {
+		temp_history_save_start();
+	}
+}
+
+/**
+ * @brief Add a measure to the history of a sensor
+ * @note To be called once per TEMP_POLLING_PERIOD_MS, aggregation counts samples
+ *
+ * @param sensorIndex Index of the sensor
+ * @param value In 1/100 °C or TEMP_HISTORY_NO_VALUE if the measure failed
+ */
+void temp_history_add(uint8_t sensorIndex, int16_t value)
+{
+	if (sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) {
+		return;
+	}
+
+	temp_history_push(&historySensors[sensorIndex], TEMP_HISTORY_LEVEL_RAW, value);
+	historyIsDirty = true;
+}
+
+/**
+ * @brief Get the time between two samples of a level
+ *
+ * @param level One of temp_history_level_e
+ * @return Period in ms, 0 for an unknown level
+ */
+uint32_t temp_history_get_period(uint8_t level)
+{
+	switch (level) {
+	case TEMP_HISTORY_LEVEL_RAW:
+		return TEMP_POLLING_PERIOD_MS;
+	case TEMP_HISTORY_LEVEL_MEDIUM:
+		return TEMP_HISTORY_MEDIUM_PERIOD_MS;
+	case TEMP_HISTORY_LEVEL_LONG:
+		return TEMP_HISTORY_LONG_PERIOD_MS;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Copy the newest samples of a level
+ *
+ * @param sensorIndex Index of the sensor
+ * @param level One of temp_history_level_e
+ * @param samples Filled with values in 1/100 °C or TEMP_HISTORY_NO_VALUE, oldest first
+ * @param maxCount Size of samples
+ * @return Number of samples copied
+ */
+uint8_t temp_history_get(uint8_t sensorIndex, uint8_t level, int16_t * samples, uint8_t maxCount)
+{
+	const struct temp_history_ring_t * pRing;
+	uint8_t                            count, index;
+
+	if ((sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) || (level >= TEMP_HISTORY_LEVEL_COUNT)) {
+		return 0;
+	}
+
+	pRing = &historySensors[sensorIndex].levels[level];
+	count = (pRing->count < maxCount) ? pRing->count : maxCount;
+	index = (pRing->head + pRing->size - count) % pRing->size;
+
+	for (uint8_t i = 0; i < count; i++) {
+		samples[i] = pRing->samples[index];
+		index      = (index + 1) % pRing->size;
+	}
+
+	return count;
+}
+
+/**
+ * @brief Encode a level into a compact block
+ * @details A varint with the number of samples, then for each sample,
+ * oldest first, the zigzag varint of its difference with the previous one.
+ * The first one is relative to 0. Slow changes take a byte per sample.
+ *
+ * @param sensorIndex Index of the sensor
+ * @param level One of temp_history_level_e
+ * @param buffer Filled with the block
+ * @param size Size of buffer, see TEMP_HISTORY_ENCODED_SIZE()
+ * @return Size of the block, 0 on error
+ */
+uint16_t temp_history_encode(uint8_t sensorIndex, uint8_t level, uint8_t * buffer, uint16_t size)
+{
+	const struct temp_history_ring_t * pRing;
+	uint16_t                           offset   = 0;
+	int32_t                            previous = 0;
+	uint8_t                            index;
+
+	if ((sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) || (level >= TEMP_HISTORY_LEVEL_COUNT)) {
+		return 0;
+	}
+
+	pRing = &historySensors[sensorIndex].levels[level];
+	if (size < TEMP_HISTORY_ENCODED_SIZE(pRing->count)) {
+		return 0;
+	}
+
+	offset += temp_history_write_varint(buffer, pRing->count);
+	index = (pRing->head + pRing->size - pRing->count) % pRing->size;
+
+	for (uint8_t i = 0; i < pRing->count; i++) {
+		int32_t delta = pRing->samples[index] - previous;
+
+		offset += temp_history_write_varint(&buffer[offset], ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31));
+		previous = pRing->samples[index];
+		index    = (index + 1) % pRing->size;
+	}
+
+	return offset;
+}
+
+/**
+ * @brief Compute statistics on the newest samples of a level
+ *
+ * @param sensorIndex Index of the sensor
+ * @param level One of temp_history_level_e
+ * @param lastCount Number of samples to look at
+ * @param pStats Filled with the result
+ * @return 0: OK, -1: No valid sample
+ */
+int temp_history_get_stats(uint8_t sensorIndex, uint8_t level, uint8_t lastCount, struct temp_history_stats_t * pStats)
+{
+	const struct temp_history_ring_t * pRing;
+	int16_t                            first = 0, last = 0;
+	uint8_t                            firstIndex = 0, lastIndex = 0;
+	int32_t                            sum        = 0;
+	uint8_t                            count, index;
+
+	pStats->count = 0;
+	pStats->min   = INT16_MAX;
+	pStats->max   = INT16_MIN;
+	pStats->mean  = 0;
+	pStats->trend = 0;
+
+	if ((sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) || (level >= TEMP_HISTORY_LEVEL_COUNT)) {
+		return -1;
+	}
+
+	pRing = &historySensors[sensorIndex].levels[level];
+	count = (pRing->count < lastCount) ? pRing->count : lastCount;
+	index = (pRing->head + pRing->size - count) % pRing->size;
+
+	for (uint8_t i = 0; i < count; i++, index = (index + 1) % pRing->size) {
+		int16_t value = pRing->samples[index];
+
+		if (value == TEMP_HISTORY_NO_VALUE) {
+			continue;
+		}
+
+		if (pStats->count == 0) {
+			first      = value;
+			firstIndex = i;
+		}
+		last      = value;
+		lastIndex = i;
+
+		if (value < pStats->min) {
+			pStats->min = value;
+		}
+		if (value > pStats->max) {
+			pStats->max = value;
+		}
+		sum += value;
+		pStats->count++;
+	}
+
+	if (pStats->count == 0) {
+		return -1;
+	}
+
+	pStats->mean = (int16_t) (sum / pStats->count);
+	if (lastIndex > firstIndex) {
+		// Samples are evenly spaced by the period of the level
+		pStats->trend = (int32_t) (((int64_t) (last - first) * (60 * 60 * 1000)) / ((int64_t) (lastIndex - firstIndex) * temp_history_get_period(level)));
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Write a level as CSV
+ * @details One "minutes ago;degrees" line per sample, newest last.
+ * Degrees are empty when the sample is missing.
+ *
+ * @param sensorIndex Index of the sensor
+ * @param level One of temp_history_level_e
+ * @param eol End of line, "\n" or "\n\r" for terminals
+ * @return The CSV text, empty on error
+ */
+String temp_history_to_csv(uint8_t sensorIndex, uint8_t level, const char * eol)
+{
+	const struct temp_history_ring_t * pRing;
+	String                             csv;
+	uint32_t                           periodMin;
+	uint8_t                            index;
+
+	if ((sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) || (level >= TEMP_HISTORY_LEVEL_COUNT)) {
+		return csv;
+	}
+
+	pRing     = &historySensors[sensorIndex].levels[level];
+	periodMin = temp_history_get_period(level) / (60 * 1000);
+	index     = (pRing->head + pRing->size - pRing->count) % pRing->size;
+
+	// About 12 bytes per line
+	csv.reserve(12 * pRing->count);
+
+	for (uint8_t i = pRing->count; i > 0; i--, index = (index + 1) % pRing->size) {
+		csv += String((i - 1) * periodMin) + ";";
+		if (pRing->samples[index] != TEMP_HISTORY_NO_VALUE) {
+			csv += String(pRing->samples[index] / 100.0);
+		}
+		csv += eol;
+	}
+
+	return csv;
+}
+
+/**
+ * @brief Get a level from its name
+ *
+ * @param str "raw", "5min" or "hour"
+ * @return One of temp_history_level_e or -1 if unknown
+ */
+int temp_history_parse_level(const char * str)
+{
+	for (uint8_t level = 0; level < TEMP_HISTORY_LEVEL_COUNT; level++) {
+		if (strcmp(str, historyLevelNames[level]) == 0) {
+			return level;
+		}
+	}
+
+	return -1;
+}
+
+#endif
@@ -0,0 +1,61 @@
+/**
+  * @file   temp_history.hpp
+  * @brief  Keep the past values of temperature sensors
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef TEMP_TEMP_HISTORY_HPP
+#define TEMP_TEMP_HISTORY_HPP
+
+#include "global.hpp"
+
+#ifdef MODULE_TEMPERATURE
+
+#ifndef TEMP_HISTORY_SENSOR_COUNT
+#define TEMP_HISTORY_SENSOR_COUNT 2 /**< History is kept for the first sensors only */
+#endif
+
+#define TEMP_HISTORY_RAW_COUNT        60                    /**< One sample per measure (TEMP_POLLING_PERIOD_MS) */
+#define TEMP_HISTORY_MEDIUM_PERIOD_MS (5 * 60 * 1000)       /**< Mean of the raw samples over this period */
+#define TEMP_HISTORY_MEDIUM_COUNT     96                    /**< 8 hours */
+#define TEMP_HISTORY_LONG_PERIOD_MS   (60 * 60 * 1000)      /**< Mean of the medium samples over this period */
+#define TEMP_HISTORY_LONG_COUNT       72                    /**< 3 days */
+#define TEMP_HISTORY_SAVE_PERIOD_MS   (60 * 60 * 1000)      /**< Time between two saves in the file system */
+#define TEMP_HISTORY_FILE_PATH        "/temp_history.bin"
+#define TEMP_HISTORY_NO_VALUE         INT16_MIN             /**< Sensor was faulty, or the board was off */
+#define TEMP_HISTORY_LARGEST_COUNT    TEMP_HISTORY_MEDIUM_COUNT /**< Size of the biggest level, for buffers */
+
+/** Worst case of temp_history_encode(): count, then 3 bytes per sample */
+#define TEMP_HISTORY_ENCODED_SIZE(count) (2 + 3 * (count))
+
+enum temp_history_level_e {
+	TEMP_HISTORY_LEVEL_RAW = 0,
+	TEMP_HISTORY_LEVEL_MEDIUM,
+	TEMP_HISTORY_LEVEL_LONG,
+	TEMP_HISTORY_LEVEL_COUNT
+};
+
+/** Computed on the last samples of a level, in 1/100 °C */
+struct temp_history_stats_t {
+	uint8_t count; /**< Valid samples, other fields are meaningless when 0 */
+	int16_t min;
+	int16_t max;
+	int16_t mean;
+	int32_t trend; /**< Per hour, between the first and the last valid samples */
+};
+
+int      temp_history_init(void);
+void     temp_history_main(void);
+void     temp_history_load(void);
+int      temp_history_save(void);
+void     temp_history_add(uint8_t sensorIndex, int16_t value);
+uint32_t temp_history_get_period(uint8_t level);
+uint8_t  temp_history_get(uint8_t sensorIndex, uint8_t level, int16_t * samples, uint8_t maxCount);
+uint16_t temp_history_encode(uint8_t sensorIndex, uint8_t level, uint8_t * buffer, uint16_t size);
+int      temp_history_get_stats(uint8_t sensorIndex, uint8_t level, uint8_t lastCount, struct temp_history_stats_t * pStats);
+String   temp_history_to_csv(uint8_t sensorIndex, uint8_t level, const char * eol);
+int      temp_history_parse_level(const char * str);
+
+#endif /* MODULE_TEMPERATURE */
+#endif /* TEMP_TEMP_HISTORY_HPP */
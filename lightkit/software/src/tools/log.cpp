@@ -15,7 +15,7 @@
 #include "cmd/term.hpp"
 #endif
 
-static char         message[128];
+static char         message[512];
 static char         argsString[512];
 static const char * level_names[] = {
 	"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
@@ -30,10 +30,10 @@ void log_raw(const char * fmt, ...)
 
 	/* Log to console */
 	va_start(args, fmt);
-	vsprintf(argsString, fmt, args);
+	vsnprintf(argsString, sizeof(argsString), fmt, args);
 	va_end(args);
 
-	sprintf(message, "%s", argsString);
+	snprintf(message, sizeof(message), "%s", argsString);
 
 #ifdef MODULE_TERM
 	term_print(message);
@@ -44,15 +44,20 @@ void log_raw(const char * fmt, ...)
 void log_log(int level, const char * file, int line, const char * fmt, ...)
 {
 	va_list args;
+	int     length;
 
 	/* Log to console */
 	va_start(args, fmt);
-	vsprintf(argsString, fmt, args);
+	vsnprintf(argsString, sizeof(argsString), fmt, args);
 	va_end(args);
 
-	sprintf(message, "%-5s [%s]:%d: %s\n", level_names[level], file, line, argsString);
+	length = snprintf(message, sizeof(message), "%-5s [%s]:%d: %s\n", level_names[level], file, line, argsString);
+	if (length >= (int) sizeof(message)) {
+		// A cut log still ends its line
+		message[sizeof(message) - 2] = '\n';
+	}
 
 #ifdef MODULE_TERM
-	term_print(message);
+	term_broadcast(message);
 #endif
 }
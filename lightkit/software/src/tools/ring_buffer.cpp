@@ -0,0 +1,136 @@
+/**
+  * @file   ring_buffer.cpp
+  * @brief  Byte ring buffer with overflow policy
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "ring_buffer.hpp"
+
+#include <string.h>
+
+/**
+ * @brief Init a ring buffer on a user provided storage
+ *
+ * @param pRb The ring buffer
+ * @param buffer Storage of the ring buffer
+ * @param size Size of the storage
+ * @param policy What to do on overflow
+ */
+void rb_init(ring_buffer_t * pRb, uint8_t * buffer, uint16_t size, rb_policy_e policy)
+{
+	memset(pRb, 0, sizeof(ring_buffer_t));
+	pRb->buffer = buffer;
+	pRb->size   = size;
+	pRb->policy = policy;
+}
+
+/**
+ * @brief Drop everything waiting in the buffer
+ * @note Counted as dropped bytes
+ *
+ * @param pRb The ring buffer
+ */
+void rb_clear(ring_buffer_t * pRb)
+{
+	pRb->bytesDropped += pRb->count;
+	pRb->head  = 0;
+	pRb->tail  = 0;
+	pRb->count = 0;
+}
+
+/**
+ * @brief Write data into the ring buffer
+ *
+ * @param pRb The ring buffer
+ * @param data Data to write
+ * @param len Length of data
+ * @return Number of bytes taken from data, always len with RB_DROP_OLDEST
+ */
+uint16_t rb_write(ring_buffer_t * pRb, const uint8_t * data, uint16_t len)
+{
+	uint16_t toWrite = len;
+	uint16_t chunk;
+
+	if (rb_free(pRb) < toWrite) {
+		if (pRb->policy == RB_BLOCK) {
+			toWrite = rb_free(pRb);
+			len     = toWrite;
+		} else {
+			// Only the end of data can fit
+			if (toWrite > pRb->size) {
+				pRb->bytesDropped += toWrite - pRb->size;
+				data += toWrite - pRb->size;
+				toWrite = pRb->size;
+			}
+			// Make room by forgetting the oldest bytes
+			chunk = toWrite - rb_free(pRb);
+			pRb->tail = (pRb->tail + chunk) % pRb->size;
+			pRb->count -= chunk;
+			pRb->bytesDropped += chunk;
+		}
+	}
+
+	pRb->count += toWrite;
+	pRb->bytesIn += toWrite;
+
+	// Copy in at most 2 parts because of the wrap around
+	while (toWrite > 0) {
+		chunk = pRb->size - pRb->head;
+		if (chunk > toWrite) {
+			chunk = toWrite;
+		}
+		memcpy(&pRb->buffer[pRb->head], data, chunk);
+		pRb->head = (pRb->head + chunk) % pRb->size;
+		data += chunk;
+		toWrite -= chunk;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Copy the oldest bytes without removing them
+ * @see rb_consume() to remove them once used
+ *
+ * @param pRb The ring buffer
+ * @param out Destination buffer
+ * @param maxLen Size of the destination buffer
+ * @return Number of bytes copied
+ */
+uint16_t rb_peek(ring_buffer_t * pRb, uint8_t * out, uint16_t maxLen)
+{
+	uint16_t len  = (maxLen < pRb->count) ? maxLen : pRb->count;
+	uint16_t tail = pRb->tail;
+	uint16_t remain;
+	uint16_t chunk;
+
+	for (remain = len; remain > 0; remain -= chunk) {
+		chunk = pRb->size - tail;
+		if (chunk > remain) {
+			chunk = remain;
+		}
+		memcpy(out, &pRb->buffer[tail], chunk);
+		tail = (tail + chunk) % pRb->size;
+		out += chunk;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Remove the oldest bytes from the ring buffer
+ *
+ * @param pRb The ring buffer
+ * @param len Number of bytes to remove
+ */
+void rb_consume(ring_buffer_t * pRb, uint16_t len)
+{
+	if (len > pRb->count) {
+		len = pRb->count;
+	}
+
+	pRb->tail = (pRb->tail + len) % pRb->size;
+	pRb->count -= len;
+	pRb->bytesOut += len;
+}
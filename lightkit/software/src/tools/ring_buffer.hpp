@@ -0,0 +1,42 @@
+/**
+  * @file   ring_buffer.hpp
+  * @brief  Byte ring buffer with overflow policy
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef TOOLS_RING_BUFFER_HPP
+#define TOOLS_RING_BUFFER_HPP
+
+#include <cstdint>
+
+/** What to do when writing into a full ring buffer */
+typedef enum
+{
+	RB_DROP_OLDEST = 0, /**< Overwrite the oldest bytes, write never fails */
+	RB_BLOCK            /**< Write what fits, the caller has to drain and retry */
+} rb_policy_e;
+
+typedef struct {
+	uint8_t *   buffer;       /**< Storage, provided by the user */
+	uint16_t    size;         /**< Size of the storage */
+	uint16_t    head;         /**< Index of the next byte to write */
+	uint16_t    tail;         /**< Index of the next byte to read */
+	uint16_t    count;        /**< Number of bytes waiting in the buffer */
+	rb_policy_e policy;       /**< Overflow policy */
+	uint32_t    bytesIn;      /**< Number of bytes written since init */
+	uint32_t    bytesOut;     /**< Number of bytes consumed since init */
+	uint32_t    bytesDropped; /**< Number of bytes lost on overflow */
+} ring_buffer_t;
+
+void     rb_init(ring_buffer_t * pRb, uint8_t * buffer, uint16_t size, rb_policy_e policy);
+void     rb_clear(ring_buffer_t * pRb);
+uint16_t rb_write(ring_buffer_t * pRb, const uint8_t * data, uint16_t len);
+uint16_t rb_peek(ring_buffer_t * pRb, uint8_t * out, uint16_t maxLen);
+void     rb_consume(ring_buffer_t * pRb, uint16_t len);
+
+#define rb_count(pRb)    ((pRb)->count)
+#define rb_free(pRb)     ((pRb)->size - (pRb)->count)
+#define rb_is_empty(pRb) ((pRb)->count == 0)
+
+#endif /* TOOLS_RING_BUFFER_HPP */
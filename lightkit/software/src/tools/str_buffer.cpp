@@ -0,0 +1,123 @@
+/**
+  * @file   str_buffer.cpp
+  * @brief  Build strings in a fixed buffer instead of the heap
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#include "str_buffer.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Cut the string at the end of the buffer
+ * @details A multi-byte UTF-8 character is not cut in the middle
+ *
+ * @param pSb The string buffer
+ */
+static void sb_truncate(str_buffer_t * pSb)
+{
+	uint16_t lead = pSb->size - 1;
+	uint8_t  c;
+	uint8_t  charLength;
+
+	// Find the first byte of the last character
+	while ((lead > 0) && (lead > (pSb->size - 5)) && ((pSb->buffer[lead - 1] & 0xC0) == 0x80)) {
+		lead--;
+	}
+
+	pSb->length = pSb->size - 1;
+	if (lead > 0) {
+		c          = pSb->buffer[lead - 1];
+		charLength = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+		if ((pSb->length - (lead - 1)) < charLength) {
+			// Last character is incomplete
+			pSb->length = lead - 1;
+		}
+	}
+	pSb->buffer[pSb->length] = '\0';
+	pSb->isTruncated         = true;
+}
+
+/**
+ * @brief Init a string buffer on a user provided storage
+ *
+ * @param pSb The string buffer
+ * @param buffer Storage of the string buffer
+ * @param size Size of the storage, with the '\0'
+ */
+void sb_init(str_buffer_t * pSb, char * buffer, uint16_t size)
+{
+	pSb->buffer = buffer;
+	pSb->size   = size;
+	sb_clear(pSb);
+}
+
+/**
+ * @brief Empty the string
+ *
+ * @param pSb The string buffer
+ */
+void sb_clear(str_buffer_t * pSb)
+{
+	pSb->length      = 0;
+	pSb->isTruncated = false;
+	pSb->buffer[0]   = '\0';
+}
+
+/**
+ * @brief Add a string at the end
+ *
+ * @param pSb The string buffer
+ * @param str The string to add
+ */
+void sb_append(str_buffer_t * pSb, const char * str)
+{
+	size_t length;
+
+	// Once cut, nothing is added: the string must not go on after the cut
+	if (pSb->isTruncated) {
+		return;
+	}
+
+	length = strlen(str);
+	if ((pSb->length + length) >= pSb->size) {
+		memcpy(&pSb->buffer[pSb->length], str, pSb->size - 1 - pSb->length);
+		sb_truncate(pSb);
+		return;
+	}
+
+	memcpy(&pSb->buffer[pSb->length], str, length + 1);
+	pSb->length += length;
+}
+
+/**
+ * @brief Add a formatted string at the end
+ *
+ * @param pSb The string buffer
+ * @param fmt printf like format
+ */
+void sb_printf(str_buffer_t * pSb, const char * fmt, ...)
+{
+	va_list args;
+	int     length;
+
+	if (pSb->isTruncated) {
+		return;
+	}
+
+	va_start(args, fmt);
+	length = vsnprintf(&pSb->buffer[pSb->length], pSb->size - pSb->length, fmt, args);
+	va_end(args);
+
+	if (length < 0) {
+		pSb->buffer[pSb->length] = '\0';
+		pSb->isTruncated         = true;
+	} else if ((pSb->length + length) >= pSb->size) {
+		sb_truncate(pSb);
+	} else {
+		pSb->length += length;
+	}
+}
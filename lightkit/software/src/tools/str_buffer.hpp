@@ -0,0 +1,28 @@
+/**
+  * @file   str_buffer.hpp
+  * @brief  Build strings in a fixed buffer instead of the heap
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef TOOLS_STR_BUFFER_HPP
+#define TOOLS_STR_BUFFER_HPP
+
+#include <cstdint>
+
+typedef struct {
+	char *   buffer;      /**< Storage, provided by the user */
+	uint16_t size;        /**< Size of the storage */
+	uint16_t length;      /**< Length of the string, without the '\0' */
+	bool     isTruncated; /**< Something did not fit, next appends are ignored */
+} str_buffer_t;
+
+void sb_init(str_buffer_t * pSb, char * buffer, uint16_t size);
+void sb_clear(str_buffer_t * pSb);
+void sb_append(str_buffer_t * pSb, const char * str);
+void sb_printf(str_buffer_t * pSb, const char * fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#define sb_str(pSb)    ((const char *) (pSb)->buffer)
+#define sb_length(pSb) ((pSb)->length)
+
+#endif /* TOOLS_STR_BUFFER_HPP */
@@ -21,6 +21,7 @@
 #include "io/inputs.hpp"
 #include "script/script.hpp"
 #include "stripled/stripled.hpp"
+#include "temp/temp_history.hpp"
 #include "web_server.hpp"
 #include "wifi/wifi.hpp"
 
@@ -498,6 +499,39 @@ static void handle_set_module_name(void)
 	handle_get_module_name();
 }
 
+#ifdef MODULE_TEMPERATURE
+/**
+ * Send the history of a sensor
+ * sensor: index of the sensor, level: raw, 5min or hour
+ * format: csv (default) or bin, see temp_history_encode()
+ */
+static void handle_get_temp_history(void)
+{
+	static uint8_t buffer[TEMP_HISTORY_ENCODED_SIZE(TEMP_HISTORY_LARGEST_COUNT)];
+	int32_t        sensorIndex, level;
+	uint16_t       size;
+
+	if (!server.hasArg("sensor") || !server.hasArg("level")) {
+		handle_bad_parameter();
+		return;
+	}
+
+	sensorIndex = server.arg("sensor").toInt();
+	level       = temp_history_parse_level(server.arg("level").c_str());
+	if ((sensorIndex < 0) || (sensorIndex >= TEMP_HISTORY_SENSOR_COUNT) || (level < 0)) {
+		handle_bad_parameter();
+		return;
+	}
+
+	if (server.arg("format") == "bin") {
+		size = temp_history_encode(sensorIndex, level, buffer, sizeof(buffer));
+		server.send_P(200, "application/octet-stream", (const char *) buffer, size);
+	} else {
+		server.send(200, "text/csv", temp_history_to_csv(sensorIndex, level, "\n"));
+	}
+}
+#endif
+
 int web_server_init(void)
 {
 	server.begin();
@@ -564,6 +598,11 @@ int web_server_init(void)
 	server.on("/get_module_name", HTTP_GET, []() {
 		handle_get_module_name();
 	});
+#ifdef MODULE_TEMPERATURE
+	server.on("/get_temp_history", HTTP_GET, []() {
+		handle_get_temp_history();
+	});
+#endif
 
 	// --- File management ---
 	server.onNotFound([]() {
@@ -8,6 +8,7 @@
 
 #include "wifi.hpp"
 #include "buzzer/buzzer.hpp"
+#include "event/event.hpp"
 #include "flash/flash.hpp"
 #include "ota/ota.hpp"
 #include "script/script.hpp"
@@ -470,6 +471,9 @@ void wifi_main(void)
 			}
 		} else if (wifiHandle->mode == MODE_CLIENT) {
 			if (WiFi.status() != WL_CONNECTED) {
+				if (_isset(STATUS_WIFI, STATUS_WIFI_IS_CO)) {
+					event_publish(EVENT_WIFI_STATE, 0, 0);
+				}
 				_unset(STATUS_WIFI, STATUS_WIFI_IS_CO);
 
 				/* If couldn't connect as client after some time, reboot in AP mode
@@ -488,6 +492,7 @@ void wifi_main(void)
 					wifi_print();
 					wifi_save_current_ip();
 					ota_configure_mdns();
+					event_publish(EVENT_WIFI_STATE, 0, 1);
 				}
 			}
 		}
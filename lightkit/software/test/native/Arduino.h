@@ -0,0 +1,499 @@
+/**
+  * @file   Arduino.h
+  * @brief  Arduino core for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Only the part of the core used by the firmware is here. Time does not
+ * follow the host clock: it moves when a test or a fake peripheral moves it,
+ * so a test can tell how long a call kept the CPU, bus transfers included.
+ */
+
+typedef uint8_t byte;
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+#define F(str) (str)
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT             0x00
+#define INPUT_PULLUP      0x02
+#define OUTPUT            0x01
+#define OUTPUT_OPEN_DRAIN 0x03
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define NOT_AN_INTERRUPT -1
+
+#define DEC 10
+#define HEX 16
+
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+
+#define FAKE_PIN_COUNT 40
+
+// ==================
+//  TIME
+// ==================
+
+inline uint64_t fakeMicros = 0; /**< Time since boot */
+
+static inline void fake_time_advance_us(uint32_t us)
+{
+	fakeMicros += us;
+}
+
+static inline unsigned long micros(void)
+{
+	return (uint32_t) fakeMicros;
+}
+
+static inline unsigned long millis(void)
+{
+	return (uint32_t) (fakeMicros / 1000);
+}
+
+static inline void delay(unsigned long ms)
+{
+	fake_time_advance_us(ms * 1000);
+}
+
+static inline void delayMicroseconds(unsigned int us)
+{
+	fake_time_advance_us(us);
+}
+
+static inline void yield(void)
+{
+}
+
+// ==================
+//  STRING
+// ==================
+
+class String {
+public:
+	String(void) {}
+	String(const char * str) : s(str ? str : "") {}
+	String(const std::string & str) : s(str) {}
+	explicit String(char c) : s(1, c) {}
+	String(int value, unsigned char base = DEC) { from_long(value, base); }
+	String(unsigned int value, unsigned char base = DEC) { from_ulong(value, base); }
+	String(long value, unsigned char base = DEC) { from_long(value, base); }
+	String(unsigned long value, unsigned char base = DEC) { from_ulong(value, base); }
+	String(float value, unsigned char decimals = 2) { from_double(value, decimals); }
+	String(double value, unsigned char decimals = 2) { from_double(value, decimals); }
+
+	const char * c_str(void) const { return s.c_str(); }
+	unsigned int length(void) const { return s.size(); }
+	bool         reserve(unsigned int size)
+	{
+		s.reserve(size);
+		return true;
+	}
+	void clear(void) { s.clear(); }
+
+	String & operator+=(const String & str)
+	{
+		s += str.s;
+		return *this;
+	}
+	String & operator+=(const char * str)
+	{
+		s += str;
+		return *this;
+	}
+	String & operator+=(char c)
+	{
+		s += c;
+		return *this;
+	}
+	String & operator+=(int value) { return *this += String(value); }
+	String & operator+=(unsigned int value) { return *this += String(value); }
+	String & operator+=(long value) { return *this += String(value); }
+	String & operator+=(unsigned long value) { return *this += String(value); }
+	String & operator+=(float value) { return *this += String(value); }
+	String & operator+=(double value) { return *this += String(value); }
+	bool     concat(const String & str)
+	{
+		s += str.s;
+		return true;
+	}
+
+	bool operator==(const String & str) const { return s == str.s; }
+	bool operator==(const char * str) const { return s == str; }
+	bool operator!=(const String & str) const { return s != str.s; }
+	bool operator!=(const char * str) const { return s != str; }
+	bool equals(const String & str) const { return s == str.s; }
+	bool equalsIgnoreCase(const String & str) const { return strcasecmp(s.c_str(), str.c_str()) == 0; }
+	bool startsWith(const String & str) const { return s.compare(0, str.s.size(), str.s) == 0; }
+	bool endsWith(const String & str) const { return (s.size() >= str.s.size()) && (s.compare(s.size() - str.s.size(), str.s.size(), str.s) == 0); }
+
+	char   operator[](unsigned int index) const { return (index < s.size()) ? s[index] : '\0'; }
+	char & operator[](unsigned int index) { return s[index]; }
+	char   charAt(unsigned int index) const { return (*this)[index]; }
+	int    indexOf(char c, unsigned int from = 0) const { return to_index(s.find(c, from)); }
+	int    indexOf(const String & str, unsigned int from = 0) const { return to_index(s.find(str.s, from)); }
+	int    lastIndexOf(char c) const { return to_index(s.rfind(c)); }
+	String substring(unsigned int from) const { return (from < s.size()) ? String(s.substr(from)) : String(); }
+	String substring(unsigned int from, unsigned int to) const { return (from < to) && (from < s.size()) ? String(s.substr(from, to - from)) : String(); }
+	void   replace(const String & from, const String & to)
+	{
+		size_t pos = 0;
+
+		while (!from.s.empty() && ((pos = s.find(from.s, pos)) != std::string::npos)) {
+			s.replace(pos, from.s.size(), to.s);
+			pos += to.s.size();
+		}
+	}
+	void trim(void)
+	{
+		size_t first = s.find_first_not_of(" \t\r\n");
+		size_t last  = s.find_last_not_of(" \t\r\n");
+
+		s = (first == std::string::npos) ? std::string() : s.substr(first, last - first + 1);
+	}
+	void toLowerCase(void)
+	{
+		for (char & c : s) {
+			c = tolower(c);
+		}
+	}
+	void toUpperCase(void)
+	{
+		for (char & c : s) {
+			c = toupper(c);
+		}
+	}
+	long  toInt(void) const { return atol(s.c_str()); }
+	float toFloat(void) const { return atof(s.c_str()); }
+
+	friend String operator+(const String & a, const String & b) { return String(a.s + b.s); }
+	friend String operator+(const String & a, const char * b) { return String(a.s + b); }
+	friend String operator+(const char * a, const String & b) { return String(a + b.s); }
+
+private:
+	std::string s;
+
+	/** A String of the board keeps only a few bytes inline, this one always takes a heap block */
+	std::vector<char> heapBlock = std::vector<char>(1);
+
+	static int to_index(size_t pos) { return (pos == std::string::npos) ? -1 : (int) pos; }
+	void       from_long(long value, unsigned char base)
+	{
+		if (base == DEC) {
+			s = std::to_string(value);
+		} else {
+			from_ulong((unsigned long) value, base);
+		}
+	}
+	void from_ulong(unsigned long value, unsigned char base)
+	{
+		char buffer[8 * sizeof(long) + 1];
+
+		snprintf(buffer, sizeof(buffer), (base == HEX) ? "%lx" : "%lu", value);
+		s = buffer;
+	}
+	void from_double(double value, unsigned char decimals)
+	{
+		char buffer[48];
+
+		snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+		s = buffer;
+	}
+};
+
+// ==================
+//  SERIAL
+// ==================
+
+class Print {
+public:
+	virtual ~Print(void) {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t * buffer, size_t size)
+	{
+		for (size_t i = 0; i < size; i++) {
+			write(buffer[i]);
+		}
+		return size;
+	}
+	size_t write(const char * str) { return write((const uint8_t *) str, strlen(str)); }
+	size_t print(const char * str) { return write(str); }
+	size_t print(const String & str) { return write(str.c_str()); }
+	size_t print(int value) { return print(String(value)); }
+	size_t println(const char * str = "") { return print(str) + print("\r\n"); }
+	size_t println(const String & str) { return println(str.c_str()); }
+	size_t printf(const char * fmt, ...)
+	{
+		char    buffer[256];
+		va_list args;
+
+		va_start(args, fmt);
+		vsnprintf(buffer, sizeof(buffer), fmt, args);
+		va_end(args);
+		return print(buffer);
+	}
+	virtual int  availableForWrite(void) { return 128; }
+	virtual void flush(void) {}
+};
+
+class Stream : public Print {
+public:
+	virtual int available(void) = 0;
+	virtual int read(void)      = 0;
+	virtual int peek(void) { return -1; }
+	void        setTimeout(unsigned long) {}
+	size_t      readBytes(uint8_t * buffer, size_t length)
+	{
+		size_t count = 0;
+		int    c;
+
+		while ((count < length) && ((c = read()) >= 0)) {
+			buffer[count++] = (uint8_t) c;
+		}
+		return count;
+	}
+	size_t readBytes(char * buffer, size_t length) { return readBytes((uint8_t *) buffer, length); }
+	String readStringUntil(char terminator)
+	{
+		String str;
+		int    c;
+
+		while (((c = read()) >= 0) && (c != terminator)) {
+			str += (char) c;
+		}
+		return str;
+	}
+};
+
+/** Output is kept for the tests, input is what they push in rx */
+class HardwareSerial : public Stream {
+public:
+	std::string tx;
+	std::string rx;
+
+	void begin(unsigned long) {}
+	using Print::write;
+	size_t write(uint8_t c) override
+	{
+		tx += (char) c;
+		return 1;
+	}
+	int available(void) override { return rx.size(); }
+	int read(void) override
+	{
+		int c;
+
+		if (rx.empty()) {
+			return -1;
+		}
+		c = (uint8_t) rx[0];
+		rx.erase(0, 1);
+		return c;
+	}
+};
+
+inline HardwareSerial Serial;
+
+// ==================
+//  SYSTEM
+// ==================
+
+class EspClass {
+public:
+	void     restart(void) {}
+	uint32_t getFreeHeap(void) { return 40000; }
+	uint32_t getMaxFreeBlockSize(void) { return 30000; }
+	uint8_t  getHeapFragmentation(void) { return 0; }
+	uint32_t getFreeSketchSpace(void) { return 1000000; }
+	uint32_t getChipId(void) { return 0x123456; }
+	uint32_t getCycleCount(void) { return (uint32_t) (fakeMicros * 80); }
+};
+
+inline EspClass ESP;
+
+#define microsecondsToClockCycles(us) ((us) * 80)
+#define clockCyclesToMicroseconds(cy) ((cy) / 80)
+
+// ==================
+//  GPIO
+// ==================
+
+#include "esp8266_peri.h"
+
+/** Masks the interrupts up to a level, like the core: 15 masks them all */
+static inline uint32_t xt_rsil(uint32_t level)
+{
+	uint32_t previous = fakeInterruptLevel;
+
+	fakeInterruptLevel = level;
+	return previous;
+}
+
+/** Restores the level returned by xt_rsil() */
+static inline void xt_wsr_ps(uint32_t state)
+{
+	fakeInterruptLevel = state;
+}
+
+static inline void noInterrupts(void)
+{
+	xt_rsil(15);
+}
+
+static inline void interrupts(void)
+{
+	xt_rsil(0);
+}
+
+inline uint8_t fakePinMode[FAKE_PIN_COUNT];
+inline void (*fakePinIsr[FAKE_PIN_COUNT])(void);
+inline void (*fakePinIsrWithArg[FAKE_PIN_COUNT])(void *);
+inline void *   fakePinIsrArg[FAKE_PIN_COUNT];
+inline uint8_t  fakePinIsrMode[FAKE_PIN_COUNT];
+inline uint32_t fakeDigitalCallCount = 0; /**< Calls of digitalWrite() and digitalRead() */
+inline void (*fakeDigitalWriteHook)(uint8_t pin, uint8_t value) = NULL; /**< Lets a fake peripheral see the pins move */
+
+static inline void pinMode(uint8_t pin, uint8_t mode)
+{
+	if (pin < FAKE_PIN_COUNT) {
+		fakePinMode[pin] = mode;
+	}
+	if (pin < 16) {
+		if ((mode == OUTPUT) || (mode == OUTPUT_OPEN_DRAIN)) {
+			GPE |= 1UL << pin;
+		} else {
+			GPE &= ~(1UL << pin);
+		}
+		if (mode == OUTPUT_OPEN_DRAIN) {
+			fakeGpioOpenDrain |= 1UL << pin;
+		} else {
+			fakeGpioOpenDrain &= ~(1UL << pin);
+		}
+	}
+}
+
+/** Same path as the core: check the pin, find its register, then write it */
+static inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+	fakeDigitalCallCount++;
+	if (fakeDigitalWriteHook != NULL) {
+		fakeDigitalWriteHook(pin, value);
+	}
+	if (pin < 16) {
+		if (value) {
+			GPOS = 1UL << pin;
+		} else {
+			GPOC = 1UL << pin;
+		}
+	} else if (pin == 16) {
+		if (value) {
+			GP16O |= 1;
+		} else {
+			GP16O &= ~1;
+		}
+	}
+}
+
+static inline int digitalRead(uint8_t pin)
+{
+	fakeDigitalCallCount++;
+	if (pin < 16) {
+		return (GPI & (1UL << pin)) ? HIGH : LOW;
+	} else if (pin == 16) {
+		return (GP16I & 0x01) ? HIGH : LOW;
+	}
+	return LOW;
+}
+
+static inline int digitalPinToInterrupt(uint8_t pin)
+{
+	return (pin < 16) ? pin : NOT_AN_INTERRUPT;
+}
+
+static inline void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode)
+{
+	if (interrupt < FAKE_PIN_COUNT) {
+		fakePinIsr[interrupt]     = isr;
+		fakePinIsrMode[interrupt] = mode;
+	}
+}
+
+static inline void attachInterruptArg(uint8_t interrupt, void (*isr)(void *), void * arg, int mode)
+{
+	if (interrupt < FAKE_PIN_COUNT) {
+		fakePinIsrWithArg[interrupt] = isr;
+		fakePinIsrArg[interrupt]     = arg;
+		fakePinIsrMode[interrupt]    = mode;
+	}
+}
+
+static inline void detachInterrupt(uint8_t interrupt)
+{
+	if (interrupt < FAKE_PIN_COUNT) {
+		fakePinIsr[interrupt]        = NULL;
+		fakePinIsrWithArg[interrupt] = NULL;
+	}
+}
+
+/**
+ * @brief Run the interrupt attached to a pin, as if its edge came
+ *
+ * @param pin The GPIO
+ */
+static inline void fake_pin_interrupt(uint8_t pin)
+{
+	if (fakePinIsr[pin] != NULL) {
+		fakePinIsr[pin]();
+	}
+	if (fakePinIsrWithArg[pin] != NULL) {
+		fakePinIsrWithArg[pin](fakePinIsrArg[pin]);
+	}
+}
+
+static inline int analogRead(uint8_t)
+{
+	return 0;
+}
+
+static inline void analogWrite(uint8_t, int)
+{
+}
+
+static inline void tone(uint8_t, unsigned int, unsigned long = 0)
+{
+}
+
+static inline void noTone(uint8_t)
+{
+}
+
+#endif /* NATIVE_ARDUINO_H */
@@ -0,0 +1,18 @@
+/**
+  * @file   DallasTemperature.h
+  * @brief  Types of the DallasTemperature library for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_DALLAS_TEMPERATURE_H
+#define NATIVE_DALLAS_TEMPERATURE_H
+
+#include <cstdint>
+
+// The temperature module talks to the sensors itself, only these are used
+typedef uint8_t DeviceAddress[8];
+
+#define DEVICE_DISCONNECTED_C -127
+
+#endif /* NATIVE_DALLAS_TEMPERATURE_H */
@@ -0,0 +1,211 @@
+/**
+  * @file   ESP8266WiFi.h
+  * @brief  Fake TCP client connected to a stand-in server of the test, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_ESP8266WIFI_H
+#define NATIVE_ESP8266WIFI_H
+
+#include <Arduino.h>
+#include <deque>
+
+/**
+ * No socket: the test gives a FakeTcpPeer that plays the server in the
+ * same process. What the board writes is handed to the peer right away,
+ * what the peer sends is received after the delay it chooses, on the
+ * fake clock. Without a peer, nobody listens and connect() times out.
+ */
+
+/** A TCP connection, seen from both ends */
+struct fake_tcp_conn_t {
+	std::string host;
+	uint16_t    port;
+	std::string toPeer;    /**< Written by the board, the peer takes what it uses */
+	std::string toBoard;   /**< Written by the peer, not read by the board yet */
+	uint64_t    readyUs;   /**< toBoard is only received from this time */
+	bool        isClosed;  /**< Closed by the peer */
+	bool        isStopped; /**< Closed by the board */
+};
+
+/** Stand-in of a server */
+class FakeTcpPeer {
+public:
+	virtual ~FakeTcpPeer(void) {}
+
+	/** @return false to refuse the connection */
+	virtual bool on_connect(struct fake_tcp_conn_t * pConn)
+	{
+		(void) pConn;
+		return true;
+	}
+
+	/** The board wrote in pConn->toPeer */
+	virtual void on_receive(struct fake_tcp_conn_t * pConn) = 0;
+
+	/** The board closed the connection */
+	virtual void on_stop(struct fake_tcp_conn_t * pConn) { (void) pConn; }
+};
+
+inline std::deque<struct fake_tcp_conn_t> fakeTcpConns;                  /**< Every connection of the test, never moved */
+inline FakeTcpPeer *                      fakeTcpPeer         = NULL;    /**< Where connect() goes, NULL: nobody listens */
+inline uint32_t                           fakeTcpConnectCount = 0;       /**< Calls of connect() */
+inline uint32_t                           fakeTcpConnectUs    = 500;     /**< Time of a connection on the LAN */
+inline uint32_t                           fakeTcpTimeoutUs    = 5000000; /**< Time of a connection to nobody, set by setTimeout() */
+
+/**
+ * @brief Send data to the board
+ *
+ * @param pConn Connection
+ * @param data What the peer sends
+ * @param delayUs Time before the board receives it
+ */
+static inline void fake_tcp_send(struct fake_tcp_conn_t * pConn, const std::string & data, uint32_t delayUs = 0)
+{
+	if (pConn->toBoard.empty() || (pConn->readyUs < fakeMicros + delayUs)) {
+		pConn->readyUs = fakeMicros + delayUs;
+	}
+	pConn->toBoard += data;
+}
+
+/**
+ * @brief Forget every connection, call it once the clients are stopped
+ */
+static inline void fake_tcp_clear(void)
+{
+	fakeTcpConns.clear();
+	fakeTcpPeer         = NULL;
+	fakeTcpConnectCount = 0;
+}
+
+class WiFiClient : public Stream {
+public:
+	virtual ~WiFiClient(void) {}
+
+	void setTimeout(unsigned long timeoutMs) { fakeTcpTimeoutUs = timeoutMs * 1000; }
+	void setNoDelay(bool) {}
+
+	int connect(const char * host, uint16_t port)
+	{
+		struct fake_tcp_conn_t conn = {};
+
+		stop();
+		fakeTcpConnectCount++;
+		conn.host = host;
+		conn.port = port;
+		fakeTcpConns.push_back(conn);
+
+		if ((fakeTcpPeer == NULL) || !fakeTcpPeer->on_connect(&fakeTcpConns.back())) {
+			// Refused is seen at once, nobody only at the timeout
+			fake_time_advance_us((fakeTcpPeer == NULL) ? fakeTcpTimeoutUs : fakeTcpConnectUs);
+			fakeTcpConns.back().isStopped = true;
+			return 0;
+		}
+
+		fake_time_advance_us(fakeTcpConnectUs);
+		pConn = &fakeTcpConns.back();
+		return 1;
+	}
+
+	uint8_t connected(void)
+	{
+		return (pConn != NULL) && (!pConn->isClosed || (available() > 0));
+	}
+
+	int available(void) override
+	{
+		if ((pConn == NULL) || (fakeMicros < pConn->readyUs)) {
+			return 0;
+		}
+		return (int) pConn->toBoard.size();
+	}
+
+	int read(void) override
+	{
+		int c;
+
+		if (available() <= 0) {
+			return -1;
+		}
+		c = (uint8_t) pConn->toBoard[0];
+		pConn->toBoard.erase(0, 1);
+		return c;
+	}
+
+	int peek(void) override
+	{
+		return (available() > 0) ? (uint8_t) pConn->toBoard[0] : -1;
+	}
+
+	using Print::write;
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t * buffer, size_t size) override
+	{
+		if ((pConn == NULL) || pConn->isClosed) {
+			return 0;
+		}
+		pConn->toPeer.append((const char *) buffer, size);
+		if (fakeTcpPeer != NULL) {
+			fakeTcpPeer->on_receive(pConn);
+		}
+		return size;
+	}
+
+	void stop(void)
+	{
+		if (pConn == NULL) {
+			return;
+		}
+		pConn->isStopped = true;
+		if (fakeTcpPeer != NULL) {
+			fakeTcpPeer->on_stop(pConn);
+		}
+		pConn = NULL;
+	}
+
+	operator bool(void) { return connected(); }
+
+private:
+	struct fake_tcp_conn_t * pConn = NULL;
+};
+
+#define WL_CONNECTED 3
+
+class IPAddress {
+public:
+	IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : bytes{a, b, c, d} {}
+	uint8_t operator[](int index) const { return bytes[index]; }
+
+	/** First byte in the low bits, as on the board */
+	operator uint32_t(void) const { return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24); }
+
+	bool fromString(const char * str)
+	{
+		unsigned int a, b, c, d;
+		char         end;
+
+		if ((sscanf(str, "%u.%u.%u.%u%c", &a, &b, &c, &d, &end) != 4) || (a > 255) || (b > 255) || (c > 255) || (d > 255)) {
+			return false;
+		}
+		bytes[0] = a;
+		bytes[1] = b;
+		bytes[2] = c;
+		bytes[3] = d;
+		return true;
+	}
+
+private:
+	uint8_t bytes[4];
+};
+
+class WiFiClass {
+public:
+	int       status(void) { return WL_CONNECTED; }
+	String    macAddress(void) { return String("5C:CF:7F:12:34:56"); }
+	IPAddress localIP(void) { return IPAddress(192, 168, 0, 51); }
+};
+
+inline WiFiClass WiFi;
+
+#endif /* NATIVE_ESP8266WIFI_H */
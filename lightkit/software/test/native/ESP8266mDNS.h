@@ -0,0 +1,13 @@
+/**
+  * @file   ESP8266mDNS.h
+  * @brief  Empty mDNS header, only ota.cpp uses the responder, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_ESP8266MDNS_H
+#define NATIVE_ESP8266MDNS_H
+
+#include <Arduino.h>
+
+#endif /* NATIVE_ESP8266MDNS_H */
@@ -0,0 +1,83 @@
+/**
+  * @file   FS.h
+  * @brief  Fake file system in memory, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <Arduino.h>
+#include <map>
+
+inline std::map<std::string, std::string> fakeFiles;                  /**< Content of each file, by path */
+inline uint32_t                           fakeFileOpenCount      = 0; /**< Calls of open() */
+inline uint32_t                           fakeFileWriteUsPerByte = 0; /**< Time the flash takes to write, 0: none */
+
+class File : public Stream {
+public:
+	File(void) {}
+	File(std::string * pData) : pData(pData) {}
+
+	operator bool(void) const { return pData != NULL; }
+	void   close(void) { pData = NULL; }
+	size_t size(void) { return (pData != NULL) ? pData->size() : 0; }
+	bool   seek(uint32_t offset)
+	{
+		position = offset;
+		return (pData != NULL) && (offset <= pData->size());
+	}
+
+	int available(void) override { return (pData != NULL) ? (int) (pData->size() - position) : 0; }
+	int read(void) override { return (available() > 0) ? (uint8_t) (*pData)[position++] : -1; }
+	int peek(void) override { return (available() > 0) ? (uint8_t) (*pData)[position] : -1; }
+	size_t read(uint8_t * buffer, size_t size)
+	{
+		size_t n = 0;
+
+		while ((n < size) && (available() > 0)) {
+			buffer[n++] = (uint8_t) read();
+		}
+		return n;
+	}
+
+	using Print::write;
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t * buffer, size_t size) override
+	{
+		if (pData == NULL) {
+			return 0;
+		}
+		fake_time_advance_us(size * fakeFileWriteUsPerByte);
+		pData->append((const char *) buffer, size);
+		return size;
+	}
+
+private:
+	std::string * pData    = NULL;
+	size_t        position = 0;
+};
+
+class FS {
+public:
+	bool begin(void) { return true; }
+	void end(void) {}
+	bool exists(const String & path) { return fakeFiles.count(path.c_str()) > 0; }
+	bool remove(const String & path) { return fakeFiles.erase(path.c_str()) > 0; }
+
+	/** "r", or "w" that empties the file, or "a" */
+	File open(const String & path, const char * mode)
+	{
+		fakeFileOpenCount++;
+		if ((mode[0] == 'r') && !exists(path)) {
+			return File();
+		}
+		if (mode[0] == 'w') {
+			fakeFiles[path.c_str()].clear();
+		}
+		return File(&fakeFiles[path.c_str()]);
+	}
+};
+
+#endif /* NATIVE_FS_H */
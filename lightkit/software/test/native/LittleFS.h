@@ -0,0 +1,15 @@
+/**
+  * @file   LittleFS.h
+  * @brief  Fake LittleFS, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include <FS.h>
+
+inline FS LittleFS;
+
+#endif /* NATIVE_LITTLEFS_H */
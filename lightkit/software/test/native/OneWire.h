@@ -0,0 +1,311 @@
+/**
+  * @file   OneWire.h
+  * @brief  Fake OneWire bus with DS18B20 and DS18S20 sensors, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_ONEWIRE_H
+#define NATIVE_ONEWIRE_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * Sensors answer like the real ones: ROM search, match and skip ROM,
+ * conversion, scratchpad read and write, power supply read. Each bus
+ * operation takes its time at standard speed on the fake clock, and a
+ * conversion is only over after the time given by the datasheet.
+ */
+
+#define FAKE_ONEWIRE_RESET_US   960   /**< Reset pulse and presence window */
+#define FAKE_ONEWIRE_SLOT_US    70    /**< One bit, read or write */
+#define FAKE_ONEWIRE_DS18B20    0x28
+#define FAKE_ONEWIRE_DS18S20    0x10
+#define FAKE_ONEWIRE_POWER_ON_C 85.0f /**< In the scratchpad until the first conversion */
+#define FAKE_ONEWIRE_SCRATCHPAD 9
+
+struct fake_ds18x20_t {
+	uint8_t  rom[8];
+	float    celsius; /**< What the sensor measures */
+	bool     isPlugged;
+	float    converted;     /**< Result of the last finished conversion */
+	uint64_t conversionEnd; /**< In us, 0 when no conversion is running */
+	uint8_t  th;
+	uint8_t  tl;
+	uint8_t  config;
+	bool     isActive; /**< Still selected in the current transaction */
+};
+
+enum fake_onewire_state_e {
+	FAKE_ONEWIRE_IDLE = 0,
+	FAKE_ONEWIRE_ROM_CMD,
+	FAKE_ONEWIRE_SEARCH,
+	FAKE_ONEWIRE_MATCH,
+	FAKE_ONEWIRE_FUNCTION,
+	FAKE_ONEWIRE_WRITE_SCRATCHPAD,
+	FAKE_ONEWIRE_READ_SCRATCHPAD,
+	FAKE_ONEWIRE_READ_POWER
+};
+
+inline std::vector<struct fake_ds18x20_t> fakeOneWireSensors;
+inline uint32_t                           fakeOneWireEarlyReadCount = 0; /**< Scratchpads read during a conversion */
+inline uint32_t                           fakeOneWireConvertCount   = 0;
+inline uint64_t                           fakeOneWireConvertUs      = 0; /**< When the last conversion started */
+inline uint32_t                           fakeOneWireReadDelayUs    = 0; /**< From the conversion to the last scratchpad read */
+
+class OneWire {
+public:
+	OneWire(uint8_t) {}
+
+	/**
+	 * @brief Add a sensor on the bus
+	 *
+	 * @param family FAKE_ONEWIRE_DS18B20 or FAKE_ONEWIRE_DS18S20
+	 * @param serial Makes the ROM code unique
+	 * @param celsius Measured temperature
+	 * @return Index of the sensor in fakeOneWireSensors
+	 */
+	static size_t add_sensor(uint8_t family, uint32_t serial, float celsius)
+	{
+		struct fake_ds18x20_t sensor = {};
+
+		sensor.rom[0] = family;
+		for (uint8_t i = 1; i < 7; i++) {
+			sensor.rom[i] = (uint8_t) (serial >> (8 * ((i - 1) % 4))) ^ (i * 0x5B);
+		}
+		sensor.rom[7]    = crc8(sensor.rom, 7);
+		sensor.celsius   = celsius;
+		sensor.isPlugged = true;
+		sensor.converted = FAKE_ONEWIRE_POWER_ON_C;
+		sensor.config    = 0x7F; // 12 bits at power on
+		fakeOneWireSensors.push_back(sensor);
+		return fakeOneWireSensors.size() - 1;
+	}
+
+	static void clear(void)
+	{
+		fakeOneWireSensors.clear();
+		fakeOneWireEarlyReadCount = 0;
+		fakeOneWireConvertCount   = 0;
+		fakeOneWireConvertUs      = 0;
+		fakeOneWireReadDelayUs    = 0;
+	}
+
+	/** Conversion time of a sensor with its current configuration, in us */
+	static uint32_t conversion_time(const struct fake_ds18x20_t * pSensor)
+	{
+		if (pSensor->rom[0] == FAKE_ONEWIRE_DS18S20) {
+			return 750000;
+		}
+		return 750000 >> (3 - ((pSensor->config >> 5) & 0x03));
+	}
+
+	uint8_t reset(void)
+	{
+		bool isPresence = false;
+
+		fake_time_advance_us(FAKE_ONEWIRE_RESET_US);
+		for (auto & sensor : fakeOneWireSensors) {
+			sensor.isActive = sensor.isPlugged;
+			isPresence |= sensor.isPlugged;
+		}
+		state = isPresence ? FAKE_ONEWIRE_ROM_CMD : FAKE_ONEWIRE_IDLE;
+		return isPresence ? 1 : 0;
+	}
+
+	void write(uint8_t value, uint8_t power = 0)
+	{
+		fake_time_advance_us(8 * FAKE_ONEWIRE_SLOT_US);
+
+		switch (state) {
+		case FAKE_ONEWIRE_ROM_CMD:
+			if (value == 0xF0) {
+				state    = FAKE_ONEWIRE_SEARCH;
+				bitIndex = 0;
+				bitPhase = 0;
+			} else if (value == 0x55) {
+				state     = FAKE_ONEWIRE_MATCH;
+				byteIndex = 0;
+			} else if (value == 0xCC) {
+				state = FAKE_ONEWIRE_FUNCTION;
+			} else {
+				state = FAKE_ONEWIRE_IDLE;
+			}
+			break;
+		case FAKE_ONEWIRE_MATCH:
+			for (auto & sensor : fakeOneWireSensors) {
+				sensor.isActive &= (sensor.rom[byteIndex] == value);
+			}
+			if (++byteIndex >= 8) {
+				state = FAKE_ONEWIRE_FUNCTION;
+			}
+			break;
+		case FAKE_ONEWIRE_FUNCTION:
+			function(value);
+			break;
+		case FAKE_ONEWIRE_WRITE_SCRATCHPAD:
+			for (auto & sensor : fakeOneWireSensors) {
+				if (!sensor.isActive) {
+					continue;
+				}
+				if (byteIndex == 0) {
+					sensor.th = value;
+				} else if (byteIndex == 1) {
+					sensor.tl = value;
+				} else if ((byteIndex == 2) && (sensor.rom[0] == FAKE_ONEWIRE_DS18B20)) {
+					sensor.config = (value & 0x60) | 0x1F;
+				}
+			}
+			byteIndex++;
+			break;
+		default:
+			break;
+		}
+		(void) power;
+	}
+
+	uint8_t read(void)
+	{
+		uint8_t value = 0xFF;
+
+		fake_time_advance_us(8 * FAKE_ONEWIRE_SLOT_US);
+		if ((state == FAKE_ONEWIRE_READ_SCRATCHPAD) && (byteIndex < FAKE_ONEWIRE_SCRATCHPAD)) {
+			value = scratchpad[byteIndex++];
+		}
+		return value;
+	}
+
+	uint8_t read_bit(void)
+	{
+		uint8_t value = 1;
+
+		fake_time_advance_us(FAKE_ONEWIRE_SLOT_US);
+		if (state == FAKE_ONEWIRE_SEARCH) {
+			// Open drain: the bus is low if one sensor pulls it low
+			for (auto & sensor : fakeOneWireSensors) {
+				if (sensor.isActive && (rom_bit(&sensor) == bitPhase)) {
+					value = 0;
+				}
+			}
+			bitPhase = 1;
+		}
+		return value;
+	}
+
+	void write_bit(uint8_t value)
+	{
+		fake_time_advance_us(FAKE_ONEWIRE_SLOT_US);
+		if (state == FAKE_ONEWIRE_SEARCH) {
+			for (auto & sensor : fakeOneWireSensors) {
+				sensor.isActive &= (rom_bit(&sensor) == (value ? 1 : 0));
+			}
+			bitIndex++;
+			bitPhase = 0;
+		}
+	}
+
+	static uint8_t crc8(const uint8_t * addr, uint8_t len)
+	{
+		uint8_t crc = 0;
+
+		while (len--) {
+			uint8_t inbyte = *addr++;
+			for (uint8_t i = 8; i; i--) {
+				uint8_t mix = (crc ^ inbyte) & 0x01;
+				crc >>= 1;
+				if (mix) {
+					crc ^= 0x8C;
+				}
+				inbyte >>= 1;
+			}
+		}
+		return crc;
+	}
+
+private:
+	uint8_t state = FAKE_ONEWIRE_IDLE;
+	uint8_t bitIndex;
+	uint8_t bitPhase; /**< 0: bit, 1: its complement */
+	uint8_t byteIndex;
+	uint8_t scratchpad[FAKE_ONEWIRE_SCRATCHPAD];
+
+	uint8_t rom_bit(const struct fake_ds18x20_t * pSensor)
+	{
+		return (pSensor->rom[bitIndex / 8] >> (bitIndex % 8)) & 0x01;
+	}
+
+	/** The result of a finished conversion is in the scratchpad */
+	static void update_conversion(struct fake_ds18x20_t * pSensor)
+	{
+		if ((pSensor->conversionEnd != 0) && (fakeMicros >= pSensor->conversionEnd)) {
+			pSensor->converted     = pSensor->celsius;
+			pSensor->conversionEnd = 0;
+		}
+	}
+
+	void function(uint8_t value)
+	{
+		state     = FAKE_ONEWIRE_IDLE;
+		byteIndex = 0;
+
+		if (value == 0x44) {
+			fakeOneWireConvertCount++;
+			fakeOneWireConvertUs = fakeMicros;
+			for (auto & sensor : fakeOneWireSensors) {
+				if (sensor.isActive) {
+					update_conversion(&sensor);
+					sensor.conversionEnd = fakeMicros + conversion_time(&sensor);
+				}
+			}
+		} else if (value == 0x4E) {
+			state = FAKE_ONEWIRE_WRITE_SCRATCHPAD;
+		} else if (value == 0xB4) {
+			state = FAKE_ONEWIRE_READ_POWER;
+		} else if (value == 0xBE) {
+			state                  = FAKE_ONEWIRE_READ_SCRATCHPAD;
+			fakeOneWireReadDelayUs = (uint32_t) (fakeMicros - fakeOneWireConvertUs);
+			memset(scratchpad, 0xFF, sizeof(scratchpad));
+			for (auto & sensor : fakeOneWireSensors) {
+				if (sensor.isActive) {
+					fill_scratchpad(&sensor);
+				}
+			}
+		}
+	}
+
+	void fill_scratchpad(struct fake_ds18x20_t * pSensor)
+	{
+		int16_t raw;
+
+		update_conversion(pSensor);
+		if (pSensor->conversionEnd != 0) {
+			fakeOneWireEarlyReadCount++;
+		}
+
+		if (pSensor->rom[0] == FAKE_ONEWIRE_DS18S20) {
+			// 0.5°C steps, the rest is in COUNT_REMAIN
+			float   shifted = pSensor->converted + 0.25f;
+			int16_t whole   = (int16_t) floorf(shifted);
+
+			raw           = whole * 2;
+			scratchpad[4] = 0xFF;
+			scratchpad[5] = 0xFF;
+			scratchpad[6] = 16 - (uint8_t) lroundf((shifted - whole) * 16);
+		} else {
+			raw           = (int16_t) lroundf(pSensor->converted * 16);
+			raw          &= ~((1 << (3 - ((pSensor->config >> 5) & 0x03))) - 1);
+			scratchpad[4] = pSensor->config;
+			scratchpad[5] = 0xFF;
+			scratchpad[6] = 0x0C;
+		}
+		scratchpad[0] = raw & 0xFF;
+		scratchpad[1] = (raw >> 8) & 0xFF;
+		scratchpad[2] = pSensor->th;
+		scratchpad[3] = pSensor->tl;
+		scratchpad[7] = 0x10;
+		scratchpad[8] = crc8(scratchpad, 8);
+	}
+};
+
+#endif /* NATIVE_ONEWIRE_H */
@@ -0,0 +1,25 @@
+/**
+  * @file   WiFiClientSecure.h
+  * @brief  Fake TLS client, plain TCP to the stand-in server, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_WIFICLIENTSECURE_H
+#define NATIVE_WIFICLIENTSECURE_H
+
+#include <ESP8266WiFi.h>
+
+namespace BearSSL {
+class Session {
+};
+}
+
+/** No handshake: the time of a connection is fakeTcpConnectUs */
+class WiFiClientSecure : public WiFiClient {
+public:
+	void setInsecure(void) {}
+	void setSession(BearSSL::Session *) {}
+};
+
+#endif /* NATIVE_WIFICLIENTSECURE_H */
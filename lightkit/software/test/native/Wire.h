@@ -0,0 +1,222 @@
+/**
+  * @file   Wire.h
+  * @brief  Fake I2C controller with PCF8574 like devices, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * Devices are quasi-bidirectional ports: a write sets the latch, a read
+ * gives the latch with the pins pulled low from outside. Faults can be
+ * injected: an unplugged device or a few NAKs, and a device that holds
+ * SDA low until SCL is clocked enough, seen through the GPIO registers.
+ */
+
+#define FAKE_I2C_ERROR_DATA_NAK 3 /**< endTransmission(): data not acknowledged */
+#define FAKE_I2C_ERROR_ADDR_NAK 2 /**< endTransmission(): address not acknowledged */
+#define FAKE_I2C_ERROR_BUSY     4 /**< endTransmission(): SDA is held low */
+
+class TwoWire;
+
+struct fake_i2c_device_t {
+	TwoWire * wire;
+	uint8_t   address;
+	uint8_t   latch;     /**< Last byte written */
+	uint8_t   pulledLow; /**< Pins driven low from outside */
+	bool      isPlugged;
+	uint32_t  nakCount;  /**< Next transactions to refuse */
+	uint32_t  writeCount;
+	uint32_t  readCount;
+};
+
+inline std::vector<struct fake_i2c_device_t> fakeI2cDevices;
+inline std::vector<TwoWire *>                fakeI2cWires;
+
+class TwoWire {
+public:
+	uint8_t  sda         = 0xFF;
+	uint8_t  scl         = 0xFF;
+	uint32_t clock       = 100000;
+	uint32_t beginCount  = 0;
+	uint32_t endCount    = 0;
+	uint8_t  stuckClocks = 0; /**< SCL clocks before SDA is released, 0: not stuck */
+
+	TwoWire(void) { fakeI2cWires.push_back(this); }
+
+	/**
+	 * @brief Add a device on this bus
+	 *
+	 * @param address 7 bits address
+	 * @return Index of the device in fakeI2cDevices
+	 */
+	size_t add_device(uint8_t address)
+	{
+		struct fake_i2c_device_t device = {};
+
+		device.wire      = this;
+		device.address   = address;
+		device.latch     = 0xFF;
+		device.isPlugged = true;
+		fakeI2cDevices.push_back(device);
+		return fakeI2cDevices.size() - 1;
+	}
+
+	/**
+	 * @brief A device keeps SDA low, as when it is reset in the middle of a read
+	 *
+	 * @param clocks SCL clocks it needs to release SDA, 0xFF: never
+	 */
+	void stick_sda(uint8_t clocks)
+	{
+		stuckClocks = clocks;
+		fakeGpioInput &= ~(1UL << sda);
+		fakeDigitalWriteHook = on_pin_write;
+	}
+
+	static void clear(void)
+	{
+		fakeI2cDevices.clear();
+		for (TwoWire * pWire : fakeI2cWires) {
+			pWire->stuckClocks = 0;
+			pWire->beginCount  = 0;
+			pWire->endCount    = 0;
+		}
+	}
+
+	bool begin(int sdaPin, int sclPin, uint32_t frequency = 0)
+	{
+		sda = sdaPin;
+		scl = sclPin;
+		beginCount++;
+		if (frequency != 0) {
+			clock = frequency;
+		}
+
+		// Like the core, pins are left to the controller with their pull-ups
+		pinMode(sda, INPUT_PULLUP);
+		pinMode(scl, INPUT_PULLUP);
+		fakeGpioInput |= 1UL << scl;
+		if (stuckClocks == 0) {
+			fakeGpioInput |= 1UL << sda;
+		}
+		return true;
+	}
+
+	void end(void) { endCount++; }
+	void setClock(uint32_t frequency) { clock = frequency; }
+	void setClockStretchLimit(uint32_t) {}
+
+	void beginTransmission(uint8_t address)
+	{
+		txAddress = address;
+		txLength  = 0;
+	}
+
+	size_t write(uint8_t value)
+	{
+		if (txLength < sizeof(txBuffer)) {
+			txBuffer[txLength++] = value;
+		}
+		return 1;
+	}
+
+	uint8_t endTransmission(bool sendStop = true)
+	{
+		struct fake_i2c_device_t * pDevice;
+
+		(void) sendStop;
+		if (stuckClocks != 0) {
+			return FAKE_I2C_ERROR_BUSY;
+		}
+		transfer_time(txLength);
+
+		pDevice = find(txAddress);
+		if (pDevice == NULL) {
+			return FAKE_I2C_ERROR_ADDR_NAK;
+		}
+		if (pDevice->nakCount > 0) {
+			pDevice->nakCount--;
+			return FAKE_I2C_ERROR_DATA_NAK;
+		}
+		if (txLength > 0) {
+			pDevice->latch = txBuffer[txLength - 1];
+		}
+		pDevice->writeCount++;
+		return 0;
+	}
+
+	uint8_t requestFrom(uint8_t address, uint8_t quantity)
+	{
+		struct fake_i2c_device_t * pDevice;
+
+		rxLength = 0;
+		rxIndex  = 0;
+		if (stuckClocks != 0) {
+			return 0;
+		}
+		transfer_time(quantity);
+
+		pDevice = find(address);
+		if ((pDevice == NULL) || (pDevice->nakCount > 0)) {
+			if (pDevice != NULL) {
+				pDevice->nakCount--;
+			}
+			return 0;
+		}
+		pDevice->readCount++;
+		for (rxLength = 0; (rxLength < quantity) && (rxLength < sizeof(rxBuffer)); rxLength++) {
+			rxBuffer[rxLength] = pDevice->latch & ~pDevice->pulledLow;
+		}
+		return rxLength;
+	}
+
+	int available(void) { return rxLength - rxIndex; }
+	int read(void) { return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1; }
+
+private:
+	uint8_t txAddress;
+	uint8_t txBuffer[16];
+	uint8_t txLength;
+	uint8_t rxBuffer[16];
+	uint8_t rxLength = 0;
+	uint8_t rxIndex  = 0;
+
+	struct fake_i2c_device_t * find(uint8_t address)
+	{
+		for (auto & device : fakeI2cDevices) {
+			if ((device.wire == this) && (device.address == address) && device.isPlugged) {
+				return &device;
+			}
+		}
+		return NULL;
+	}
+
+	/** START, address, bytes and STOP, 9 clocks each */
+	void transfer_time(uint8_t byteCount)
+	{
+		fake_time_advance_us((uint32_t) ((byteCount + 2) * 9 * 1000000ULL / clock));
+	}
+
+	/** A stuck device shifts one bit out on each rising edge of SCL */
+	static void on_pin_write(uint8_t pin, uint8_t value)
+	{
+		for (TwoWire * pWire : fakeI2cWires) {
+			if ((pin != pWire->scl) || (value == LOW) || (pWire->stuckClocks == 0) || (pWire->stuckClocks == 0xFF)) {
+				continue;
+			}
+			if (--pWire->stuckClocks == 0) {
+				fakeGpioInput |= 1UL << pWire->sda;
+			}
+		}
+	}
+};
+
+inline TwoWire Wire;
+
+#endif /* NATIVE_WIRE_H */
@@ -0,0 +1,85 @@
+/**
+  * @file   esp8266_peri.h
+  * @brief  Model of the ESP8266 GPIO registers for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_ESP8266_PERI_H
+#define NATIVE_ESP8266_PERI_H
+
+#include <cstdint>
+
+/**
+ * Registers behave like the hardware: a write to GPOS or GPOC changes only
+ * the bits of its mask, GPI reads back the outputs and the levels driven
+ * from outside on the other pins. Each register write is counted.
+ */
+
+inline uint32_t fakeGpioInput      = 0; /**< Levels driven from outside, bit 16 is GPIO16 */
+inline uint32_t fakeGpioWriteCount = 0; /**< Writes to GPOS, GPOC and GP16O */
+inline uint32_t fakeInterruptLevel = 0; /**< Interrupts masked by the CPU, see xt_rsil() */
+inline uint32_t fakeGpio16RmwCount = 0; /**< Writes to GP16O while interrupts could change it in between */
+
+inline uint32_t GPO               = 0; /**< Output levels */
+inline uint32_t GPE               = 0; /**< Output enable, set by pinMode() */
+inline uint32_t fakeGpioOpenDrain = 0; /**< Outputs that can only pull low, set by pinMode() */
+
+/** Write-only register that sets or clears the bits written to it */
+struct fake_gpio_wreg_t {
+	bool isSet;
+
+	fake_gpio_wreg_t & operator=(uint32_t mask)
+	{
+		fakeGpioWriteCount++;
+		if (isSet) {
+			GPO |= mask;
+		} else {
+			GPO &= ~mask;
+		}
+		return *this;
+	}
+};
+
+/** Read-only register of the pin levels */
+struct fake_gpio_rreg_t {
+	uint8_t shift;
+
+	operator uint32_t() const
+	{
+		if (shift) {
+			return (fakeGpioInput >> shift) & 0x01;
+		}
+		// An open drain output is low if it or the outside pulls low
+		return (GPO & GPE & ~fakeGpioOpenDrain) | (GPO & fakeGpioInput & GPE & fakeGpioOpenDrain) | (fakeGpioInput & ~GPE);
+	}
+};
+
+/** Register of GPIO16, which has no set/clear registers */
+struct fake_gpio16_reg_t {
+	uint32_t value;
+
+	operator uint32_t() const { return value; }
+	fake_gpio16_reg_t & operator|=(uint32_t mask)
+	{
+		fakeGpioWriteCount++;
+		fakeGpio16RmwCount += (fakeInterruptLevel == 0) ? 1 : 0;
+		value |= mask;
+		return *this;
+	}
+	fake_gpio16_reg_t & operator&=(uint32_t mask)
+	{
+		fakeGpioWriteCount++;
+		fakeGpio16RmwCount += (fakeInterruptLevel == 0) ? 1 : 0;
+		value &= mask;
+		return *this;
+	}
+};
+
+inline fake_gpio_wreg_t  GPOS  = {true};
+inline fake_gpio_wreg_t  GPOC  = {false};
+inline fake_gpio_rreg_t  GPI   = {0};
+inline fake_gpio16_reg_t GP16O = {0};
+inline fake_gpio_rreg_t  GP16I = {16};
+
+#endif /* NATIVE_ESP8266_PERI_H */
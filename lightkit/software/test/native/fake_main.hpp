@@ -0,0 +1,98 @@
+/**
+  * @file   fake_main.hpp
+  * @brief  What main.cpp gives to the modules, for the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#ifndef NATIVE_FAKE_MAIN_HPP
+#define NATIVE_FAKE_MAIN_HPP
+
+#include "global.hpp"
+
+#include <string>
+
+/**
+ * Include it once, in the test file of a suite: it defines the globals.
+ * Logs are not printed, they are counted per level for the tests.
+ */
+
+uint32_t tick = 0;
+uint8_t  boardStatus[NB_STATUS];
+
+uint32_t    fakeLogCount[LOG_FATAL + 1];
+std::string fakeLastLog;
+
+extern "C" {
+void log_raw(const char * fmt, ...)
+{
+	char    buffer[512];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+	fakeLastLog = buffer;
+}
+}
+
+void log_log(int level, const char * file, int line, const char * fmt, ...)
+{
+	char    buffer[512];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+	fakeLastLog = buffer;
+	fakeLogCount[level]++;
+	(void) file;
+	(void) line;
+}
+
+/**
+ * @brief Start a test from a board that just booted
+ */
+static void fake_main_reset(void)
+{
+	fakeMicros = 0;
+	tick       = 0;
+	memset(boardStatus, 0, sizeof(boardStatus));
+	memset(fakeLogCount, 0, sizeof(fakeLogCount));
+	fakeLastLog.clear();
+}
+
+/**
+ * @brief Call a main function once per tick, like loop() does
+ * @details A call that takes more than 1 ms delays the next one,
+ * as on the board
+ *
+ * @param mainFct Main function of the module
+ * @param durationMs How long to run it
+ * @return The longest call in us
+ */
+static uint32_t fake_main_run(void (*mainFct)(void), uint32_t durationMs)
+{
+	uint64_t endUs    = fakeMicros + 1000ULL * durationMs;
+	uint32_t longest  = 0;
+	uint64_t startUs;
+	uint32_t elapsed;
+
+	while (fakeMicros < endUs) {
+		startUs = fakeMicros;
+		tick    = millis();
+		mainFct();
+
+		elapsed = (uint32_t) (fakeMicros - startUs);
+		if (elapsed > longest) {
+			longest = elapsed;
+		}
+		if (elapsed < 1000) {
+			fake_time_advance_us(1000 - elapsed);
+		}
+	}
+
+	return longest;
+}
+
+#endif /* NATIVE_FAKE_MAIN_HPP */
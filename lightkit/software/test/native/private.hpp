@@ -0,0 +1,9 @@
+/**
+  * @file   private.hpp
+  * @brief  Confidential informations of the unit tests on the host
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+// Only used when src/private.hpp does not exist: blank values are enough
+#include "private_tmpl.hpp"
@@ -0,0 +1,343 @@
+/**
+  * @file   test_main.cpp
+  * @brief  Command tree of the terminal: every command resolves, autocomplete, parse and dispatch time
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_FEU_ROUGE
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+#include <chrono>
+#include <string>
+
+// The strip commands too, for the biggest tree
+#define MODULE_STRIPLED
+
+// Unit under test, built here to reach its state
+#include "cmd/term.cpp"
+
+#define TEST_LEAF_COUNT  30 /**< board 4, flash 1, strip 4, buzzer 1, feu 1, wifi 15, batch 4 */
+#define TEST_BENCH_LOOPS 100000
+
+static std::string serialOutput;
+static uint8_t     stripBrightness;
+static bool        stripState;
+static int         feuMode;
+static int         feuColor;
+static int         buzzerId;
+
+void serial_write(uint8_t * data, uint16_t len)
+{
+	serialOutput.append((const char *) data, len);
+}
+
+void telnet_write(uint8_t clientId, uint8_t * data, uint16_t len)
+{
+}
+
+void serial_print_stats(void)
+{
+}
+
+void telnet_print_stats(void)
+{
+}
+
+void inputs_print_ioi2c_stats(void)
+{
+}
+
+void cmd_reset_module(void)
+{
+}
+
+void cmd_print_status(void)
+{
+}
+
+int32_t cmd_flash_setting_reset(void)
+{
+	return 0;
+}
+
+void cmd_set_brightness_auto(bool newValue)
+{
+}
+
+void cmd_set_brightness(uint8_t newValue)
+{
+	stripBrightness = newValue;
+}
+
+bool cmd_get_state(void)
+{
+	return stripState;
+}
+
+int32_t cmd_set_state(bool state)
+{
+	stripState = state;
+	return 0;
+}
+
+bool cmd_get_demo_mode(void)
+{
+	return false;
+}
+
+int32_t cmd_set_demo_mode(bool isDemoMode)
+{
+	return 0;
+}
+
+int32_t cmd_set_animation(uint8_t animID)
+{
+	return 0;
+}
+
+int cmd_set_buzzer(uint8_t id, uint8_t melody, bool repeat)
+{
+	buzzerId = id;
+	return 0;
+}
+
+void feu_rouge_set_fct_mode(FEU_ROUGE_MODE_FCT_E newMode)
+{
+	feuMode = newMode;
+}
+
+void feu_rouge_mode_fct_color(COLOR_CMD_E cmd)
+{
+	feuMode  = MODE_FCT_COLOR;
+	feuColor = cmd;
+}
+
+static wifi_handle_t wifiHandle;
+
+wifi_handle_t * wifi_get_handle(void)
+{
+	return &wifiHandle;
+}
+
+void wifi_print_config(wifi_handle_t * pHandle)
+{
+}
+
+int32_t wifi_use_new_settings(wifi_handle_t * pWifiHandle, String & reason)
+{
+	memcpy(&wifiHandle, pWifiHandle, sizeof(wifiHandle));
+	return 0;
+}
+
+bool file_sys_exist(String & path)
+{
+	return false;
+}
+
+File file_sys_open(String & path, const char * mode)
+{
+	return File();
+}
+
+/** Run a line like the serial session does once Enter is hit */
+static int run_line(const char * line)
+{
+	return cli_execute_lb(line, strlen(line));
+}
+
+/** Type on the serial session */
+static void type(const char * keys)
+{
+	while (*keys != '\0') {
+		term_rx(TERM_SESSION_SERIAL, *keys++);
+	}
+}
+
+static uint32_t leafCount;
+static uint32_t sameHashCount;
+static uint32_t callCount;
+static uint8_t  callArgc;
+
+static int call_record(uint8_t argc, char * argv[])
+{
+	callCount++;
+	callArgc = argc;
+	return 0;
+}
+
+/**
+ * @brief Run every leaf below a token with its arguments, on a callback that
+ * only records the call
+ *
+ * @param pParent The token
+ * @param path The words that lead to it
+ */
+static void walk_tree(cli_token * pParent, const std::string & path)
+{
+	for (cli_token * pChild = pParent->firstChild; pChild != NULL; pChild = pChild->nextSibling) {
+		std::string    line = path + pChild->text;
+		cli_callback_t callback;
+		uint32_t       before;
+		int            ret;
+
+		for (cli_token * pOther = pChild->nextSibling; pOther != NULL; pOther = pOther->nextSibling) {
+			sameHashCount += (pOther->hash == pChild->hash) ? 1 : 0;
+		}
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(cli_hash(pChild->text), pChild->hash, line.c_str());
+
+		if (!pChild->isLeaf) {
+			walk_tree(pChild, line + " ");
+			continue;
+		}
+
+		for (uint8_t i = 0; i < pChild->mandatoryArgc + pChild->optionalArgc; i++) {
+			line += " a";
+		}
+		callback         = pChild->callback;
+		pChild->callback = &call_record;
+		before           = callCount;
+		ret              = run_line(line.c_str());
+		pChild->callback = callback;
+
+		TEST_ASSERT_EQUAL_MESSAGE(0, ret, line.c_str());
+		TEST_ASSERT_EQUAL_MESSAGE(before + 1, callCount, line.c_str());
+		TEST_ASSERT_EQUAL_MESSAGE(pChild->mandatoryArgc + pChild->optionalArgc, callArgc, line.c_str());
+		leafCount++;
+	}
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	serialOutput.clear();
+	memset(&wifiHandle, 0, sizeof(wifiHandle));
+	memset(&wifiHandleTmp, 0, sizeof(wifiHandleTmp));
+	stripBrightness = 0;
+	stripState      = false;
+	feuMode         = -1;
+	feuColor        = -1;
+	buzzerId        = -1;
+	term_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_every_command_resolves(void)
+{
+	leafCount     = 0;
+	sameHashCount = 0;
+	walk_tree(cli_get_root_token(), "");
+
+	// No token was left out of the pool, no sibling costs a second strcmp
+	TEST_ASSERT_EQUAL(TEST_LEAF_COUNT, leafCount);
+	TEST_ASSERT_EQUAL(0, sameHashCount);
+}
+
+void test_commands_reach_their_module(void)
+{
+	TEST_ASSERT_EQUAL(0, run_line("wifi client set ssid \"My home\""));
+	TEST_ASSERT_EQUAL(0, run_line("wifi ap set ip 192.168.4.2"));
+	TEST_ASSERT_EQUAL(0, run_line("wifi ap set hidden on"));
+	TEST_ASSERT_EQUAL(0, run_line("wifi save"));
+	TEST_ASSERT_EQUAL_STRING("My home", wifiHandle.client.ssid);
+	TEST_ASSERT_EQUAL_HEX32(IP_TO_U32(192, 168, 4, 2), wifiHandle.ap.ip);
+	TEST_ASSERT_EQUAL(1, wifiHandle.ap.isHidden);
+
+	TEST_ASSERT_EQUAL(0, run_line("strip brightness 40"));
+	TEST_ASSERT_EQUAL(0, run_line("strip state toggle"));
+	TEST_ASSERT_EQUAL(40, stripBrightness);
+	TEST_ASSERT_TRUE(stripState);
+
+	TEST_ASSERT_EQUAL(0, run_line("feu set mode door"));
+	TEST_ASSERT_EQUAL(MODE_FCT_DOOR, feuMode);
+	TEST_ASSERT_EQUAL(0, run_line("feu set mode color y"));
+	TEST_ASSERT_EQUAL(COLOR_CMD_YELLOW, feuColor);
+
+	TEST_ASSERT_EQUAL(0, run_line("buzzer set 2 1 off"));
+	TEST_ASSERT_EQUAL(2, buzzerId);
+}
+
+void test_bad_commands_are_refused(void)
+{
+	// Unknown word, node instead of a leaf, missing and extra arguments
+	TEST_ASSERT_EQUAL(-1, run_line("wifi client get ssid"));
+	TEST_ASSERT_EQUAL(-1, run_line("wifi client set"));
+	TEST_ASSERT_EQUAL(-1, run_line("strip brightness"));
+	TEST_ASSERT_EQUAL(-1, run_line("strip state on off"));
+	TEST_ASSERT_EQUAL(-1, run_line("feu set mode color r g"));
+
+	// A prefix is not a command, the hash of the whole word is compared
+	TEST_ASSERT_EQUAL(-1, run_line("wifi loa"));
+	TEST_ASSERT_EQUAL(-1, run_line("wifi loads"));
+	TEST_ASSERT_EQUAL(-1, run_line("strip state maybe"));
+	TEST_ASSERT_TRUE(serialOutput.find("Unknown argument: maybe") != std::string::npos);
+	TEST_ASSERT_FALSE(stripState);
+}
+
+void test_autocomplete_from_the_session(void)
+{
+	char    completion[CLI_CMD_MAX_LEN];
+	uint8_t added;
+
+	// One choice is written with a space, several are only listed
+	added = cli_autocomplete_lb("wifi ap set ch", 14, completion, sizeof(completion));
+	TEST_ASSERT_EQUAL(6, added);
+	TEST_ASSERT_EQUAL_STRING("annel ", completion);
+	TEST_ASSERT_EQUAL(0, cli_autocomplete_lb("wifi ap set s", 13, completion, sizeof(completion)));
+	TEST_ASSERT_EQUAL(0, cli_autocomplete_lb("wifi ap set x", 13, completion, sizeof(completion)));
+
+	// Tab on each word, then Enter
+	type("wi\tcl\tse\tss\t");
+	TEST_ASSERT_TRUE(fakeLastLog.find("> wifi client set ssid ") != std::string::npos);
+	type("box\r\n");
+	TEST_ASSERT_EQUAL_STRING("box", wifiHandleTmp.client.ssid);
+
+	type("fe\t\t\t\tdoor\n");
+	TEST_ASSERT_EQUAL(MODE_FCT_DOOR, feuMode);
+}
+
+/** Wall clock time to parse and run a line on the host, only informative */
+static double bench_ns(const char * line, int expected)
+{
+	int  fails = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < TEST_BENCH_LOOPS; i++) {
+		fails += (run_line(line) != expected) ? 1 : 0;
+	}
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, fails, line);
+	return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / TEST_BENCH_LOOPS;
+}
+
+void test_bench_parse_and_dispatch(void)
+{
+	const char * lines[] = { "board status", "strip state on", "feu set mode traffic", "wifi ap set hidden on" };
+	char         message[96];
+
+	for (const char * line : lines) {
+		snprintf(message, sizeof(message), "\"%s\": %.1f ns", line, bench_ns(line, 0));
+		TEST_MESSAGE(message);
+	}
+
+	// A refused line also prints the usage
+	snprintf(message, sizeof(message), "\"wifi ap set\" (refused): %.1f ns", bench_ns("wifi ap set", -1));
+	TEST_MESSAGE(message);
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_every_command_resolves);
+	RUN_TEST(test_commands_reach_their_module);
+	RUN_TEST(test_bad_commands_are_refused);
+	RUN_TEST(test_autocomplete_from_the_session);
+	RUN_TEST(test_bench_parse_and_dispatch);
+	return UNITY_END();
+}
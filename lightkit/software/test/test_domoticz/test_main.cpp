@@ -0,0 +1,261 @@
+/**
+  * @file   test_main.cpp
+  * @brief  Domoticz module against a stand-in server: keep-alive, coalescing, back-off, faults
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_TEMP_DOMOTICZ
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+#include <vector>
+
+// Unit under test, built here to reach its state
+#include "domoticz/domoticz.cpp"
+#include "event/event.cpp"
+
+void status_led_set_color(char)
+{
+}
+
+/**
+ * Domoticz JSON API over HTTP/1.1: one reply per request,
+ * with a delay, and the faults of a real server on demand
+ */
+class DomoticzServer : public FakeTcpPeer {
+public:
+	std::vector<std::string> requests;      /**< Request line of each request */
+	bool                     isDown;        /**< Refuses connections */
+	bool                     isSilent;      /**< Never replies */
+	int                      httpCode;      /**< Status of the replies */
+	uint32_t                 replyDelayUs;  /**< Time to process a request */
+	uint32_t                 dropOnRequest; /**< Closes instead of replying to this request, 0: never */
+
+	DomoticzServer(void) { reset(); }
+
+	void reset(void)
+	{
+		requests.clear();
+		isDown        = false;
+		isSilent      = false;
+		httpCode      = 200;
+		replyDelayUs  = 20000;
+		dropOnRequest = 0;
+	}
+
+	bool on_connect(struct fake_tcp_conn_t * pConn) override
+	{
+		(void) pConn;
+		return !isDown;
+	}
+
+	void on_receive(struct fake_tcp_conn_t * pConn) override
+	{
+		size_t      end;
+		std::string body;
+		char        headers[128];
+
+		while ((end = pConn->toPeer.find("\r\n\r\n")) != std::string::npos) {
+			requests.push_back(pConn->toPeer.substr(0, pConn->toPeer.find("\r\n")));
+			pConn->toPeer.erase(0, end + 4);
+
+			// Like an idle timeout that hits just when the request comes
+			if (requests.size() == dropOnRequest) {
+				pConn->isClosed = true;
+				return;
+			}
+			if (isSilent) {
+				continue;
+			}
+
+			body = (httpCode == 200) ? "{\n\t\"status\" : \"OK\",\n\t\"title\" : \"Update Device\"\n}\n" : "Internal error\n";
+			snprintf(headers, sizeof(headers),
+			         "HTTP/1.1 %d %s\r\nContent-Type: application/json;charset=UTF-8\r\nContent-Length: %u\r\n\r\n",
+			         httpCode, (httpCode == 200) ? "OK" : "Error", (unsigned int) body.size());
+			fake_tcp_send(pConn, headers + body, replyDelayUs);
+		}
+	}
+
+	/** Number of requests for a device */
+	uint32_t count(uint8_t idx)
+	{
+		char     needle[16];
+		uint32_t n = 0;
+
+		snprintf(needle, sizeof(needle), "idx=%u&", idx);
+		for (const std::string & request : requests) {
+			n += (request.find(needle) != std::string::npos) ? 1 : 0;
+		}
+		return n;
+	}
+};
+
+static DomoticzServer server;
+
+static uint32_t run_ms(uint32_t durationMs)
+{
+	return fake_main_run(
+	    []() {
+		    domoticz_main();
+		    event_main();
+	    },
+	    durationMs);
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	client.stop();
+	fake_tcp_clear();
+	server.reset();
+	fakeTcpPeer = &server;
+
+	event_init();
+	domoticz_init();
+	_set(STATUS_WIFI, STATUS_WIFI_IS_CO);
+}
+
+void tearDown(void)
+{
+}
+
+void test_values_share_one_connection(void)
+{
+	uint32_t longest;
+
+	domoticz_send_temperature(3, 20.5f);
+	domoticz_send_temperature(4, 18.0f);
+	domoticz_send_temperature(5, -2.25f);
+	longest = run_ms(1000);
+
+	TEST_ASSERT_EQUAL(3, server.requests.size());
+	TEST_ASSERT_EQUAL_STRING("GET /json.htm?type=command&param=udevice&idx=3&nvalue=0&svalue=20.50 HTTP/1.1", server.requests[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("GET /json.htm?type=command&param=udevice&idx=5&nvalue=0&svalue=-2.25 HTTP/1.1", server.requests[2].c_str());
+	TEST_ASSERT_EQUAL(1, fakeTcpConnectCount);
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_TRUE(_isunset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+
+	// Only the connection could block, the replies are read as they come
+	TEST_ASSERT_LESS_OR_EQUAL(1000, longest);
+}
+
+void test_newest_value_replaces_a_queued_one(void)
+{
+	// The first value is in flight while the next ones come
+	server.replyDelayUs = 200000;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(10);
+	domoticz_send_temperature(3, 21.0f);
+	domoticz_send_temperature(4, 18.0f);
+	domoticz_send_temperature(3, 21.5f);
+	run_ms(2000);
+
+	TEST_ASSERT_EQUAL(3, server.requests.size());
+	TEST_ASSERT_EQUAL(2, server.count(3));
+	TEST_ASSERT_TRUE(server.requests[1].find("idx=3&nvalue=0&svalue=21.50") != std::string::npos);
+	TEST_ASSERT_EQUAL(0, queueCount);
+}
+
+void test_full_queue_drops_the_oldest_value(void)
+{
+	server.isDown = true;
+	for (uint8_t idx = 1; idx <= DOMOTICZ_QUEUE_SIZE + 2; idx++) {
+		domoticz_send_temperature(idx, 20.0f);
+	}
+	TEST_ASSERT_EQUAL(DOMOTICZ_QUEUE_SIZE, queueCount);
+	TEST_ASSERT_EQUAL(2, fakeLogCount[LOG_WARN]);
+
+	server.isDown = false;
+	run_ms(DOMOTICZ_RETRY_MIN_MS + 500);
+	TEST_ASSERT_EQUAL(DOMOTICZ_QUEUE_SIZE, server.requests.size());
+	TEST_ASSERT_EQUAL(0, server.count(1));
+	TEST_ASSERT_EQUAL(0, server.count(2));
+	TEST_ASSERT_EQUAL(1, server.count(DOMOTICZ_QUEUE_SIZE + 2));
+}
+
+void test_down_server_is_retried_with_back_off(void)
+{
+	server.isDown = true;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(60000);
+
+	// Tries at 0, 1, 3, 7, 15 and 31 s
+	TEST_ASSERT_EQUAL(6, fakeTcpConnectCount);
+	TEST_ASSERT_TRUE(_isset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+	TEST_ASSERT_EQUAL(1, queueCount);
+
+	// Kept until the server is back, then sent at the next try
+	server.isDown = false;
+	run_ms(10000);
+	TEST_ASSERT_EQUAL(1, server.requests.size());
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_TRUE(_isunset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+}
+
+void test_wifi_back_retries_at_once(void)
+{
+	server.isDown = true;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(10000);
+	server.isDown = false;
+
+	event_publish(EVENT_WIFI_STATE, EVENT_SOURCE_ANY, 1);
+	run_ms(100);
+	TEST_ASSERT_EQUAL(1, server.requests.size());
+}
+
+void test_refused_value_is_not_sent_again(void)
+{
+	server.httpCode = 500;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(10000);
+
+	TEST_ASSERT_EQUAL(1, server.requests.size());
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_TRUE(_isset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+}
+
+void test_silent_server_times_out(void)
+{
+	server.isSilent = true;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(DOMOTICZ_TIMEOUT_MS + 100);
+
+	TEST_ASSERT_EQUAL(1, server.requests.size());
+	TEST_ASSERT_EQUAL(1, queueCount);
+	TEST_ASSERT_TRUE(_isset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+	TEST_ASSERT_TRUE(fakeTcpConns[0].isStopped);
+}
+
+void test_closed_idle_connection_is_opened_again(void)
+{
+	// The server closes the kept-alive connection as the second request comes
+	server.dropOnRequest = 2;
+	domoticz_send_temperature(3, 20.5f);
+	run_ms(500);
+	domoticz_send_temperature(4, 18.0f);
+	run_ms(500);
+
+	TEST_ASSERT_EQUAL(3, server.requests.size());
+	TEST_ASSERT_EQUAL(2, server.count(4));
+	TEST_ASSERT_EQUAL(2, fakeTcpConnectCount);
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_TRUE(_isunset(STATUS_WIFI, STATUS_WIFI_DOMOTICZ_FAULT));
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_values_share_one_connection);
+	RUN_TEST(test_newest_value_replaces_a_queued_one);
+	RUN_TEST(test_full_queue_drops_the_oldest_value);
+	RUN_TEST(test_down_server_is_retried_with_back_off);
+	RUN_TEST(test_wifi_back_retries_at_once);
+	RUN_TEST(test_refused_value_is_not_sent_again);
+	RUN_TEST(test_silent_server_times_out);
+	RUN_TEST(test_closed_idle_connection_is_opened_again);
+	return UNITY_END();
+}
@@ -0,0 +1,174 @@
+/**
+  * @file   test_main.cpp
+  * @brief  Native outputs on the model of the GPIO registers: writes per call, levels, speed
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_TEMP_DOMOTICZ
+#define BOARD_TEMP_DOMOTICZ_BUZZER
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+#include <chrono>
+
+// A board with more native outputs, GPIO16 has its own register
+#undef OUTPUTS_COUNT
+#undef OUTPUTS_PINS
+#define OUTPUTS_COUNT 6
+#define OUTPUTS_PINS  { 12, 13, 14, 15, 5, 16 }
+
+// Unit under test, built here to reach its state
+#include "io/outputs.cpp"
+
+#define TEST_BENCH_LOOPS 200000
+
+static const uint32_t allOutputs[OUTPUTS_COUNT] = { 0, 1, 2, 3, 4, 5 };
+static const uint8_t  allPins[OUTPUTS_COUNT]    = OUTPUTS_PINS;
+
+void setUp(void)
+{
+	fake_main_reset();
+	GPO                  = 0;
+	GPE                  = 0;
+	GP16O.value          = 0;
+	fakeGpioInput        = 0;
+	fakeGpioWriteCount   = 0;
+	fakeGpio16RmwCount   = 0;
+	fakeInterruptLevel   = 0;
+	fakeDigitalCallCount = 0;
+	outputs_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_multiple_outputs_are_one_write_per_register(void)
+{
+	bool states[OUTPUTS_COUNT] = { true, false, true, true, false, true };
+
+	output_set_multiple(allOutputs, states, OUTPUTS_COUNT);
+
+	// One set and one clear for the first bank, one for GPIO16
+	TEST_ASSERT_EQUAL(3, fakeGpioWriteCount);
+	TEST_ASSERT_EQUAL(0, fakeDigitalCallCount);
+	TEST_ASSERT_EQUAL_HEX32((1 << 12) | (1 << 14) | (1 << 15), GPO);
+	TEST_ASSERT_EQUAL(1, GP16O.value);
+	for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) {
+		TEST_ASSERT_EQUAL(states[i], output_get(i));
+	}
+
+	// Same levels with digitalWrite(): one write per pin
+	fakeGpioWriteCount = 0;
+	for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) {
+		digitalWrite(allPins[i], states[i]);
+	}
+	TEST_ASSERT_EQUAL(OUTPUTS_COUNT, fakeGpioWriteCount);
+	TEST_ASSERT_EQUAL_HEX32((1 << 12) | (1 << 14) | (1 << 15), GPO);
+}
+
+void test_single_output_is_one_write(void)
+{
+	output_set(1, true);
+	TEST_ASSERT_EQUAL(1, fakeGpioWriteCount);
+	TEST_ASSERT_EQUAL_HEX32(1 << 13, GPO);
+
+	output_set(5, true);
+	output_set(1, false);
+	TEST_ASSERT_EQUAL(3, fakeGpioWriteCount);
+	TEST_ASSERT_EQUAL_HEX32(0, GPO);
+	TEST_ASSERT_EQUAL(1, GP16O.value);
+	TEST_ASSERT_EQUAL(0, fakeDigitalCallCount);
+}
+
+void test_pins_are_read_from_the_level_register(void)
+{
+	// Outputs read back their level, inputs the level from outside
+	pinMode(4, INPUT);
+	fakeGpioInput = (1 << 4) | (1 << 13) | (1 << 16);
+	output_set(0, true);
+
+	TEST_ASSERT_TRUE(fast_gpio_read(12));
+	TEST_ASSERT_FALSE(fast_gpio_read(13));
+	TEST_ASSERT_TRUE(fast_gpio_read(4));
+	TEST_ASSERT_TRUE(fast_gpio_read(16));
+	TEST_ASSERT_EQUAL_HEX32((1 << 4) | (1 << 12), fast_gpio_read_mask() & ((1 << 4) | (1 << 12) | (1 << 13)));
+	TEST_ASSERT_EQUAL(0, fakeDigitalCallCount);
+}
+
+void test_gpio16_is_written_with_interrupts_masked(void)
+{
+	fast_gpio_write(16, true);
+	TEST_ASSERT_EQUAL(1, GP16O.value);
+	TEST_ASSERT_EQUAL(0, fakeInterruptLevel);
+
+	// From an ISR, the level of the ISR is given back
+	fakeInterruptLevel = 1;
+	fast_gpio_write(16, false);
+	TEST_ASSERT_EQUAL(0, GP16O.value);
+	TEST_ASSERT_EQUAL(1, fakeInterruptLevel);
+	TEST_ASSERT_EQUAL(0, fakeGpio16RmwCount);
+}
+
+/** Wall clock time of a loop on the host, only to compare the two paths */
+static uint64_t bench_ns(void (*fct)(uint32_t))
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < TEST_BENCH_LOOPS; i++) {
+		fct(i);
+	}
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_bench_multiple_against_digital_write(void)
+{
+	uint32_t fastWrites;
+	uint32_t digitalWrites;
+	uint64_t fastNs;
+	uint64_t digitalNs;
+	char     message[128];
+
+	fastNs = bench_ns([](uint32_t i) {
+		bool states[OUTPUTS_COUNT];
+
+		for (uint8_t j = 0; j < OUTPUTS_COUNT; j++) {
+			states[j] = ((i >> j) & 0x01) != 0;
+		}
+		output_set_multiple(allOutputs, states, OUTPUTS_COUNT);
+	});
+	fastWrites = fakeGpioWriteCount;
+
+	fakeGpioWriteCount = 0;
+	digitalNs          = bench_ns([](uint32_t i) {
+		for (uint8_t j = 0; j < OUTPUTS_COUNT; j++) {
+			digitalWrite(allPins[j], (i >> j) & 0x01);
+		}
+	});
+	digitalWrites = fakeGpioWriteCount;
+
+	snprintf(message, sizeof(message), "%d outputs: %.1f writes, %.1f ns with output_set_multiple(), %.1f writes, %.1f ns with digitalWrite()",
+	         OUTPUTS_COUNT,
+	         (double) fastWrites / TEST_BENCH_LOOPS, (double) fastNs / TEST_BENCH_LOOPS,
+	         (double) digitalWrites / TEST_BENCH_LOOPS, (double) digitalNs / TEST_BENCH_LOOPS);
+	TEST_MESSAGE(message);
+
+	// At most 3 register writes instead of one per pin, the host time is only informative
+	TEST_ASSERT_LESS_OR_EQUAL(3 * TEST_BENCH_LOOPS, fastWrites);
+	TEST_ASSERT_EQUAL(OUTPUTS_COUNT * TEST_BENCH_LOOPS, digitalWrites);
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_multiple_outputs_are_one_write_per_register);
+	RUN_TEST(test_single_output_is_one_write);
+	RUN_TEST(test_gpio16_is_written_with_interrupts_masked);
+	RUN_TEST(test_pins_are_read_from_the_level_register);
+	RUN_TEST(test_bench_multiple_against_digital_write);
+	return UNITY_END();
+}
@@ -0,0 +1,216 @@
+/**
+  * @file   test_main.cpp
+  * @brief  IOI2C group on a fake Wire: outputs, inputs, NAK, back-off, bus clear, INT line
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_FEU_ROUGE
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+// Unit under test, built here to reach its state
+#include "drivers/ioi2c/ioi2c_driver.cpp"
+#include "drivers/ioi2c/ioi2c_group.cpp"
+
+#define TEST_SDA 4
+#define TEST_SCL 5
+#define TEST_INT 12
+
+static const IOI2CBus buses[]   = { IOI2C_BUS(Wire, TEST_SDA, TEST_SCL, IOI2C_CLOCK_STANDARD) };
+static const uint16_t devices[] = { IOI2C_DEV(0, IOI2C_0_ADDR), IOI2C_DEV(0, IOI2C_1_ADDR) };
+
+static IOI2CGroup * pGroup;
+static size_t       dev0;
+static size_t       dev1;
+
+/** Poll the inputs every 10 ms and send the outputs, like inputs and outputs do */
+static uint32_t run_ms(uint32_t durationMs)
+{
+	return fake_main_run(
+	    []() {
+		    if ((tick % 10) == 0) {
+			    pGroup->scan();
+		    }
+		    pGroup->commit();
+	    },
+	    durationMs);
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	TwoWire::clear();
+	dev0 = Wire.add_device(IOI2C_0_ADDR);
+	dev1 = Wire.add_device(IOI2C_1_ADDR);
+
+	pGroup = new IOI2CGroup(buses, 1, devices, 2);
+	pGroup->begin();
+}
+
+void tearDown(void)
+{
+	delete pGroup;
+}
+
+void test_outputs_and_inputs(void)
+{
+	// All off at begin, outputs are inverted
+	TEST_ASSERT_EQUAL_HEX8(0xFF, fakeI2cDevices[dev0].latch);
+	TEST_ASSERT_EQUAL(1, fakeI2cDevices[dev0].writeCount);
+
+	// S1 of the first device, S2 of the second one
+	pGroup->output_write(0, 1);
+	pGroup->output_write(IOI2C_OUTPUT_COUNT + 1, 1);
+	pGroup->commit();
+	TEST_ASSERT_EQUAL_HEX8(0xDF, fakeI2cDevices[dev0].latch);
+	TEST_ASSERT_EQUAL_HEX8(0xEF, fakeI2cDevices[dev1].latch);
+
+	// Nothing changed, nothing sent
+	pGroup->commit();
+	TEST_ASSERT_EQUAL(2, fakeI2cDevices[dev0].writeCount);
+	TEST_ASSERT_EQUAL(2, fakeI2cDevices[dev1].writeCount);
+
+	// E1 of the first device is pulled low
+	fakeI2cDevices[dev0].pulledLow = 0x80;
+	pGroup->scan();
+	TEST_ASSERT_EQUAL(1, pGroup->input_read(0));
+	TEST_ASSERT_EQUAL(0, pGroup->input_read(1));
+	TEST_ASSERT_EQUAL(0, pGroup->input_read(IOI2C_INPUT_COUNT));
+	TEST_ASSERT_EQUAL(6, pGroup->get_transaction_count());
+	TEST_ASSERT_EQUAL(0, pGroup->get_error_count());
+}
+
+void test_single_nak_is_retried(void)
+{
+	IOI2CDriver * pDevice = pGroup->get_device(0);
+
+	fakeI2cDevices[dev0].nakCount = 1;
+	pGroup->output_write(2, 1);
+	pGroup->commit();
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_COMM_ERROR, pDevice->get_status());
+	TEST_ASSERT_TRUE(pDevice->is_dirty());
+	TEST_ASSERT_EQUAL_HEX8(0xFF, fakeI2cDevices[dev0].latch);
+
+	pGroup->commit();
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pDevice->get_status());
+	TEST_ASSERT_EQUAL_HEX8(0xF7, fakeI2cDevices[dev0].latch);
+	TEST_ASSERT_EQUAL(1, pGroup->get_error_count());
+}
+
+void test_unplugged_device_is_backed_off(void)
+{
+	IOI2CDriver * pDevice = pGroup->get_device(1);
+	uint32_t      transactionCount;
+
+	fakeI2cDevices[dev1].isPlugged = false;
+	run_ms(30);
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OFFLINE, pDevice->get_status());
+
+	// 100 ms doubled up to 10 s: 11 retries in a minute instead of 6000
+	transactionCount = pDevice->get_transaction_count();
+	pGroup->output_write(IOI2C_OUTPUT_COUNT, 1);
+	run_ms(60000);
+	TEST_ASSERT_LESS_OR_EQUAL(12, pDevice->get_transaction_count() - transactionCount);
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pGroup->get_device(0)->get_status());
+	TEST_ASSERT_EQUAL(0, pGroup->get_device(0)->get_error_count());
+
+	// Outputs changed while offline are sent once it is back
+	fakeI2cDevices[dev1].isPlugged = true;
+	run_ms(IOI2C_BACKOFF_MAX_MS + 20);
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pDevice->get_status());
+	TEST_ASSERT_EQUAL_HEX8(0xDF, fakeI2cDevices[dev1].latch);
+}
+
+void test_power_cycled_device_gets_its_outputs_back(void)
+{
+	pGroup->output_write(5, 1);
+	pGroup->commit();
+	TEST_ASSERT_EQUAL_HEX8(0xFE, fakeI2cDevices[dev0].latch);
+
+	// The device loses its latch while away
+	fakeI2cDevices[dev0].isPlugged = false;
+	run_ms(100);
+	fakeI2cDevices[dev0].latch     = 0xFF;
+	fakeI2cDevices[dev0].isPlugged = true;
+	run_ms(IOI2C_BACKOFF_MAX_MS + 20);
+
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pGroup->get_device(0)->get_status());
+	TEST_ASSERT_EQUAL_HEX8(0xFE, fakeI2cDevices[dev0].latch);
+}
+
+void test_stuck_sda_is_cleared(void)
+{
+	// The device needs 5 clocks to finish its byte
+	Wire.stick_sda(5);
+	pGroup->scan();
+
+	TEST_ASSERT_EQUAL(1, pGroup->get_bus_clear_count());
+	TEST_ASSERT_EQUAL(0, Wire.stuckClocks);
+	TEST_ASSERT_EQUAL(2, Wire.beginCount);
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pGroup->get_device(0)->get_status());
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OK, pGroup->get_device(1)->get_status());
+
+	// The bus is idle again
+	run_ms(1000);
+	TEST_ASSERT_EQUAL(1, pGroup->get_bus_clear_count());
+	TEST_ASSERT_EQUAL(0, pGroup->get_error_count());
+}
+
+void test_stuck_sda_clear_is_rate_limited(void)
+{
+	uint32_t longest;
+
+	// Never released, the devices go offline but the loop goes on
+	Wire.stick_sda(0xFF);
+	longest = run_ms(5000);
+
+	TEST_ASSERT_EQUAL(5000 / IOI2C_BUS_CLEAR_PERIOD_MS, pGroup->get_bus_clear_count());
+	TEST_ASSERT_EQUAL(IOI2CDriver::STATUS_OFFLINE, pGroup->get_device(0)->get_status());
+	TEST_ASSERT_LESS_OR_EQUAL(1000, longest);
+}
+
+void test_int_line_of_each_group(void)
+{
+	IOI2CGroup other(buses, 1, devices, 1);
+
+	// Pull-ups hold both lines high
+	fakeGpioInput |= (1 << TEST_INT) | (1 << (TEST_INT + 1));
+	pGroup->begin_interrupt(TEST_INT);
+	other.begin_interrupt(TEST_INT + 1);
+	TEST_ASSERT_TRUE(pGroup->is_changed());
+	pGroup->scan();
+	other.scan();
+	TEST_ASSERT_FALSE(pGroup->is_changed());
+	TEST_ASSERT_FALSE(other.is_changed());
+
+	// A falling INT only wakes its own group
+	fakeGpioInput &= ~(1 << TEST_INT);
+	fake_pin_interrupt(TEST_INT);
+	TEST_ASSERT_TRUE(pGroup->is_changed());
+	TEST_ASSERT_FALSE(other.is_changed());
+
+	// Still low after the scan, a device is not released yet
+	pGroup->scan();
+	TEST_ASSERT_TRUE(pGroup->is_changed());
+	fakeGpioInput |= (1 << TEST_INT);
+	pGroup->scan();
+	TEST_ASSERT_FALSE(pGroup->is_changed());
+
+	fakeGpioInput = 0;
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_outputs_and_inputs);
+	RUN_TEST(test_single_nak_is_retried);
+	RUN_TEST(test_unplugged_device_is_backed_off);
+	RUN_TEST(test_power_cycled_device_gets_its_outputs_back);
+	RUN_TEST(test_stuck_sda_is_cleared);
+	RUN_TEST(test_stuck_sda_clear_is_rate_limited);
+	RUN_TEST(test_int_line_of_each_group);
+	return UNITY_END();
+}
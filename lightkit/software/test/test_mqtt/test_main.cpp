@@ -0,0 +1,465 @@
+/**
+  * @file   test_main.cpp
+  * @brief  MQTT module against a stand-in broker: session, QoS 1, commands, keep-alive
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_TEMP_DOMOTICZ
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+#include <map>
+#include <vector>
+
+// A broker, and the strip commands of the boards that have one
+#undef P_MQTT_HOST
+#define P_MQTT_HOST "192.168.0.40"
+#define MODULE_STRIPLED
+
+// Unit under test, built here to reach its state
+#include "event/event.cpp"
+#include "mqtt/mqtt.cpp"
+
+#define TEST_PREFIX "lightkit/LightKit/"
+
+// Strip commands, as the strip module would take them
+static bool    stripIsOn;
+static uint8_t stripSetStateCount;
+
+String cmd_get_module_name(void)
+{
+	return String("LightKit");
+}
+
+bool cmd_get_state(void)
+{
+	return stripIsOn;
+}
+
+int32_t cmd_set_state(bool state)
+{
+	stripIsOn = state;
+	stripSetStateCount++;
+	return 0;
+}
+
+bool cmd_get_demo_mode(void)
+{
+	return false;
+}
+
+int32_t cmd_set_demo_mode(bool)
+{
+	return 0;
+}
+
+uint8_t cmd_get_brightness(void)
+{
+	return 50;
+}
+
+void cmd_set_brightness(uint8_t)
+{
+}
+
+void cmd_set_brightness_auto(bool)
+{
+}
+
+uint8_t cmd_get_animation(void)
+{
+	return 0;
+}
+
+int32_t cmd_set_animation(uint8_t)
+{
+	return 0;
+}
+
+uint32_t cmd_get_color(void)
+{
+	return 0xFF8000;
+}
+
+void cmd_set_color(uint32_t)
+{
+}
+
+struct broker_publish_t {
+	std::string topic;
+	std::string payload;
+	uint8_t     qos;
+	bool        isDup;
+	bool        isRetain;
+	uint16_t    packetId;
+};
+
+/**
+ * MQTT 3.1.1 broker for one client: CONNACK, SUBACK, PUBACK, PINGRESP,
+ * retained messages, and the faults of a real broker on demand
+ */
+class MqttBroker : public FakeTcpPeer {
+public:
+	std::vector<struct broker_publish_t> publishes;     /**< From the board */
+	std::map<std::string, std::string>   retained;      /**< Last retained payload of each topic */
+	std::vector<std::string>             subscriptions; /**< Topic filters */
+	std::vector<uint16_t>                pubacks;       /**< Packet ID of the PUBACK from the board */
+	std::string                          clientId;
+	std::string                          willTopic;
+	uint16_t                             keepAlive;
+	uint32_t                             connectCount;
+	uint32_t                             pingCount;
+	bool                                 isDown;          /**< Refuses connections */
+	uint8_t                              connackCode;     /**< 0: accepted */
+	bool                                 isSilent;        /**< Connected, but never answers anymore */
+	std::string                          withheldTopic;   /**< First QoS 1 message of it is not acknowledged */
+	bool                                 isClosingOnWithheld;
+	struct fake_tcp_conn_t *             pConn;
+
+	MqttBroker(void) { reset(); }
+
+	void reset(void)
+	{
+		publishes.clear();
+		retained.clear();
+		subscriptions.clear();
+		pubacks.clear();
+		clientId.clear();
+		willTopic.clear();
+		keepAlive           = 0;
+		connectCount        = 0;
+		pingCount           = 0;
+		isDown              = false;
+		connackCode         = 0;
+		isSilent            = false;
+		isClosingOnWithheld = false;
+		withheldTopic.clear();
+		pConn = NULL;
+	}
+
+	bool on_connect(struct fake_tcp_conn_t * pNewConn) override
+	{
+		if (isDown) {
+			return false;
+		}
+		pConn = pNewConn;
+		return true;
+	}
+
+	void on_stop(struct fake_tcp_conn_t * pStopped) override
+	{
+		if (pStopped == pConn) {
+			pConn = NULL;
+		}
+	}
+
+	void on_receive(struct fake_tcp_conn_t * pFrom) override
+	{
+		uint8_t  type;
+		uint32_t length;
+		size_t   offset;
+
+		// Only complete packets
+		while (parse_header(pFrom->toPeer, &type, &length, &offset) && (pFrom->toPeer.size() >= offset + length)) {
+			std::string body = pFrom->toPeer.substr(offset, length);
+
+			pFrom->toPeer.erase(0, offset + length);
+			if (!isSilent) {
+				handle(pFrom, type, body);
+			}
+		}
+	}
+
+	/** Send a message to the board, like another client would */
+	void publish_to_board(const std::string & topic, const std::string & payload, uint16_t packetId)
+	{
+		std::string body = u16(topic.size()) + topic + u16(packetId) + payload;
+
+		fake_tcp_send(pConn, std::string(1, (char) (MQTT_PUBLISH | MQTT_PUBLISH_QOS1)) + std::string(1, (char) body.size()) + body);
+	}
+
+	/** Messages of a topic, without the prefix */
+	std::vector<struct broker_publish_t> of(const std::string & topic)
+	{
+		std::vector<struct broker_publish_t> found;
+
+		for (const struct broker_publish_t & publish : publishes) {
+			if (publish.topic == TEST_PREFIX + topic) {
+				found.push_back(publish);
+			}
+		}
+		return found;
+	}
+
+private:
+	static std::string u16(uint16_t value)
+	{
+		return std::string(1, (char) (value >> 8)) + std::string(1, (char) (value & 0xFF));
+	}
+
+	static uint16_t get_u16(const std::string & data, size_t offset)
+	{
+		return ((uint8_t) data[offset] << 8) | (uint8_t) data[offset + 1];
+	}
+
+	static bool parse_header(const std::string & data, uint8_t * pType, uint32_t * pLength, size_t * pOffset)
+	{
+		*pLength = 0;
+		for (size_t i = 1; (i < data.size()) && (i <= 4); i++) {
+			*pLength |= (uint32_t) ((uint8_t) data[i] & 0x7F) << (7 * (i - 1));
+			if (((uint8_t) data[i] & 0x80) == 0) {
+				*pType   = (uint8_t) data[0];
+				*pOffset = i + 1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void handle(struct fake_tcp_conn_t * pFrom, uint8_t type, const std::string & body)
+	{
+		size_t offset;
+
+		switch (type & 0xF0) {
+		case MQTT_CONNECT:
+			// "MQTT", level, flags, keep alive, client ID, will topic
+			connectCount++;
+			offset    = 2 + get_u16(body, 0) + 2;
+			keepAlive = get_u16(body, offset);
+			offset += 2;
+			clientId = body.substr(offset + 2, get_u16(body, offset));
+			offset += 2 + clientId.size();
+			willTopic = body.substr(offset + 2, get_u16(body, offset));
+			fake_tcp_send(pFrom, std::string("\x20\x02\x00", 3) + std::string(1, (char) connackCode));
+			break;
+		case MQTT_SUBSCRIBE & 0xF0:
+			subscriptions.push_back(body.substr(4, get_u16(body, 2)));
+			fake_tcp_send(pFrom, std::string("\x90\x03", 2) + body.substr(0, 2) + std::string("\x01", 1));
+			break;
+		case MQTT_PUBLISH: {
+			struct broker_publish_t publish;
+
+			publish.qos      = (type >> 1) & 0x03;
+			publish.isDup    = (type & MQTT_PUBLISH_DUP) != 0;
+			publish.isRetain = (type & MQTT_PUBLISH_RETAIN) != 0;
+			publish.topic    = body.substr(2, get_u16(body, 0));
+			offset           = 2 + publish.topic.size();
+			publish.packetId = (publish.qos > 0) ? get_u16(body, offset) : 0;
+			offset += (publish.qos > 0) ? 2 : 0;
+			publish.payload = body.substr(offset);
+			publishes.push_back(publish);
+
+			if (publish.qos == 0) {
+				if (publish.isRetain) {
+					retained[publish.topic] = publish.payload;
+				}
+				break;
+			}
+			if (!withheldTopic.empty() && (publish.topic == TEST_PREFIX + withheldTopic)) {
+				withheldTopic.clear();
+				if (isClosingOnWithheld) {
+					pFrom->isClosed = true;
+				}
+				break;
+			}
+			if (publish.isRetain) {
+				retained[publish.topic] = publish.payload;
+			}
+			fake_tcp_send(pFrom, std::string("\x40\x02", 2) + u16(publish.packetId));
+			break;
+		}
+		case MQTT_PUBACK:
+			pubacks.push_back(get_u16(body, 0));
+			break;
+		case MQTT_PINGREQ:
+			pingCount++;
+			fake_tcp_send(pFrom, std::string("\xD0\x00", 2));
+			break;
+		default:
+			break;
+		}
+	}
+};
+
+static MqttBroker broker;
+
+static uint32_t run_ms(uint32_t durationMs)
+{
+	return fake_main_run(
+	    []() {
+		    mqtt_main();
+		    event_main();
+	    },
+	    durationMs);
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	client.stop();
+	fake_tcp_clear();
+	broker.reset();
+	fakeTcpPeer = &broker;
+
+	stripIsOn          = false;
+	stripSetStateCount = 0;
+	stripNextCheckTick = 0;
+	failCount          = 0;
+
+	event_init();
+	mqtt_init();
+	_set(STATUS_WIFI, STATUS_WIFI_IS_CO);
+}
+
+void tearDown(void)
+{
+}
+
+void test_session_is_opened_and_states_published(void)
+{
+	uint32_t longest = run_ms(1000);
+
+	TEST_ASSERT_TRUE(mqtt_is_connected());
+	TEST_ASSERT_EQUAL(1, broker.connectCount);
+	TEST_ASSERT_EQUAL_STRING("lightkit-5CCF7F123456", broker.clientId.c_str());
+	TEST_ASSERT_EQUAL_STRING(TEST_PREFIX "status", broker.willTopic.c_str());
+	TEST_ASSERT_EQUAL(MQTT_KEEP_ALIVE_S, broker.keepAlive);
+	TEST_ASSERT_EQUAL(1, broker.subscriptions.size());
+	TEST_ASSERT_EQUAL_STRING(TEST_PREFIX "strip/+/set", broker.subscriptions[0].c_str());
+
+	TEST_ASSERT_EQUAL_STRING("online", broker.retained[TEST_PREFIX "status"].c_str());
+	TEST_ASSERT_EQUAL_STRING("0", broker.retained[TEST_PREFIX "alert"].c_str());
+	TEST_ASSERT_EQUAL_STRING("0", broker.retained[TEST_PREFIX "strip/state"].c_str());
+	TEST_ASSERT_EQUAL_STRING("FF8000", broker.retained[TEST_PREFIX "strip/color"].c_str());
+
+	// Everything acknowledged, and the loop never waits for the broker
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_LESS_OR_EQUAL(1000, longest);
+}
+
+void test_offline_values_are_coalesced(void)
+{
+	broker.isDown = true;
+	run_ms(100);
+	event_publish(EVENT_TEMP_VALUE, 0, 2150);
+	run_ms(100);
+	event_publish(EVENT_TEMP_VALUE, 0, 2175);
+	event_publish(EVENT_TEMP_VALUE, 1, 1800);
+	run_ms(100);
+
+	broker.isDown = false;
+	run_ms(MQTT_RETRY_MIN_MS + 500);
+	TEST_ASSERT_TRUE(mqtt_is_connected());
+	TEST_ASSERT_EQUAL(1, broker.of("temp/0").size());
+	TEST_ASSERT_EQUAL_STRING("21.75", broker.of("temp/0")[0].payload.c_str());
+	TEST_ASSERT_EQUAL_STRING("18.00", broker.retained[TEST_PREFIX "temp/1"].c_str());
+}
+
+void test_unacknowledged_message_is_sent_again(void)
+{
+	std::vector<struct broker_publish_t> alerts;
+
+	broker.withheldTopic = "alert";
+	run_ms(MQTT_PUBACK_TIMEOUT_MS + 500);
+
+	alerts = broker.of("alert");
+	TEST_ASSERT_EQUAL(2, alerts.size());
+	TEST_ASSERT_FALSE(alerts[0].isDup);
+	TEST_ASSERT_TRUE(alerts[1].isDup);
+	TEST_ASSERT_EQUAL(alerts[0].packetId, alerts[1].packetId);
+	TEST_ASSERT_EQUAL(0, queueCount);
+	TEST_ASSERT_EQUAL(1, broker.connectCount);
+}
+
+void test_in_flight_message_survives_a_reconnection(void)
+{
+	std::vector<struct broker_publish_t> faults;
+
+	// The broker goes away before it acknowledges
+	run_ms(1000);
+	broker.withheldTopic       = "temp/0/fault";
+	broker.isClosingOnWithheld = true;
+	event_publish(EVENT_TEMP_FAULT, 0, 1);
+	run_ms(MQTT_RETRY_MIN_MS + 500);
+
+	faults = broker.of("temp/0/fault");
+	TEST_ASSERT_EQUAL(2, broker.connectCount);
+	TEST_ASSERT_EQUAL(2, faults.size());
+	TEST_ASSERT_FALSE(faults[0].isDup);
+	TEST_ASSERT_TRUE(faults[1].isDup);
+	TEST_ASSERT_EQUAL(faults[0].packetId, faults[1].packetId);
+	TEST_ASSERT_EQUAL_STRING("1", broker.retained[TEST_PREFIX "temp/0/fault"].c_str());
+	TEST_ASSERT_EQUAL(0, queueCount);
+}
+
+void test_strip_command_is_applied_and_acknowledged(void)
+{
+	// Between two checks of the strip state
+	run_ms(1000 + MQTT_STRIP_CHECK_PERIOD_MS / 2);
+	broker.publish_to_board(TEST_PREFIX "strip/state/set", "on", 0x0707);
+	run_ms(MQTT_STRIP_CHECK_PERIOD_MS / 5);
+
+	TEST_ASSERT_EQUAL(1, stripSetStateCount);
+	TEST_ASSERT_TRUE(stripIsOn);
+	TEST_ASSERT_EQUAL(1, broker.pubacks.size());
+	TEST_ASSERT_EQUAL_HEX16(0x0707, broker.pubacks[0]);
+
+	// The new state is published without waiting for the next check
+	TEST_ASSERT_EQUAL_STRING("1", broker.retained[TEST_PREFIX "strip/state"].c_str());
+}
+
+void test_live_broker_is_pinged_while_publishing(void)
+{
+	uint32_t tickEnd;
+
+	// QoS 0 values get no answer from the broker
+	run_ms(1000);
+	for (tickEnd = tick + 4 * MQTT_KEEP_ALIVE_S * 1000; tick < tickEnd;) {
+		event_publish(EVENT_TEMP_VALUE, 0, 2000 + (tick / 1000) % 100);
+		run_ms(5000);
+	}
+
+	TEST_ASSERT_TRUE(mqtt_is_connected());
+	TEST_ASSERT_EQUAL(1, broker.connectCount);
+	TEST_ASSERT_GREATER_OR_EQUAL(4 * 2 - 1, broker.pingCount);
+	TEST_ASSERT_EQUAL(0, fakeLogCount[LOG_ERROR]);
+}
+
+void test_silent_broker_is_left(void)
+{
+	run_ms(1000);
+	broker.isSilent = true;
+	run_ms(MQTT_KEEP_ALIVE_S * 1500 + 100);
+
+	TEST_ASSERT_FALSE(mqtt_is_connected());
+	TEST_ASSERT_TRUE(fakeTcpConns[0].isStopped);
+	TEST_ASSERT_EQUAL_STRING("MQTT retry in 1000 ms", fakeLastLog.c_str());
+}
+
+void test_refused_connection_is_retried_with_back_off(void)
+{
+	broker.connackCode = 5; // Not authorized
+	run_ms(60000);
+
+	// Tries at 0, 1, 3, 7, 15 and 31 s
+	TEST_ASSERT_FALSE(mqtt_is_connected());
+	TEST_ASSERT_EQUAL(6, broker.connectCount);
+	TEST_ASSERT_EQUAL(0, broker.publishes.size());
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_session_is_opened_and_states_published);
+	RUN_TEST(test_offline_values_are_coalesced);
+	RUN_TEST(test_unacknowledged_message_is_sent_again);
+	RUN_TEST(test_in_flight_message_survives_a_reconnection);
+	RUN_TEST(test_strip_command_is_applied_and_acknowledged);
+	RUN_TEST(test_live_broker_is_pinged_while_publishing);
+	RUN_TEST(test_silent_broker_is_left);
+	RUN_TEST(test_refused_connection_is_retried_with_back_off);
+	return UNITY_END();
+}
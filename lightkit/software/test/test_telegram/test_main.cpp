@@ -0,0 +1,411 @@
+/**
+  * @file   test_main.cpp
+  * @brief  Telegram replies: content of /status, chat list, no heap allocation over 10k replies,
+  *         queue against a stand-in Bot API
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_TEMP_TELEGRAM
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+#include <vector>
+
+// The module is disabled without a token
+#undef TELEGRAM_CONV_TOKEN
+#define TELEGRAM_CONV_TOKEN "TOKEN"
+
+bool          isAutoTempMsgEnabled = true;
+const float   sensorThreshold[]    = { 20.0f };
+const uint8_t sensorThresholdCount = 1;
+
+// Unit under test, built here to reach its state
+#include "event/event.cpp"
+#include "telegram/telegram.cpp"
+#include "telegram/telegram_chat.cpp"
+#include "tools/str_buffer.cpp"
+
+#define TEST_CHAT_ID      42
+#define TEST_STATUS_LOOPS 10000
+
+/**
+ * Every malloc, calloc and realloc of the host is counted, the new of
+ * the C++ library ends in them. A String of the fakes always takes a
+ * heap block. Only the calls of the unit under test are compared
+ */
+static uint32_t allocCount = 0;
+
+// The allocator of glibc, under the names it exports for that
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t count, size_t size);
+extern "C" void * __libc_realloc(void * p, size_t size);
+
+extern "C" void * malloc(size_t size)
+{
+	allocCount++;
+	return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t count, size_t size)
+{
+	allocCount++;
+	return __libc_calloc(count, size);
+}
+
+extern "C" void * realloc(void * p, size_t size)
+{
+	allocCount++;
+	return __libc_realloc(p, size);
+}
+
+static const float sensorValues[] = { 21.5f, 0.0f };
+
+uint8_t temp_get_nb_sensor(void)
+{
+	return 2;
+}
+
+bool temp_is_faulty(uint8_t deviceIndex)
+{
+	return deviceIndex == 1;
+}
+
+float temp_get_value(uint8_t deviceIndex)
+{
+	return sensorValues[deviceIndex];
+}
+
+char * temp_get_address(char * str, uint8_t deviceIndex)
+{
+	sprintf(str, "28FF00000000000%d", deviceIndex);
+	return str;
+}
+
+int temp_history_get_stats(uint8_t sensorIndex, uint8_t level, uint8_t lastCount, struct temp_history_stats_t * pStats)
+{
+	return -1;
+}
+
+bool file_sys_exist(String & path)
+{
+	return LittleFS.exists(path);
+}
+
+File file_sys_open(String & path, const char * mode)
+{
+	return LittleFS.open(path, mode);
+}
+
+/** A sendMessage received by the server */
+struct test_sent_t {
+	int64_t     chatId;
+	std::string text;
+};
+
+/**
+ * Bot API over HTTP/1.1 keep-alive: sendMessage is recorded, getUpdates
+ * returns the next pushed update, a long poll is held until one is pushed
+ * or its timeout is over. step() is called each tick for the held poll
+ */
+class TelegramServer : public FakeTcpPeer {
+public:
+	std::vector<struct test_sent_t> sent;
+	std::vector<std::string>        updates;  /**< Pushed, not returned yet */
+	uint32_t                        polls;    /**< getUpdates received */
+	uint32_t                        updateId; /**< Of the next update */
+	struct fake_tcp_conn_t *        pPollConn;
+	uint64_t                        pollEndUs;
+
+	TelegramServer(void) { reset(); }
+
+	void reset(void)
+	{
+		sent.clear();
+		updates.clear();
+		polls     = 0;
+		updateId  = 100;
+		pPollConn = NULL;
+	}
+
+	void on_receive(struct fake_tcp_conn_t * pConn) override
+	{
+		size_t      end;
+		size_t      bodyLength;
+		std::string head;
+		std::string body;
+
+		while ((end = pConn->toPeer.find("\r\n\r\n")) != std::string::npos) {
+			head       = pConn->toPeer.substr(0, end);
+			bodyLength = (head.find("Content-Length: ") != std::string::npos) ? atoi(&head[head.find("Content-Length: ") + 16]) : 0;
+			if (pConn->toPeer.size() < end + 4 + bodyLength) {
+				return;
+			}
+			body = pConn->toPeer.substr(end + 4, bodyLength);
+			pConn->toPeer.erase(0, end + 4 + bodyLength);
+
+			if (head.find("/sendMessage ") != std::string::npos) {
+				receive_message(body);
+				reply(pConn, "{\"ok\":true,\"result\":{}}");
+			} else if (head.find("/getUpdates?") != std::string::npos) {
+				polls++;
+				pPollConn = pConn;
+				pollEndUs = fakeMicros + 1000000ULL * atoi(&head[head.find("timeout=") + 8]);
+				step();
+			} else {
+				reply(pConn, "{\"ok\":false}");
+			}
+		}
+	}
+
+	void on_stop(struct fake_tcp_conn_t * pConn) override
+	{
+		if (pConn == pPollConn) {
+			pPollConn = NULL;
+		}
+	}
+
+	/** Reply to the held poll if it can be */
+	void step(void)
+	{
+		char body[160];
+
+		if ((pPollConn == NULL) || (updates.empty() && (fakeMicros < pollEndUs))) {
+			return;
+		}
+		if (updates.empty()) {
+			reply(pPollConn, "{\"ok\":true,\"result\":[]}");
+		} else {
+			snprintf(body, sizeof(body), "{\"ok\":true,\"result\":[{\"update_id\":%u,\"message\":%s}]}", updateId++, updates[0].c_str());
+			updates.erase(updates.begin());
+			reply(pPollConn, body);
+		}
+		pPollConn = NULL;
+	}
+
+	/** A user writes to the bot */
+	void push_update(int64_t chatId, const char * text)
+	{
+		char message[96];
+
+		snprintf(message, sizeof(message), "{\"chat\":{\"id\":%lld},\"text\":\"%s\"}", (long long) chatId, text);
+		updates.push_back(message);
+	}
+
+	/** Number of times a text was sent to a chat */
+	uint32_t count(int64_t chatId, const char * text)
+	{
+		uint32_t n = 0;
+
+		for (const struct test_sent_t & msg : sent) {
+			n += ((msg.chatId == chatId) && (msg.text.find(text) != std::string::npos)) ? 1 : 0;
+		}
+		return n;
+	}
+
+private:
+	void receive_message(const std::string & body)
+	{
+		struct test_sent_t msg;
+		size_t             pos = body.find("\"text\":\"");
+
+		msg.chatId = strtoll(&body[body.find("\"chat_id\":") + 10], NULL, 10);
+		msg.text   = (pos != std::string::npos) ? body.substr(pos + 8, body.find('"', pos + 8) - pos - 8) : "";
+		sent.push_back(msg);
+	}
+
+	void reply(struct fake_tcp_conn_t * pConn, const char * body)
+	{
+		char headers[128];
+
+		snprintf(headers, sizeof(headers), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: keep-alive\r\n\r\n",
+		         (unsigned int) strlen(body));
+		fake_tcp_send(pConn, std::string(headers) + body, 50000);
+	}
+};
+
+static TelegramServer server;
+
+static uint32_t run_ms(uint32_t durationMs)
+{
+	return fake_main_run(
+	    []() {
+		    telegram_main();
+		    server.step();
+	    },
+	    durationMs);
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	telegram_disconnect();
+	fake_tcp_clear();
+	server.reset();
+	fakeTcpPeer = &server;
+	fakeFiles.clear();
+	isAutoTempMsgEnabled = true;
+
+	event_init();
+	TEST_ASSERT_EQUAL(0, telegram_init());
+	_set(STATUS_WIFI, STATUS_WIFI_IS_CO);
+}
+
+void tearDown(void)
+{
+}
+
+void test_status_reply(void)
+{
+	telegram_handle_new_message(TEST_CHAT_ID, "/status");
+
+	TEST_ASSERT_EQUAL(1, txCount);
+	TEST_ASSERT_EQUAL(1 << 0, txQueue[0].chatMask);
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[0].text, FIRMWARE_VERSION "\n"));
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[0].text, "192.168.0.51\n"));
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[0].text, "`Temp. 0] `" EMOJI_GREEN_CHECK " 21.50 'C\n"));
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[0].text, "`Temp. 1] `" EMOJI_CROSS_MARK));
+	TEST_ASSERT_FALSE(reply.isTruncated);
+
+	// The request holds the whole reply and the keyboard
+	TEST_ASSERT_GREATER_THAN(0, telegram_build_send_request(&txQueue[0], TEST_CHAT_ID));
+	TEST_ASSERT_NOT_NULL(strstr(txBuffer, "\"chat_id\":42"));
+	TEST_ASSERT_NOT_NULL(strstr(txBuffer, keyboardJson));
+}
+
+void test_first_chat_owns_the_board(void)
+{
+	telegram_handle_new_message(TEST_CHAT_ID, "/status");
+	TEST_ASSERT_EQUAL(TELEGRAM_ROLE_OPERATOR, telegram_chat_get(0)->role);
+	TEST_ASSERT_EQUAL(0x01, telegram_chat_get_subscribers());
+
+	// Other chats only learn their id
+	telegram_handle_new_message(TEST_CHAT_ID + 1, "/status");
+	TEST_ASSERT_EQUAL(-1, telegram_chat_find(TEST_CHAT_ID + 1));
+	TEST_ASSERT_EQUAL(TEST_CHAT_ID + 1, txQueue[1].chatId);
+	TEST_ASSERT_EQUAL(0, txQueue[1].chatMask);
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[1].text, TG_MSG_UNKNOWN_CHAT "43"));
+	TEST_ASSERT_NULL(strstr(txQueue[1].text, "192.168.0.51"));
+
+	// They can not fill the list
+	for (uint8_t i = 2; i <= TELEGRAM_CHAT_MAX; i++) {
+		telegram_handle_new_message(TEST_CHAT_ID + i, "/status");
+		telegram_queue_remove(txCount - 1);
+	}
+	TEST_ASSERT_NULL(telegram_chat_get(1));
+
+	// Until an operator adds them
+	TEST_ASSERT_EQUAL(1, telegram_chat_add(TEST_CHAT_ID + 1, TELEGRAM_ROLE_VIEWER));
+	TEST_ASSERT_EQUAL(TELEGRAM_ROLE_VIEWER, telegram_chat_get(1)->role);
+	TEST_ASSERT_EQUAL(0x03, telegram_chat_get_subscribers());
+
+	// A viewer can not stop the messages
+	telegram_handle_new_message(TEST_CHAT_ID + 1, "/stop");
+	TEST_ASSERT_TRUE(isAutoTempMsgEnabled);
+	TEST_ASSERT_NOT_NULL(strstr(txQueue[txCount - 1].text, TG_MSG_NOT_ALLOWED));
+
+	// Kept after a reboot
+	TEST_ASSERT_EQUAL(0, telegram_chat_load());
+	TEST_ASSERT_EQUAL(0, telegram_chat_find(TEST_CHAT_ID));
+	TEST_ASSERT_EQUAL(1, telegram_chat_find(TEST_CHAT_ID + 1));
+	TEST_ASSERT_EQUAL(0x03, telegram_chat_get_subscribers());
+}
+
+void test_status_replies_do_not_allocate(void)
+{
+	uint32_t allocs;
+	uint32_t warnCount;
+	char     message[64];
+
+	// The chat is added and saved by the first message only
+	telegram_handle_new_message(TEST_CHAT_ID, "/status");
+	telegram_queue_remove(0);
+
+	warnCount  = fakeLogCount[LOG_WARN];
+	allocCount = 0;
+	for (uint32_t i = 0; i < TEST_STATUS_LOOPS; i++) {
+		telegram_handle_new_message(TEST_CHAT_ID, "/status");
+		telegram_build_send_request(&txQueue[0], TEST_CHAT_ID);
+		telegram_queue_remove(0);
+	}
+	allocs = allocCount;
+
+	snprintf(message, sizeof(message), "%u allocations over %d /status", allocs, TEST_STATUS_LOOPS);
+	TEST_MESSAGE(message);
+
+	// The heap is kept whole for the TLS handshake
+	TEST_ASSERT_EQUAL(0, allocs);
+	TEST_ASSERT_EQUAL(0, txCount);
+	TEST_ASSERT_EQUAL(warnCount, fakeLogCount[LOG_WARN]);
+}
+
+void test_forced_poll_keeps_the_queue(void)
+{
+	TEST_ASSERT_EQUAL(0, telegram_chat_add(TEST_CHAT_ID, TELEGRAM_ROLE_OPERATOR));
+	TEST_ASSERT_EQUAL(1, telegram_chat_add(TEST_CHAT_ID + 1, TELEGRAM_ROLE_VIEWER));
+	telegram_chat_subscribe(0, true);
+	telegram_chat_subscribe(1, true);
+
+	// 3 broadcasts take 6 sends, a poll comes after the 4th with one still queued
+	telegram_send_msg_temperature(0, 20.0f);
+	telegram_send_msg_temperature(1, 21.0f);
+	telegram_send_msg_temperature(2, 22.0f);
+	server.push_update(TEST_CHAT_ID, "/stop");
+	run_ms(2000);
+
+	// The reply goes before the last broadcast, each message once to each chat
+	TEST_ASSERT_EQUAL(2, server.polls); // + the long poll once the queue is empty
+	TEST_ASSERT_EQUAL(7, server.sent.size());
+	TEST_ASSERT_EQUAL(1, server.count(TEST_CHAT_ID, TG_MSG_HAD_BEEN_STOPPED));
+	TEST_ASSERT_EQUAL(1, server.count(TEST_CHAT_ID, "2] "));
+	TEST_ASSERT_EQUAL(1, server.count(TEST_CHAT_ID + 1, "2] "));
+	TEST_ASSERT_EQUAL(TEST_CHAT_ID, server.sent[4].chatId);
+	TEST_ASSERT_NOT_NULL(strstr(server.sent[4].text.c_str(), TG_MSG_HAD_BEEN_STOPPED));
+	TEST_ASSERT_FALSE(isAutoTempMsgEnabled);
+	TEST_ASSERT_EQUAL(0, txCount);
+	TEST_ASSERT_EQUAL(1, fakeTcpConnectCount);
+}
+
+void test_send_waits_for_the_poll(void)
+{
+	uint32_t longest;
+
+	telegram_chat_add(TEST_CHAT_ID, TELEGRAM_ROLE_OPERATOR);
+	telegram_chat_subscribe(0, true);
+	run_ms(500);
+	TEST_ASSERT_EQUAL(1, server.polls);
+
+	// No new connection, so no handshake, the alert goes once the poll is over
+	telegram_send_alert(true);
+	longest = run_ms(TELEGRAM_POLL_TIMEOUT_S * 1000);
+	TEST_ASSERT_EQUAL(1, server.count(TEST_CHAT_ID, TG_MSG_ALERT_GOES_ON));
+	TEST_ASSERT_EQUAL(1, fakeTcpConnectCount);
+	TEST_ASSERT_LESS_THAN(fakeTcpConnectUs, longest);
+	TEST_ASSERT_EQUAL(0, txCount);
+}
+
+void test_unknown_chat_gets_its_id(void)
+{
+	telegram_chat_add(TEST_CHAT_ID, TELEGRAM_ROLE_OPERATOR);
+	server.push_update(TEST_CHAT_ID + 1, "/status");
+	run_ms(500);
+
+	TEST_ASSERT_EQUAL(1, server.sent.size());
+	TEST_ASSERT_EQUAL(1, server.count(TEST_CHAT_ID + 1, TG_MSG_UNKNOWN_CHAT "43"));
+	TEST_ASSERT_EQUAL(0, txCount);
+	TEST_ASSERT_EQUAL(-1, telegram_chat_find(TEST_CHAT_ID + 1));
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_status_reply);
+	RUN_TEST(test_first_chat_owns_the_board);
+	RUN_TEST(test_status_replies_do_not_allocate);
+	RUN_TEST(test_forced_poll_keeps_the_queue);
+	RUN_TEST(test_send_waits_for_the_poll);
+	RUN_TEST(test_unknown_chat_gets_its_id);
+	return UNITY_END();
+}
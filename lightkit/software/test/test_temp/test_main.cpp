@@ -0,0 +1,234 @@
+/**
+  * @file   test_main.cpp
+  * @brief  Temperature module on a fake OneWire bus: enumeration, conversion, loop latency,
+  *         history in the file system
+  * @author David DEVANT
+  * @date   19/10/2026
+  */
+
+#define BOARD_TEMP_DOMOTICZ
+
+#include <unity.h>
+
+#include "fake_main.hpp"
+
+// Unit under test, built here to reach its state
+#include "event/event.cpp"
+#include "temp/temp.cpp"
+#include "temp/temp_history.cpp"
+
+/** Samples that fill every level of a history */
+#define TEST_HISTORY_FULL (TEMP_HISTORY_LONG_COUNT * ((TEMP_HISTORY_LONG_PERIOD_MS) / (TEMP_POLLING_PERIOD_MS)))
+
+bool file_sys_exist(String & path)
+{
+	return LittleFS.exists(path);
+}
+
+File file_sys_open(String & path, const char * mode)
+{
+	return LittleFS.open(path, mode);
+}
+
+static uint32_t valueEventCount;
+
+static void on_temp_value(const struct event_t * pEvent, void * arg)
+{
+	valueEventCount++;
+	(void) pEvent;
+	(void) arg;
+}
+
+/** Run the loop with the event bus, return the longest call to temp_main() */
+static uint32_t run_ms(uint32_t durationMs)
+{
+	return fake_main_run(
+	    []() {
+		    temp_main();
+		    event_main();
+	    },
+	    durationMs);
+}
+
+/**
+ * @brief Find where the module put a fake sensor
+ *
+ * @param fakeIndex Index in fakeOneWireSensors
+ * @return Index of the module, -1 if not found
+ */
+static int find_sensor(size_t fakeIndex)
+{
+	for (uint8_t i = 0; i < temp_get_nb_sensor(); i++) {
+		if (memcmp(temp_get_rom(i), fakeOneWireSensors[fakeIndex].rom, sizeof(DeviceAddress)) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void setUp(void)
+{
+	fake_main_reset();
+	OneWire::clear();
+	fakeFiles.clear();
+	fakeFileOpenCount      = 0;
+	fakeFileWriteUsPerByte = 0;
+	valueEventCount        = 0;
+	event_init();
+	event_subscribe(event_mask(EVENT_TEMP_VALUE), EVENT_SOURCE_ANY, on_temp_value, NULL);
+}
+
+void tearDown(void)
+{
+}
+
+void test_search_finds_all_sensors(void)
+{
+	for (uint32_t serial = 1; serial <= 12; serial++) {
+		OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, serial * 7919, 20.0f);
+	}
+	OneWire::add_sensor(FAKE_ONEWIRE_DS18S20, 42, 20.0f);
+
+	temp_init();
+	run_ms(500);
+
+	TEST_ASSERT_EQUAL(fakeOneWireSensors.size(), temp_get_nb_sensor());
+	for (size_t i = 0; i < fakeOneWireSensors.size(); i++) {
+		TEST_ASSERT_TRUE(find_sensor(i) >= 0);
+	}
+
+	// Sorted, highest ROM code first
+	for (uint8_t i = 1; i < temp_get_nb_sensor(); i++) {
+		TEST_ASSERT_TRUE(memcmp(temp_get_rom(i - 1), temp_get_rom(i), sizeof(DeviceAddress)) > 0);
+	}
+}
+
+void test_loop_is_never_blocked(void)
+{
+	uint32_t longest;
+
+	for (uint32_t serial = 1; serial <= TEMP_MAX_SENSOR_SUPPORTED; serial++) {
+		OneWire::add_sensor((serial == 3) ? FAKE_ONEWIRE_DS18S20 : FAKE_ONEWIRE_DS18B20, serial * 104729, 18.5f);
+	}
+
+	// Enumeration and a first measure, then 2 periodic ones
+	temp_init();
+	longest = run_ms(2 * TEMP_POLLING_PERIOD_MS + 5000);
+
+	TEST_ASSERT_EQUAL(3, fakeOneWireConvertCount);
+	TEST_ASSERT_EQUAL(3 * TEMP_MAX_SENSOR_SUPPORTED, valueEventCount);
+	TEST_ASSERT_LESS_OR_EQUAL(1000, longest);
+}
+
+void test_values_are_read_after_conversion(void)
+{
+	size_t b20Low  = OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 1000, 21.25f);
+	size_t b20High = OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 2000, -3.5f);
+
+	temp_init();
+	run_ms(2000);
+
+	TEST_ASSERT_EQUAL(1, fakeOneWireConvertCount);
+	TEST_ASSERT_EQUAL(0, fakeOneWireEarlyReadCount);
+	TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.25f, temp_get_value(find_sensor(b20Low)));
+	TEST_ASSERT_FLOAT_WITHIN(0.01f, -3.5f, temp_get_value(find_sensor(b20High)));
+
+	// No longer than the 10 bits conversion, 187.5 ms
+	TEST_ASSERT_GREATER_OR_EQUAL(187500, fakeOneWireReadDelayUs);
+	TEST_ASSERT_LESS_THAN(250000, fakeOneWireReadDelayUs);
+}
+
+void test_ds18s20_makes_the_bus_wait(void)
+{
+	size_t b20 = OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 1000, 22.75f);
+	size_t s20 = OneWire::add_sensor(FAKE_ONEWIRE_DS18S20, 3000, 23.5625f);
+
+	temp_init();
+	run_ms(2000);
+
+	// The DS18S20 ignores the resolution and converts in 750 ms
+	TEST_ASSERT_EQUAL(0, fakeOneWireEarlyReadCount);
+	TEST_ASSERT_GREATER_OR_EQUAL(750000, fakeOneWireReadDelayUs);
+	TEST_ASSERT_FLOAT_WITHIN(0.01f, 22.75f, temp_get_value(find_sensor(b20)));
+	TEST_ASSERT_FLOAT_WITHIN(0.07f, 23.5625f, temp_get_value(find_sensor(s20)));
+}
+
+void test_unplugged_sensor_is_faulty(void)
+{
+	size_t kept    = OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 1000, 19.0f);
+	size_t removed = OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 2000, 19.5f);
+
+	temp_init();
+	run_ms(2000);
+	TEST_ASSERT_FALSE(temp_is_faulty(find_sensor(removed)));
+	TEST_ASSERT_TRUE(_isunset(STATUS_TEMP, STATUS_TEMP_FAULT));
+
+	fakeOneWireSensors[removed].isPlugged = false;
+	run_ms(TEMP_POLLING_PERIOD_MS);
+	TEST_ASSERT_TRUE(temp_is_faulty(find_sensor(removed)));
+	TEST_ASSERT_FALSE(temp_is_faulty(find_sensor(kept)));
+	TEST_ASSERT_TRUE(_isset(STATUS_TEMP, STATUS_TEMP_FAULT));
+
+	fakeOneWireSensors[removed].isPlugged = true;
+	run_ms(TEMP_POLLING_PERIOD_MS);
+	TEST_ASSERT_FALSE(temp_is_faulty(find_sensor(removed)));
+	TEST_ASSERT_TRUE(_isunset(STATUS_TEMP, STATUS_TEMP_FAULT));
+}
+
+void test_history_is_saved_a_level_per_tick(void)
+{
+	uint32_t longest;
+	int16_t  samples[TEMP_HISTORY_LARGEST_COUNT];
+
+	OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 1000, 19.0f);
+	OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 2000, 19.5f);
+	temp_init();
+	run_ms(2000);
+
+	// Full levels, with steps that take several bytes per sample
+	for (uint32_t i = 0; i < TEST_HISTORY_FULL; i++) {
+		temp_history_add(0, (i % 7) * 250);
+		temp_history_add(1, (i % 5) * -300);
+	}
+
+	// The flash is slow, the hourly save must not hold the loop for the whole file
+	fakeFileWriteUsPerByte = 10;
+	historyNextSaveTick    = tick;
+	longest                = run_ms(1000);
+	TEST_ASSERT_EQUAL(0, historySaveBlock);
+	TEST_ASSERT_GREATER_THAN(2 * TEMP_HISTORY_ENCODED_SIZE(TEMP_HISTORY_LARGEST_COUNT), fakeFiles[TEMP_HISTORY_FILE_PATH].size());
+	TEST_ASSERT_LESS_OR_EQUAL(1000 + 10 * (sizeof(DeviceAddress) + 2 + TEMP_HISTORY_ENCODED_SIZE(TEMP_HISTORY_LARGEST_COUNT)), longest);
+
+	// Read back after a reboot
+	temp_init();
+	run_ms(2000);
+	TEST_ASSERT_EQUAL(TEMP_HISTORY_LONG_COUNT, temp_history_get(find_sensor(1), TEMP_HISTORY_LEVEL_LONG, samples, TEMP_HISTORY_LARGEST_COUNT));
+}
+
+void test_history_is_read_when_sensors_change(void)
+{
+	fakeFiles[TEMP_HISTORY_FILE_PATH] = "not a history";
+
+	// Without sensor, the bus is searched again each period
+	temp_init();
+	run_ms(3 * TEMP_POLLING_PERIOD_MS);
+	TEST_ASSERT_EQUAL(0, fakeFileOpenCount);
+
+	OneWire::add_sensor(FAKE_ONEWIRE_DS18B20, 1000, 19.0f);
+	run_ms(2 * TEMP_POLLING_PERIOD_MS);
+	TEST_ASSERT_EQUAL(1, temp_get_nb_sensor());
+	TEST_ASSERT_EQUAL(1, fakeFileOpenCount);
+}
+
+int main(int argc, char ** argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_search_finds_all_sensors);
+	RUN_TEST(test_loop_is_never_blocked);
+	RUN_TEST(test_values_are_read_after_conversion);
+	RUN_TEST(test_ds18s20_makes_the_bus_wait);
+	RUN_TEST(test_unplugged_sensor_is_faulty);
+	RUN_TEST(test_history_is_saved_a_level_per_tick);
+	RUN_TEST(test_history_is_read_when_sensors_change);
+	return UNITY_END();
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+#
+# Send a batch script to one or several LightKit modules over telnet
+#
+# The script is wrapped between "batch begin" and "batch end", the module
+# runs it in a row and stops on the first failing line.
+#
+# Usage: batch_telnet.py script.txt 192.168.1.10 192.168.1.11 ...
+
+import argparse
+import socket
+import sys
+import time
+
+TELNET_PORT = 23
+RESULT_OK = b"Batch done"
+RESULT_KO = (b"Batch aborted", b"Batch is too long", b"A batch is already in progress")
+
+
+def send_batch(host, port, lines, timeout):
+	with socket.create_connection((host, port), timeout=timeout) as sock:
+		payload = "batch begin\n" + "".join(line + "\n" for line in lines) + "batch end\n"
+		sock.sendall(payload.encode())
+
+		# Wait for the result line
+		received = b""
+		deadline = time.time() + timeout
+		while time.time() < deadline:
+			try:
+				chunk = sock.recv(1024)
+			except socket.timeout:
+				break
+			if not chunk:
+				break
+			received += chunk
+			for marker in (RESULT_OK,) + RESULT_KO:
+				index = received.find(marker)
+				if index >= 0:
+					result = received[index:].split(b"\n")[0].strip()
+					return marker == RESULT_OK, result.decode(errors="replace")
+	return False, "No result received"
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Run a CLI batch on LightKit modules")
+	parser.add_argument("script", help="File with one command per line")
+	parser.add_argument("hosts", nargs="+", help="IP addresses or names of the modules")
+	parser.add_argument("-p", "--port", type=int, default=TELNET_PORT)
+	parser.add_argument("-t", "--timeout", type=float, default=10.0)
+	args = parser.parse_args()
+
+	with open(args.script) as f:
+		lines = [line.rstrip("\r\n") for line in f]
+
+	failures = 0
+	for host in args.hosts:
+		try:
+			ok, result = send_batch(host, args.port, lines, args.timeout)
+		except OSError as e:
+			ok, result = False, str(e)
+		print("%-20s %s %s" % (host, "OK  " if ok else "FAIL", result))
+		failures += 0 if ok else 1
+
+	return 1 if failures else 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+#
+# Host client for the binary control protocol of LightKit modules (src/rpc)
+#
+# Request:  [len u16][reqId u16][opcode u8][payload]
+# Response: [len u16][reqId u16][opcode u8][status s8][payload]
+# All integers are little endian, len counts the bytes following it.
+#
+# Exemple:
+#   with LightKitRpc("192.168.1.10") as rpc:
+#       print(rpc.get_version())
+#       rpc.set_color(0xFF8000)
+
+import socket
+import struct
+
+RPC_PORT = 2323
+RPC_FRAME_MAX_LEN = 128
+
+# Levels of the temperature history, see temp_history_level_e
+TEMP_HISTORY_LEVEL_RAW = 0
+TEMP_HISTORY_LEVEL_MEDIUM = 1
+TEMP_HISTORY_LEVEL_LONG = 2
+
+# Opcodes, see rpc_opcode_e
+OP_PING = 0x01
+OP_GET_VERSION = 0x02
+OP_GET_STATUS = 0x03
+OP_GET_MODULE_NAME = 0x04
+OP_SET_MODULE_NAME = 0x05
+OP_RESET = 0x06
+OP_SET_STATUS_LED = 0x07
+OP_GET_STATE = 0x10
+OP_SET_STATE = 0x11
+OP_GET_BRIGHTNESS = 0x12
+OP_SET_BRIGHTNESS = 0x13
+OP_GET_COLOR = 0x14
+OP_SET_COLOR = 0x15
+OP_GET_ANIMATION = 0x16
+OP_SET_ANIMATION = 0x17
+OP_GET_DEMO_MODE = 0x18
+OP_SET_DEMO_MODE = 0x19
+OP_GET_RELAY = 0x20
+OP_SET_RELAY = 0x21
+OP_SET_BUZZER = 0x30
+OP_GET_FEU_ROUGE = 0x40
+OP_SET_FEU_ROUGE = 0x41
+OP_SET_FEU_ROUGE_COL = 0x42
+OP_GET_TEMP_HISTORY = 0x50
+
+# Status, see rpc_status_e
+STATUS_NAMES = {
+	0: "OK",
+	-1: "ERROR",
+	-2: "UNKNOWN",
+	-3: "BAD_LENGTH",
+	-4: "NOT_SUPPORTED",
+}
+
+
+class RpcError(Exception):
+	def __init__(self, opcode, status):
+		self.opcode = opcode
+		self.status = status
+		super().__init__("opcode 0x%02X failed: %s" % (opcode, STATUS_NAMES.get(status, status)))
+
+
+class LightKitRpc:
+	def __init__(self, host, port=RPC_PORT, timeout=5.0):
+		self.sock = socket.create_connection((host, port), timeout=timeout)
+		self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+		self.nextReqId = 0
+		self.rxBuffer = b""
+
+	def __enter__(self):
+		return self
+
+	def __exit__(self, *args):
+		self.close()
+
+	def close(self):
+		self.sock.close()
+
+	# Frames
+
+	def _encode(self, opcode, payload):
+		if len(payload) > RPC_FRAME_MAX_LEN - 3:
+			raise ValueError("Payload too long")
+		reqId = self.nextReqId
+		self.nextReqId = (self.nextReqId + 1) & 0xFFFF
+		return reqId, struct.pack("<HHB", 3 + len(payload), reqId, opcode) + payload
+
+	def _read_response(self):
+		while True:
+			if len(self.rxBuffer) >= 2:
+				length = struct.unpack_from("<H", self.rxBuffer)[0]
+				if len(self.rxBuffer) >= 2 + length:
+					frame = self.rxBuffer[2:2 + length]
+					self.rxBuffer = self.rxBuffer[2 + length:]
+					reqId, opcode, status = struct.unpack_from("<HBb", frame)
+					return reqId, opcode, status, frame[4:]
+			chunk = self.sock.recv(4096)
+			if not chunk:
+				raise ConnectionError("Connection closed by module")
+			self.rxBuffer += chunk
+
+	def call(self, opcode, payload=b""):
+		"""Send one request and wait for its response payload"""
+		return self.call_many([(opcode, payload)])[0]
+
+	def call_many(self, requests, check=True):
+		"""Pipeline several (opcode, payload) requests, return the payloads in order
+
+		With check=False, return (status, payload) tuples instead of raising
+		"""
+		reqIds = []
+		data = b""
+		for opcode, payload in requests:
+			reqId, frame = self._encode(opcode, payload)
+			reqIds.append(reqId)
+			data += frame
+		self.sock.sendall(data)
+
+		results = []
+		for expectedId in reqIds:
+			reqId, opcode, status, payload = self._read_response()
+			if reqId != expectedId:
+				raise ConnectionError("Unexpected reqId %d (expected %d)" % (reqId, expectedId))
+			if check and status != 0:
+				raise RpcError(opcode, status)
+			results.append(payload if check else (status, payload))
+		return results
+
+	# Board
+
+	def ping(self, payload=b""):
+		return self.call(OP_PING, payload)
+
+	def get_version(self):
+		return self.call(OP_GET_VERSION).decode()
+
+	def get_status(self):
+		return list(self.call(OP_GET_STATUS))
+
+	def get_module_name(self):
+		return self.call(OP_GET_MODULE_NAME).decode()
+
+	def set_module_name(self, name):
+		self.call(OP_SET_MODULE_NAME, name.encode())
+
+	def reset(self):
+		self.call(OP_RESET)
+
+	def set_status_led(self, isEnabled):
+		self.call(OP_SET_STATUS_LED, bytes([int(bool(isEnabled))]))
+
+	# Strip led
+
+	def get_state(self):
+		return bool(self.call(OP_GET_STATE)[0])
+
+	def set_state(self, isOn):
+		self.call(OP_SET_STATE, bytes([int(bool(isOn))]))
+
+	def get_brightness(self):
+		return self.call(OP_GET_BRIGHTNESS)[0]
+
+	def set_brightness(self, value):
+		self.call(OP_SET_BRIGHTNESS, bytes([value]))
+
+	def get_color(self):
+		return struct.unpack("<I", self.call(OP_GET_COLOR))[0]
+
+	def set_color(self, color):
+		self.call(OP_SET_COLOR, struct.pack("<I", color))
+
+	def get_animation(self):
+		return self.call(OP_GET_ANIMATION)[0]
+
+	def set_animation(self, animId):
+		self.call(OP_SET_ANIMATION, bytes([animId]))
+
+	def get_demo_mode(self):
+		return bool(self.call(OP_GET_DEMO_MODE)[0])
+
+	def set_demo_mode(self, isInDemoMode):
+		self.call(OP_SET_DEMO_MODE, bytes([int(bool(isInDemoMode))]))
+
+	# Relay
+
+	def get_relay(self):
+		state, theoretical = self.call(OP_GET_RELAY)
+		return bool(state), bool(theoretical)
+
+	def set_relay(self, isClose):
+		self.call(OP_SET_RELAY, bytes([int(bool(isClose))]))
+
+	# Buzzer
+
+	def set_buzzer(self, buzzerId, melody, repeat=False):
+		self.call(OP_SET_BUZZER, bytes([buzzerId, melody, int(bool(repeat))]))
+
+	# Feu rouge
+
+	def get_feu_rouge_mode(self):
+		return self.call(OP_GET_FEU_ROUGE)[0]
+
+	def set_feu_rouge_mode(self, mode):
+		self.call(OP_SET_FEU_ROUGE, bytes([mode]))
+
+	def set_feu_rouge_color(self, colorCmd):
+		self.call(OP_SET_FEU_ROUGE_COL, bytes([colorCmd]))
+
+	# Temperature
+
+	def get_temp_history(self, sensor, level=TEMP_HISTORY_LEVEL_MEDIUM):
+		"""Samples in °C, oldest first, None when the sensor was faulty"""
+		samples = []
+		while True:
+			resp = self.call(OP_GET_TEMP_HISTORY, bytes([sensor, level, len(samples)]))
+			count = resp[0]
+			page = struct.unpack_from("<%dh" % ((len(resp) - 2) // 2), resp, 2)
+			samples += [None if s == -32768 else s / 100.0 for s in page]
+			if (len(samples) >= count) or (len(page) == 0):
+				return samples[:count]
+
+
+if __name__ == "__main__":
+	import sys
+
+	if len(sys.argv) < 2:
+		print("Usage: %s <host>" % sys.argv[0])
+		sys.exit(1)
+
+	with LightKitRpc(sys.argv[1]) as rpc:
+		print("Version: %s" % rpc.get_version())
+		print("Name:    %s" % rpc.get_module_name())
+		print("Status:  %s" % " ".join("0x%02X" % s for s in rpc.get_status()))
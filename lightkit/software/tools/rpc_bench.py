@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+#
+# Measure the request throughput of the binary control protocol
+#
+# Compare one request at a time with pipelined bursts of requests.
+#
+# Usage: rpc_bench.py <host> [-n 1000] [-d 16] [-s 16]
+
+import argparse
+import time
+
+from lightkit_rpc import OP_PING, LightKitRpc
+
+
+def run(rpc, count, depth, payload):
+	requests = [(OP_PING, payload)] * depth
+	start = time.perf_counter()
+	done = 0
+	while done < count:
+		burst = min(depth, count - done)
+		rpc.call_many(requests[:burst])
+		done += burst
+	return time.perf_counter() - start
+
+
+def main():
+	parser = argparse.ArgumentParser(description="LightKit RPC throughput benchmark")
+	parser.add_argument("host")
+	parser.add_argument("-p", "--port", type=int, default=2323)
+	parser.add_argument("-n", "--count", type=int, default=1000, help="Requests per run")
+	parser.add_argument("-d", "--depth", type=int, default=16, help="Requests in flight when pipelining")
+	parser.add_argument("-s", "--size", type=int, default=16, help="Ping payload size")
+	args = parser.parse_args()
+
+	payload = bytes(range(args.size))
+	with LightKitRpc(args.host, args.port) as rpc:
+		for depth in (1, args.depth):
+			duration = run(rpc, args.count, depth, payload)
+			print("depth %3d: %6d req in %6.2f s -> %7.1f req/s, %6.2f ms/req" %
+				  (depth, args.count, duration, args.count / duration, 1000 * duration / args.count))
+
+
+if __name__ == "__main__":
+	main()